@@ -0,0 +1,1130 @@
+#include "../include/ams_protocol.hpp"
+#include "../include/ads_sumup.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+// ADS/AMS Simulator für Lasttests ohne PLC
+//
+// Spricht AMS/TCP auf Port 48898 und bedient eine konfigurierbare Symboltabelle:
+// Handles (0xF003/0xF006), Symbol-Infos (0xF009), Werte (0xF005), alle Sum-Up
+// Index Groups (0xF080-0xF085) sowie Device Notifications. Notifications werden
+// wie bei TwinCAT pro Zeitstempel in einem Frame gebündelt verschickt.
+//
+// Beispiel (Bridge gegen localhost):
+//   ./ads_simulator --symbol GVL.abc:DINT --symbols 1000 --aggregate-hz 100000 --jitter-us 200
+//   config.ini: [plc] ip = 127.0.0.1
+
+namespace sim {
+
+using namespace ads_realtime;
+
+constexpr uint32_t ADSIGRP_SYM_HNDBYNAME = 0xF003;
+constexpr uint32_t ADSIGRP_SYM_VALBYHND = 0xF005;
+constexpr uint32_t ADSIGRP_SYM_RELEASEHND = 0xF006;
+constexpr uint32_t ADSIGRP_SYM_INFOBYNAMEEX = 0xF009;
+constexpr uint32_t ADSIGRP_PLC_MEMORY = 0x4040;
+
+constexpr uint32_t SYMBOL_HANDLE_BASE = 0x10000;
+constexpr uint32_t NOTIFICATION_HANDLE_BASE = 0x1000;
+constexpr size_t MAX_NOTIFICATION_FRAME = 64 * 1024;
+constexpr uint64_t MIN_NOTIFICATION_PERIOD_NS = 10000;   // 100 kHz pro Notification
+constexpr uint32_t MAX_CATCHUP_ROUNDS = 64;              // max. nachgeholte Perioden pro Wakeup
+
+std::atomic<bool> g_running{true};
+
+struct Options {
+    std::string bind_address = "127.0.0.1";
+    uint16_t port = ams::AMS_TCP_PORT;
+    std::vector<std::string> symbol_specs;   // NAME:TYPE[:SIZE]
+    std::string symbol_file;                 // Zeilen "name, type, size" wie config.ini [variables]
+    uint32_t generated_symbols = 0;
+    std::string generated_prefix = "GVL.sim";
+    std::string generated_type = "DINT";
+    uint32_t generated_size = 0;             // nur STRING/ARRAY
+    double rate_hz = 0.0;                    // fix pro Notification (0 = nCycleTime des Clients)
+    double aggregate_hz = 0.0;               // Gesamtrate pro Verbindung, gleichmäßig verteilt
+    uint32_t plc_cycle_us = 1000;            // Wertänderungen im PLC Task
+    double change_ratio = 0.1;               // Anteil der Symbole, die sich pro PLC-Zyklus ändern
+    uint32_t jitter_us = 0;                  // zufällige Verzögerung je Notification Frame
+    uint32_t disconnect_every_s = 0;         // Verbindung nach ~N s hart trennen (0 = nie)
+    uint32_t stats_interval_ms = 1000;
+};
+
+inline uint64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// FILETIME (100ns seit 1601) wie im ADS Notification Stream
+inline int64_t filetime_now() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return 116444736000000000LL + static_cast<int64_t>(ts.tv_sec) * 10000000LL + ts.tv_nsec / 100;
+}
+
+inline void sleep_until_ns(uint64_t deadline_ns) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadline_ns / 1000000000ULL);
+    ts.tv_nsec = static_cast<long>(deadline_ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// xorshift64* - billig genug für zehntausende Symbole pro PLC-Zyklus
+class FastRandom {
+public:
+    explicit FastRandom(uint64_t seed) : state_(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+    uint64_t next() {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1DULL;
+    }
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+private:
+    uint64_t state_;
+};
+
+template<typename T>
+inline void put(std::vector<uint8_t>& buffer, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+inline T get(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+inline std::string to_upper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return s;
+}
+
+inline std::string trim(const std::string& s) {
+    auto begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+// ============================================================================
+// Symboltabelle
+// ============================================================================
+
+struct Symbol {
+    std::string name;
+    std::string type_name;
+    ams::DataType type = ams::DataType::Int32;
+    uint32_t size = 4;
+    uint32_t offset = 0;
+    uint32_t handle = 0;
+    std::vector<uint8_t> value;
+    uint64_t version = 0;        // wird bei jeder Wertänderung erhöht (für SERVERONCHA)
+    uint64_t counter = 0;
+};
+
+class SymbolTable {
+public:
+    bool add(const std::string& name, const std::string& type, uint32_t size_override) {
+        Symbol symbol;
+        symbol.name = name;
+        symbol.type_name = to_upper(type);
+        if (!resolve_type(symbol, size_override)) {
+            std::cerr << "[SIM] ERROR: Unbekannter Typ " << type << " für " << name << "\n";
+            return false;
+        }
+        symbol.offset = next_offset_;
+        symbol.handle = SYMBOL_HANDLE_BASE + static_cast<uint32_t>(symbols_.size());
+        symbol.value.assign(symbol.size, 0);
+        next_offset_ += symbol.size;
+
+        by_name_[to_upper(name)] = symbols_.size();
+        symbols_.push_back(std::move(symbol));
+        return true;
+    }
+
+    Symbol* find(const std::string& name) {
+        auto it = by_name_.find(to_upper(name));
+        return it == by_name_.end() ? nullptr : &symbols_[it->second];
+    }
+
+    Symbol* by_handle(uint32_t handle) {
+        if (handle < SYMBOL_HANDLE_BASE || handle - SYMBOL_HANDLE_BASE >= symbols_.size()) {
+            return nullptr;
+        }
+        return &symbols_[handle - SYMBOL_HANDLE_BASE];
+    }
+
+    // Ein PLC-Zyklus: zufällige Teilmenge der Symbole ändern
+    void update(FastRandom& random, double change_ratio) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& symbol : symbols_) {
+            if (random.uniform() >= change_ratio) continue;
+            mutate(symbol, random);
+            symbol.version++;
+        }
+    }
+
+    size_t size() const { return symbols_.size(); }
+    const std::vector<Symbol>& symbols() const { return symbols_; }
+
+    std::mutex mutex;   // schützt value/version
+
+private:
+    static bool resolve_type(Symbol& symbol, uint32_t size_override) {
+        const std::string& t = symbol.type_name;
+        struct TypeInfo { const char* name; ams::DataType type; uint32_t size; };
+        static const TypeInfo types[] = {
+            {"BOOL", ams::DataType::Bit, 1},     {"BYTE", ams::DataType::UInt8, 1},
+            {"USINT", ams::DataType::UInt8, 1},  {"SINT", ams::DataType::Int8, 1},
+            {"WORD", ams::DataType::UInt16, 2},  {"UINT", ams::DataType::UInt16, 2},
+            {"INT", ams::DataType::Int16, 2},    {"DWORD", ams::DataType::UInt32, 4},
+            {"UDINT", ams::DataType::UInt32, 4}, {"DINT", ams::DataType::Int32, 4},
+            {"REAL", ams::DataType::Real32, 4},  {"LREAL", ams::DataType::Real64, 8},
+            {"LINT", ams::DataType::Int64, 8},   {"ULINT", ams::DataType::UInt64, 8},
+            {"LWORD", ams::DataType::UInt64, 8},
+        };
+        for (const auto& info : types) {
+            if (t == info.name) {
+                symbol.type = info.type;
+                symbol.size = info.size;
+                return true;
+            }
+        }
+        if (t.rfind("STRING", 0) == 0) {
+            // STRING = STRING(80) + Terminator, STRING(n) = n+1 Bytes
+            uint32_t length = 80;
+            auto open = t.find('(');
+            if (open != std::string::npos) length = static_cast<uint32_t>(std::strtoul(t.c_str() + open + 1, nullptr, 10));
+            symbol.type = ams::DataType::String;
+            symbol.size = size_override ? size_override : length + 1;
+            return true;
+        }
+        if (t.rfind("ARRAY", 0) == 0 || t.rfind("ST_", 0) == 0) {
+            // Arrays/Strukturen: Größe muss angegeben sein
+            symbol.type = ams::DataType::BigType;
+            symbol.size = size_override ? size_override : 64;
+            return true;
+        }
+        return false;
+    }
+
+    static void mutate(Symbol& symbol, FastRandom& random) {
+        symbol.counter++;
+        uint8_t* v = symbol.value.data();
+        switch (symbol.type) {
+            case ams::DataType::Bit:
+                v[0] = v[0] ? 0 : 1;
+                break;
+            case ams::DataType::Real32: {
+                float f = static_cast<float>(100.0 * std::sin(symbol.counter * 0.01) + random.uniform());
+                std::memcpy(v, &f, sizeof(f));
+                break;
+            }
+            case ams::DataType::Real64: {
+                double d = 100.0 * std::sin(symbol.counter * 0.01) + random.uniform();
+                std::memcpy(v, &d, sizeof(d));
+                break;
+            }
+            case ams::DataType::String: {
+                std::string text = "value " + std::to_string(symbol.counter);
+                size_t n = std::min<size_t>(text.size(), symbol.size - 1);
+                std::memset(v, 0, symbol.size);
+                std::memcpy(v, text.data(), n);
+                break;
+            }
+            case ams::DataType::BigType: {
+                // Array/Struktur: ein zufälliges Element (4 Bytes) ändern
+                uint32_t slots = std::max<uint32_t>(1, symbol.size / 4);
+                uint32_t pos = static_cast<uint32_t>(random.next() % slots) * 4;
+                uint32_t word = static_cast<uint32_t>(symbol.counter);
+                std::memcpy(v + pos, &word, std::min<uint32_t>(4, symbol.size - pos));
+                break;
+            }
+            default: {
+                // Ganzzahlen: Zähler (Little Endian, auf Symbolgröße gekürzt)
+                uint64_t counter = symbol.counter;
+                std::memcpy(v, &counter, std::min<size_t>(sizeof(counter), symbol.size));
+                break;
+            }
+        }
+    }
+
+    std::vector<Symbol> symbols_;
+    std::unordered_map<std::string, size_t> by_name_;
+    uint32_t next_offset_ = 0;
+};
+
+// ============================================================================
+// Client-Verbindung
+// ============================================================================
+
+struct SimStats {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> late{0};         // Perioden verworfen (Sender > 64 Perioden hinterher)
+    std::atomic<uint64_t> disconnects{0};
+};
+
+class ClientSession {
+public:
+    ClientSession(int fd, SymbolTable& table, const Options& options, SimStats& stats, uint64_t seed)
+        : fd_(fd), table_(table), options_(options), stats_(stats), random_(seed) {
+        if (options_.disconnect_every_s > 0) {
+            // ±25% Streuung, damit mehrere Clients nicht synchron getrennt werden
+            double factor = 0.75 + 0.5 * random_.uniform();
+            disconnect_at_ns_ = monotonic_ns() +
+                static_cast<uint64_t>(options_.disconnect_every_s * factor * 1e9);
+        }
+        reader_ = std::thread(&ClientSession::reader_loop, this);
+        emitter_ = std::thread(&ClientSession::emitter_loop, this);
+    }
+
+    ~ClientSession() {
+        closing_.store(true);
+        ::shutdown(fd_, SHUT_RDWR);
+        if (reader_.joinable()) reader_.join();
+        if (emitter_.joinable()) emitter_.join();
+        ::close(fd_);
+    }
+
+    bool finished() const { return closing_.load(); }
+
+    size_t notification_count() {
+        std::lock_guard<std::mutex> lock(notes_mutex_);
+        return notes_.size();
+    }
+
+private:
+    struct NotificationEntry {
+        Symbol* symbol = nullptr;
+        uint32_t length = 0;
+        uint32_t trans_mode = 0;
+        uint64_t cycle_ns = 0;          // vom Client angefordert
+        uint64_t period_ns = 0;         // effektiv (nach --rate / --aggregate-hz)
+        uint64_t next_due_ns = 0;
+        uint64_t last_version = UINT64_MAX;
+    };
+
+    // ------------------------------------------------------------------------
+    // Empfang und Request-Verarbeitung
+    // ------------------------------------------------------------------------
+
+    void reader_loop() {
+        std::vector<uint8_t> buffer(256 * 1024);
+        size_t size = 0;
+
+        while (g_running.load() && !closing_.load()) {
+            if (disconnect_at_ns_ != 0 && monotonic_ns() >= disconnect_at_ns_) {
+                std::cout << "[SIM] Trenne Verbindung (disconnect-every)\n";
+                stats_.disconnects.fetch_add(1);
+                break;
+            }
+
+            pollfd pfd{fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 100) <= 0) continue;
+
+            if (size == buffer.size()) buffer.resize(buffer.size() * 2);
+            ssize_t received = ::recv(fd_, buffer.data() + size, buffer.size() - size, 0);
+            if (received <= 0) break;
+            size += static_cast<size_t>(received);
+
+            size_t offset = 0;
+            while (size - offset >= sizeof(ams::TcpHeader)) {
+                auto tcp = get<ams::TcpHeader>(buffer.data() + offset);
+                size_t frame_size = sizeof(ams::TcpHeader) + tcp.length;
+                if (size - offset < frame_size) break;
+                if (tcp.length >= sizeof(ams::Header)) {
+                    auto header = get<ams::Header>(buffer.data() + offset + sizeof(ams::TcpHeader));
+                    const uint8_t* data = buffer.data() + offset + ams::FRAME_HEADER_SIZE;
+                    uint32_t data_size = std::min<uint32_t>(header.data_length,
+                        static_cast<uint32_t>(tcp.length - sizeof(ams::Header)));
+                    handle_request(header, data, data_size);
+                }
+                offset += frame_size;
+            }
+            std::memmove(buffer.data(), buffer.data() + offset, size - offset);
+            size -= offset;
+        }
+
+        closing_.store(true);
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+
+    void handle_request(const ams::Header& header, const uint8_t* data, uint32_t size) {
+        if (header.state_flags & ams::STATE_FLAG_RESPONSE) return;
+        stats_.requests.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<uint8_t> response;
+        switch (static_cast<ams::Command>(header.command_id)) {
+            case ams::Command::Read: {
+                if (size < sizeof(ams::ReadRequest)) return;
+                auto request = get<ams::ReadRequest>(data);
+                std::vector<uint8_t> value(request.length, 0);
+                uint32_t returned = 0;
+                uint32_t result = do_read(request.index_group, request.index_offset,
+                                          request.length, value.data(), returned);
+                put(response, result);
+                put(response, returned);
+                response.insert(response.end(), value.begin(), value.begin() + returned);
+                break;
+            }
+            case ams::Command::Write: {
+                if (size < sizeof(ams::WriteRequest)) return;
+                auto request = get<ams::WriteRequest>(data);
+                uint32_t length = std::min<uint32_t>(request.length, size - sizeof(request));
+                put(response, do_write(request.index_group, request.index_offset,
+                                       data + sizeof(request), length));
+                break;
+            }
+            case ams::Command::ReadWrite: {
+                if (size < sizeof(ams::ReadWriteRequest)) return;
+                auto request = get<ams::ReadWriteRequest>(data);
+                uint32_t write_length = std::min<uint32_t>(request.write_length, size - sizeof(request));
+                std::vector<uint8_t> out;
+                uint32_t result = do_read_write(request.index_group, request.index_offset,
+                                                request.read_length, data + sizeof(request),
+                                                write_length, out);
+                if (out.size() > request.read_length) {
+                    out.resize(request.read_length);
+                }
+                put(response, result);
+                put(response, static_cast<uint32_t>(out.size()));
+                response.insert(response.end(), out.begin(), out.end());
+                break;
+            }
+            case ams::Command::AddNotification: {
+                if (size < sizeof(ams::AddNotificationRequest)) return;
+                auto request = get<ams::AddNotificationRequest>(data);
+                uint32_t handle = 0;
+                put(response, do_add_notification(request.index_group, request.index_offset,
+                                                  request.length, request.trans_mode,
+                                                  request.cycle_time, handle));
+                put(response, handle);
+                break;
+            }
+            case ams::Command::DelNotification: {
+                if (size < sizeof(ams::DelNotificationRequest)) return;
+                auto request = get<ams::DelNotificationRequest>(data);
+                put(response, do_del_notification(request.notification_handle));
+                break;
+            }
+            default:
+                put(response, ams::ERR_DEVICE_SRVNOTSUPP);
+                break;
+        }
+
+        send_frame(header.source_net_id, header.source_port, header.target_net_id, header.target_port,
+                   header.command_id, ams::STATE_FLAGS_RESPONSE, header.invoke_id, response);
+
+        // Absender merken - Ziel der Notification Frames
+        if (!have_peer_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            peer_net_id_ = header.source_net_id;
+            peer_port_ = header.source_port;
+            own_net_id_ = header.target_net_id;
+            own_port_ = header.target_port;
+            have_peer_.store(true, std::memory_order_release);
+        }
+    }
+
+    uint32_t do_read(uint32_t index_group, uint32_t index_offset, uint32_t length,
+                     uint8_t* out, uint32_t& returned) {
+        returned = 0;
+        if (index_group != ADSIGRP_SYM_VALBYHND) return ams::ERR_DEVICE_INVALIDGRP;
+        Symbol* symbol = table_.by_handle(index_offset);
+        if (!symbol) return ams::ERR_DEVICE_SYMBOLNOTFOUND;
+
+        std::lock_guard<std::mutex> lock(table_.mutex);
+        returned = std::min(length, symbol->size);
+        std::memcpy(out, symbol->value.data(), returned);
+        return ams::ERR_NOERROR;
+    }
+
+    uint32_t do_write(uint32_t index_group, uint32_t index_offset, const uint8_t* data, uint32_t length) {
+        if (index_group == ADSIGRP_SYM_RELEASEHND) {
+            if (length < sizeof(uint32_t)) return ams::ERR_DEVICE_INVALIDSIZE;
+            return table_.by_handle(get<uint32_t>(data)) ? ams::ERR_NOERROR : ams::ERR_DEVICE_SYMBOLNOTFOUND;
+        }
+        if (index_group != ADSIGRP_SYM_VALBYHND) return ams::ERR_DEVICE_INVALIDGRP;
+        Symbol* symbol = table_.by_handle(index_offset);
+        if (!symbol) return ams::ERR_DEVICE_SYMBOLNOTFOUND;
+
+        std::lock_guard<std::mutex> lock(table_.mutex);
+        std::memcpy(symbol->value.data(), data, std::min(length, symbol->size));
+        symbol->version++;
+        return ams::ERR_NOERROR;
+    }
+
+    uint32_t do_read_write(uint32_t index_group, uint32_t index_offset, uint32_t read_length,
+                           const uint8_t* write_data, uint32_t write_length, std::vector<uint8_t>& out) {
+        switch (index_group) {
+            case ADSIGRP_SYM_HNDBYNAME: {
+                Symbol* symbol = table_.find(symbol_name(write_data, write_length));
+                if (!symbol) return ams::ERR_DEVICE_SYMBOLNOTFOUND;
+                put(out, symbol->handle);
+                return ams::ERR_NOERROR;
+            }
+            case ADSIGRP_SYM_INFOBYNAMEEX: {
+                Symbol* symbol = table_.find(symbol_name(write_data, write_length));
+                if (!symbol) return ams::ERR_DEVICE_SYMBOLNOTFOUND;
+                append_symbol_entry(*symbol, out);
+                return ams::ERR_NOERROR;
+            }
+            case ADSIGRP_SUMUP_READ:
+                return sumup_read(index_offset, write_data, write_length, out);
+            case ADSIGRP_SUMUP_WRITE:
+                return sumup_write(index_offset, write_data, write_length, out);
+            case ADSIGRP_SUMUP_READWRITE:
+                return sumup_read_write(index_offset, write_data, write_length, out);
+            case ADSIGRP_SUMUP_ADDDEVNOTE:
+                return sumup_add_notifications(index_offset, write_data, write_length, out);
+            case ADSIGRP_SUMUP_DELDEVNOTE:
+                return sumup_del_notifications(index_offset, write_data, write_length, out);
+            case ADSIGRP_SYM_VALBYHND: {
+                out.assign(read_length, 0);
+                uint32_t returned = 0;
+                uint32_t result = do_read(index_group, index_offset, read_length, out.data(), returned);
+                out.resize(returned);
+                return result;
+            }
+            default:
+                return ams::ERR_DEVICE_INVALIDGRP;
+        }
+    }
+
+    static std::string symbol_name(const uint8_t* data, uint32_t length) {
+        std::string name(reinterpret_cast<const char*>(data), length);
+        while (!name.empty() && name.back() == '\0') name.pop_back();
+        return name;
+    }
+
+    static void append_symbol_entry(const Symbol& symbol, std::vector<uint8_t>& out) {
+        static const char comment[] = "ads_simulator";
+        AdsSymbolEntry entry{};
+        entry.iGroup = ADSIGRP_PLC_MEMORY;
+        entry.iOffs = symbol.offset;
+        entry.size = symbol.size;
+        entry.dataType = static_cast<uint32_t>(symbol.type);
+        entry.nameLength = static_cast<uint16_t>(symbol.name.size());
+        entry.typeLength = static_cast<uint16_t>(symbol.type_name.size());
+        entry.commentLength = static_cast<uint16_t>(sizeof(comment) - 1);
+        entry.entryLength = static_cast<uint32_t>(sizeof(entry) + entry.nameLength + 1 +
+                                                  entry.typeLength + 1 + entry.commentLength + 1);
+        put(out, entry);
+        out.insert(out.end(), symbol.name.begin(), symbol.name.end());
+        out.push_back(0);
+        out.insert(out.end(), symbol.type_name.begin(), symbol.type_name.end());
+        out.push_back(0);
+        out.insert(out.end(), comment, comment + sizeof(comment));
+    }
+
+    // 0xF080: N x [ig][io][len] -> N x [result] + Werte mit fester Länge
+    uint32_t sumup_read(uint32_t count, const uint8_t* data, uint32_t size, std::vector<uint8_t>& out) {
+        if (count > ADS_SUMUP_MAX_ITEMS || size < count * 12) return ams::ERR_DEVICE_INVALIDSIZE;
+        std::vector<uint8_t> values;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* item = data + i * 12;
+            uint32_t length = get<uint32_t>(item + 8);
+            size_t pos = values.size();
+            values.resize(pos + length, 0);
+            uint32_t returned = 0;
+            put(out, do_read(get<uint32_t>(item), get<uint32_t>(item + 4), length,
+                             values.data() + pos, returned));
+        }
+        out.insert(out.end(), values.begin(), values.end());
+        return ams::ERR_NOERROR;
+    }
+
+    // 0xF081: N x [ig][io][len] + Daten -> N x [result]
+    uint32_t sumup_write(uint32_t count, const uint8_t* data, uint32_t size, std::vector<uint8_t>& out) {
+        if (count > ADS_SUMUP_MAX_ITEMS || size < count * 12) return ams::ERR_DEVICE_INVALIDSIZE;
+        const uint8_t* payload = data + count * 12;
+        const uint8_t* end = data + size;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* item = data + i * 12;
+            uint32_t length = get<uint32_t>(item + 8);
+            if (end - payload < static_cast<ptrdiff_t>(length)) return ams::ERR_DEVICE_INVALIDSIZE;
+            put(out, do_write(get<uint32_t>(item), get<uint32_t>(item + 4), payload, length));
+            payload += length;
+        }
+        return ams::ERR_NOERROR;
+    }
+
+    // 0xF082: N x [ig][io][rlen][wlen] + Daten -> N x [result][len] + Daten lückenlos
+    uint32_t sumup_read_write(uint32_t count, const uint8_t* data, uint32_t size, std::vector<uint8_t>& out) {
+        if (count > ADS_SUMUP_MAX_ITEMS || size < count * 16) return ams::ERR_DEVICE_INVALIDSIZE;
+        const uint8_t* payload = data + count * 16;
+        const uint8_t* end = data + size;
+        std::vector<uint8_t> values;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* item = data + i * 16;
+            uint32_t read_length = get<uint32_t>(item + 8);
+            uint32_t write_length = get<uint32_t>(item + 12);
+            if (end - payload < static_cast<ptrdiff_t>(write_length)) return ams::ERR_DEVICE_INVALIDSIZE;
+
+            std::vector<uint8_t> value;
+            uint32_t result = do_read_write(get<uint32_t>(item), get<uint32_t>(item + 4), read_length,
+                                            payload, write_length, value);
+            if (value.size() > read_length) value.resize(read_length);
+            put(out, result);
+            put(out, static_cast<uint32_t>(value.size()));
+            values.insert(values.end(), value.begin(), value.end());
+            payload += write_length;
+        }
+        out.insert(out.end(), values.begin(), values.end());
+        return ams::ERR_NOERROR;
+    }
+
+    // 0xF084: N x [ig][io][len][mode][maxDelay][cycle][reserved:16] -> N x [result][handle]
+    uint32_t sumup_add_notifications(uint32_t count, const uint8_t* data, uint32_t size, std::vector<uint8_t>& out) {
+        if (count > ADS_SUMUP_MAX_ITEMS || size < count * 40) return ams::ERR_DEVICE_INVALIDSIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            const uint8_t* item = data + i * 40;
+            uint32_t handle = 0;
+            put(out, do_add_notification(get<uint32_t>(item), get<uint32_t>(item + 4), get<uint32_t>(item + 8),
+                                         get<uint32_t>(item + 12), get<uint32_t>(item + 20), handle));
+            put(out, handle);
+        }
+        return ams::ERR_NOERROR;
+    }
+
+    // 0xF085: N x [handle] -> N x [result]
+    uint32_t sumup_del_notifications(uint32_t count, const uint8_t* data, uint32_t size, std::vector<uint8_t>& out) {
+        if (count > ADS_SUMUP_MAX_ITEMS || size < count * 4) return ams::ERR_DEVICE_INVALIDSIZE;
+        for (uint32_t i = 0; i < count; i++) {
+            put(out, do_del_notification(get<uint32_t>(data + i * 4)));
+        }
+        return ams::ERR_NOERROR;
+    }
+
+    uint32_t do_add_notification(uint32_t index_group, uint32_t index_offset, uint32_t length,
+                                 uint32_t trans_mode, uint32_t cycle_100ns, uint32_t& handle) {
+        handle = 0;
+        if (index_group != ADSIGRP_SYM_VALBYHND) return ams::ERR_DEVICE_INVALIDGRP;
+        Symbol* symbol = table_.by_handle(index_offset);
+        if (!symbol) return ams::ERR_DEVICE_SYMBOLNOTFOUND;
+
+        NotificationEntry entry;
+        entry.symbol = symbol;
+        entry.length = std::min(length, symbol->size);
+        entry.trans_mode = trans_mode;
+        // nCycleTime 0 = so schnell wie der PLC Task
+        uint64_t cycle_ns = cycle_100ns ? uint64_t{cycle_100ns} * 100 : uint64_t{options_.plc_cycle_us} * 1000;
+        entry.cycle_ns = std::max(cycle_ns, MIN_NOTIFICATION_PERIOD_NS);
+        entry.next_due_ns = monotonic_ns();
+
+        std::lock_guard<std::mutex> lock(notes_mutex_);
+        handle = next_notification_handle_++;
+        notes_[handle] = entry;
+        update_periods();
+        return ams::ERR_NOERROR;
+    }
+
+    uint32_t do_del_notification(uint32_t handle) {
+        std::lock_guard<std::mutex> lock(notes_mutex_);
+        if (notes_.erase(handle) == 0) return ams::ERR_DEVICE_NOTIFYHNDINVALID;
+        update_periods();
+        return ams::ERR_NOERROR;
+    }
+
+    // Effektive Perioden neu berechnen (notes_mutex_ gehalten)
+    void update_periods() {
+        uint64_t fixed_ns = 0;
+        if (options_.aggregate_hz > 0.0 && !notes_.empty()) {
+            fixed_ns = static_cast<uint64_t>(1e9 * notes_.size() / options_.aggregate_hz);
+        } else if (options_.rate_hz > 0.0) {
+            fixed_ns = static_cast<uint64_t>(1e9 / options_.rate_hz);
+        }
+        for (auto& [handle, entry] : notes_) {
+            entry.period_ns = fixed_ns ? std::max(fixed_ns, MIN_NOTIFICATION_PERIOD_NS) : entry.cycle_ns;
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Notification Stream
+    // ------------------------------------------------------------------------
+
+    void emitter_loop() {
+        std::vector<uint8_t> payload;
+        payload.reserve(MAX_NOTIFICATION_FRAME + 1024);
+
+        while (g_running.load() && !closing_.load()) {
+            uint64_t now = monotonic_ns();
+            uint64_t next_wake = now + 5000000;   // spätestens alle 5ms neue Notifications prüfen
+
+            if (have_peer_.load(std::memory_order_acquire)) {
+                std::unique_lock<std::mutex> notes_lock(notes_mutex_);
+                std::unique_lock<std::mutex> table_lock(table_.mutex);
+                int64_t timestamp = filetime_now();
+
+                // Eine Runde = ein Stamp mit allen fälligen Samples. Weitere Runden holen
+                // verpasste Perioden nach (Sleep-Granularität), wie gepufferte ADS Frames.
+                begin_stream(payload);
+                uint32_t stamps = 0;
+                uint32_t samples = 0;
+                for (uint32_t round = 0; round < MAX_CATCHUP_ROUNDS; round++) {
+                    size_t stamp_pos = payload.size();
+                    put(payload, ams::NotificationStampHeader{timestamp, 0});
+                    uint32_t stamp_samples = 0;
+                    bool any_due = false;
+
+                    for (auto& [handle, entry] : notes_) {
+                        if (entry.next_due_ns > now) continue;
+                        any_due = true;
+                        entry.next_due_ns += entry.period_ns;
+
+                        Symbol& symbol = *entry.symbol;
+                        if (entry.trans_mode == ADSTRANS_SERVERONCHA && entry.last_version == symbol.version) {
+                            continue;
+                        }
+                        entry.last_version = symbol.version;
+
+                        put(payload, ams::NotificationSampleHeader{handle, entry.length});
+                        payload.insert(payload.end(), symbol.value.begin(), symbol.value.begin() + entry.length);
+                        stamp_samples++;
+                    }
+
+                    if (stamp_samples == 0) {
+                        payload.resize(stamp_pos);
+                    } else {
+                        ams::NotificationStampHeader stamp{timestamp, stamp_samples};
+                        std::memcpy(payload.data() + stamp_pos, &stamp, sizeof(stamp));
+                        stamps++;
+                        samples += stamp_samples;
+                    }
+                    if (!any_due) break;
+
+                    if (payload.size() >= MAX_NOTIFICATION_FRAME) {
+                        flush_stream(payload, stamps, samples);
+                        begin_stream(payload);
+                        stamps = 0;
+                        samples = 0;
+                    }
+                }
+
+                // Immer noch hinterher -> Takt neu aufsetzen statt endlos nachzuholen
+                for (auto& [handle, entry] : notes_) {
+                    if (entry.next_due_ns <= now) {
+                        stats_.late.fetch_add(1, std::memory_order_relaxed);
+                        entry.next_due_ns = now + entry.period_ns;
+                    }
+                    next_wake = std::min(next_wake, entry.next_due_ns);
+                }
+                table_lock.unlock();
+                notes_lock.unlock();
+
+                if (stamps > 0) {
+                    flush_stream(payload, stamps, samples);
+                }
+            }
+
+            if (next_wake > monotonic_ns()) {
+                sleep_until_ns(next_wake);
+            }
+        }
+    }
+
+    // [length][stamps] - wird in flush_stream() gesetzt, danach folgen die Stamps
+    static void begin_stream(std::vector<uint8_t>& payload) {
+        payload.clear();
+        put(payload, ams::NotificationStreamHeader{0, 0});
+    }
+
+    void flush_stream(std::vector<uint8_t>& payload, uint32_t stamps, uint32_t samples) {
+        if (options_.jitter_us > 0) {
+            uint64_t delay_ns = static_cast<uint64_t>(random_.uniform() * options_.jitter_us * 1000.0);
+            sleep_until_ns(monotonic_ns() + delay_ns);
+        }
+
+        ams::NotificationStreamHeader stream{static_cast<uint32_t>(payload.size() - sizeof(uint32_t)), stamps};
+        std::memcpy(payload.data(), &stream, sizeof(stream));
+
+        send_frame(peer_net_id_, peer_port_, own_net_id_, own_port_,
+                   static_cast<uint16_t>(ams::Command::Notification), ams::STATE_FLAGS_REQUEST,
+                   0, payload);
+
+        stats_.samples.fetch_add(samples, std::memory_order_relaxed);
+        stats_.frames.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void send_frame(const ams::NetId& target, uint16_t target_port,
+                    const ams::NetId& source, uint16_t source_port,
+                    uint16_t command, uint16_t state_flags, uint32_t invoke_id,
+                    const std::vector<uint8_t>& payload) {
+        ams::Header header{};
+        header.target_net_id = target;
+        header.target_port = target_port;
+        header.source_net_id = source;
+        header.source_port = source_port;
+        header.command_id = command;
+        header.state_flags = state_flags;
+        header.data_length = static_cast<uint32_t>(payload.size());
+        header.invoke_id = invoke_id;
+        ams::TcpHeader tcp{0, static_cast<uint32_t>(sizeof(header) + payload.size())};
+
+        iovec iov[3] = {
+            {&tcp, sizeof(tcp)},
+            {&header, sizeof(header)},
+            {const_cast<uint8_t*>(payload.data()), payload.size()}
+        };
+
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!send_all(iov, payload.empty() ? 2 : 3)) {
+            closing_.store(true);
+            return;
+        }
+        stats_.bytes.fetch_add(sizeof(tcp) + sizeof(header) + payload.size(), std::memory_order_relaxed);
+    }
+
+    // Blockierendes Senden eines kompletten Frames (Backpressure wie bei echter PLC)
+    bool send_all(iovec* iov, int count) {
+        while (count > 0) {
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = static_cast<size_t>(count);
+            ssize_t sent = ::sendmsg(fd_, &msg, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            size_t remaining = static_cast<size_t>(sent);
+            while (count > 0 && remaining >= iov->iov_len) {
+                remaining -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + remaining;
+                iov->iov_len -= remaining;
+            }
+        }
+        return true;
+    }
+
+    int fd_;
+    SymbolTable& table_;
+    const Options& options_;
+    SimStats& stats_;
+    FastRandom random_;
+    uint64_t disconnect_at_ns_ = 0;
+
+    std::thread reader_;
+    std::thread emitter_;
+    std::atomic<bool> closing_{false};
+
+    std::mutex send_mutex_;
+    std::atomic<bool> have_peer_{false};
+    ams::NetId peer_net_id_{};
+    uint16_t peer_port_ = 0;
+    ams::NetId own_net_id_{};
+    uint16_t own_port_ = 0;
+
+    std::mutex notes_mutex_;
+    std::unordered_map<uint32_t, NotificationEntry> notes_;
+    uint32_t next_notification_handle_ = NOTIFICATION_HANDLE_BASE;
+};
+
+// ============================================================================
+// Setup
+// ============================================================================
+
+bool load_symbols(const Options& options, SymbolTable& table) {
+    for (const auto& spec : options.symbol_specs) {
+        // NAME:TYPE[:SIZE]
+        std::stringstream ss(spec);
+        std::string name, type = "DINT", size;
+        std::getline(ss, name, ':');
+        std::getline(ss, type, ':');
+        std::getline(ss, size, ':');
+        if (!table.add(name, type, static_cast<uint32_t>(std::strtoul(size.c_str(), nullptr, 10)))) {
+            return false;
+        }
+    }
+
+    if (!options.symbol_file.empty()) {
+        std::ifstream file(options.symbol_file);
+        if (!file) {
+            std::cerr << "[SIM] ERROR: " << options.symbol_file << " nicht lesbar\n";
+            return false;
+        }
+        // "name, type, size" oder "var_1 = name, type, size" (config.ini [variables])
+        std::string line;
+        while (std::getline(file, line)) {
+            auto comment = line.find_first_of("#;");
+            if (comment != std::string::npos) line = line.substr(0, comment);
+            auto eq = line.find('=');
+            if (eq != std::string::npos) line = line.substr(eq + 1);
+            line = trim(line);
+            if (line.empty() || line.front() == '[') continue;
+
+            std::stringstream ss(line);
+            std::string name, type, size;
+            std::getline(ss, name, ',');
+            std::getline(ss, type, ',');
+            std::getline(ss, size, ',');
+            type = trim(type);
+            if (!table.add(trim(name), type.empty() ? "DINT" : type,
+                           static_cast<uint32_t>(std::strtoul(trim(size).c_str(), nullptr, 10)))) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < options.generated_symbols; i++) {
+        if (!table.add(options.generated_prefix + std::to_string(i), options.generated_type,
+                       options.generated_size)) {
+            return false;
+        }
+    }
+    return table.size() > 0;
+}
+
+void print_usage() {
+    std::cout << "Usage: ads_simulator [Optionen]\n"
+              << "  --bind IP              Listen-Adresse (Default 127.0.0.1)\n"
+              << "  --port N               AMS/TCP Port (Default 48898)\n"
+              << "  --symbol NAME:TYPE[:SIZE]  Einzelnes Symbol (mehrfach möglich)\n"
+              << "  --symbol-file PATH     Symbolliste (name, type, size)\n"
+              << "  --symbols N            N generierte Symbole <prefix><i>\n"
+              << "  --prefix NAME          Prefix generierter Symbole (Default GVL.sim)\n"
+              << "  --type TYPE            Typ generierter Symbole (Default DINT)\n"
+              << "  --size BYTES           Größe für STRING/ARRAY/Strukturen\n"
+              << "  --rate HZ              Feste Rate pro Notification (statt nCycleTime)\n"
+              << "  --aggregate-hz HZ      Gesamtrate pro Verbindung (1 .. 100000+)\n"
+              << "  --plc-cycle-us US      PLC Task Zyklus für Wertänderungen (Default 1000)\n"
+              << "  --change-ratio R       Anteil geänderter Symbole pro Zyklus (Default 0.1)\n"
+              << "  --jitter-us US         Zufällige Verzögerung je Notification Frame\n"
+              << "  --disconnect-every S   Verbindung nach ~S Sekunden trennen\n"
+              << "  --stats-ms MS          Statistik-Intervall (Default 1000)\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "[SIM] ERROR: " << arg << " erwartet einen Wert\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--bind") options.bind_address = value();
+        else if (arg == "--port") options.port = static_cast<uint16_t>(std::stoul(value()));
+        else if (arg == "--symbol") options.symbol_specs.push_back(value());
+        else if (arg == "--symbol-file") options.symbol_file = value();
+        else if (arg == "--symbols") options.generated_symbols = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--prefix") options.generated_prefix = value();
+        else if (arg == "--type") options.generated_type = value();
+        else if (arg == "--size") options.generated_size = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--rate") options.rate_hz = std::stod(value());
+        else if (arg == "--aggregate-hz") options.aggregate_hz = std::stod(value());
+        else if (arg == "--plc-cycle-us") options.plc_cycle_us = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--change-ratio") options.change_ratio = std::stod(value());
+        else if (arg == "--jitter-us") options.jitter_us = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--disconnect-every") options.disconnect_every_s = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--stats-ms") options.stats_interval_ms = static_cast<uint32_t>(std::stoul(value()));
+        else {
+            print_usage();
+            return false;
+        }
+    }
+    if (options.symbol_specs.empty() && options.symbol_file.empty() && options.generated_symbols == 0) {
+        options.generated_symbols = 100;
+    }
+    if (options.plc_cycle_us == 0) options.plc_cycle_us = 1000;
+    return true;
+}
+
+int listen_socket(const Options& options) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.bind_address.c_str(), &addr.sin_addr) != 1 ||
+        ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 16) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace sim
+
+void signal_handler(int) {
+    sim::g_running.store(false);
+}
+
+int main(int argc, char* argv[]) {
+    using namespace sim;
+
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    SymbolTable table;
+    if (!load_symbols(options, table)) {
+        std::cerr << "[SIM] ERROR: Keine gültigen Symbole\n";
+        return 1;
+    }
+
+    int listen_fd = listen_socket(options);
+    if (listen_fd < 0) {
+        std::cerr << "[SIM] ERROR: Kann " << options.bind_address << ":" << options.port
+                  << " nicht öffnen: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    std::cout << "=== ADS/AMS Simulator ===\n";
+    std::cout << "[SIM] Lausche auf " << options.bind_address << ":" << options.port << "\n";
+    std::cout << "[SIM] Symbole: " << table.size() << " (z.B. " << table.symbols().front().name
+              << " : " << table.symbols().front().type_name << ")\n";
+    if (options.aggregate_hz > 0.0) {
+        std::cout << "[SIM] Notification Rate: " << options.aggregate_hz << " Hz gesamt pro Verbindung\n";
+    } else if (options.rate_hz > 0.0) {
+        std::cout << "[SIM] Notification Rate: " << options.rate_hz << " Hz pro Notification\n";
+    } else {
+        std::cout << "[SIM] Notification Rate: nCycleTime des Clients\n";
+    }
+    if (options.jitter_us > 0) std::cout << "[SIM] Jitter: bis " << options.jitter_us << "µs pro Frame\n";
+    if (options.disconnect_every_s > 0) std::cout << "[SIM] Disconnect alle ~" << options.disconnect_every_s << "s\n";
+
+    SimStats stats;
+
+    // PLC Task: Werte zyklisch ändern
+    std::thread plc_thread([&]() {
+        FastRandom random(monotonic_ns());
+        uint64_t next = monotonic_ns();
+        while (g_running.load()) {
+            table.update(random, options.change_ratio);
+            next += uint64_t{options.plc_cycle_us} * 1000;
+            uint64_t now = monotonic_ns();
+            if (next < now) next = now;
+            sleep_until_ns(next);
+        }
+    });
+
+    std::list<std::unique_ptr<ClientSession>> sessions;
+    std::mutex sessions_mutex;
+
+    // Statistik
+    std::thread stats_thread([&]() {
+        uint64_t last_samples = 0, last_frames = 0, last_bytes = 0;
+        uint64_t last_time = monotonic_ns();
+        while (g_running.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.stats_interval_ms));
+            uint64_t now = monotonic_ns();
+            double seconds = (now - last_time) / 1e9;
+            uint64_t samples = stats.samples.load(), frames = stats.frames.load(), bytes = stats.bytes.load();
+
+            size_t clients = 0, notifications = 0;
+            {
+                std::lock_guard<std::mutex> lock(sessions_mutex);
+                for (auto& session : sessions) {
+                    if (session->finished()) continue;
+                    clients++;
+                    notifications += session->notification_count();
+                }
+            }
+
+            std::cout << "[SIM] Clients: " << clients
+                      << " | Notifications: " << notifications
+                      << " | Samples/s: " << static_cast<uint64_t>((samples - last_samples) / seconds)
+                      << " | Frames/s: " << static_cast<uint64_t>((frames - last_frames) / seconds)
+                      << " | KB/s: " << static_cast<uint64_t>((bytes - last_bytes) / seconds / 1024)
+                      << " | Requests: " << stats.requests.load()
+                      << " | Late: " << stats.late.load()
+                      << " | Disconnects: " << stats.disconnects.load() << "\n";
+
+            last_samples = samples;
+            last_frames = frames;
+            last_bytes = bytes;
+            last_time = now;
+        }
+    });
+
+    // Accept Loop
+    uint64_t connection_seed = 1;
+    while (g_running.load()) {
+        pollfd pfd{listen_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, 200) > 0) {
+            int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                std::cout << "[SIM] Client verbunden\n";
+                std::lock_guard<std::mutex> lock(sessions_mutex);
+                sessions.push_back(std::make_unique<ClientSession>(
+                    fd, table, options, stats, monotonic_ns() ^ (connection_seed++ << 32)));
+            }
+        }
+
+        // Beendete Verbindungen aufräumen
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            if ((*it)->finished()) {
+                it = sessions.erase(it);
+                std::cout << "[SIM] Client getrennt\n";
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    std::cout << "\n[SIM] Beende...\n";
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        sessions.clear();
+    }
+    ::close(listen_fd);
+    plc_thread.join();
+    stats_thread.join();
+    return 0;
+}
+
+#else
+int main() {
+    std::cout << "ads_simulator ist Linux-only (POSIX Sockets, clock_nanosleep)." << std::endl;
+    return 1;
+}
+#endif
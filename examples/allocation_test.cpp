@@ -0,0 +1,507 @@
+#include "../include/ads_realtime_engine.hpp"
+#include "../include/mqtt_client.hpp"
+#include "../include/variable_batch.hpp"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Allokations-Test für den Notification-Pfad
+//
+// Ein eingebetteter Mini-AMS-Server streamt Notifications an eine echte
+// AdsRealtimeEngine (AMS/TCP Client -> Ring -> Dispatcher -> Callback). Der
+// Callback formatiert wie main.cpp in einen Pool-Puffer und übergibt ihn dem
+// nativen MqttClient (Queue -> Flush Thread -> writev), der gegen einen
+// Mini-Broker auf Loopback publiziert (QoS 0 und QoS 1 mit PUBACK). Nach dem
+// Warmup wird jede globale new/delete-Allokation gezählt - erwartet werden 0
+// Allokationen im eingeschwungenen Zustand.
+//
+// Zweiter Teil: VariableBatch mit 10k Samples/s - Producer-Thread füllt,
+// Flusher-Thread serialisiert die übergebenen Puffer in einen Sende-Puffer.
+
+using namespace ads_realtime;
+
+// ============================================================================
+// Allokationszähler (globale operator new/delete)
+// ============================================================================
+
+static std::atomic<bool> g_counting{false};
+static std::atomic<uint64_t> g_allocations{0};
+
+static void* counted_alloc(size_t size) {
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+static void* counted_alloc_aligned(size_t size, std::align_val_t alignment) {
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    size_t align = static_cast<size_t>(alignment);
+    void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void* operator new(size_t size, std::align_val_t a) { return counted_alloc_aligned(size, a); }
+void* operator new[](size_t size, std::align_val_t a) { return counted_alloc_aligned(size, a); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// ============================================================================
+// Mini-AMS-Server: ein DINT Symbol, Notifications im 100µs Takt
+// ============================================================================
+
+class MiniAmsServer {
+public:
+    static constexpr uint32_t SYMBOL_HANDLE = 0x10000;
+    static constexpr uint32_t NOTIFICATION_HANDLE = 0x1000;
+
+    bool start() {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;   // freier Port
+        socklen_t len = sizeof(addr);
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, 1) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread(&MiniAmsServer::serve, this);
+        return true;
+    }
+
+    void stop() {
+        running_.store(false);
+        if (client_fd_ >= 0) ::shutdown(client_fd_, SHUT_RDWR);
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        if (streamer_.joinable()) streamer_.join();
+        if (thread_.joinable()) thread_.join();
+        if (client_fd_ >= 0) ::close(client_fd_);
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+    uint64_t samples_sent() const { return samples_sent_.load(); }
+
+private:
+    void serve() {
+        client_fd_ = ::accept(listen_fd_, nullptr, nullptr);
+        if (client_fd_ < 0) return;
+
+        std::vector<uint8_t> buffer(64 * 1024);
+        size_t size = 0;
+        while (running_.load()) {
+            ssize_t n = ::recv(client_fd_, buffer.data() + size, buffer.size() - size, 0);
+            if (n <= 0) break;
+            size += static_cast<size_t>(n);
+
+            size_t offset = 0;
+            while (size - offset >= ams::FRAME_HEADER_SIZE) {
+                ams::TcpHeader tcp;
+                std::memcpy(&tcp, buffer.data() + offset, sizeof(tcp));
+                if (size - offset < sizeof(tcp) + tcp.length) break;
+                ams::Header header;
+                std::memcpy(&header, buffer.data() + offset + sizeof(tcp), sizeof(header));
+                handle(header, buffer.data() + offset + ams::FRAME_HEADER_SIZE);
+                offset += sizeof(tcp) + tcp.length;
+            }
+            std::memmove(buffer.data(), buffer.data() + offset, size - offset);
+            size -= offset;
+        }
+    }
+
+    void handle(const ams::Header& request, const uint8_t* data) {
+        std::vector<uint8_t> out;
+        auto put = [&out](const auto& v) {
+            const uint8_t* b = reinterpret_cast<const uint8_t*>(&v);
+            out.insert(out.end(), b, b + sizeof(v));
+        };
+
+        switch (static_cast<ams::Command>(request.command_id)) {
+            case ams::Command::ReadWrite: {
+                ams::ReadWriteRequest rw;
+                std::memcpy(&rw, data, sizeof(rw));
+                if (rw.index_group == 0xF003) {            // HNDBYNAME
+                    put(uint32_t{0}); put(uint32_t{4}); put(SYMBOL_HANDLE);
+                } else if (rw.index_group == 0xF009) {     // INFOBYNAMEEX
+                    AdsSymbolEntry entry{};
+                    entry.entryLength = sizeof(entry) + 3;
+                    entry.size = 4;
+                    entry.dataType = static_cast<uint32_t>(ams::DataType::Int32);
+                    put(uint32_t{0}); put(uint32_t{sizeof(entry) + 3}); put(entry);
+                    out.insert(out.end(), 3, 0);
+                } else {                                   // Sum-Up etc. -> nicht unterstützt
+                    put(ams::ERR_DEVICE_SRVNOTSUPP); put(uint32_t{0});
+                }
+                break;
+            }
+            case ams::Command::AddNotification:
+                put(uint32_t{0}); put(NOTIFICATION_HANDLE);
+                if (!streamer_.joinable()) {
+                    streamer_ = std::thread(&MiniAmsServer::stream, this, request);
+                }
+                break;
+            default:
+                put(uint32_t{0});
+                break;
+        }
+        send_frame(request, request.command_id, ams::STATE_FLAGS_RESPONSE, request.invoke_id, out);
+    }
+
+    // Notification Frames in einem festen Puffer - der Server selbst allokiert nicht
+    void stream(ams::Header request) {
+        constexpr size_t PAYLOAD = sizeof(ams::NotificationStreamHeader) + sizeof(ams::NotificationStampHeader) +
+                                   sizeof(ams::NotificationSampleHeader) + sizeof(int32_t);
+        std::vector<uint8_t> payload(PAYLOAD);
+        ams::NotificationStreamHeader stream{static_cast<uint32_t>(PAYLOAD - sizeof(uint32_t)), 1};
+        ams::NotificationSampleHeader sample{NOTIFICATION_HANDLE, sizeof(int32_t)};
+        std::memcpy(payload.data(), &stream, sizeof(stream));
+        std::memcpy(payload.data() + sizeof(stream) + sizeof(ams::NotificationStampHeader), &sample, sizeof(sample));
+
+        int32_t value = 0;
+        while (running_.load()) {
+            ams::NotificationStampHeader stamp{133000000000000000LL + value, 1};
+            std::memcpy(payload.data() + sizeof(stream), &stamp, sizeof(stamp));
+            std::memcpy(payload.data() + PAYLOAD - sizeof(value), &value, sizeof(value));
+            value++;
+            send_frame(request, static_cast<uint16_t>(ams::Command::Notification),
+                       ams::STATE_FLAGS_REQUEST, 0, payload);
+            samples_sent_.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    void send_frame(const ams::Header& request, uint16_t command, uint16_t flags,
+                    uint32_t invoke_id, const std::vector<uint8_t>& payload) {
+        uint8_t frame[ams::FRAME_HEADER_SIZE + 256];
+        ams::TcpHeader tcp{0, static_cast<uint32_t>(sizeof(ams::Header) + payload.size())};
+        ams::Header header = request;
+        header.target_net_id = request.source_net_id;
+        header.target_port = request.source_port;
+        header.source_net_id = request.target_net_id;
+        header.source_port = request.target_port;
+        header.command_id = command;
+        header.state_flags = flags;
+        header.data_length = static_cast<uint32_t>(payload.size());
+        header.error_code = 0;
+        header.invoke_id = invoke_id;
+        std::memcpy(frame, &tcp, sizeof(tcp));
+        std::memcpy(frame + sizeof(tcp), &header, sizeof(header));
+        std::memcpy(frame + ams::FRAME_HEADER_SIZE, payload.data(), payload.size());
+
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        ::send(client_fd_, frame, ams::FRAME_HEADER_SIZE + payload.size(), MSG_NOSIGNAL);
+    }
+
+    int listen_fd_ = -1;
+    int client_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{true};
+    std::thread thread_;
+    std::thread streamer_;
+    std::mutex send_mutex_;
+    std::atomic<uint64_t> samples_sent_{0};
+};
+
+// ============================================================================
+// Mini-Broker: CONNACK, PUBACK (QoS 1), PINGRESP - zählt PUBLISH Pakete
+// ============================================================================
+
+class MiniBroker {
+public:
+    bool start() {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;   // freier Port
+        socklen_t len = sizeof(addr);
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, 1) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread(&MiniBroker::serve, this);
+        return true;
+    }
+
+    void stop() {
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        if (thread_.joinable()) thread_.join();
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+    uint64_t publishes() const { return publishes_.load(); }
+
+private:
+    // Fester Empfangspuffer - der Broker selbst allokiert nicht
+    void serve() {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) return;
+
+        static uint8_t buffer[256 * 1024];
+        size_t size = 0;
+        for (;;) {
+            ssize_t n = ::recv(fd, buffer + size, sizeof(buffer) - size, 0);
+            if (n <= 0) break;
+            size += static_cast<size_t>(n);
+
+            size_t offset = 0;
+            while (size - offset >= 2) {
+                uint32_t remaining = 0;
+                size_t length_bytes = 0;
+                uint32_t multiplier = 1;
+                bool complete = false;
+                while (offset + 1 + length_bytes < size && length_bytes < 4) {
+                    uint8_t byte = buffer[offset + 1 + length_bytes++];
+                    remaining += (byte & 0x7F) * multiplier;
+                    multiplier *= 128;
+                    if (!(byte & 0x80)) {
+                        complete = true;
+                        break;
+                    }
+                }
+                if (!complete || size - offset < 1 + length_bytes + remaining) break;
+                handle(fd, buffer[offset], buffer + offset + 1 + length_bytes, remaining);
+                offset += 1 + length_bytes + remaining;
+            }
+            std::memmove(buffer, buffer + offset, size - offset);
+            size -= offset;
+        }
+        ::close(fd);
+    }
+
+    void handle(int fd, uint8_t type, const uint8_t* body, uint32_t length) {
+        switch (type >> 4) {
+            case 1: {                                      // CONNECT -> CONNACK
+                const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+                ::send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+                break;
+            }
+            case 3: {                                      // PUBLISH (QoS 1 -> PUBACK)
+                publishes_.fetch_add(1, std::memory_order_relaxed);
+                if ((type & 0x06) != 0 && length >= 2) {
+                    size_t topic = (static_cast<size_t>(body[0]) << 8) | body[1];
+                    if (length >= 2 + topic + 2) {
+                        const uint8_t puback[] = {0x40, 0x02, body[2 + topic], body[3 + topic]};
+                        ::send(fd, puback, sizeof(puback), MSG_NOSIGNAL);
+                    }
+                }
+                break;
+            }
+            case 12: {                                     // PINGREQ -> PINGRESP
+                const uint8_t pingresp[] = {0xD0, 0x00};
+                ::send(fd, pingresp, sizeof(pingresp), MSG_NOSIGNAL);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<uint64_t> publishes_{0};
+};
+
+// ============================================================================
+
+static int notification_test(uint8_t qos) {
+    std::cout << "=== Allocation Test: ADS Notification -> MqttClient (QoS " << static_cast<int>(qos)
+              << ") ===\n";
+
+    MiniAmsServer server;
+    MiniBroker broker;
+    if (!server.start() || !broker.start()) {
+        std::cerr << "Mini-AMS-Server bzw. Mini-Broker konnte nicht starten\n";
+        return 1;
+    }
+
+    RealtimeConfig config;
+    config.ads_target_ip = "127.0.0.1";
+    config.ams_tcp_port = server.port();
+    config.notification_queue_capacity = 4096;
+    config.mqtt_broker = "127.0.0.1";
+    config.mqtt_port = broker.port();
+    config.mqtt_client_id = "allocation-test";
+    config.mqtt_qos = qos;
+
+    MqttClient::Pool pool(1024);
+    std::atomic<uint64_t> published{0};
+    int result = 0;
+
+    {
+        AdsRealtimeEngine engine(config);
+        MqttClient client(config, pool);
+        if (!engine.connect() || !client.connect()) {
+            return 1;
+        }
+
+        // Callback wie in main.cpp: Pool-Puffer, Typ-Decoder, an den nativen Client übergeben
+        engine.add_variable("GVL.counter", [&](uint32_t variable_id, const void* data,
+                                               size_t data_size, uint64_t timestamp) {
+            MqttClient::Message* message = pool.acquire();
+            if (!message) return;
+            size_t length = 0;
+            engine.variable_decoder(variable_id).to_text(data, data_size, reinterpret_cast<char*>(message->data),
+                                                         sizeof(message->data), length);
+            message->length = static_cast<uint32_t>(length);
+            message->variable_id = variable_id;
+            message->timestamp = timestamp;
+            client.enqueue(message);
+            published.fetch_add(1, std::memory_order_relaxed);
+        });
+        for (uint32_t id = 0; id < engine.variable_count(); id++) {
+            client.register_topic(id, engine.variable_topic(id));
+        }
+        engine.start();
+
+        // Warmup: Thread-lokale Initialisierung, Puffer-Wachstum, erste Wakeups
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+        uint64_t start_published = published.load();
+        uint64_t start_received = broker.publishes();
+        g_allocations.store(0);
+        g_counting.store(true);
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        g_counting.store(false);
+        uint64_t allocations = g_allocations.load();
+        uint64_t samples = published.load() - start_published;
+        uint64_t received = broker.publishes() - start_received;
+
+        engine.stop();
+        PublisherStats stats;
+        LatencySnapshot flush_latency;
+        client.add_stats(stats, flush_latency);
+        client.disconnect();
+
+        std::cout << "Samples im Messfenster: " << samples << " (Broker: " << received << " PUBLISH, "
+                  << stats.flushes << " Batches, " << stats.errors << " Fehler)\n";
+        std::cout << "Heap-Allokationen:      " << allocations << "\n";
+
+        if (samples == 0 || received == 0) {
+            std::cout << "❌ Keine Samples beim Broker angekommen\n";
+            result = 1;
+        } else if (allocations != 0) {
+            std::cout << "❌ Notification-Pfad allokiert ("
+                      << static_cast<double>(allocations) / samples << " pro Sample)\n";
+            result = 1;
+        } else {
+            std::cout << "✅ Keine Allokation vom ADS Frame bis zum writev() an den Broker\n";
+        }
+    }
+
+    server.stop();
+    broker.stop();
+    return result;
+}
+
+// ============================================================================
+// VariableBatch: Producer (10k Samples/s) -> swap() -> Flusher -> Sende-Puffer
+// ============================================================================
+
+static int batch_test() {
+    std::cout << "\n=== Allocation Test: VariableBatch (10k Samples/s) ===\n";
+
+    VariableBatch batch(100, std::chrono::milliseconds(10));
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> flushed{0};
+
+    std::thread flusher([&]() {
+        std::vector<uint8_t> wire(64 * 1024);      // Sende-Puffer, einmal allokiert
+        while (running.load(std::memory_order_relaxed)) {
+            if (batch.serialize_ready(wire.data(), wire.size()) > 0) {
+                flushed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+    });
+
+    uint64_t samples = 0;
+    int32_t value = 0;
+    auto produce = [&](std::chrono::milliseconds duration) {
+        auto next = std::chrono::steady_clock::now();
+        auto end = next + duration;
+        while (next < end) {
+            value++;
+            if (batch.add_variable("GVL.Axis[1].ActualPosition", &value, sizeof(value))) {
+                batch.swap();
+            }
+            samples++;
+            next += std::chrono::microseconds(100);
+            std::this_thread::sleep_until(next);
+        }
+    };
+
+    produce(std::chrono::milliseconds(200));       // Warmup
+    uint64_t start_samples = samples;
+    uint64_t start_flushed = flushed.load();
+    g_allocations.store(0);
+    g_counting.store(true);
+    produce(std::chrono::seconds(1));
+    g_counting.store(false);
+    uint64_t allocations = g_allocations.load();
+    running.store(false);
+    flusher.join();
+
+    uint64_t measured = samples - start_samples;
+    std::cout << "Samples im Messfenster: " << measured << " (" << flushed.load() - start_flushed
+              << " Batches, " << batch.dropped() << " verworfen)\n";
+    std::cout << "Heap-Allokationen:      " << allocations << "\n";
+
+    if (measured == 0 || flushed.load() == start_flushed) {
+        std::cout << "❌ Keine Batches serialisiert\n";
+        return 1;
+    }
+    if (allocations != 0) {
+        std::cout << "❌ Batching allokiert (" << static_cast<double>(allocations) / measured
+                  << " pro Sample)\n";
+        return 1;
+    }
+    std::cout << "✅ Keine Allokation vom add_variable() bis zum Sende-Puffer\n";
+    return 0;
+}
+
+int main() {
+    int result = notification_test(0);
+    std::cout << "\n";
+    result |= notification_test(1);
+    return batch_test() != 0 ? 1 : result;
+}
+
+#else
+int main() {
+    std::cout << "allocation_test benötigt den AMS/TCP Client (Linux)." << std::endl;
+    return 1;
+}
+#endif
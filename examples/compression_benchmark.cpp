@@ -0,0 +1,430 @@
+#include "../include/binary_payload.hpp"
+#include "../include/compressed_payload.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compression Benchmark
+//
+// Spielt Payload-Korpora durch alle Codecs und prüft jeden Round-Trip.
+// Synthetische Korpora: --batches Batch-Payloads mit je --variables
+// Variablen, 1 ms Zyklus (ein Sample pro Variable und Batch):
+//   bool arrays   - ARRAY[0..63] OF BOOL, selten wechselnde Bits
+//   real ramps    - REAL Rampen (Sollwertgeneratoren)
+//   noisy analog  - REAL Sinus + Rauschen (Messwerte)
+//   strings       - STRING(80) Statusmeldungen (Rest mit 0 aufgefüllt)
+//   structs       - 48 Byte Achs-Struktur (REAL/LREAL/DINT/BOOL gemischt)
+// --corpus DATEI lädt aufgezeichnete Payloads ([uint32 Länge][Bytes] pro
+// Eintrag, sonst die ganze Datei als ein Payload).
+//
+// Codecs: RLE, Dictionary (Legacy, ein Durchlauf), LZ, LZ Stream (Historie
+// über die Payloads eines Korpus), auto (compress_auto), adaptive
+// (AdaptiveCompressor), Gorilla (nur numerische Korpora - dieselben Samples
+// statt der Batch-Bytes). Ausgabe: Ratio (Batch-Bytes / komprimiert), ns pro
+// Original-Byte für Compress und Decompress, Round-Trip. Exit-Code 1 bei
+// einem Round-Trip Fehler.
+//
+// Beispiel:
+//   ./compression_benchmark --variables 50 --batches 200 --repeat 5
+
+using namespace ads_realtime;
+
+struct Options {
+    size_t variables = 50;
+    size_t batches = 200;
+    size_t repeat = 3;
+    std::vector<std::string> corpora;
+};
+
+struct Corpus {
+    std::string name;
+    std::vector<std::vector<uint8_t>> payloads;         // Batch-Payloads (bzw. aufgezeichnet)
+    PayloadSchema schema;                               // Gorilla: ID -> Typ
+    std::vector<std::vector<ColumnarEntry>> samples;    // pro Payload, leer = Gorilla nicht anwendbar
+    std::vector<uint8_t> values;                        // Werte der Samples
+
+    size_t bytes() const {
+        size_t total = 0;
+        for (const auto& payload : payloads) total += payload.size();
+        return total;
+    }
+};
+
+struct Result {
+    bool applicable = true;
+    size_t compressed = 0;
+    double compress_ns = 0;        // pro Original-Byte
+    double decompress_ns = 0;
+    bool ok = true;
+    std::string note;
+};
+
+// Byte-Codec: begin() vor jedem Durchlauf (Zustand zurücksetzen), komprimiert = [Method][Daten]
+struct ByteCodec {
+    const char* name;
+    size_t passes;
+    std::function<void()> begin;
+    std::function<void(const std::vector<uint8_t>&, std::vector<uint8_t>&)> compress;
+    std::function<bool(const std::vector<uint8_t>&, std::vector<uint8_t>&)> decompress;
+};
+
+// Synthetischer Korpus: value(batch, variable, out) erzeugt den Wert (value_size Bytes)
+static Corpus make_corpus(const std::string& name, const char* suffix, AdsDataType type, size_t value_size,
+                          bool numeric, const Options& options,
+                          const std::function<void(size_t, size_t, uint8_t*)>& value) {
+    Corpus corpus;
+    corpus.name = name;
+    std::vector<std::string> names;
+    for (size_t v = 0; v < options.variables; v++) {
+        names.push_back("GVL_Plant.Line" + std::to_string(v / 10) + ".Axis[" + std::to_string(v % 10) + "]." + suffix);
+        corpus.schema.set(static_cast<uint16_t>(v), names.back(), type, value_size);
+    }
+
+    corpus.values.resize(options.batches * options.variables * value_size);
+    BinaryPayloadBuilder builder;
+    std::vector<PayloadEntry> entries(options.variables);
+    const uint64_t start_us = 1700000000000000ULL;
+    for (size_t b = 0; b < options.batches; b++) {
+        std::vector<ColumnarEntry> samples;
+        for (size_t v = 0; v < options.variables; v++) {
+            uint8_t* data = corpus.values.data() + (b * options.variables + v) * value_size;
+            value(b, v, data);
+            entries[v] = PayloadEntry{names[v], type, data, value_size};
+            samples.push_back(ColumnarEntry{static_cast<uint16_t>(v), start_us + 1000 * b, data, value_size});
+        }
+        std::vector<uint8_t> payload(BinaryPayloadBuilder::batch_size(entries));
+        payload.resize(builder.encode_batch(payload.data(), payload.size(), entries));
+        corpus.payloads.push_back(std::move(payload));
+        if (numeric) corpus.samples.push_back(std::move(samples));
+    }
+    return corpus;
+}
+
+static std::vector<Corpus> make_corpora(const Options& options) {
+    std::vector<Corpus> corpora;
+    std::mt19937 rng(42);
+
+    std::vector<uint64_t> bits(options.variables);
+    corpora.push_back(make_corpus("bool arrays", "Inputs", AdsDataType::Custom, 64, false, options,
+        [&](size_t, size_t v, uint8_t* out) {
+            if (rng() % 8 == 0) bits[v] ^= uint64_t(1) << (rng() % 64);
+            for (size_t i = 0; i < 64; i++) out[i] = (bits[v] >> i) & 1;
+        }));
+
+    corpora.push_back(make_corpus("real ramps", "Setpoint", AdsDataType::Real32, 4, true, options,
+        [](size_t b, size_t v, uint8_t* out) {
+            float value = static_cast<float>(v * 10) + 0.25f * static_cast<float>(b % 400);
+            std::memcpy(out, &value, sizeof(value));
+        }));
+
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    corpora.push_back(make_corpus("noisy analog", "Current", AdsDataType::Real32, 4, true, options,
+        [&](size_t b, size_t v, uint8_t* out) {
+            float value = 12.0f + 3.0f * std::sin(0.002f * static_cast<float>(b) * static_cast<float>(v + 1)) + noise(rng);
+            std::memcpy(out, &value, sizeof(value));
+        }));
+
+    static const char* messages[] = {"Automatik", "Referenzfahrt aktiv", "Stoerung Achse %zu: Schleppfehler",
+                                     "Warte auf Freigabe", "Position %zu erreicht"};
+    corpora.push_back(make_corpus("strings", "Status", AdsDataType::String, 81, false, options,
+        [&](size_t b, size_t v, uint8_t* out) {
+            std::memset(out, 0, 81);
+            std::snprintf(reinterpret_cast<char*>(out), 81, messages[(b / 50 + v) % 5], v + b / 100);
+        }));
+
+    corpora.push_back(make_corpus("structs", "Data", AdsDataType::Custom, 48, false, options,
+        [](size_t b, size_t v, uint8_t* out) {
+            std::memset(out, 0, 48);
+            float position = static_cast<float>(v) * 100.0f + 0.1f * static_cast<float>(b);
+            float velocity = 0.1f;
+            int32_t state = 3;
+            uint8_t flags[8] = {1, 1, 0, static_cast<uint8_t>((b / 100) & 1), 0, 0, 1, 0};
+            double cycle_time = 0.001 * static_cast<double>(b);
+            int16_t error = 0;
+            std::memcpy(out, &position, 4);
+            std::memcpy(out + 4, &velocity, 4);
+            std::memcpy(out + 8, &state, 4);
+            std::memcpy(out + 12, flags, 8);
+            std::memcpy(out + 24, &cycle_time, 8);
+            std::memcpy(out + 32, &error, 2);
+        }));
+    return corpora;
+}
+
+static bool load_corpus(const std::string& path, Corpus& corpus) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    corpus.name = path;
+
+    size_t offset = 0;
+    while (offset + 4 <= data.size()) {
+        uint32_t length;
+        std::memcpy(&length, data.data() + offset, sizeof(length));
+        if (length == 0 || length > data.size() - offset - 4) break;
+        corpus.payloads.emplace_back(data.begin() + offset + 4, data.begin() + offset + 4 + length);
+        offset += 4 + length;
+    }
+    if (offset != data.size() || corpus.payloads.empty()) {
+        corpus.payloads.assign(1, data);        // kein Record-Format: ganze Datei
+    }
+    return !data.empty();
+}
+
+static std::vector<ByteCodec> make_codecs() {
+    using Method = PayloadCompressor::Method;
+    auto tagged = [](Method method, const std::vector<uint8_t>& data, std::vector<uint8_t>& out) {
+        out.assign(1, static_cast<uint8_t>(method));
+        out.insert(out.end(), data.begin(), data.end());
+    };
+    auto untag = [](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+        if (in.empty()) return false;
+        out = PayloadCompressor::decompress(in.data() + 1, in.size() - 1, static_cast<Method>(in[0]));
+        return true;
+    };
+    auto fixed = [tagged](Method method, std::vector<uint8_t> (*compress)(const uint8_t*, size_t)) {
+        return [tagged, method, compress](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            tagged(method, compress(in.data(), in.size()), out);
+        };
+    };
+
+    auto adaptive = std::make_shared<AdaptiveCompressor>();
+    auto encoder = std::make_shared<LzStreamEncoder>();
+    auto decoder = std::make_shared<LzStreamDecoder>();
+    auto session = std::make_shared<CompressionSession>();
+    auto consumer = std::make_shared<DecompressionSession>();
+
+    std::vector<ByteCodec> codecs;
+    codecs.push_back({"rle", 0, [] {}, fixed(Method::RLE, &SimpleCompressor::compress), untag});
+    codecs.push_back({"dictionary", 1, [] {}, fixed(Method::Dictionary, &DictionaryCompressor::compress), untag});
+    codecs.push_back({"lz", 0, [] {}, fixed(Method::LZ, &LzCompressor::compress), untag});
+    codecs.push_back({"lz stream", 0,
+        [encoder, decoder] { encoder->reset(); decoder->reset(); },
+        [encoder](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            out.resize(LzCompressor::bound(in.size()));
+            out.resize(encoder->compress(in.data(), in.size(), out.data(), out.size()));
+        },
+        [decoder](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            size_t size = LzCompressor::decompressed_size(in.data(), in.size());
+            if (size == SIZE_MAX) return false;
+            out.resize(size);
+            size_t length = 0;
+            return decoder->decompress(in.data(), in.size(), out.data(), out.size(), length);
+        }});
+    codecs.push_back({"session", 0,
+        [session, consumer] { *session = CompressionSession(); consumer->reset(); },
+        [session](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            out.resize(CompressionSession::bound(in.size()));
+            out.resize(session->compress(in.data(), in.size(), out.data(), out.size()));
+        },
+        [consumer](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            out = consumer->decompress(in.data(), in.size());
+            return !out.empty();
+        }});
+    codecs.push_back({"auto", 0, [] {},
+        [tagged](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            auto [data, method] = PayloadCompressor::compress_auto(in.data(), in.size());
+            tagged(method, data, out);
+        }, untag});
+    codecs.push_back({"adaptive", 0, [adaptive] { *adaptive = AdaptiveCompressor(); },
+        [adaptive, tagged](const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+            auto [data, method] = adaptive->compress(0, in.data(), in.size());
+            tagged(method, data, out);
+        }, untag});
+    return codecs;
+}
+
+static double elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Result run_codec(const Corpus& corpus, const ByteCodec& codec, size_t repeat) {
+    Result result;
+    size_t passes = codec.passes > 0 ? codec.passes : repeat;
+    std::vector<std::vector<uint8_t>> compressed(corpus.payloads.size());
+    std::vector<std::vector<uint8_t>> restored(corpus.payloads.size());
+    double compress_ns = 0;
+    double decompress_ns = 0;
+
+    for (size_t pass = 0; pass < passes; pass++) {
+        codec.begin();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < corpus.payloads.size(); i++) {
+            codec.compress(corpus.payloads[i], compressed[i]);
+        }
+        compress_ns += elapsed_ns(start);
+
+        codec.begin();
+        bool decoded = true;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < corpus.payloads.size(); i++) {
+            decoded = codec.decompress(compressed[i], restored[i]) && decoded;
+        }
+        decompress_ns += elapsed_ns(start);
+        result.ok = result.ok && decoded && restored == corpus.payloads;
+    }
+
+    for (const auto& payload : compressed) result.compressed += payload.size();
+    double bytes = static_cast<double>(corpus.bytes()) * passes;
+    result.compress_ns = compress_ns / bytes;
+    result.decompress_ns = decompress_ns / bytes;
+    return result;
+}
+
+// Gorilla: dieselben Samples, ein Frame pro Batch, Zustand über den ganzen Korpus
+static Result run_gorilla(const Corpus& corpus, size_t repeat) {
+    Result result;
+    if (corpus.samples.empty()) {
+        result.applicable = false;
+        return result;
+    }
+
+    std::vector<std::vector<uint8_t>> frames(corpus.samples.size());
+    std::vector<GorillaSample> decoded;
+    double compress_ns = 0;
+    double decompress_ns = 0;
+
+    for (size_t pass = 0; pass < repeat; pass++) {
+        CompressedPayloadBuilder builder;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < corpus.samples.size(); i++) {
+            frames[i].resize(CompressedPayloadBuilder::gorilla_bound(corpus.samples[i].size()));
+            frames[i].resize(builder.encode_gorilla(frames[i].data(), frames[i].size(), corpus.schema,
+                                                    corpus.samples[i]));
+        }
+        compress_ns += elapsed_ns(start);
+
+        GorillaDecoder decoder;
+        std::vector<std::vector<GorillaSample>> restored(corpus.samples.size());
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames.size(); i++) {
+            restored[i].resize(corpus.samples[i].size());
+            size_t count = 0;
+            bool ok = CompressedPayloadBuilder::decode_gorilla(decoder, frames[i].data(), frames[i].size(),
+                                                               corpus.schema, restored[i].data(), restored[i].size(),
+                                                               count);
+            result.ok = result.ok && ok && count == corpus.samples[i].size();
+        }
+        decompress_ns += elapsed_ns(start);
+
+        // Samples einer Variable stehen gruppiert, hier ein Sample pro Variable und Frame
+        for (size_t i = 0; i < frames.size() && result.ok; i++) {
+            for (size_t k = 0; k < corpus.samples[i].size(); k++) {
+                const ColumnarEntry& sample = corpus.samples[i][k];
+                uint64_t value = 0;
+                std::memcpy(&value, sample.data, sample.length);
+                result.ok = result.ok && restored[i][k].id == sample.id &&
+                            restored[i][k].timestamp_us == sample.timestamp_us && restored[i][k].value == value;
+            }
+        }
+    }
+
+    for (const auto& frame : frames) result.compressed += frame.size();
+    double bytes = static_cast<double>(corpus.bytes()) * repeat;
+    result.compress_ns = compress_ns / bytes;
+    result.decompress_ns = decompress_ns / bytes;
+    return result;
+}
+
+static void print_result(const char* name, const Corpus& corpus, const Result& result) {
+    std::cout << "  " << std::left << std::setw(12) << name << std::right;
+    if (!result.applicable) {
+        std::cout << std::setw(8) << "-" << "\n";
+        return;
+    }
+    std::cout << std::setw(7) << std::setprecision(2)
+              << static_cast<double>(corpus.bytes()) / static_cast<double>(result.compressed) << "x"
+              << std::setw(12) << std::setprecision(3) << result.compress_ns
+              << std::setw(12) << result.decompress_ns
+              << "   " << (result.ok ? "OK" : "FAIL") << result.note << "\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: " << arg << " erwartet einen Wert\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--variables") options.variables = std::stoul(value());
+        else if (arg == "--batches") options.batches = std::stoul(value());
+        else if (arg == "--repeat") options.repeat = std::stoul(value());
+        else if (arg == "--corpus") options.corpora.push_back(value());
+        else {
+            std::cout << "Verwendung: compression_benchmark [--variables N] [--batches N] [--repeat N] "
+                         "[--corpus DATEI]...\n";
+            return false;
+        }
+    }
+    if (options.variables == 0) options.variables = 1;
+    if (options.variables > UINT16_MAX) options.variables = UINT16_MAX;
+    if (options.batches == 0) options.batches = 1;
+    if (options.repeat == 0) options.repeat = 1;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Corpus> corpora = make_corpora(options);
+    for (const std::string& path : options.corpora) {
+        Corpus corpus;
+        if (!load_corpus(path, corpus)) {
+            std::cerr << "ERROR: Korpus " << path << " nicht lesbar\n";
+            return 1;
+        }
+        corpora.push_back(std::move(corpus));
+    }
+
+    std::cout << "=== Compression Benchmark ===\n"
+              << "  " << options.variables << " Variablen, " << options.batches << " Batches, "
+              << options.repeat << " Durchläufe\n" << std::fixed;
+
+    std::vector<ByteCodec> codecs = make_codecs();
+    bool ok = true;
+    for (const Corpus& corpus : corpora) {
+        std::cout << "\n" << corpus.name << " (" << corpus.payloads.size() << " Payloads, " << corpus.bytes()
+                  << " Bytes)\n"
+                  << "  codec          ratio  compress    decomp.   round-trip\n"
+                  << "                        ns/Byte     ns/Byte\n";
+        for (const ByteCodec& codec : codecs) {
+            Result result = run_codec(corpus, codec, options.repeat);
+            if (std::string(codec.name) == "adaptive") {
+                // Letzter Durchlauf: gewählte Methode und Anteil der Probes
+                AdaptiveCompressor adaptive;
+                for (const auto& payload : corpus.payloads) adaptive.compress(0, payload.data(), payload.size());
+                result.note = std::string("  (") + PayloadCompressor::method_name(adaptive.selected(0)) + ", " +
+                              std::to_string(adaptive.probes()) + "/" + std::to_string(adaptive.payloads()) +
+                              " Probes)";
+            }
+            print_result(codec.name, corpus, result);
+            ok = ok && result.ok;
+        }
+        Result gorilla = run_gorilla(corpus, options.repeat);
+        print_result("gorilla", corpus, gorilla);
+        ok = ok && gorilla.ok;
+    }
+
+    if (!ok) {
+        std::cerr << "\nERROR: Round-Trip fehlgeschlagen\n";
+        return 1;
+    }
+    return 0;
+}
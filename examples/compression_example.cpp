@@ -7,14 +7,13 @@
 using namespace ads_realtime;
 
 void print_stats(const char* name, const PayloadCompressor::CompressionStats& stats) {
-    const char* method_names[] = {"None", "RLE", "Dictionary"};
     std::cout << name << ":" << std::endl;
     std::cout << "  Original: " << stats.original_size << " bytes" << std::endl;
     std::cout << "  Compressed: " << stats.compressed_size << " bytes" << std::endl;
     std::cout << "  Ratio: " << std::fixed << std::setprecision(2) 
               << stats.compression_ratio << "x" << std::endl;
     std::cout << "  Time: " << stats.compression_time_us << " µs" << std::endl;
-    std::cout << "  Method: " << method_names[static_cast<int>(stats.method)] << std::endl;
+    std::cout << "  Method: " << PayloadCompressor::method_name(stats.method) << std::endl;
     std::cout << "  Savings: " << (stats.original_size - stats.compressed_size) 
               << " bytes (" << std::fixed << std::setprecision(1)
               << (100.0 * (stats.original_size - stats.compressed_size) / stats.original_size)
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 using namespace ads_realtime;
 
@@ -115,12 +116,12 @@ void benchmark_all() {
     {
         auto start = std::chrono::high_resolution_clock::now();
         VariableBatch batch;
+        std::vector<uint8_t> wire(64 * 1024);
         int32_t value = 42;
         
         for (int i = 0; i < iterations; ++i) {
-            batch.add_variable("Test", &value, sizeof(value));
-            if (batch.should_flush()) {
-                auto data = batch.serialize();
+            if (batch.add_variable("Test", &value, sizeof(value))) {
+                batch.serialize(wire.data(), wire.size());
                 batch.clear();
             }
         }
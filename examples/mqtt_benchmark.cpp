@@ -0,0 +1,515 @@
+#include "../include/mqtt_publisher.hpp"
+#include "../include/mqtt_wire.hpp"
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// MQTT Publish Benchmark: Paho vs. nativer Client
+//
+// Ein eingebetteter Broker-Stellvertreter (localhost, ephemerer Port) nimmt
+// CONNECT an (MQTT 3.1.1 und 5.0, Topic Alias Maximum 65535), zählt PUBLISH
+// Pakete, bestätigt QoS 1 mit PUBACK und beantwortet PINGREQ. Der Benchmark
+// publiziert N Pool-Nachrichten über MqttPublisher - einmal mit Paho, einmal
+// mit dem nativen MqttClient - und
+// misst die Producer-Kosten pro Nachricht sowie den End-to-End Durchsatz bis
+// der Broker alle Nachrichten empfangen hat.
+//
+// --mode embedded: die Bridge ist selbst der Broker (MqttBroker), ein
+// Subscriber auf "#" zählt die zugestellten Nachrichten - gemessen wird also
+// bis zum Subscriber, ohne externen Broker dazwischen.
+//
+// Beispiel:
+//   ./mqtt_benchmark --messages 1000000 --topics 100 --payload 16 --qos 0
+//   ./mqtt_benchmark --mode native --qos 1 --protocol 5
+//   ./mqtt_benchmark --mode native --protocol 5 --no-alias   (Bytes/Nachricht ohne Topic Alias)
+//   ./mqtt_benchmark --mode native --qos 1 --connections 4   (Sharding über 4 Verbindungen)
+//   ./mqtt_benchmark --mode all --qos 1                      (Paho, native und eingebetteter Broker)
+
+using namespace ads_realtime;
+
+// ============================================================================
+// Broker-Stellvertreter
+// ============================================================================
+
+class BrokerStandIn {
+public:
+    bool start() {
+        listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;   // freier Port
+        socklen_t len = sizeof(addr);
+        if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd_, 4) != 0 ||
+            getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        accept_thread_ = std::thread(&BrokerStandIn::accept_loop, this);
+        return true;
+    }
+
+    void stop() {
+        running_.store(false);
+        ::shutdown(listen_fd_, SHUT_RDWR);
+        if (accept_thread_.joinable()) accept_thread_.join();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : clients_) ::shutdown(fd, SHUT_RDWR);
+        for (auto& t : sessions_) if (t.joinable()) t.join();
+        for (int fd : clients_) ::close(fd);
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const { return port_; }
+    uint64_t received() const { return received_.load(); }
+    uint64_t bytes() const { return bytes_.load(); }
+
+    void reset() {
+        received_.store(0);
+        bytes_.store(0);
+    }
+
+private:
+    void accept_loop() {
+        while (running_.load()) {
+            int fd = ::accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) break;
+            std::lock_guard<std::mutex> lock(mutex_);
+            clients_.push_back(fd);
+            sessions_.emplace_back(&BrokerStandIn::session, this, fd);
+        }
+    }
+
+    void session(int fd) {
+        std::vector<uint8_t> buffer(1 << 20);
+        std::vector<uint8_t> out;
+        size_t size = 0;
+        uint8_t protocol_level = mqtt_wire::PROTOCOL_LEVEL_311;
+
+        for (;;) {
+            ssize_t n = ::recv(fd, buffer.data() + size, buffer.size() - size, 0);
+            if (n <= 0) break;
+            size += static_cast<size_t>(n);
+            bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+
+            size_t offset = 0;
+            uint64_t publishes = 0;
+            while (size - offset >= 2) {
+                uint32_t remaining = 0;
+                size_t length_bytes = 0;
+                if (!mqtt_wire::decode_remaining_length(buffer.data() + offset + 1, size - offset - 1,
+                                                        remaining, length_bytes)) {
+                    break;
+                }
+                size_t total = 1 + length_bytes + remaining;
+                if (size - offset < total) break;
+
+                uint8_t header = buffer[offset];
+                const uint8_t* body = buffer.data() + offset + 1 + length_bytes;
+                switch (static_cast<mqtt_wire::PacketType>(header >> 4)) {
+                    case mqtt_wire::PacketType::Connect:
+                        protocol_level = body[6];   // nach [00 04 'M' 'Q' 'T' 'T']
+                        if (protocol_level >= mqtt_wire::PROTOCOL_LEVEL_5) {
+                            // Properties: Topic Alias Maximum = 65535
+                            out.insert(out.end(), {0x20, 0x06, 0x00, 0x00, 0x03, 0x22, 0xFF, 0xFF});
+                        } else {
+                            out.insert(out.end(), {0x20, 0x02, 0x00, 0x00});
+                        }
+                        break;
+                    case mqtt_wire::PacketType::Publish:
+                        publishes++;
+                        if ((header >> 1) & 0x03) {
+                            // Packet-ID folgt dem Topic
+                            size_t topic_length = mqtt_wire::decode_u16(body);
+                            const uint8_t* id = body + 2 + topic_length;
+                            out.insert(out.end(), {0x40, 0x02, id[0], id[1]});
+                        }
+                        break;
+                    case mqtt_wire::PacketType::Pingreq:
+                        out.insert(out.end(), {0xD0, 0x00});
+                        break;
+                    default:
+                        break;
+                }
+                offset += total;
+            }
+            std::memmove(buffer.data(), buffer.data() + offset, size - offset);
+            size -= offset;
+
+            // Antworten gesammelt pro recv() zurück (wie ein Broker mit Write-Batching)
+            if (!out.empty()) {
+                ssize_t ignored = ::send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+                (void)ignored;
+                out.clear();
+            }
+            received_.fetch_add(publishes, std::memory_order_relaxed);
+        }
+    }
+
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{true};
+    std::thread accept_thread_;
+    std::mutex mutex_;
+    std::vector<int> clients_;
+    std::vector<std::thread> sessions_;
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+// ============================================================================
+// Subscriber für den eingebetteten Broker (zählt zugestellte PUBLISH)
+// ============================================================================
+
+class EmbeddedSubscriber {
+public:
+    bool start(uint16_t port, uint8_t qos) {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return false;
+        }
+        auto connect = mqtt_wire::build_connect("mqtt-benchmark-subscriber", 0, true);
+        // SUBSCRIBE "#": [82][Länge][Packet-ID 1][00 01 '#'][QoS]
+        const uint8_t subscribe[] = {0x82, 0x06, 0x00, 0x01, 0x00, 0x01, '#', qos};
+        if (::send(fd_, connect.data(), connect.size(), MSG_NOSIGNAL) < 0 ||
+            ::send(fd_, subscribe, sizeof(subscribe), MSG_NOSIGNAL) < 0) {
+            return false;
+        }
+        reader_ = std::thread(&EmbeddedSubscriber::read_loop, this);
+
+        // Erst nach dem SUBACK publizieren, sonst fehlen die ersten Nachrichten
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!subscribed_.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return subscribed_.load();
+    }
+
+    void stop() {
+        if (fd_ < 0) return;
+        ::shutdown(fd_, SHUT_RDWR);
+        if (reader_.joinable()) reader_.join();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    uint64_t received() const { return received_.load(); }
+    uint64_t bytes() const { return bytes_.load(); }
+
+private:
+    void read_loop() {
+        std::vector<uint8_t> buffer(1 << 20);
+        std::vector<uint8_t> acks;
+        size_t size = 0;
+        for (;;) {
+            ssize_t n = ::recv(fd_, buffer.data() + size, buffer.size() - size, 0);
+            if (n <= 0) break;
+            size += static_cast<size_t>(n);
+            bytes_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+
+            size_t offset = 0;
+            uint64_t publishes = 0;
+            while (size - offset >= 2) {
+                uint32_t remaining = 0;
+                size_t length_bytes = 0;
+                if (!mqtt_wire::decode_remaining_length(buffer.data() + offset + 1, size - offset - 1,
+                                                        remaining, length_bytes)) {
+                    break;
+                }
+                size_t total = 1 + length_bytes + remaining;
+                if (size - offset < total) break;
+
+                uint8_t header = buffer[offset];
+                const uint8_t* body = buffer.data() + offset + 1 + length_bytes;
+                auto type = static_cast<mqtt_wire::PacketType>(header >> 4);
+                if (type == mqtt_wire::PacketType::Suback) {
+                    subscribed_.store(true);
+                } else if (type == mqtt_wire::PacketType::Publish) {
+                    publishes++;
+                    if ((header >> 1) & 0x03) {
+                        const uint8_t* id = body + 2 + mqtt_wire::decode_u16(body);
+                        acks.insert(acks.end(), {0x40, 0x02, id[0], id[1]});
+                    }
+                }
+                offset += total;
+            }
+            std::memmove(buffer.data(), buffer.data() + offset, size - offset);
+            size -= offset;
+            if (!acks.empty()) {
+                ssize_t ignored = ::send(fd_, acks.data(), acks.size(), MSG_NOSIGNAL);
+                (void)ignored;
+                acks.clear();
+            }
+            received_.fetch_add(publishes, std::memory_order_relaxed);
+        }
+    }
+
+    int fd_ = -1;
+    std::thread reader_;
+    std::atomic<bool> subscribed_{false};
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+// Freien Port für den eingebetteten Broker finden
+static uint16_t free_port() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    uint16_t port = 0;
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+        port = ntohs(addr.sin_port);
+    }
+    ::close(fd);
+    return port;
+}
+
+// ============================================================================
+
+struct Options {
+    uint64_t messages = 1000000;
+    uint32_t topics = 100;
+    uint32_t payload = 16;
+    uint8_t qos = 0;
+    uint8_t protocol = 4;
+    uint32_t pool = 16384;
+    bool topic_alias = true;
+    uint32_t connections = 1;
+    std::string mode = "both";
+};
+
+struct Result {
+    bool ok = false;
+    double producer_ns = 0.0;       // Producer: acquire + formatieren + publish()
+    double elapsed_s = 0.0;         // Erste Nachricht bis alle beim Broker
+    uint64_t received = 0;
+    uint64_t wire_bytes = 0;        // beim Broker angekommen (inkl. CONNECT/DISCONNECT)
+    uint64_t pool_waits = 0;
+    PublisherStats stats;
+};
+
+static Result run(const Options& options, MqttPublishMode mode, BrokerStandIn& broker) {
+    using clock = std::chrono::steady_clock;
+    Result result;
+
+    RealtimeConfig config;
+    config.mqtt_broker = "127.0.0.1";
+    config.mqtt_port = broker.port();
+    config.mqtt_client_id = "mqtt-benchmark";
+    config.mqtt_publish_mode = mode;
+    config.mqtt_qos = options.qos;
+    config.mqtt_protocol_version = options.protocol;
+    config.message_pool_size = options.pool;
+    config.mqtt_topic_alias = options.topic_alias;
+
+    // Embedded: Bridge ist selbst der Broker, gemessen wird bis zum Subscriber
+    bool embedded = mode == MqttPublishMode::Embedded;
+    EmbeddedSubscriber subscriber;
+    if (embedded) {
+        config.mqtt_port = free_port();
+        config.mqtt_listen_address = "127.0.0.1";
+        config.mqtt_broker_max_pending = 256 * 1024 * 1024;   // Durchsatz messen, nicht Slow-Subscriber Drops
+    }
+    auto received = [&]() { return embedded ? subscriber.received() : broker.received(); };
+
+    broker.reset();
+    MqttPublisher publisher(config);
+    for (uint32_t i = 0; i < options.topics; i++) {
+        publisher.register_topic(i, "bench/plc/var_" + std::to_string(i));
+    }
+    if (!publisher.connect()) {
+        return result;
+    }
+    if (embedded && !subscriber.start(config.mqtt_port, options.qos)) {
+        std::cerr << "Subscriber konnte sich nicht am eingebetteten Broker anmelden\n";
+        return result;
+    }
+
+    size_t payload = std::min<size_t>(options.payload, MqttPublisher::Pool::buffer_size);
+    auto start = clock::now();
+    for (uint64_t i = 0; i < options.messages; i++) {
+        MqttPublisher::Message* message = publisher.acquire_message();
+        while (!message) {
+            // Pool erschöpft: Backpressure statt Drop, damit beide Pfade alle Nachrichten senden
+            result.pool_waits++;
+            std::this_thread::yield();
+            message = publisher.acquire_message();
+        }
+        message->variable_id = static_cast<uint32_t>(i % options.topics);
+        message->length = static_cast<uint32_t>(payload);
+        std::memset(message->data, static_cast<int>(i & 0xFF), payload);
+        publisher.publish(message);
+    }
+    auto produced = clock::now();
+
+    // Warten bis der Broker alles hat, was der Publisher abgegeben hat
+    auto deadline = produced + std::chrono::seconds(30);
+    uint64_t expected = 0;
+    for (;;) {
+        result.stats = publisher.get_statistics();
+        expected = options.messages - result.stats.dropped_disconnected - result.stats.errors -
+                   result.stats.broker_dropped_slow;
+        if (received() >= expected || clock::now() > deadline) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    auto done = clock::now();
+
+    result.received = received();
+    result.wire_bytes = embedded ? subscriber.bytes() : broker.bytes();
+    result.producer_ns = std::chrono::duration<double, std::nano>(produced - start).count() /
+                         static_cast<double>(options.messages);
+    result.elapsed_s = std::chrono::duration<double>(done - start).count();
+    result.stats = publisher.get_statistics();
+    result.ok = result.received >= expected;
+    publisher.disconnect();
+    subscriber.stop();
+    return result;
+}
+
+static void print(const char* name, const Options& options, const Result& result) {
+    double rate = result.received / result.elapsed_s;
+    std::cout << std::fixed << std::setprecision(1)
+              << "  " << std::left << std::setw(9) << name << std::right
+              << std::setw(10) << result.producer_ns << " ns/msg (Producer)"
+              << std::setw(12) << rate / 1000.0 << " k msg/s"
+              << std::setw(9) << rate * options.payload / 1e6 << " MB/s Payload"
+              << std::setw(7) << static_cast<double>(result.wire_bytes) / std::max<uint64_t>(result.received, 1)
+              << " Bytes/msg"
+              << "  empfangen " << result.received << "/" << options.messages
+              << (result.ok ? "" : " (Timeout)") << "\n";
+    std::cout << "           Pool-Wartezyklen " << result.pool_waits
+              << ", Fehler " << result.stats.errors
+              << ", Offline-Drops " << result.stats.dropped_disconnected;
+    if (result.stats.flushes > 0) {
+        std::cout << ", " << result.stats.flushes << " Batches ("
+                  << static_cast<double>(result.stats.published) / result.stats.flushes << " msg/writev)"
+                  << ", Flush P50/P99 " << result.stats.flush_latency_p50_us << "/"
+                  << result.stats.flush_latency_p99_us << "µs";
+    }
+    if (result.stats.acked > 0) {
+        std::cout << ", PUBACK " << result.stats.acked;
+    }
+    if (result.stats.topic_alias_hits > 0) {
+        std::cout << ", Topic Alias " << result.stats.topic_alias_hits;
+    }
+    if (result.stats.broker_delivered > 0) {
+        std::cout << ", Fan-out " << result.stats.broker_delivered
+                  << " (langsam verworfen " << result.stats.broker_dropped_slow << ")";
+    }
+    std::cout << "\n";
+}
+
+static void print_usage() {
+    std::cout << "Usage: mqtt_benchmark [Optionen]\n"
+              << "  --messages N      Anzahl Nachrichten (Default 1000000)\n"
+              << "  --topics N        Anzahl Topics / Variable-IDs (Default 100)\n"
+              << "  --payload BYTES   Payload-Größe (Default 16, max. 256)\n"
+              << "  --qos 0|1         QoS (Default 0)\n"
+              << "  --protocol 4|5    MQTT 3.1.1 oder 5.0 (nur native, Default 4)\n"
+              << "  --pool N          message_pool_size (Default 16384)\n"
+              << "  --no-alias        MQTT 5 ohne Topic Aliases\n"
+              << "  --connections N   MQTT-Verbindungen / Publish-Shards (Default 1)\n"
+              << "  --mode M          native, paho, embedded, both (paho + native) oder all (Default both)\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: " << arg << " erwartet einen Wert\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--messages") options.messages = std::stoull(value());
+        else if (arg == "--topics") options.topics = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--payload") options.payload = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--qos") options.qos = static_cast<uint8_t>(std::min<unsigned long>(std::stoul(value()), 1));
+        else if (arg == "--protocol") options.protocol = static_cast<uint8_t>(std::stoul(value()) == 5 ? 5 : 4);
+        else if (arg == "--pool") options.pool = static_cast<uint32_t>(std::stoul(value()));
+        else if (arg == "--mode") options.mode = value();
+        else if (arg == "--no-alias") options.topic_alias = false;
+        else if (arg == "--connections") options.connections = std::max<uint32_t>(static_cast<uint32_t>(std::stoul(value())), 1);
+        else {
+            print_usage();
+            return false;
+        }
+    }
+    if (options.topics == 0) options.topics = 1;
+    if (options.messages == 0) options.messages = 1;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    BrokerStandIn broker;
+    if (!broker.start()) {
+        std::cerr << "Broker-Stellvertreter konnte nicht starten\n";
+        return 1;
+    }
+
+    std::cout << "=== MQTT Publish Benchmark ===\n"
+              << "  " << options.messages << " Nachrichten, " << options.topics << " Topics, "
+              << options.payload << " Bytes Payload, QoS " << static_cast<int>(options.qos)
+              << ", " << options.connections << " Verbindung(en)"
+              << ", Broker 127.0.0.1:" << broker.port() << "\n";
+
+    bool ok = true;
+    std::vector<std::pair<const char*, Result>> results;
+    if (options.mode == "paho" || options.mode == "both" || options.mode == "all") {
+        Result result = run(options, MqttPublishMode::Paho, broker);
+        ok = ok && result.ok;
+        results.emplace_back("paho", result);
+    }
+    if (options.mode == "native" || options.mode == "both" || options.mode == "all") {
+        Result result = run(options, MqttPublishMode::Native, broker);
+        ok = ok && result.ok;
+        results.emplace_back("native", result);
+    }
+    if (options.mode == "embedded" || options.mode == "all") {
+        Result result = run(options, MqttPublishMode::Embedded, broker);
+        ok = ok && result.ok;
+        results.emplace_back("embedded", result);
+    }
+
+    std::cout << "\n=== Ergebnis ===\n";
+    for (const auto& entry : results) {
+        print(entry.first, options, entry.second);
+    }
+
+    broker.stop();
+    return ok ? 0 : 1;
+}
+
+#else
+int main() {
+    std::cout << "mqtt_benchmark benötigt Linux (Broker-Stellvertreter über BSD Sockets)." << std::endl;
+    return 1;
+}
+#endif
@@ -0,0 +1,299 @@
+#include "../include/binary_payload.hpp"
+#include "../include/columnar_payload.hpp"
+#include "../include/lz_compressor.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Binary Payload Benchmark
+//
+// Kodiert einen Batch aus N Variablen (gemischt BOOL/INT/DINT/REAL/LREAL,
+// typische TwinCAT Symbolnamen) wiederholt:
+//   create_batch - bisherige API, std::vector Rückgabe (Kopie pro Aufruf)
+//   encode_batch - direkt in einen wiederverwendeten Puffer des Aufrufers
+//   view         - BinaryPayloadView über das Ergebnis iterieren (ohne Kopie)
+//   id batch     - encode_id_batch (Variable-IDs statt Namen, PayloadSchema)
+//   id view      - BinaryPayloadView über das IdBatch mit Schema
+//   columnar     - encode_columnar (Timestamps/IDs/Werte als Spalten)
+//   load batch   - Batch über die View in Arrays (Timestamps, Werte) laden
+//   load columns - Columnar Spalten per ColumnarView::decode() in Arrays laden
+//   lz compress  - Batch per LzCompressor komprimieren (zusätzlich MB/s)
+//   lz decompress- LZ Block zurück in einen Puffer (zusätzlich MB/s)
+// und gibt ns pro Eintrag sowie die Payload-Größen aus. Vor der Messung wird
+// der Round-Trip geprüft (inkl. Schema-Payload encode/decode).
+//
+// Beispiel:
+//   ./payload_benchmark --variables 500 --iterations 20000
+
+using namespace ads_realtime;
+
+struct Options {
+    size_t variables = 500;
+    size_t iterations = 20000;
+};
+
+struct Sample {
+    std::string name;
+    AdsDataType type;
+    uint8_t data[8];
+    size_t length;
+};
+
+static std::vector<Sample> make_samples(size_t count) {
+    static const struct { AdsDataType type; size_t length; } types[] = {
+        {AdsDataType::Bool, 1}, {AdsDataType::Int16, 2}, {AdsDataType::Int32, 4},
+        {AdsDataType::Real32, 4}, {AdsDataType::Real64, 8},
+    };
+    std::vector<Sample> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        Sample& sample = samples[i];
+        sample.name = "GVL_Plant.Line" + std::to_string(i / 50) + ".Axis[" + std::to_string(i % 50) + "].Value";
+        sample.type = types[i % 5].type;
+        sample.length = types[i % 5].length;
+        for (size_t b = 0; b < sizeof(sample.data); b++) {
+            sample.data[b] = static_cast<uint8_t>(i * 31 + b);
+        }
+    }
+    return samples;
+}
+
+static double ns_per_entry(std::chrono::steady_clock::time_point start, size_t iterations, size_t variables) {
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(iterations * variables);
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: " << arg << " erwartet einen Wert\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+        if (arg == "--variables") options.variables = std::stoul(value());
+        else if (arg == "--iterations") options.iterations = std::stoul(value());
+        else {
+            std::cout << "Verwendung: payload_benchmark [--variables N] [--iterations N]\n";
+            return false;
+        }
+    }
+    if (options.variables == 0) options.variables = 1;
+    if (options.variables > UINT16_MAX) options.variables = UINT16_MAX;
+    if (options.iterations == 0) options.iterations = 1;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Sample> samples = make_samples(options.variables);
+    std::vector<std::tuple<std::string, AdsDataType, const void*, size_t>> tuples;
+    std::vector<PayloadEntry> entries;
+    std::vector<IdPayloadEntry> id_entries;
+    std::vector<ColumnarEntry> columnar_entries;
+    PayloadSchema schema;
+    for (const Sample& sample : samples) {
+        tuples.emplace_back(sample.name, sample.type, sample.data, sample.length);
+        entries.push_back(PayloadEntry{sample.name, sample.type, sample.data, sample.length});
+        uint16_t id = static_cast<uint16_t>(id_entries.size());
+        schema.set(id, sample.name, sample.type);
+        id_entries.push_back(IdPayloadEntry{id, sample.data, sample.length});
+        columnar_entries.push_back(ColumnarEntry{id, 1700000000000000ULL + 100 * id, sample.data, sample.length});
+    }
+
+    BinaryPayloadBuilder builder;
+    std::vector<uint8_t> buffer(BinaryPayloadBuilder::batch_size(entries));
+    size_t size = builder.encode_batch(buffer.data(), buffer.size(), entries);
+    std::vector<uint8_t> id_buffer(BinaryPayloadBuilder::id_batch_size(schema, id_entries));
+    size_t id_size = builder.encode_id_batch(id_buffer.data(), id_buffer.size(), schema, id_entries);
+    std::vector<uint8_t> schema_payload = builder.create_schema(schema);
+    ColumnarPayloadBuilder columnar_builder;
+    std::vector<uint64_t> columnar_words(
+        (columnar_builder.columnar_size(schema, columnar_entries.data(), columnar_entries.size()) + 7) / 8);
+    uint8_t* columnar_buffer = reinterpret_cast<uint8_t*>(columnar_words.data());   // 8-Byte aligned
+    size_t columnar_size = columnar_builder.encode_columnar(columnar_buffer, columnar_words.size() * 8, schema,
+                                                            columnar_entries);
+
+    std::cout << "=== Binary Payload Benchmark ===\n"
+              << "  " << options.variables << " Variablen, " << options.iterations << " Iterationen\n"
+              << "  Batch " << size << " Bytes, IdBatch " << id_size << " Bytes ("
+              << std::fixed << std::setprecision(1) << static_cast<double>(size) / id_size
+              << "x kleiner), Columnar " << columnar_size << " Bytes, Schema " << schema_payload.size()
+              << " Bytes (retained)\n";
+
+    // Round-Trip: neue API == bisherige API (bis auf Timestamps/Sequence), View liest alles zurück
+    std::vector<uint8_t> legacy = builder.create_batch(tuples);
+    BinaryPayloadView view(buffer.data(), size);
+    bool ok = legacy.size() == size && view.valid() && view.size() == samples.size();
+    size_t index = 0;
+    for (const auto& entry : view) {
+        const Sample& sample = samples[index++];
+        ok = ok && entry.name == sample.name && entry.type == sample.type && entry.length == sample.length &&
+             std::memcmp(entry.data, sample.data, sample.length) == 0;
+    }
+    ok = ok && index == samples.size();
+    ok = ok && !BinaryPayloadView(buffer.data(), size - 1).valid();
+    ok = ok && builder.encode_batch(buffer.data(), size - 1, entries) == 0;
+
+    // IdBatch nur mit dem Schema der Gegenseite (aus der Schema-Payload) lesbar
+    PayloadSchema received;
+    ok = ok && !BinaryPayloadView(id_buffer.data(), id_size, &received).valid() &&
+         BinaryPayloadView(id_buffer.data(), id_size, &received).needs_schema();
+    ok = ok && received.decode(schema_payload.data(), schema_payload.size()) &&
+         received.version() == schema.version();
+    BinaryPayloadView id_view(id_buffer.data(), id_size, &received);
+    ok = ok && id_view.valid() && id_view.size() == samples.size();
+    index = 0;
+    for (const auto& entry : id_view) {
+        const Sample& sample = samples[index++];
+        ok = ok && entry.name == sample.name && entry.type == sample.type && entry.length == sample.length &&
+             std::memcmp(entry.data, sample.data, sample.length) == 0;
+    }
+    ok = ok && index == samples.size();
+    ok = ok && !BinaryPayloadView(id_buffer.data(), id_size - 1, &received).valid();
+
+    // Columnar: Spalten in Arrays laden und gegen die Samples prüfen
+    std::vector<uint64_t> loaded_timestamps(samples.size());
+    std::vector<uint16_t> loaded_ids(samples.size());
+    std::vector<uint8_t> loaded_values(samples.size() * 8);
+    ColumnarView columnar(columnar_buffer, columnar_size);
+    ok = ok && columnar.valid() && columnar.rows() == samples.size() && !ColumnarView(columnar_buffer, columnar_size - 8).valid();
+    ok = ok && ColumnarView::decode(columnar.timestamps(), loaded_timestamps.data(), loaded_timestamps.size() * 8) &&
+         ColumnarView::decode(columnar.ids(), loaded_ids.data(), loaded_ids.size() * 2);
+    for (size_t c = 2; ok && c < columnar.column_count(); c++) {
+        ColumnarView::Column column = columnar.column(c);
+        ok = ColumnarView::decode(column, loaded_values.data(), loaded_values.size());
+        for (uint32_t k = 0; ok && k < column.rows; k++) {
+            const Sample& sample = samples[loaded_ids[column.first_row + k]];
+            ok = sample.type == column.type && sample.length == column.value_size &&
+                 loaded_timestamps[column.first_row + k] == columnar_entries[loaded_ids[column.first_row + k]].timestamp_us &&
+                 std::memcmp(loaded_values.data() + k * column.value_size, sample.data, sample.length) == 0;
+        }
+    }
+    // LZ: Batch komprimieren und bitgenau zurück
+    std::vector<uint8_t> lz_buffer(LzCompressor::bound(size));
+    std::vector<uint8_t> lz_restored(size);
+    size_t lz_size = LzCompressor::compress(buffer.data(), size, lz_buffer.data(), lz_buffer.size());
+    size_t lz_restored_size = 0;
+    ok = ok && lz_size > 0 &&
+         LzCompressor::decompress(lz_buffer.data(), lz_size, lz_restored.data(), lz_restored.size(), lz_restored_size) &&
+         lz_restored_size == size && std::memcmp(lz_restored.data(), buffer.data(), size) == 0 &&
+         !LzCompressor::decompress(lz_buffer.data(), lz_size - 1, lz_restored.data(), lz_restored.size(), lz_restored_size);
+    if (!ok) {
+        std::cerr << "ERROR: Round-Trip fehlgeschlagen\n";
+        return 1;
+    }
+
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        checksum += builder.create_batch(tuples).size();
+    }
+    double legacy_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        checksum += builder.encode_batch(buffer.data(), buffer.size(), entries);
+    }
+    double encode_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        for (const auto& entry : BinaryPayloadView(buffer.data(), size)) {
+            checksum += entry.length + entry.data[0];
+        }
+    }
+    double view_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        checksum += builder.encode_id_batch(id_buffer.data(), id_buffer.size(), schema, id_entries);
+    }
+    double id_encode_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        for (const auto& entry : BinaryPayloadView(id_buffer.data(), id_size, &received)) {
+            checksum += entry.length + entry.data[0];
+        }
+    }
+    double id_view_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        checksum += columnar_builder.encode_columnar(columnar_buffer, columnar_words.size() * 8, schema,
+                                                     columnar_entries);
+    }
+    double columnar_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    // Laden in Arrays (Historian/Analytics): Timestamps + Werte zusammenhängend
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        size_t row = 0;
+        size_t offset = 0;
+        for (const auto& entry : BinaryPayloadView(buffer.data(), size)) {
+            loaded_timestamps[row++] = entry.timestamp_us;
+            std::memcpy(loaded_values.data() + offset, entry.data, entry.length);
+            offset += entry.length;
+        }
+        checksum += offset + loaded_values[0];
+    }
+    double load_batch_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        ColumnarView view(columnar_buffer, columnar_size);
+        ColumnarView::decode(view.timestamps(), loaded_timestamps.data(), loaded_timestamps.size() * 8);
+        ColumnarView::decode(view.ids(), loaded_ids.data(), loaded_ids.size() * 2);
+        size_t offset = 0;
+        for (size_t c = 2; c < view.column_count(); c++) {
+            ColumnarView::Column column = view.column(c);
+            ColumnarView::decode(column, loaded_values.data() + offset, loaded_values.size() - offset);
+            offset += column.length;
+        }
+        checksum += offset + loaded_values[0];
+    }
+    double load_columnar_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        checksum += LzCompressor::compress(buffer.data(), size, lz_buffer.data(), lz_buffer.size());
+    }
+    double lz_compress_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.iterations; i++) {
+        LzCompressor::decompress(lz_buffer.data(), lz_size, lz_restored.data(), lz_restored.size(), lz_restored_size);
+        checksum += lz_restored_size + lz_restored[0];
+    }
+    double lz_decompress_ns = ns_per_entry(start, options.iterations, options.variables);
+
+    // Bytes des unkomprimierten Batches pro ns = GB/s, * 1000 = MB/s
+    auto mb_per_s = [&](double ns) { return static_cast<double>(size) / (ns * options.variables) * 1000.0; };
+
+    std::cout << "  create_batch:    " << std::setw(7) << legacy_ns << " ns/Eintrag\n"
+              << "  encode_batch:    " << std::setw(7) << encode_ns << " ns/Eintrag\n"
+              << "  view:            " << std::setw(7) << view_ns << " ns/Eintrag\n"
+              << "  encode_id_batch: " << std::setw(7) << id_encode_ns << " ns/Eintrag\n"
+              << "  id view:         " << std::setw(7) << id_view_ns << " ns/Eintrag\n"
+              << "  encode_columnar: " << std::setw(7) << columnar_ns << " ns/Eintrag\n"
+              << "  load batch:      " << std::setw(7) << load_batch_ns << " ns/Eintrag\n"
+              << "  load columns:    " << std::setw(7) << load_columnar_ns << " ns/Eintrag\n"
+              << "  lz compress:     " << std::setw(7) << lz_compress_ns << " ns/Eintrag ("
+              << std::setprecision(0) << mb_per_s(lz_compress_ns) << " MB/s, " << size << " -> " << lz_size
+              << " Bytes)\n" << std::setprecision(1)
+              << "  lz decompress:   " << std::setw(7) << lz_decompress_ns << " ns/Eintrag ("
+              << std::setprecision(0) << mb_per_s(lz_decompress_ns) << " MB/s)\n" << std::setprecision(1)
+              << "  (Checksumme " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "../include/payload_compression.hpp"
+#include "../include/rle_kernels.hpp"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// RLE Microbenchmark
+//
+// Vergleicht SimpleCompressor mit jedem verfügbaren RleKernel (scalar, sse2,
+// avx2) und der bisherigen Byte-für-Byte Implementierung (reference, push_back)
+// auf typischen Blöcken:
+//   bool array    - ARRAY OF BOOL, lange 0/1 Runs
+//   status words  - DWORD Statusworte, überwiegend 0
+//   analog        - REAL Messwerte (kaum Runs, Worst Case für die Suche)
+//   mixed         - Strings mit Füllbytes, 0xFF Bytes, kurze Runs
+// Jede Ausgabe muss byte-identisch mit der Referenz sein und zurück das
+// Original ergeben. Ausgabe in MB/s (Original-Bytes). Exit-Code 1 bei Abweichung.
+//
+// Beispiel:
+//   ./rle_benchmark --size 65536 --repeat 2000
+
+using namespace ads_realtime;
+
+// Bisherige Implementierung als Referenz für Format und Geschwindigkeit
+static std::vector<uint8_t> reference_compress(const uint8_t* data, size_t len) {
+    std::vector<uint8_t> compressed;
+    compressed.reserve(len);
+    size_t i = 0;
+    while (i < len) {
+        uint8_t current = data[i];
+        size_t run_length = 1;
+        while (i + run_length < len && data[i + run_length] == current && run_length < 255) {
+            run_length++;
+        }
+        if (run_length >= 3) {
+            compressed.push_back(0xFF);
+            compressed.push_back(static_cast<uint8_t>(run_length));
+            compressed.push_back(current);
+            i += run_length;
+        } else {
+            if (current == 0xFF) {
+                compressed.push_back(0xFF);
+                compressed.push_back(0x00);
+            } else {
+                compressed.push_back(current);
+            }
+            i++;
+        }
+    }
+    return compressed;
+}
+
+static std::vector<uint8_t> reference_decompress(const uint8_t* data, size_t len) {
+    std::vector<uint8_t> decompressed;
+    decompressed.reserve(len * 2);
+    size_t i = 0;
+    while (i < len) {
+        if (data[i] == 0xFF) {
+            if (i + 1 < len && data[i + 1] == 0x00) {
+                decompressed.push_back(0xFF);
+                i += 2;
+            } else if (i + 2 < len) {
+                for (int j = 0; j < data[i + 1]; j++) decompressed.push_back(data[i + 2]);
+                i += 3;
+            } else {
+                i++;
+            }
+        } else {
+            decompressed.push_back(data[i]);
+            i++;
+        }
+    }
+    return decompressed;
+}
+
+struct Block {
+    const char* name;
+    std::vector<uint8_t> data;
+};
+
+static std::vector<Block> make_blocks(size_t size) {
+    std::mt19937 rng(42);
+    std::vector<Block> blocks;
+
+    Block bools{"bool array", std::vector<uint8_t>(size)};
+    uint8_t bit = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (rng() % 200 == 0) bit ^= 1;
+        bools.data[i] = bit;
+    }
+    blocks.push_back(std::move(bools));
+
+    Block status{"status words", std::vector<uint8_t>(size)};
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        uint32_t word = rng() % 20 == 0 ? (1u << (rng() % 32)) : 0;
+        std::memcpy(status.data.data() + i, &word, 4);
+    }
+    blocks.push_back(std::move(status));
+
+    Block analog{"analog", std::vector<uint8_t>(size)};
+    std::normal_distribution<float> noise(0.0f, 0.5f);
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        float value = 20.0f + noise(rng);
+        std::memcpy(analog.data.data() + i, &value, 4);
+    }
+    blocks.push_back(std::move(analog));
+
+    Block mixed{"mixed", std::vector<uint8_t>(size)};
+    for (size_t i = 0; i < size;) {
+        size_t n = std::min(size - i, static_cast<size_t>(1 + rng() % 40));
+        uint8_t value = static_cast<uint8_t>(rng() % 4 == 0 ? 0xFF : 'A' + rng() % 26);
+        if (rng() % 3 == 0) {
+            std::memset(mixed.data.data() + i, value, n);        // Run (auch 0xFF Runs)
+        } else {
+            for (size_t k = 0; k < n; k++) mixed.data[i + k] = static_cast<uint8_t>('a' + rng() % 26);
+        }
+        i += n;
+    }
+    blocks.push_back(std::move(mixed));
+    return blocks;
+}
+
+template <typename Fn>
+static double mb_per_s(size_t bytes, size_t repeat, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeat; r++) fn();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(bytes) * repeat / seconds / 1e6;
+}
+
+static void print_row(const char* name, double compress, double decompress, bool ok) {
+    std::cout << "  " << std::left << std::setw(12) << name << std::right << std::setw(10) << compress
+              << std::setw(12) << decompress << "   " << (ok ? "OK" : "FAIL") << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = 65536;
+    size_t repeat = 1000;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) size = std::stoul(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc) repeat = std::stoul(argv[++i]);
+        else {
+            std::cout << "Verwendung: rle_benchmark [--size BYTES] [--repeat N]\n";
+            return 1;
+        }
+    }
+    if (repeat == 0) repeat = 1;
+
+    std::vector<const RleKernel*> kernels{&RleKernel::scalar(), RleKernel::sse2(), RleKernel::avx2()};
+    std::cout << "=== RLE Benchmark ===\n"
+              << "  " << size << " Bytes pro Block, " << repeat << " Durchläufe, Auswahl: "
+              << RleKernel::select().name << "\n" << std::fixed << std::setprecision(0);
+
+    bool ok = true;
+    volatile size_t sink = 0;
+    for (const Block& block : make_blocks(size)) {
+        const uint8_t* data = block.data.data();
+        std::vector<uint8_t> expected = reference_compress(data, size);
+        std::cout << "\n" << block.name << " (Ratio " << std::setprecision(2)
+                  << static_cast<double>(size) / static_cast<double>(expected.size()) << "x)\n"
+                  << std::setprecision(0)
+                  << "  path          compress  decompress   round-trip\n"
+                  << "                    MB/s        MB/s\n";
+
+        double compress = mb_per_s(size, repeat, [&] { sink = sink + reference_compress(data, size).size(); });
+        double decompress = mb_per_s(size, repeat, [&] {
+            sink = sink + reference_decompress(expected.data(), expected.size()).size();
+        });
+        print_row("reference", compress, decompress,
+                  reference_decompress(expected.data(), expected.size()) == block.data);
+
+        // Decoder ist für alle Kernel derselbe (memchr/memset)
+        double fast_decompress = mb_per_s(size, repeat, [&] {
+            sink = sink + SimpleCompressor::decompress(expected.data(), expected.size()).size();
+        });
+        for (const RleKernel* kernel : kernels) {
+            if (!kernel) continue;
+            std::vector<uint8_t> compressed = SimpleCompressor::compress(data, size, *kernel);
+            bool same = compressed == expected &&
+                        SimpleCompressor::decompress(compressed.data(), compressed.size()) == block.data;
+            compress = mb_per_s(size, repeat, [&] { sink = sink + SimpleCompressor::compress(data, size, *kernel).size(); });
+            print_row(kernel->name, compress, fast_decompress, same);
+            ok = ok && same;
+        }
+    }
+    return ok ? 0 : 1;
+}
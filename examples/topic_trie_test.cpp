@@ -0,0 +1,162 @@
+#include "../include/topic_trie.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// TopicTrie Test: Trie gegen topic::matches()
+//
+// Feste Fälle (Wildcards, '#' auf der Elternebene, $-Topics, leere Ebenen),
+// danach 200k zufällige subscribe/unsubscribe/match Operationen. Referenz ist
+// eine Map (Filter, Key) -> QoS, aufgelöst per topic::matches(): jeder Key
+// höchstens einmal mit der höchsten QoS, size() und generation() passend.
+// Aufruf: ./topic_trie_test [seed] - Exit-Code 1 bei Abweichungen.
+
+using namespace ads_realtime;
+
+using Trie = TopicTrie<int>;
+
+static int g_failures = 0;
+
+static void fail(const std::string& what) {
+    if (g_failures < 20) std::cout << "❌ " << what << "\n";
+    g_failures++;
+}
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) fail(what);
+}
+
+static std::string subscribers(Trie& trie, const std::string& name) {
+    std::vector<Trie::Subscriber> out;
+    trie.match(name, out);
+    std::string text;
+    for (const auto& subscriber : out) {
+        if (!text.empty()) text += ' ';
+        text += std::to_string(subscriber.key) + ":" + std::to_string(subscriber.qos);
+    }
+    return text;
+}
+
+static void fixed_cases() {
+    Trie trie;
+    trie.subscribe("#", 1, 0);
+    trie.subscribe("a/+", 2, 1);
+    trie.subscribe("a/#", 2, 0);
+    trie.subscribe("+/b/c", 3, 1);
+    trie.subscribe("$SYS/#", 4, 0);
+    trie.subscribe("a/b", 5, 1);
+    trie.subscribe("+/+", 6, 0);
+
+    check(subscribers(trie, "a/b") == "1:0 2:1 5:1 6:0", "a/b: " + subscribers(trie, "a/b"));
+    check(subscribers(trie, "a") == "1:0 2:0", "a ('#' passt auf die Elternebene): " + subscribers(trie, "a"));
+    check(subscribers(trie, "a/b/c") == "1:0 2:0 3:1", "a/b/c: " + subscribers(trie, "a/b/c"));
+    check(subscribers(trie, "$SYS/x") == "4:0", "$SYS/x (keine Wildcard auf Ebene 1): " + subscribers(trie, "$SYS/x"));
+    check(subscribers(trie, "x/$SYS") == "1:0 6:0", "x/$SYS ($ nur auf Ebene 1): " + subscribers(trie, "x/$SYS"));
+    check(subscribers(trie, "a/") == "1:0 2:1 6:0", "a/ (leere Ebene): " + subscribers(trie, "a/"));
+
+    check(trie.subscribe("a/b", 5, 0) == false, "a/b erneut: kein neuer Eintrag");
+    check(subscribers(trie, "a/b") == "1:0 2:1 5:0 6:0", "a/b nach QoS-Wechsel: " + subscribers(trie, "a/b"));
+    check(trie.unsubscribe("a/#", 2) && !trie.unsubscribe("a/#", 2), "a/# doppelt abbestellt");
+    check(!trie.unsubscribe("a/b/c", 5), "a/b/c nie abonniert");
+    check(subscribers(trie, "a") == "1:0", "a nach unsubscribe: " + subscribers(trie, "a"));
+    check(trie.size() == 6, "size() == 6");
+}
+
+static std::string random_topic(std::mt19937& rng, bool filter) {
+    // Ebenen inkl. leerer Ebene und $-Präfix; '+'/'#' nur in Filtern, '#' nur am Ende.
+    // Filter bis 3 Ebenen (hält die Referenz-Map klein), Namen bis 4 ('#' über mehrere Ebenen)
+    static const char* const levels[] = {"a", "b", "c", "zz", "", "$SYS", "$x", "+", "#"};
+    size_t choices = filter ? 9 : 7;
+    int count = 1 + static_cast<int>(rng() % (filter ? 3 : 4));
+    std::string text;
+    for (int i = 0; i < count; i++) {
+        if (i > 0) text += '/';
+        std::string level = levels[rng() % choices];
+        if (level == "#" && i != count - 1) level = "+";
+        text += level;
+    }
+    return text;
+}
+
+static void randomized(uint32_t seed) {
+    constexpr int OPERATIONS = 200000;
+    constexpr int KEYS = 6;
+
+    std::mt19937 rng(seed);
+    Trie trie;
+    std::map<std::pair<std::string, int>, uint8_t> reference;   // (Filter, Key) -> QoS
+    std::vector<Trie::Subscriber> out;
+    size_t matches = 0;
+    const int failures = g_failures;   // ab der ersten Abweichung abbrechen
+
+    int op = 0;
+    for (; op < OPERATIONS && g_failures == failures; op++) {
+        uint64_t generation = trie.generation();
+        std::string filter = random_topic(rng, true);
+        int key = static_cast<int>(rng() % KEYS);
+
+        switch (rng() % 3) {
+            case 0: {
+                uint8_t qos = static_cast<uint8_t>(rng() % 2);
+                auto it = reference.find({filter, key});
+                bool is_new = it == reference.end();
+                bool changed = is_new || it->second != qos;
+                if (trie.subscribe(filter, key, qos) != is_new) fail("subscribe " + filter);
+                if ((trie.generation() != generation) != changed) fail("generation nach subscribe " + filter);
+                reference[{filter, key}] = qos;
+                break;
+            }
+            case 1: {
+                bool existed = reference.erase({filter, key}) == 1;
+                if (trie.unsubscribe(filter, key) != existed) fail("unsubscribe " + filter);
+                if ((trie.generation() != generation) != existed) fail("generation nach unsubscribe " + filter);
+                break;
+            }
+            default: {
+                std::string name = random_topic(rng, false);
+                std::map<int, uint8_t> expected;
+                for (const auto& [entry, qos] : reference) {
+                    if (topic::matches(entry.first, name)) {
+                        auto [it, inserted] = expected.emplace(entry.second, qos);
+                        if (!inserted) it->second = std::max(it->second, qos);
+                    }
+                }
+                trie.match(name, out);
+                bool ok = out.size() == expected.size();
+                for (const auto& subscriber : out) {
+                    auto it = expected.find(subscriber.key);
+                    ok = ok && it != expected.end() && it->second == subscriber.qos;
+                }
+                if (!ok) fail("match " + name + ": " + subscribers(trie, name));
+                matches += out.size();
+                break;
+            }
+        }
+        if (trie.size() != reference.size()) fail("size() nach Operation " + std::to_string(op));
+    }
+
+    // Alles abbestellen: Knoten werden freigegeben, nichts passt mehr
+    for (const auto& [entry, qos] : reference) {
+        if (!trie.unsubscribe(entry.first, entry.second)) fail("Abbau " + entry.first);
+    }
+    check(trie.size() == 0 && subscribers(trie, "a/b").empty(), "Trie nach Abbau nicht leer");
+
+    std::cout << "Seed " << seed << ": " << op << " Operationen, " << matches << " Treffer\n";
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 42;
+
+    fixed_cases();
+    randomized(seed);
+
+    if (g_failures == 0) {
+        std::cout << "✅ TopicTrie: identisch zu topic::matches()\n";
+        return 0;
+    }
+    std::cout << g_failures << " Abweichung(en)\n";
+    return 1;
+}
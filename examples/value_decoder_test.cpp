@@ -0,0 +1,175 @@
+#include "../include/value_decoder.hpp"
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// ValueDecoder Round-Trip Test
+//
+// Pro unterstütztem ADST Typ wird ein Wert per ValueDecoder::resolve()
+// formatiert und aus dem Klartext zurückgelesen:
+//   BOOL, SINT/USINT, INT/UINT, DINT/UDINT, LINT/ULINT - min, 0, max
+//   REAL/LREAL     - kürzeste Darstellung, bitgenau zurück; NaN/Inf als null
+//   Arrays         - [a,b,c] Element für Element
+//   STRING(n)      - Windows-1252 -> UTF-8, Ende am ersten NUL
+//   WSTRING(n)     - UTF-16LE inkl. Surrogate-Paar -> UTF-8
+//   Strukturen     - ADST_BIGTYPE als Hex, zurück in die Rohbytes
+// Dazu: leerer STRING ist gültig (0 Bytes), ein zu kleiner Ausgabepuffer
+// liefert false. Exit-Code 1 bei Abweichungen.
+
+using namespace ads_realtime;
+
+static int g_failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "❌ " << what << "\n";
+        g_failures++;
+    }
+}
+
+static std::string format(uint32_t ads_type, const void* data, size_t size, size_t capacity = 512,
+                          bool* fits = nullptr) {
+    ValueDecoder decoder = ValueDecoder::resolve(ads_type, size);
+    std::vector<char> out(capacity);
+    size_t length = 0;
+    bool ok = decoder.to_text(data, size, out.data(), out.size(), length);
+    if (fits) *fits = ok;
+    return std::string(out.data(), length);
+}
+
+template<typename T>
+static bool parse(const std::string& text, T& value) {
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+template<typename T>
+static void round_trip(ams::DataType type, const char* name, T value) {
+    std::string text = format(static_cast<uint32_t>(type), &value, sizeof(value));
+    T back{};
+    bool ok = parse(text, back) && std::memcmp(&back, &value, sizeof(T)) == 0;
+    check(ok, std::string(name) + ": \"" + text + "\"");
+}
+
+template<typename T>
+static void integer_type(ams::DataType type, const char* name) {
+    round_trip<T>(type, name, std::numeric_limits<T>::min());
+    round_trip<T>(type, name, T{0});
+    round_trip<T>(type, name, std::numeric_limits<T>::max());
+}
+
+template<typename T>
+static void float_type(ams::DataType type, const char* name) {
+    for (T value : {T(0), T(-0.0), T(0.1), T(-1.5e-30), std::numeric_limits<T>::max(),
+                    std::numeric_limits<T>::denorm_min(), T(123456.789)}) {
+        round_trip<T>(type, name, value);
+    }
+    T nan = std::numeric_limits<T>::quiet_NaN();
+    T inf = std::numeric_limits<T>::infinity();
+    check(format(static_cast<uint32_t>(type), &nan, sizeof(nan)) == "null", std::string(name) + ": NaN");
+    check(format(static_cast<uint32_t>(type), &inf, sizeof(inf)) == "null", std::string(name) + ": Inf");
+}
+
+template<typename T>
+static void array_type(ams::DataType type, const char* name, std::vector<T> values) {
+    std::string text = format(static_cast<uint32_t>(type), values.data(), values.size() * sizeof(T));
+    bool ok = text.size() >= 2 && text.front() == '[' && text.back() == ']';
+    size_t pos = 1;
+    for (size_t i = 0; ok && i < values.size(); i++) {
+        size_t next = text.find(i + 1 < values.size() ? ',' : ']', pos);
+        T back{};
+        ok = next != std::string::npos && parse(text.substr(pos, next - pos), back) &&
+             std::memcmp(&back, &values[i], sizeof(T)) == 0;
+        pos = next + 1;
+    }
+    check(ok && pos == text.size(), std::string(name) + " Array: \"" + text + "\"");
+}
+
+static void bool_type() {
+    uint8_t values[] = {1, 0};
+    check(format(static_cast<uint32_t>(ams::DataType::Bit), &values[0], 1) == "true", "BOOL: true");
+    check(format(static_cast<uint32_t>(ams::DataType::Bit), &values[1], 1) == "false", "BOOL: false");
+    check(format(static_cast<uint32_t>(ams::DataType::Bit), values, 2) == "[true,false]", "BOOL Array");
+}
+
+static void string_types() {
+    // STRING(80): "Grüße" in Windows-1252, Rest NUL
+    uint8_t text[81] = {};
+    std::memcpy(text, "Gr\xFC\xDF" "e", 5);
+    check(format(static_cast<uint32_t>(ams::DataType::String), text, sizeof(text)) == "Grüße", "STRING(80)");
+
+    // Leerer STRING(80): gültig, 0 Bytes - kein Überlauf
+    uint8_t empty[81] = {};
+    bool fits = false;
+    check(format(static_cast<uint32_t>(ams::DataType::String), empty, sizeof(empty), 512, &fits).empty() && fits,
+          "STRING(80) leer");
+
+    // Ohne NUL am Ende (voller Puffer): genau size Zeichen
+    uint8_t full[3] = {'a', 'b', 'c'};
+    check(format(static_cast<uint32_t>(ams::DataType::String), full, sizeof(full)) == "abc", "STRING ohne NUL");
+
+    // WSTRING(10): "€ x 😀" (U+20AC, U+1F600 als Surrogate-Paar)
+    uint16_t wide[11] = {0x20AC, ' ', 'x', ' ', 0xD83D, 0xDE00, 0};
+    check(format(static_cast<uint32_t>(ams::DataType::WString), wide, sizeof(wide)) == "€ x 😀", "WSTRING(10)");
+}
+
+static void struct_type() {
+    uint8_t raw[] = {0x00, 0xAB, 0x10, 0xFF, 0x7F};
+    std::string text = format(static_cast<uint32_t>(ams::DataType::BigType), raw, sizeof(raw));
+    bool ok = text.size() == 2 * sizeof(raw);
+    for (size_t i = 0; ok && i < sizeof(raw); i++) {
+        unsigned value = 0;
+        auto [ptr, ec] = std::from_chars(text.data() + 2 * i, text.data() + 2 * i + 2, value, 16);
+        ok = ec == std::errc() && ptr == text.data() + 2 * i + 2 && value == raw[i];
+    }
+    check(ok, "STRUCT: \"" + text + "\"");
+}
+
+static void overflow() {
+    bool fits = true;
+    int32_t value = -123456;
+    check(format(static_cast<uint32_t>(ams::DataType::Int32), &value, sizeof(value), 3, &fits).empty() && !fits,
+          "DINT Überlauf");
+    uint8_t raw[4] = {1, 2, 3, 4};
+    check(format(static_cast<uint32_t>(ams::DataType::BigType), raw, sizeof(raw), 7, &fits).empty() && !fits,
+          "STRUCT Überlauf");
+    uint8_t text[8] = {'a', 'b', 'c', 'd', 'e', 0};
+    check(format(static_cast<uint32_t>(ams::DataType::String), text, sizeof(text), 4, &fits).empty() && !fits,
+          "STRING Überlauf");
+    uint16_t wide[3] = {0x20AC, 0x20AC, 0};
+    check(format(static_cast<uint32_t>(ams::DataType::WString), wide, sizeof(wide), 5, &fits).empty() && !fits,
+          "WSTRING Überlauf");
+}
+
+int main() {
+    bool_type();
+    integer_type<int8_t>(ams::DataType::Int8, "SINT");
+    integer_type<uint8_t>(ams::DataType::UInt8, "USINT");
+    integer_type<int16_t>(ams::DataType::Int16, "INT");
+    integer_type<uint16_t>(ams::DataType::UInt16, "UINT");
+    integer_type<int32_t>(ams::DataType::Int32, "DINT");
+    integer_type<uint32_t>(ams::DataType::UInt32, "UDINT");
+    integer_type<int64_t>(ams::DataType::Int64, "LINT");
+    integer_type<uint64_t>(ams::DataType::UInt64, "ULINT");
+    float_type<float>(ams::DataType::Real32, "REAL");
+    float_type<double>(ams::DataType::Real64, "LREAL");
+
+    array_type<int16_t>(ams::DataType::Int16, "INT", {1, -2, 32767, -32768});
+    array_type<uint32_t>(ams::DataType::UInt32, "UDINT", {0, 4294967295u, 42});
+    array_type<float>(ams::DataType::Real32, "REAL", {0.5f, -1.25f, 3.4e38f});
+    array_type<double>(ams::DataType::Real64, "LREAL", {0.1, -2.5e-300, 1e300});
+
+    string_types();
+    struct_type();
+    overflow();
+
+    if (g_failures == 0) {
+        std::cout << "✅ ValueDecoder: alle ADST Typen round-trip\n";
+        return 0;
+    }
+    std::cout << g_failures << " Abweichung(en)\n";
+    return 1;
+}
@@ -0,0 +1,266 @@
+#include "../include/value_filter.hpp"
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// ValueFilter Sequenz-Test
+//
+// Jede Sequenz läuft wie in der Engine durch pass() + commit() und wird als
+// Muster verglichen ('P' = weitergereicht, '-' = verworfen):
+//   Totzone absolut     - Grenze exklusiv, Drift summiert sich gegen den letzten Wert
+//   Totzone relativ     - letzter Wert 0 (Schwelle 0), größere von abs/% gilt
+//   Bit-Änderung        - on_change, vorzeichenlose Typen trotz Totzone, Strukturen
+//   min/max Intervall   - Drossel, Heartbeat, Timestamp-Sprung zurück
+//   NaN                 - REAL/LREAL über das Bitmuster (auch unter -ffast-math)
+//   Arrays              - Treffer im 16er-Block, im Rest und unter der Totzone
+// Exit-Code 1 bei Abweichungen.
+
+using namespace ads_realtime;
+
+static int g_failures = 0;
+
+template<typename T>
+static std::vector<uint8_t> bytes(std::initializer_list<T> values) {
+    std::vector<uint8_t> out(values.size() * sizeof(T));
+    std::memcpy(out.data(), values.begin(), out.size());
+    return out;
+}
+
+struct Step {
+    std::vector<uint8_t> data;
+    int64_t ms = 0;
+};
+
+static void sequence(const char* name, ams::DataType type, const FilterConfig& config,
+                     const std::vector<Step>& steps, const std::string& expected) {
+    size_t size = steps.empty() ? 0 : steps.front().data.size();
+    ValueFilter filter;
+    filter.configure(config, ValueDecoder::resolve(static_cast<uint32_t>(type), size), size);
+
+    std::string result;
+    for (const Step& step : steps) {
+        uint32_t length = static_cast<uint32_t>(step.data.size());
+        int64_t ads_timestamp = step.ms * 10000;   // 100ns Ticks
+        if (filter.pass(step.data.data(), length, ads_timestamp)) {
+            filter.commit(step.data.data(), length, ads_timestamp);
+            result += 'P';
+        } else {
+            result += '-';
+        }
+    }
+
+    if (result != expected) {
+        std::cout << "❌ " << name << ": " << result << " (erwartet " << expected << ")\n";
+        g_failures++;
+    }
+}
+
+template<typename T>
+static std::vector<Step> values(std::initializer_list<T> list) {
+    std::vector<Step> steps;
+    int64_t ms = 0;
+    for (T value : list) {
+        steps.push_back({bytes<T>({value}), ms++});
+    }
+    return steps;
+}
+
+static void absolute_deadband() {
+    FilterConfig config;
+    config.deadband_abs = 0.5;
+
+    // 0.5 liegt nicht über der Totzone; 0.9 vergleicht gegen 0.6, nicht gegen 0.5
+    sequence("REAL abs 0.5", ams::DataType::Real32, config,
+             values<float>({0.0f, 0.3f, 0.5f, 0.6f, 0.9f, 1.2f, 0.6f, 0.65f}), "P--P-PP-");
+    sequence("LREAL abs 0.5", ams::DataType::Real64, config,
+             values<double>({-1.0, -1.4, -0.4, -0.4, -0.95}), "P-P-P");
+
+    // Langsame Drift unterhalb der Totzone summiert sich auf
+    sequence("REAL Drift", ams::DataType::Real32, config,
+             values<float>({10.0f, 10.2f, 10.4f, 10.6f, 10.8f, 11.0f, 11.2f}), "P--P--P");
+
+    config.deadband_abs = 2.0;
+    sequence("INT abs 2", ams::DataType::Int16, config,
+             values<int16_t>({0, 1, 2, 3, -3, -5, -4, 32767}), "P--PP--P");
+    sequence("LINT abs 2", ams::DataType::Int64, config,
+             values<int64_t>({std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::min() + 2,
+                              0, 3}), "P-PP");
+}
+
+static void percent_deadband() {
+    FilterConfig config;
+    config.deadband_percent = 10.0;
+
+    // Letzter Wert 0: Schwelle 0 - jede Änderung geht durch, Gleichstand nicht
+    sequence("DINT 10% ab 0", ams::DataType::Int32, config,
+             values<int32_t>({0, 0, 1, 1, 100, 105, 110, 111, 111, 0}), "P-P-P--P-P");
+    sequence("REAL 10% ab 0", ams::DataType::Real32, config,
+             values<float>({0.0f, 0.0f, 1e-30f, -0.0f, 0.0f}), "P-PP-");
+
+    // Schwelle relativ zum letzten Betrag, auch bei negativen Werten
+    sequence("LREAL 10% negativ", ams::DataType::Real64, config,
+             values<double>({-50.0, -54.0, -56.0, -50.0, -50.3}), "P-PP-");
+
+    // Beide gesetzt: die größere Schwelle gilt
+    config.deadband_abs = 2.0;
+    sequence("DINT abs 2 / 10%", ams::DataType::Int32, config,
+             values<int32_t>({10, 12, 13, 1000, 1090, 1101, 1101}), "P-PP-P-");
+}
+
+static void bitwise_change() {
+    FilterConfig config;
+    config.on_change = true;
+
+    sequence("BOOL on_change", ams::DataType::Bit, config,
+             values<uint8_t>({0, 0, 1, 1, 1, 0}), "P-P--P");
+    sequence("UDINT on_change", ams::DataType::UInt32, config,
+             values<uint32_t>({7, 7, 8, 0x80000008u, 0x80000008u}), "P-PP-");
+
+    // Vorzeichenlose Typen vergleichen bitweise - eine Totzone wird ignoriert
+    FilterConfig deadband;
+    deadband.deadband_abs = 10.0;
+    sequence("UINT Totzone ignoriert", ams::DataType::UInt16, deadband,
+             values<uint16_t>({5, 5, 6, 7, 7}), "P-PP-");
+
+    // Struktur (100 Bytes): Änderung im ersten 64-Byte Block, im Rest, letztes Byte
+    std::vector<uint8_t> block(100, 0xA5);
+    std::vector<Step> steps;
+    steps.push_back({block, 0});
+    steps.push_back({block, 1});
+    block[3] ^= 0x01;
+    steps.push_back({block, 2});
+    steps.push_back({block, 3});
+    block[70] ^= 0x80;
+    steps.push_back({block, 4});
+    block[99] = 0;
+    steps.push_back({block, 5});
+    steps.push_back({block, 6});
+    sequence("STRUCT on_change", ams::DataType::BigType, config, steps, "P-P-PP-");
+
+    // STRING: Zeichen hinter dem NUL zählen ebenfalls als Änderung
+    std::vector<uint8_t> text(81, 0);
+    std::memcpy(text.data(), "abc", 3);
+    std::vector<Step> strings{{text, 0}, {text, 1}};
+    text[50] = 'x';
+    strings.push_back({text, 2});
+    sequence("STRING on_change", ams::DataType::String, config, strings, "P-P");
+}
+
+static void intervals() {
+    FilterConfig config;
+    config.on_change = true;
+    config.min_interval_ms = 10;
+    config.max_interval_ms = 100;
+
+    // Änderung bei 5 ms gedrosselt, kommt mit dem nächsten Zyklus nach Ablauf;
+    // ohne Änderung Heartbeat 100 ms nach dem letzten weitergereichten Sample
+    std::vector<Step> steps{
+        {bytes<int32_t>({1}), 0},
+        {bytes<int32_t>({2}), 5},
+        {bytes<int32_t>({2}), 9},
+        {bytes<int32_t>({2}), 10},
+        {bytes<int32_t>({2}), 50},
+        {bytes<int32_t>({2}), 109},
+        {bytes<int32_t>({2}), 110},
+        {bytes<int32_t>({3}), 115},
+        {bytes<int32_t>({3}), 120},
+        {bytes<int32_t>({3}), 60},      // Timestamp-Sprung zurück
+        {bytes<int32_t>({3}), 61},
+    };
+    sequence("DINT min 10 / max 100", ams::DataType::Int32, config, steps, "P--P--P-PP-");
+
+    // Nur Drossel: jedes Sample nach Ablauf geht durch, auch ohne Änderung
+    FilterConfig throttle;
+    throttle.min_interval_ms = 10;
+    std::vector<Step> throttled;
+    for (int64_t ms : {0, 3, 9, 10, 15, 19, 20, 45}) {
+        throttled.push_back({bytes<int32_t>({7}), ms});
+    }
+    sequence("DINT nur min 10", ams::DataType::Int32, throttle, throttled, "P--P--PP");
+
+    // Nur Heartbeat ohne Wertvergleich: jedes Sample geht durch
+    FilterConfig heartbeat;
+    heartbeat.max_interval_ms = 100;
+    sequence("DINT nur max 100", ams::DataType::Int32, heartbeat, values<int32_t>({1, 1, 1}), "PPP");
+}
+
+static void nan_values() {
+    FilterConfig config;
+    config.deadband_abs = 0.5;
+
+    const float qnan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    float negative_nan;   // anderes NaN-Bitmuster (Vorzeichen, Payload)
+    uint32_t bits = 0xFFC00001u;
+    std::memcpy(&negative_nan, &bits, sizeof(bits));
+
+    // Zahl -> NaN und NaN -> Zahl sind Änderungen, NaN -> NaN nicht
+    sequence("REAL NaN", ams::DataType::Real32, config,
+             values<float>({1.0f, qnan, qnan, negative_nan, 1.0f, 1.2f, inf, inf, qnan}), "PP--P-P-P");
+
+    const double dnan = std::numeric_limits<double>::quiet_NaN();
+    sequence("LREAL NaN", ams::DataType::Real64, config,
+             values<double>({dnan, dnan, 0.0, 0.4, dnan}), "P-P-P");
+
+    // Prozentuale Totzone: |NaN| als Referenz darf die Schwelle nicht vergiften
+    FilterConfig percent;
+    percent.deadband_percent = 10.0;
+    sequence("REAL NaN 10%", ams::DataType::Real32, percent,
+             values<float>({qnan, 100.0f, 105.0f, 111.0f}), "PP-P");
+}
+
+static void arrays() {
+    FilterConfig config;
+    config.deadband_abs = 0.5;
+
+    // REAL[40]: zwei 16er-Blöcke + Rest von 8 Elementen
+    std::vector<float> array(40, 1.0f);
+    auto step = [&array](int64_t ms) {
+        std::vector<uint8_t> data(array.size() * sizeof(float));
+        std::memcpy(data.data(), array.data(), data.size());
+        return Step{data, ms};
+    };
+    std::vector<Step> steps;
+    steps.push_back(step(0));
+    array[20] += 0.4f;                 // zweiter Block, unter der Totzone
+    steps.push_back(step(1));
+    array[20] += 0.4f;                 // 0.8 gegen den weitergereichten Wert
+    steps.push_back(step(2));
+    array[37] += 1.0f;                 // Rest
+    steps.push_back(step(3));
+    array[5] -= 0.6f;                  // erster Block
+    steps.push_back(step(4));
+    steps.push_back(step(5));
+    array[33] = std::numeric_limits<float>::quiet_NaN();
+    steps.push_back(step(6));
+    array[15] += 0.5f;                 // genau auf der Grenze
+    steps.push_back(step(7));
+    sequence("REAL[40] abs 0.5", ams::DataType::Real32, config, steps, "P-PPP-P-");
+
+    // LINT[3]: Rest ohne vollen Block
+    sequence("LINT[3] abs 0.5", ams::DataType::Int64, config,
+             {{bytes<int64_t>({1, 2, 3}), 0}, {bytes<int64_t>({1, 2, 3}), 1}, {bytes<int64_t>({1, 2, 4}), 2}},
+             "P-P");
+
+    // Größe ändert sich (z.B. Online Change): immer weiterreichen
+    sequence("DINT Größenwechsel", ams::DataType::Int32, config,
+             {{bytes<int32_t>({1, 2}), 0}, {bytes<int32_t>({1}), 1}, {bytes<int32_t>({1}), 2}}, "PP-");
+}
+
+int main() {
+    absolute_deadband();
+    percent_deadband();
+    bitwise_change();
+    intervals();
+    nan_values();
+    arrays();
+
+    if (g_failures == 0) {
+        std::cout << "✅ ValueFilter: alle Sequenzen wie erwartet\n";
+        return 0;
+    }
+    std::cout << g_failures << " Abweichung(en)\n";
+    return 1;
+}
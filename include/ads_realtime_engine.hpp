@@ -1,15 +1,27 @@
 #pragma once
 
 #include "realtime_config.hpp"
+#include "notification_ring.hpp"
+#include "latency_histogram.hpp"
+#include "ads_sumup.hpp"
+#include "ams_protocol.hpp"
+#include "value_decoder.hpp"
+#include "value_filter.hpp"
+#ifdef _WIN32
 #include <Windows.h>
 #include <TcAdsDef.h>
 #include <TcAdsAPI.h>
+#else
+#include "ams_tcp_client.hpp"
+#endif
 #include <functional>
 #include <memory>
 #include <atomic>
 #include <chrono>
 #include <unordered_map>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
 
 namespace ads_realtime {
 
@@ -17,15 +29,32 @@ namespace ads_realtime {
  * ADS Realtime Engine
  * 
  * High-performance ADS notification handler mit <1ms garantierter Latenz.
- * Verwendet Windows High-Resolution Timer und Lock-Free Data Structures.
+ * Verwendet High-Resolution Timer und Lock-Free Data Structures.
+ *
+ * Transport: Windows über TcAdsDll, sonst nativer AMS/TCP Client (AmsTcpClient,
+ * epoll) - Notifications kommen dort direkt aus dem IO Thread ohne DLL-Thread-Hop.
+ *
+ * Der ADS Callback kopiert nur Header + Sample in einen vorallokierten Ring;
+ * ein eigener Dispatcher Thread leert den Ring und ruft die User-Callbacks auf.
+ * Dadurch blockiert der ADS Router nie auf MQTT.
+ *
+ * Alternativ (AcquisitionMode::SumUpPolling) werden die Symbole zyklisch in
+ * Sum-Up Reads gruppiert; nur geänderte Werte gelangen in den Ring.
+ *
+ * Jede Variable erhält bei der Registrierung eine fortlaufende ID (0..N-1) und
+ * ein vorberechnetes MQTT Topic. Callbacks bekommen nur die ID - der Pfad vom
+ * ADS Sample bis zum Callback allokiert im eingeschwungenen Zustand nicht.
+ *
+ * Vor dem Ring sitzt pro Variable ein ValueFilter (Change-of-Value, Totzone,
+ * Min/Max-Intervall) - unveränderte Samples erreichen MQTT gar nicht erst.
  */
 class AdsRealtimeEngine {
 public:
     using NotificationCallback = std::function<void(
-        const std::string& variable_name,
+        uint32_t variable_id,
         const void* data,
         size_t data_size,
-        uint64_t timestamp_ns
+        uint64_t timestamp
     )>;
 
     explicit AdsRealtimeEngine(const RealtimeConfig& config);
@@ -43,11 +72,28 @@ public:
     /**
      * ADS Notification für Variable registrieren
      * @param variable_name Name der PLC Variable (z.B. "GVL.abc")
-     * @param callback Callback für Wertänderungen (wird in Realtime-Thread aufgerufen!)
+     * @param callback Callback für Wertänderungen (wird im Dispatcher Thread aufgerufen)
      * @return true bei Erfolg
      */
     bool add_variable(const std::string& variable_name, NotificationCallback callback);
 
+    /**
+     * Wie add_variable(), aber mit eigenem Filter statt RealtimeConfig::filter
+     */
+    bool add_variable(const std::string& variable_name, NotificationCallback callback,
+                      const FilterConfig& filter);
+
+    /**
+     * Viele Variablen auf einmal registrieren (Sum-Up Requests statt 2 Round Trips pro Symbol)
+     * Handles (0xF003) und Symbol-Infos (0xF009) werden in Blöcken zu je 500 per 0xF082 aufgelöst.
+     * @param variable_names Namen der PLC Variablen
+     * @param callback Gemeinsamer Callback für alle Variablen
+     * @return Anzahl erfolgreich registrierter Variablen
+     */
+    size_t add_variables(const std::vector<std::string>& variable_names, NotificationCallback callback);
+    size_t add_variables(const std::vector<std::string>& variable_names, NotificationCallback callback,
+                         const FilterConfig& filter);
+
     /**
      * Engine starten (beginnt Notification-Handling)
      */
@@ -58,49 +104,178 @@ public:
      */
     void stop();
 
+    /**
+     * Verbindung zur PLC noch aktiv?
+     * AMS/TCP: false nach Verbindungsverlust - Handles und Notifications sind dann
+     * verloren, die Engine baut sie nicht neu auf (Prozess neu starten).
+     * Windows: der lokale TwinCAT Router hält die Verbindung, true solange der Port offen ist.
+     */
+    bool is_connected() const;
+
     /**
      * Performance-Statistiken abrufen
      */
     PerformanceStats get_statistics() const;
 
+    /**
+     * Registrierte Variablen (IDs sind dicht: 0 .. variable_count()-1)
+     * Topic = <mqtt_topic_prefix>/<name>, einmalig bei der Registrierung gebaut.
+     */
+    uint32_t variable_count() const { return variable_count_.load(std::memory_order_acquire); }
+    const std::string& variable_name(uint32_t variable_id) const { return variable_table_[variable_id]->name; }
+    const std::string& variable_topic(uint32_t variable_id) const { return variable_table_[variable_id]->topic; }
+    size_t variable_size(uint32_t variable_id) const { return variable_table_[variable_id]->data_size; }
+
+    /**
+     * Typ-Decoder der Variable (aus AdsSymbolEntry::dataType, einmalig bei der Registrierung)
+     * Liefert JSON/Klartext/double ohne Typ-Dispatch pro Sample.
+     */
+    const ValueDecoder& variable_decoder(uint32_t variable_id) const { return variable_table_[variable_id]->decoder; }
+
 private:
     struct VariableHandle {
+        uint32_t id = 0;
         uint32_t handle = 0;
-        unsigned long notification_handle = 0;  // MUSS unsigned long sein f\u00fcr ADS API
+        uint32_t notification_handle = 0;
         NotificationCallback callback;
         std::string name;
+        std::string topic;
         size_t data_size = 0;
+        uint32_t data_type = static_cast<uint32_t>(ams::DataType::Int32);  // ADST_*
+        ValueDecoder decoder;
+        FilterConfig filter_config;
+        ValueFilter filter;                   // Nur vom einliefernden Thread benutzt
+        AdsRealtimeEngine* engine = nullptr;  // Für den statischen ADS Callback
     };
 
+#ifdef _WIN32
     // ADS Notification Callback (static für C-API)
+    // hUser ist nur 32 Bit breit: [Engine-Slot:8][Variable-ID:24] statt Pointer
     static void __stdcall ads_notification_callback(
         const AmsAddr* pAddr,
         const AdsNotificationHeader* pNotification,
         uint32_t hUser
     );
 
-    // Interne Notification-Verarbeitung
+    static constexpr uint32_t MAX_ENGINES = 256;
+    static constexpr uint32_t VARIABLE_ID_BITS = 24;
+    static inline std::atomic<AdsRealtimeEngine*> engines_[MAX_ENGINES] = {};
+    uint32_t engine_slot_ = 0;
+#else
+    // AMS/TCP Notification Callback (IO Thread des AmsTcpClient)
+    static void ams_notification_callback(
+        uintptr_t user,
+        const AmsTcpClient::Notification& notification
+    );
+
+    // Block mit fortlaufenden IDs übernehmen, Notifications per Sum-Up (0xF084) anlegen
+    size_t register_variables_sumup(std::vector<std::unique_ptr<VariableHandle>>& variables);
+
+    // Notifications eines Blocks per Sum-Up (0xF084) in einem Round Trip anlegen
+    // (false wenn der Request scheitert - dann ist keine Notification aktiv)
+    bool add_notifications_sumup(std::vector<std::unique_ptr<VariableHandle>>& variables);
+#endif
+
+    // Transport-Abstraktion (TcAdsDll bzw. AmsTcpClient), Rückgabe: ADS Fehlercode
+    long ads_read_write(uint32_t index_group, uint32_t index_offset,
+                        uint32_t read_length, void* read_data,
+                        uint32_t write_length, const void* write_data,
+                        uint32_t* bytes_read = nullptr);
+    long ads_add_notification(VariableHandle* var_handle, const AdsNotificationAttrib& attrib,
+                              uint32_t* notification_handle);
+
+    // Alle Device Notifications entfernen (Aufrufer hält variables_mutex_)
+    void delete_notifications();
+
+    // Device Notification für eine Variable anlegen (AcquisitionMode::Notification)
+    bool add_notification(VariableHandle* var_handle);
+
+    // Sum-Up Registrierung eines Blocks (max. ADS_SUMUP_MAX_ITEMS Namen)
+    size_t add_variable_batch(const std::vector<std::string>& variable_names,
+                              size_t begin, size_t end,
+                              const NotificationCallback& callback,
+                              const FilterConfig& filter);
+
+    // ID, Topic, Decoder und Filter setzen, Tabelleneintrag veröffentlichen (false bei max_variables)
+    bool prepare_variable(VariableHandle* var_handle, uint32_t id);
+
+    // Variable nach erfolgreicher Auflösung übernehmen (Notification anlegen, speichern)
+    bool register_variable(std::unique_ptr<VariableHandle> var_handle);
+
+    // Alle Symbol-Handles per Sum-Up Write (0xF081 / 0xF006) freigeben
+    void release_handles();
+
+    // Sum-Up Polling: eine Gruppe = ein Round Trip (0xF080)
+    struct PollGroup {
+        SumUpReadRequest request;
+        std::vector<VariableHandle*> variables;   // Änderungserkennung über VariableHandle::filter
+    };
+
+    // Sample filtern, in den Ring kopieren und Dispatcher wecken (ADS Callback / Poll Thread)
+    // false nur wenn die Queue voll ist (gefilterte Samples gelten als erledigt)
+    bool enqueue_sample(VariableHandle* var_handle, const void* data,
+                        uint32_t size, int64_t ads_timestamp, uint32_t notification_handle = 0);
+
+    // Sum-Up Polling Thread
+    void build_poll_groups();
+    void poll_loop();
+    void poll_group(PollGroup& group, int64_t ads_timestamp);
+
+    // Interne Notification-Verarbeitung (Dispatcher Thread)
     void process_notification(
-        const AdsNotificationHeader* notification,
-        VariableHandle* var_handle
+        const NotificationSample& sample,
+        const uint8_t* data
     );
 
+    // Dispatcher Thread: leert den Notification Ring
+    void dispatch_loop();
+
     // High-Resolution Timer
     uint64_t get_timestamp_ns() const;
 
     RealtimeConfig config_;
     AmsAddr ams_addr_{};
+#ifdef _WIN32
     long ads_port_ = 0;
+#else
+    std::unique_ptr<AmsTcpClient> ams_client_;
+#endif
     
     std::atomic<bool> running_{false};
     std::unordered_map<uint32_t, std::unique_ptr<VariableHandle>> variables_;
     std::mutex variables_mutex_;
 
-    // Performance tracking
+    // Variable-ID -> Handle (fest vorallokiert, wächst nie während Samples laufen)
+    std::vector<VariableHandle*> variable_table_;
+    std::atomic<uint32_t> variable_count_{0};
+
+    // Notification Hand-off
+    using Ring = NotificationRing<256>;
+    std::unique_ptr<Ring> ring_;
+    std::thread dispatch_thread_;
+    std::mutex dispatch_mutex_;
+    std::condition_variable dispatch_cv_;
+    std::atomic<bool> dispatcher_waiting_{false};
+    std::atomic<uint64_t> notifications_dispatched_{0};
+    std::atomic<uint64_t> samples_filtered_{0};
+
+    // Sum-Up Polling
+    std::vector<PollGroup> poll_groups_;
+    std::thread poll_thread_;
+    std::atomic<uint64_t> poll_cycles_{0};
+    std::atomic<uint64_t> poll_overruns_{0};
+
+    // Performance tracking (lock-frei, fixer Speicher)
+    std::unique_ptr<LatencyRecorder> latency_recorder_;
+    std::atomic<uint64_t> deadline_misses_{0};
+    
+    // Throughput-Berechnung zwischen zwei get_statistics() Aufrufen
     mutable std::mutex stats_mutex_;
-    PerformanceStats stats_{};
-    std::vector<double> latency_samples_;
+    mutable uint64_t last_stats_count_ = 0;
+    mutable uint64_t last_stats_time_ns_ = 0;
+#ifdef _WIN32
     LARGE_INTEGER qpc_frequency_{};
+#endif
 };
 
 } // namespace ads_realtime
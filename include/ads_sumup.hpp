@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ads_realtime {
+
+// ADS Sum-Up Index Groups (mehrere Sub-Kommandos in einem Round Trip)
+// Limit laut TwinCAT: max. 500 Sub-Kommandos pro Request
+constexpr uint32_t ADSIGRP_SUMUP_READ = 0xF080;
+constexpr uint32_t ADSIGRP_SUMUP_WRITE = 0xF081;
+constexpr uint32_t ADSIGRP_SUMUP_READWRITE = 0xF082;
+constexpr uint32_t ADSIGRP_SUMUP_READEX = 0xF083;
+constexpr uint32_t ADSIGRP_SUMUP_ADDDEVNOTE = 0xF084;
+constexpr uint32_t ADSIGRP_SUMUP_DELDEVNOTE = 0xF085;
+
+constexpr uint32_t ADS_SUMUP_MAX_ITEMS = 500;
+
+// Sum-Up Read Request (0xF080)
+// Write-Daten: N x [indexGroup:4][indexOffset:4][length:4]
+// Read-Daten:  N x [result:4] gefolgt von allen Werten hintereinander
+// Puffer werden einmal aufgebaut und dann zyklisch wiederverwendet.
+class SumUpReadRequest {
+public:
+    void add(uint32_t index_group, uint32_t index_offset, uint32_t length) {
+        uint32_t item[3] = {index_group, index_offset, length};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(item);
+        write_buffer_.insert(write_buffer_.end(), bytes, bytes + sizeof(item));
+        lengths_.push_back(length);
+    }
+
+    // Read-Puffer und Offsets berechnen (nach dem letzten add())
+    void finalize() {
+        size_t count = lengths_.size();
+        offsets_.resize(count);
+        size_t offset = count * sizeof(uint32_t);
+        for (size_t i = 0; i < count; i++) {
+            offsets_[i] = static_cast<uint32_t>(offset);
+            offset += lengths_[i];
+        }
+        read_buffer_.assign(offset, 0);
+    }
+
+    uint32_t count() const { return static_cast<uint32_t>(lengths_.size()); }
+
+    const uint8_t* write_data() const { return write_buffer_.data(); }
+    uint32_t write_size() const { return static_cast<uint32_t>(write_buffer_.size()); }
+
+    uint8_t* read_data() { return read_buffer_.data(); }
+    const uint8_t* read_data() const { return read_buffer_.data(); }
+    uint32_t read_size() const { return static_cast<uint32_t>(read_buffer_.size()); }
+
+    // ADS Fehlercode des i-ten Sub-Kommandos (0 = OK)
+    uint32_t result(size_t i) const {
+        uint32_t code;
+        std::memcpy(&code, read_buffer_.data() + i * sizeof(uint32_t), sizeof(code));
+        return code;
+    }
+
+    const uint8_t* value(size_t i) const { return read_buffer_.data() + offsets_[i]; }
+    uint32_t value_offset(size_t i) const { return offsets_[i]; }
+    uint32_t length(size_t i) const { return lengths_[i]; }
+
+private:
+    std::vector<uint8_t> write_buffer_;
+    std::vector<uint8_t> read_buffer_;
+    std::vector<uint32_t> lengths_;
+    std::vector<uint32_t> offsets_;
+};
+
+// Sum-Up Read/Write Request (0xF082) - z.B. Handles (0xF003) oder Symbol-Info (0xF009) per Name
+// Write-Daten: N x [indexGroup:4][indexOffset:4][readLength:4][writeLength:4] + alle Write-Daten
+// Read-Daten:  N x [result:4][returnedLength:4] + zurückgegebene Daten lückenlos hintereinander
+class SumUpReadWriteRequest {
+public:
+    void add(uint32_t index_group, uint32_t index_offset, uint32_t read_length,
+             const void* write_data, uint32_t write_length) {
+        uint32_t item[4] = {index_group, index_offset, read_length, write_length};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(item);
+        headers_.insert(headers_.end(), bytes, bytes + sizeof(item));
+        const uint8_t* payload = static_cast<const uint8_t*>(write_data);
+        payload_.insert(payload_.end(), payload, payload + write_length);
+        read_lengths_.push_back(read_length);
+    }
+
+    void finalize() {
+        write_buffer_.clear();
+        write_buffer_.reserve(headers_.size() + payload_.size());
+        write_buffer_.insert(write_buffer_.end(), headers_.begin(), headers_.end());
+        write_buffer_.insert(write_buffer_.end(), payload_.begin(), payload_.end());
+
+        size_t size = read_lengths_.size() * 2 * sizeof(uint32_t);
+        for (uint32_t len : read_lengths_) {
+            size += len;
+        }
+        read_buffer_.assign(size, 0);
+    }
+
+    // Offsets anhand der zurückgegebenen Längen berechnen (nach dem Request)
+    bool parse(uint32_t bytes_returned) {
+        size_t count = read_lengths_.size();
+        size_t offset = count * 2 * sizeof(uint32_t);
+        if (bytes_returned < offset || bytes_returned > read_buffer_.size()) {
+            return false;
+        }
+        offsets_.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            offsets_[i] = static_cast<uint32_t>(offset);
+            offset += returned_length(i);
+            if (offset > bytes_returned) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t count() const { return static_cast<uint32_t>(read_lengths_.size()); }
+
+    const uint8_t* write_data() const { return write_buffer_.data(); }
+    uint32_t write_size() const { return static_cast<uint32_t>(write_buffer_.size()); }
+
+    uint8_t* read_data() { return read_buffer_.data(); }
+    uint32_t read_size() const { return static_cast<uint32_t>(read_buffer_.size()); }
+
+    uint32_t result(size_t i) const { return read_u32(i * 2 * sizeof(uint32_t)); }
+    uint32_t returned_length(size_t i) const { return read_u32(i * 2 * sizeof(uint32_t) + sizeof(uint32_t)); }
+    const uint8_t* value(size_t i) const { return read_buffer_.data() + offsets_[i]; }
+
+private:
+    uint32_t read_u32(size_t offset) const {
+        uint32_t v;
+        std::memcpy(&v, read_buffer_.data() + offset, sizeof(v));
+        return v;
+    }
+
+    std::vector<uint8_t> headers_;
+    std::vector<uint8_t> payload_;
+    std::vector<uint8_t> write_buffer_;
+    std::vector<uint8_t> read_buffer_;
+    std::vector<uint32_t> read_lengths_;
+    std::vector<uint32_t> offsets_;
+};
+
+// Sum-Up Write Request (0xF081) - z.B. Handles freigeben (0xF006)
+// Write-Daten: N x [indexGroup:4][indexOffset:4][length:4] + alle Daten
+// Read-Daten:  N x [result:4]
+class SumUpWriteRequest {
+public:
+    void add(uint32_t index_group, uint32_t index_offset, const void* data, uint32_t length) {
+        uint32_t item[3] = {index_group, index_offset, length};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(item);
+        headers_.insert(headers_.end(), bytes, bytes + sizeof(item));
+        const uint8_t* payload = static_cast<const uint8_t*>(data);
+        payload_.insert(payload_.end(), payload, payload + length);
+        count_++;
+    }
+
+    void finalize() {
+        write_buffer_.clear();
+        write_buffer_.reserve(headers_.size() + payload_.size());
+        write_buffer_.insert(write_buffer_.end(), headers_.begin(), headers_.end());
+        write_buffer_.insert(write_buffer_.end(), payload_.begin(), payload_.end());
+        read_buffer_.assign(count_ * sizeof(uint32_t), 0);
+    }
+
+    uint32_t count() const { return count_; }
+
+    const uint8_t* write_data() const { return write_buffer_.data(); }
+    uint32_t write_size() const { return static_cast<uint32_t>(write_buffer_.size()); }
+
+    uint8_t* read_data() { return read_buffer_.data(); }
+    uint32_t read_size() const { return static_cast<uint32_t>(read_buffer_.size()); }
+
+    uint32_t result(size_t i) const {
+        uint32_t code;
+        std::memcpy(&code, read_buffer_.data() + i * sizeof(uint32_t), sizeof(code));
+        return code;
+    }
+
+private:
+    std::vector<uint8_t> headers_;
+    std::vector<uint8_t> payload_;
+    std::vector<uint8_t> write_buffer_;
+    std::vector<uint8_t> read_buffer_;
+    uint32_t count_ = 0;
+};
+
+// Sum-Up Add Device Notification (0xF084)
+// Write-Daten: N x [indexGroup:4][indexOffset:4][length:4][transMode:4][maxDelay:4][cycleTime:4][reserved:16]
+// Read-Daten:  N x [result:4][notificationHandle:4]
+// Zeiten in 100ns Einheiten (wie im AMS Protokoll)
+class SumUpAddNotificationRequest {
+public:
+    void add(uint32_t index_group, uint32_t index_offset, uint32_t length,
+             uint32_t trans_mode, uint32_t max_delay_100ns, uint32_t cycle_time_100ns) {
+        uint32_t item[10] = {index_group, index_offset, length, trans_mode,
+                             max_delay_100ns, cycle_time_100ns, 0, 0, 0, 0};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(item);
+        write_buffer_.insert(write_buffer_.end(), bytes, bytes + sizeof(item));
+        count_++;
+    }
+
+    void finalize() {
+        read_buffer_.assign(count_ * 2 * sizeof(uint32_t), 0);
+    }
+
+    uint32_t count() const { return count_; }
+
+    const uint8_t* write_data() const { return write_buffer_.data(); }
+    uint32_t write_size() const { return static_cast<uint32_t>(write_buffer_.size()); }
+
+    uint8_t* read_data() { return read_buffer_.data(); }
+    uint32_t read_size() const { return static_cast<uint32_t>(read_buffer_.size()); }
+
+    uint32_t result(size_t i) const { return read_u32(i * 2); }
+    uint32_t notification_handle(size_t i) const { return read_u32(i * 2 + 1); }
+
+private:
+    uint32_t read_u32(size_t index) const {
+        uint32_t v;
+        std::memcpy(&v, read_buffer_.data() + index * sizeof(uint32_t), sizeof(v));
+        return v;
+    }
+
+    std::vector<uint8_t> write_buffer_;
+    std::vector<uint8_t> read_buffer_;
+    uint32_t count_ = 0;
+};
+
+// Sum-Up Delete Device Notification (0xF085)
+// Write-Daten: N x [notificationHandle:4]
+// Read-Daten:  N x [result:4]
+class SumUpDelNotificationRequest {
+public:
+    void add(uint32_t notification_handle) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&notification_handle);
+        write_buffer_.insert(write_buffer_.end(), bytes, bytes + sizeof(notification_handle));
+        count_++;
+    }
+
+    void finalize() {
+        read_buffer_.assign(count_ * sizeof(uint32_t), 0);
+    }
+
+    uint32_t count() const { return count_; }
+
+    const uint8_t* write_data() const { return write_buffer_.data(); }
+    uint32_t write_size() const { return static_cast<uint32_t>(write_buffer_.size()); }
+
+    uint8_t* read_data() { return read_buffer_.data(); }
+    uint32_t read_size() const { return static_cast<uint32_t>(read_buffer_.size()); }
+
+    uint32_t result(size_t i) const {
+        uint32_t code;
+        std::memcpy(&code, read_buffer_.data() + i * sizeof(uint32_t), sizeof(code));
+        return code;
+    }
+
+private:
+    std::vector<uint8_t> write_buffer_;
+    std::vector<uint8_t> read_buffer_;
+    uint32_t count_ = 0;
+};
+
+} // namespace ads_realtime
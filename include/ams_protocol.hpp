@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace ads_realtime {
+namespace ams {
+
+// AMS/TCP Protokoll (Beckhoff ADS über TCP, Port 48898)
+// Frame: [AMS/TCP Header:6][AMS Header:32][ADS Daten]
+// Alle Felder Little Endian (Zielplattformen x86/ARM sind LE, daher direktes memcpy)
+constexpr uint16_t AMS_TCP_PORT = 48898;
+constexpr uint16_t AMS_DEFAULT_SOURCE_PORT = 32905;
+
+enum class Command : uint16_t {
+    ReadDeviceInfo = 1,
+    Read = 2,
+    Write = 3,
+    ReadState = 4,
+    WriteControl = 5,
+    AddNotification = 6,
+    DelNotification = 7,
+    Notification = 8,
+    ReadWrite = 9
+};
+
+// ADS Datentypen (AdsSymbolEntry::dataType, Werte wie ADST_* in TcAdsDef.h)
+enum class DataType : uint32_t {
+    Void = 0,
+    Int16 = 2,
+    Int32 = 3,
+    Real32 = 4,
+    Real64 = 5,
+    Int8 = 16,
+    UInt8 = 17,
+    UInt16 = 18,
+    UInt32 = 19,
+    Int64 = 20,
+    UInt64 = 21,
+    String = 30,
+    WString = 31,
+    Bit = 33,
+    BigType = 65     // Strukturen, Arrays, FBs
+};
+
+constexpr uint16_t STATE_FLAG_RESPONSE = 0x0001;
+constexpr uint16_t STATE_FLAG_ADS_COMMAND = 0x0004;
+constexpr uint16_t STATE_FLAGS_REQUEST = STATE_FLAG_ADS_COMMAND;
+constexpr uint16_t STATE_FLAGS_RESPONSE = STATE_FLAG_ADS_COMMAND | STATE_FLAG_RESPONSE;
+
+// ADS Fehlercodes (Teilmenge, Werte wie TcAdsDef.h)
+constexpr uint32_t ERR_NOERROR = 0;
+constexpr uint32_t ERR_DEVICE_SRVNOTSUPP = 0x701;
+constexpr uint32_t ERR_DEVICE_INVALIDGRP = 0x702;
+constexpr uint32_t ERR_DEVICE_INVALIDOFFSET = 0x703;
+constexpr uint32_t ERR_DEVICE_INVALIDSIZE = 0x705;
+constexpr uint32_t ERR_DEVICE_SYMBOLNOTFOUND = 0x710;
+constexpr uint32_t ERR_DEVICE_NOTIFYHNDINVALID = 0x714;
+constexpr uint32_t ERR_CLIENT_INVALIDPARM = 0x741;
+constexpr uint32_t ERR_CLIENT_SYNCTIMEOUT = 0x745;
+constexpr uint32_t ERR_CLIENT_PORTNOTOPEN = 0x748;
+constexpr uint32_t ERR_CLIENT_SYNCRESINVALID = 0x754;
+
+#pragma pack(push, 1)
+struct NetId {
+    uint8_t b[6];
+};
+
+struct TcpHeader {
+    uint16_t reserved;         // immer 0
+    uint32_t length;           // AMS Header + Daten
+};
+
+struct Header {
+    NetId target_net_id;
+    uint16_t target_port;
+    NetId source_net_id;
+    uint16_t source_port;
+    uint16_t command_id;
+    uint16_t state_flags;
+    uint32_t data_length;
+    uint32_t error_code;
+    uint32_t invoke_id;
+};
+
+struct ReadRequest {
+    uint32_t index_group;
+    uint32_t index_offset;
+    uint32_t length;
+};
+
+struct WriteRequest {
+    uint32_t index_group;
+    uint32_t index_offset;
+    uint32_t length;
+    // gefolgt von length Bytes
+};
+
+struct ReadWriteRequest {
+    uint32_t index_group;
+    uint32_t index_offset;
+    uint32_t read_length;
+    uint32_t write_length;
+    // gefolgt von write_length Bytes
+};
+
+struct AddNotificationRequest {
+    uint32_t index_group;
+    uint32_t index_offset;
+    uint32_t length;
+    uint32_t trans_mode;
+    uint32_t max_delay;        // 100ns Einheiten
+    uint32_t cycle_time;       // 100ns Einheiten
+    uint8_t reserved[16];
+};
+
+struct DelNotificationRequest {
+    uint32_t notification_handle;
+};
+
+struct ReadResponse {
+    uint32_t result;
+    uint32_t length;
+    // gefolgt von length Bytes (auch für ReadWrite)
+};
+
+struct WriteResponse {
+    uint32_t result;
+};
+
+struct AddNotificationResponse {
+    uint32_t result;
+    uint32_t notification_handle;
+};
+
+// Device Notification Stream (Command 8, vom Server initiiert)
+// [length:4][stamps:4] { [timestamp:8][samples:4] { [handle:4][size:4][data] }* }*
+struct NotificationStreamHeader {
+    uint32_t length;
+    uint32_t stamps;
+};
+
+struct NotificationStampHeader {
+    int64_t timestamp;         // FILETIME (100ns seit 1601)
+    uint32_t samples;
+};
+
+struct NotificationSampleHeader {
+    uint32_t notification_handle;
+    uint32_t sample_size;
+};
+#pragma pack(pop)
+
+constexpr size_t FRAME_HEADER_SIZE = sizeof(TcpHeader) + sizeof(Header);
+
+// Obergrenze für TcpHeader::length ohne passenden Request (Notification Streams,
+// kleine Antworten) - größere Read-Antworten nur, wenn ein Request sie anfordert
+constexpr uint32_t MAX_FRAME_DATA = 64 * 1024;
+
+// "192.168.3.42.1.1" -> NetId
+inline bool parse_net_id(const std::string& text, NetId& net_id) {
+    unsigned int b[6];
+    char tail;
+    if (std::sscanf(text.c_str(), "%u.%u.%u.%u.%u.%u%c",
+                    &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &tail) != 6) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (b[i] > 255) return false;
+        net_id.b[i] = static_cast<uint8_t>(b[i]);
+    }
+    return true;
+}
+
+inline std::string to_string(const NetId& net_id) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u.%u.%u",
+                  net_id.b[0], net_id.b[1], net_id.b[2], net_id.b[3], net_id.b[4], net_id.b[5]);
+    return buffer;
+}
+
+} // namespace ams
+
+#ifndef _WIN32
+// TcAdsDef.h-kompatible Typen (identisches Layout) für Builds ohne TcAdsDll
+#pragma pack(push, 1)
+using AmsNetId = ams::NetId;
+
+struct AmsAddr {
+    AmsNetId netId;
+    uint16_t port;
+};
+
+enum ADSTRANSMODE : uint32_t {
+    ADSTRANS_NOTRANS = 0,
+    ADSTRANS_CLIENTCYCLE = 1,
+    ADSTRANS_CLIENT1REQ = 2,
+    ADSTRANS_SERVERCYCLE = 3,
+    ADSTRANS_SERVERONCHA = 4
+};
+
+struct AdsNotificationAttrib {
+    uint32_t cbLength;
+    ADSTRANSMODE nTransMode;
+    uint32_t nMaxDelay;        // 100ns Einheiten
+    uint32_t nCycleTime;       // 100ns Einheiten
+};
+
+struct AdsSymbolEntry {
+    uint32_t entryLength;      // Länge des kompletten Eintrags
+    uint32_t iGroup;
+    uint32_t iOffs;
+    uint32_t size;             // Größe in Bytes (0 = Bit)
+    uint32_t dataType;         // ADS Datentyp (ADST_*)
+    uint32_t flags;
+    uint16_t nameLength;       // ohne \0
+    uint16_t typeLength;       // ohne \0
+    uint16_t commentLength;    // ohne \0
+    // char name[], type[], comment[] jeweils mit \0
+};
+#pragma pack(pop)
+#endif // !_WIN32
+
+} // namespace ads_realtime
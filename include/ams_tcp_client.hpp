@@ -0,0 +1,159 @@
+#pragma once
+
+#include "ams_protocol.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ads_realtime {
+
+/**
+ * Nativer AMS/TCP Client (Linux, epoll)
+ *
+ * Ersetzt TcAdsDll auf Plattformen ohne TwinCAT Router:
+ * - eigenes Framing (AMS/TCP + AMS Header) über einen non-blocking Socket
+ * - synchrone Requests mit Invoke-ID Zuordnung (Antwortdaten direkt in den Caller-Puffer)
+ * - Notification Stream Parser: Samples werden in-place aus dem Empfangspuffer
+ *   an den Callback gereicht (kein Thread-Hop, keine Kopie)
+ *
+ * Die PLC benötigt eine statische Route auf die lokale AMS NetId dieses Clients.
+ */
+class AmsTcpClient {
+public:
+    struct Notification {
+        uint32_t notification_handle;
+        int64_t timestamp;           // FILETIME (100ns seit 1601)
+        const uint8_t* data;         // zeigt in den Empfangspuffer, nur im Callback gültig
+        uint32_t size;
+    };
+
+    // Wird im IO Thread aufgerufen - darf nicht blockieren
+    using NotificationFunc = void (*)(uintptr_t user, const Notification& notification);
+
+    AmsTcpClient();
+    ~AmsTcpClient();
+
+    AmsTcpClient(const AmsTcpClient&) = delete;
+    AmsTcpClient& operator=(const AmsTcpClient&) = delete;
+
+    /**
+     * TCP Verbindung zum AMS Router der PLC aufbauen und IO Thread starten
+     * @param ip IP-Adresse der PLC
+     * @param local_net_id Lokale AMS NetId (leer = <lokale IP>.1.1)
+     */
+    bool connect(const std::string& ip, const std::string& local_net_id = "",
+                 uint16_t tcp_port = ams::AMS_TCP_PORT);
+
+    void disconnect();
+
+    bool is_connected() const { return connected_.load(std::memory_order_acquire); }
+
+    const AmsAddr& local_addr() const { return local_addr_; }
+
+    void set_timeout_ms(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+
+    // Für Scheduling/Affinität des IO Threads (ruft die Notification Callbacks auf)
+    std::thread::native_handle_type io_thread_handle() { return io_thread_.native_handle(); }
+
+    // Synchrone ADS Requests (Rückgabe: ADS Fehlercode, 0 = OK)
+    long read(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+              uint32_t length, void* data, uint32_t* bytes_read);
+
+    long write(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+               uint32_t length, const void* data);
+
+    long read_write(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                    uint32_t read_length, void* read_data,
+                    uint32_t write_length, const void* write_data,
+                    uint32_t* bytes_read);
+
+    long add_notification(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                          const AdsNotificationAttrib& attrib, NotificationFunc func,
+                          uintptr_t user, uint32_t* notification_handle);
+
+    long del_notification(const AmsAddr& target, uint32_t notification_handle);
+
+    // Callback für Notifications zuordnen, die per Sum-Up (0xF084) angelegt wurden
+    void register_notification(uint32_t notification_handle, NotificationFunc func, uintptr_t user);
+    void unregister_notification(uint32_t notification_handle);
+
+    // Statistiken
+    uint64_t notifications_received() const { return notifications_received_.load(std::memory_order_relaxed); }
+    uint64_t notifications_unknown() const { return notifications_unknown_.load(std::memory_order_relaxed); }
+
+private:
+    // Ausstehender synchroner Request (lebt auf dem Stack des Aufrufers)
+    struct PendingRequest {
+        uint32_t invoke_id = 0;
+        ams::Command command = ams::Command::Read;
+        void* read_data = nullptr;           // Ziel für Antwortdaten
+        uint32_t read_capacity = 0;
+        uint32_t bytes_read = 0;
+        uint32_t result = 0;
+        uint32_t value = 0;                  // z.B. Notification Handle
+        bool done = false;
+    };
+
+    struct NotificationTarget {
+        NotificationFunc func = nullptr;
+        uintptr_t user = 0;
+    };
+
+    long transact(const AmsAddr& target, ams::Command command,
+                  const void* header, uint32_t header_size,
+                  const void* payload, uint32_t payload_size,
+                  PendingRequest& pending);
+
+    bool send_frame(const AmsAddr& target, ams::Command command, uint16_t state_flags,
+                    uint32_t invoke_id, const void* header, uint32_t header_size,
+                    const void* payload, uint32_t payload_size);
+
+    void io_loop();
+    bool receive();
+    size_t process_frames(const uint8_t* data, size_t size);
+    void raise_frame_limit(uint32_t read_capacity);
+    void handle_response(const ams::Header& header, const uint8_t* data, uint32_t size);
+    void handle_notification_stream(const uint8_t* data, uint32_t size);
+    void fail_pending(uint32_t error);
+    void close_socket();
+
+    int socket_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::thread io_thread_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> running_{false};
+
+    AmsAddr local_addr_{};
+    uint32_t timeout_ms_ = 5000;
+
+    // Senden (ein Frame am Stück per writev)
+    std::mutex send_mutex_;
+
+    // Invoke-ID -> wartender Request
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::unordered_map<uint32_t, PendingRequest*> pending_;
+    uint32_t next_invoke_id_ = 1;
+
+    // Notification Handle -> Callback
+    std::mutex notifications_mutex_;
+    std::unordered_map<uint32_t, NotificationTarget> notifications_;
+
+    // Empfangspuffer (nur IO Thread)
+    std::vector<uint8_t> rx_buffer_;
+    size_t rx_size_ = 0;
+
+    // Größte zulässige TcpHeader::length: MAX_FRAME_DATA, angehoben durch große Reads
+    std::atomic<uint32_t> max_frame_length_{sizeof(ams::Header) + ams::MAX_FRAME_DATA};
+
+    std::atomic<uint64_t> notifications_received_{0};
+    std::atomic<uint64_t> notifications_unknown_{0};
+};
+
+} // namespace ads_realtime
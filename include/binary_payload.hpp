@@ -1,9 +1,13 @@
 ﻿#pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <cstring>
-#include <vector>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace ads_realtime {
 
@@ -12,7 +16,7 @@ namespace ads_realtime {
 #pragma pack(push, 1)
 struct BinaryPayloadHeader {
     uint8_t version;           // Protocol version (1)
-    uint8_t type;              // Payload type (0=single, 1=batch, 2=compressed)
+    uint8_t type;              // Payload type (0=single, 1=batch, 2=compressed, 3=id batch, 4=schema, 5=columnar)
     uint16_t variable_count;   // Anzahl Variablen
     uint32_t total_size;       // Gesamtgröße payload
     uint64_t timestamp_us;     // Timestamp in Mikrosekunden
@@ -25,12 +29,28 @@ struct VariableHeader {
     uint32_t data_length;      // Länge der Daten
     uint64_t timestamp_us;     // Variable-spezifischer Timestamp
 };
+
+// IdBatch und Schema: folgt direkt auf BinaryPayloadHeader
+struct SchemaVersionHeader {
+    uint32_t schema_version;   // PayloadSchema::version() (Inhalts-Hash)
+};
+
+// Schema: ein Eintrag pro Variable, danach der Name
+struct SchemaEntryHeader {
+    uint16_t variable_id;
+    uint8_t data_type;         // AdsDataType
+    uint16_t value_size;       // Bytes pro Wert, 0 = variable Länge
+    uint16_t name_length;
+};
 #pragma pack(pop)
 
 enum class PayloadType : uint8_t {
     Single = 0,
     Batch = 1,
-    Compressed = 2
+    Compressed = 2,
+    IdBatch = 3,      // [var_id:2][Wert] bzw. [var_id:2][len:2][Wert], Namen/Typen im Schema
+    Schema = 4,       // Variable-ID -> Name, Datentyp, Wertgröße (retained publizieren)
+    Columnar = 5      // Spalten: Timestamps, IDs, Werte pro Datentyp (columnar_payload.hpp)
 };
 
 enum class AdsDataType : uint8_t {
@@ -44,84 +64,324 @@ enum class AdsDataType : uint8_t {
     Real32 = 8,
     Real64 = 9,
     String = 10,
-    Custom = 255
+    Int8 = 11,
+    UInt64 = 12,
+    WString = 13,
+    Custom = 255      // Strukturen/FBs: Rohbytes
+};
+
+/**
+ * Schema für IdBatch Payloads: Variable-ID -> Name, Datentyp, Wertgröße
+ *
+ * Statt des Namens (meist 10x größer als der Wert) trägt jeder IdBatch
+ * Eintrag nur die 2-Byte Variable-ID; Werte fester Größe (value_size > 0)
+ * kommen ohne Längenfeld aus. Das Schema wird als Schema-Payload retained auf
+ * topic(<topic_prefix>) publiziert (MqttPublisher::publish_retained), neue
+ * Consumer erhalten es beim Subscribe sofort.
+ *
+ * Versionierung: version() ist ein FNV-1a Hash über den Inhalt - gleich über
+ * Neustarts, neu bei jeder Änderung. Jedes IdBatch trägt die Version; passt
+ * sie nicht zum bekannten Schema (BinaryPayloadView::needs_schema()), wartet
+ * der Consumer auf die nächste Schema-Nachricht statt falsch zu dekodieren.
+ *
+ * Nicht thread-safe: vor dem Start befüllen, danach nur lesen.
+ */
+class PayloadSchema {
+public:
+    struct Variable {
+        std::string name;                    // leer = ID nicht belegt
+        AdsDataType type = AdsDataType::Custom;
+        uint16_t value_size = 0;             // 0 = variable Länge
+    };
+
+    // Wertgröße fester ADS Datentypen (0: String/WString/Custom)
+    static constexpr uint16_t fixed_size(AdsDataType type) {
+        switch (type) {
+            case AdsDataType::Bool:
+            case AdsDataType::Byte:
+            case AdsDataType::Int8:   return 1;
+            case AdsDataType::Word:
+            case AdsDataType::Int16:  return 2;
+            case AdsDataType::Dword:
+            case AdsDataType::Int32:
+            case AdsDataType::Real32: return 4;
+            case AdsDataType::Int64:
+            case AdsDataType::UInt64:
+            case AdsDataType::Real64: return 8;
+            default:                  return 0;
+        }
+    }
+
+    static std::string topic(const std::string& topic_prefix) { return topic_prefix + "/_schema"; }
+
+    /**
+     * Variable eintragen bzw. ändern
+     * value_size 0: aus dem Datentyp; Strings/Strukturen mit fester Symbolgröße
+     * (z.B. STRING(80) = 81 Bytes) können ihre Größe angeben und sparen das Längenfeld
+     */
+    bool set(uint16_t id, const std::string& name, AdsDataType type, size_t value_size = 0) {
+        if (name.empty() || name.size() > UINT16_MAX || value_size > UINT16_MAX) return false;
+        if (id >= variables_.size()) variables_.resize(static_cast<size_t>(id) + 1);
+        Variable& variable = variables_[id];
+        if (variable.name.empty()) count_++;
+        variable.name = name;
+        variable.type = type;
+        variable.value_size = value_size > 0 ? static_cast<uint16_t>(value_size) : fixed_size(type);
+        version_ = 0;
+        return true;
+    }
+
+    void remove(uint16_t id) {
+        if (id < variables_.size() && !variables_[id].name.empty()) {
+            variables_[id] = Variable();
+            count_--;
+            version_ = 0;
+        }
+    }
+
+    void clear() {
+        variables_.clear();
+        count_ = 0;
+        version_ = 0;
+    }
+
+    const Variable* find(uint16_t id) const {
+        return id < variables_.size() && !variables_[id].name.empty() ? &variables_[id] : nullptr;
+    }
+
+    size_t size() const { return count_; }
+
+    uint32_t version() const {
+        if (version_ == 0) {
+            uint32_t hash = 2166136261u;
+            auto mix = [&hash](const void* data, size_t length) {
+                const uint8_t* bytes = static_cast<const uint8_t*>(data);
+                for (size_t i = 0; i < length; i++) hash = (hash ^ bytes[i]) * 16777619u;
+            };
+            for (size_t id = 0; id < variables_.size(); id++) {
+                const Variable& variable = variables_[id];
+                if (variable.name.empty()) continue;
+                SchemaEntryHeader entry = entry_header(static_cast<uint16_t>(id), variable);
+                mix(&entry, sizeof(entry));
+                mix(variable.name.data(), variable.name.size());
+            }
+            version_ = hash != 0 ? hash : 1;   // 0 = nicht berechnet
+        }
+        return version_;
+    }
+
+    // Größe der Schema-Payload
+    size_t encoded_size() const {
+        size_t total = sizeof(BinaryPayloadHeader) + sizeof(SchemaVersionHeader);
+        for (const Variable& variable : variables_) {
+            if (!variable.name.empty()) total += sizeof(SchemaEntryHeader) + variable.name.size();
+        }
+        return total;
+    }
+
+    /**
+     * Schema-Payload (PayloadType::Schema) übernehmen - Consumer Seite
+     * Ersetzt den Inhalt nur wenn Grenzen und Version (Inhalts-Hash) stimmen.
+     */
+    bool decode(const uint8_t* data, size_t len) {
+        BinaryPayloadHeader header;
+        SchemaVersionHeader version;
+        if (!data || len < sizeof(header) + sizeof(version)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.version != 1 || header.type != static_cast<uint8_t>(PayloadType::Schema) ||
+            header.total_size > len || header.total_size < sizeof(header) + sizeof(version)) return false;
+        std::memcpy(&version, data + sizeof(header), sizeof(version));
+
+        PayloadSchema schema;
+        size_t offset = sizeof(header) + sizeof(version);
+        for (uint16_t i = 0; i < header.variable_count; i++) {
+            SchemaEntryHeader entry;
+            if (header.total_size - offset < sizeof(entry)) return false;
+            std::memcpy(&entry, data + offset, sizeof(entry));
+            offset += sizeof(entry);
+            if (header.total_size - offset < entry.name_length) return false;
+            std::string name(reinterpret_cast<const char*>(data + offset), entry.name_length);
+            offset += entry.name_length;
+            if (!schema.set(entry.variable_id, name, static_cast<AdsDataType>(entry.data_type), 0)) return false;
+            schema.variables_[entry.variable_id].value_size = entry.value_size;
+        }
+        if (schema.version() != version.schema_version) return false;
+        *this = std::move(schema);
+        return true;
+    }
+
+private:
+    friend class BinaryPayloadBuilder;
+
+    static SchemaEntryHeader entry_header(uint16_t id, const Variable& variable) {
+        SchemaEntryHeader entry{};
+        entry.variable_id = id;
+        entry.data_type = static_cast<uint8_t>(variable.type);
+        entry.value_size = variable.value_size;
+        entry.name_length = static_cast<uint16_t>(variable.name.size());
+        return entry;
+    }
+
+    std::vector<Variable> variables_;        // Index = Variable-ID
+    size_t count_ = 0;
+    mutable uint32_t version_ = 0;
+};
+
+// Eintrag für encode_id_batch: Variable-ID und Wert des Aufrufers (keine Kopie)
+struct IdPayloadEntry {
+    uint16_t id;
+    const void* data;
+    size_t length;
+};
+
+// Eintrag für encode_batch: zeigt nur auf Name und Daten des Aufrufers (keine Kopie)
+struct PayloadEntry {
+    std::string_view name;
+    AdsDataType type;
+    const void* data;
+    size_t length;
 };
 
+/**
+ * Binary Payload Encoder
+ *
+ * encode_single()/encode_batch() schreiben direkt in einen Puffer des
+ * Aufrufers (z.B. MessagePool-Puffer oder wiederverwendeter Sende-Puffer):
+ * Größe vorab exakt berechnet, jeder Header mit einem memcpy, ein Timestamp
+ * pro Payload, keine Allokation. Rückgabe: geschriebene Bytes, 0 wenn der
+ * Puffer zu klein ist (Sequence Number wird dann nicht verbraucht).
+ *
+ * create_single()/create_batch() liefern wie bisher einen std::vector und
+ * nutzen intern denselben Encoder.
+ *
+ * encode_id_batch() schreibt IdBatch Payloads gegen ein PayloadSchema,
+ * encode_schema() die zugehörige Schema-Payload.
+ */
 class BinaryPayloadBuilder {
 private:
     std::vector<uint8_t> buffer;
     uint32_t sequence_counter = 0;
     
 public:
+    // Exakte Payload-Größe (0 wenn Name oder Anzahl das Format sprengen)
+    static size_t single_size(size_t name_len, size_t data_len) {
+        if (name_len > UINT16_MAX) return 0;
+        return sizeof(BinaryPayloadHeader) + sizeof(VariableHeader) + name_len + data_len;
+    }
+
+    template <typename Range>
+    static size_t batch_size(const Range& entries) {
+        if (std::size(entries) > UINT16_MAX) return 0;
+        size_t total = sizeof(BinaryPayloadHeader);
+        for (const auto& item : entries) {
+            PayloadEntry entry = entry_of(item);
+            if (entry.name.size() > UINT16_MAX) return 0;
+            total += sizeof(VariableHeader) + entry.name.size() + entry.length;
+        }
+        return total;
+    }
+
+    // Single-Variable Payload in out[0..capacity) schreiben
+    size_t encode_single(uint8_t* out, size_t capacity, std::string_view name, AdsDataType type,
+                         const void* data, size_t data_len) {
+        PayloadEntry entry{name, type, data, data_len};
+        return encode(out, capacity, PayloadType::Single, &entry, &entry + 1);
+    }
+
+    // Batch Payload in out[0..capacity) schreiben (PayloadEntry oder Tupel wie create_batch)
+    template <typename Range>
+    size_t encode_batch(uint8_t* out, size_t capacity, const Range& entries) {
+        return encode(out, capacity, PayloadType::Batch, std::begin(entries), std::end(entries));
+    }
+
+    // Exakte IdBatch-Größe (0 wenn eine ID fehlt oder ein Wert nicht zur Schema-Größe passt)
+    template <typename Range>
+    static size_t id_batch_size(const PayloadSchema& schema, const Range& entries) {
+        size_t count = 0;
+        size_t total = sizeof(BinaryPayloadHeader) + sizeof(SchemaVersionHeader);
+        for (const IdPayloadEntry& entry : entries) {
+            const PayloadSchema::Variable* variable = schema.find(entry.id);
+            if (!variable) return 0;
+            if (variable->value_size > 0) {
+                if (entry.length != variable->value_size) return 0;
+                total += sizeof(uint16_t) + entry.length;
+            } else {
+                if (entry.length > UINT16_MAX) return 0;
+                total += 2 * sizeof(uint16_t) + entry.length;
+            }
+            count++;
+        }
+        return count <= UINT16_MAX && total <= UINT32_MAX ? total : 0;
+    }
+
+    // IdBatch Payload in out[0..capacity) schreiben - ein Eintrag pro IdPayloadEntry
+    template <typename Range>
+    size_t encode_id_batch(uint8_t* out, size_t capacity, const PayloadSchema& schema, const Range& entries) {
+        size_t total = id_batch_size(schema, entries);
+        if (total == 0 || total > capacity || !out) return 0;
+
+        size_t count = 0;
+        for (auto it = std::begin(entries); it != std::end(entries); ++it) count++;
+        write_header(out, PayloadType::IdBatch, count, total);
+        SchemaVersionHeader version{schema.version()};
+        std::memcpy(out + sizeof(BinaryPayloadHeader), &version, sizeof(version));
+        uint8_t* pos = out + sizeof(BinaryPayloadHeader) + sizeof(version);
+
+        for (const IdPayloadEntry& entry : entries) {
+            std::memcpy(pos, &entry.id, sizeof(entry.id));
+            pos += sizeof(entry.id);
+            if (schema.variables_[entry.id].value_size == 0) {
+                uint16_t length = static_cast<uint16_t>(entry.length);
+                std::memcpy(pos, &length, sizeof(length));
+                pos += sizeof(length);
+            }
+            if (entry.length) std::memcpy(pos, entry.data, entry.length);
+            pos += entry.length;
+        }
+        return total;
+    }
+
+    // Schema-Payload (PayloadType::Schema) in out[0..capacity) schreiben
+    size_t encode_schema(uint8_t* out, size_t capacity, const PayloadSchema& schema) {
+        size_t total = schema.encoded_size();
+        if (schema.size() > UINT16_MAX || total > UINT32_MAX || total > capacity || !out) return 0;
+
+        write_header(out, PayloadType::Schema, schema.size(), total);
+        SchemaVersionHeader version{schema.version()};
+        std::memcpy(out + sizeof(BinaryPayloadHeader), &version, sizeof(version));
+        uint8_t* pos = out + sizeof(BinaryPayloadHeader) + sizeof(version);
+
+        for (size_t id = 0; id < schema.variables_.size(); id++) {
+            const PayloadSchema::Variable& variable = schema.variables_[id];
+            if (variable.name.empty()) continue;
+            SchemaEntryHeader entry = PayloadSchema::entry_header(static_cast<uint16_t>(id), variable);
+            std::memcpy(pos, &entry, sizeof(entry));
+            pos += sizeof(entry);
+            std::memcpy(pos, variable.name.data(), variable.name.size());
+            pos += variable.name.size();
+        }
+        return total;
+    }
+
+    std::vector<uint8_t> create_schema(const PayloadSchema& schema) {
+        buffer.resize(schema.encoded_size());
+        buffer.resize(encode_schema(buffer.data(), buffer.size(), schema));
+        return buffer;
+    }
+
     // Erstellt Single-Variable Payload
     std::vector<uint8_t> create_single(const std::string& name, AdsDataType type, 
                                        const void* data, size_t data_len) {
-        buffer.clear();
-        
-        // Header
-        BinaryPayloadHeader header{};
-        header.version = 1;
-        header.type = static_cast<uint8_t>(PayloadType::Single);
-        header.variable_count = 1;
-        header.sequence_number = sequence_counter++;
-        header.timestamp_us = get_timestamp_us();
-        
-        // Variable Header
-        VariableHeader var_header{};
-        var_header.name_length = static_cast<uint16_t>(name.size());
-        var_header.data_type = static_cast<uint8_t>(type);
-        var_header.data_length = static_cast<uint32_t>(data_len);
-        var_header.timestamp_us = header.timestamp_us;
-        
-        // Total Size berechnen
-        header.total_size = sizeof(BinaryPayloadHeader) + sizeof(VariableHeader) + 
-                           name.size() + data_len;
-        
-        // Serialisieren
-        append_bytes(&header, sizeof(header));
-        append_bytes(&var_header, sizeof(var_header));
-        append_bytes(name.data(), name.size());
-        append_bytes(data, data_len);
-        
+        buffer.resize(single_size(name.size(), data_len));
+        buffer.resize(encode_single(buffer.data(), buffer.size(), name, type, data, data_len));
         return buffer;
     }
     
     // Erstellt Batch Payload
     std::vector<uint8_t> create_batch(const std::vector<std::tuple<std::string, AdsDataType, 
                                       const void*, size_t>>& variables) {
-        buffer.clear();
-        
-        // Header
-        BinaryPayloadHeader header{};
-        header.version = 1;
-        header.type = static_cast<uint8_t>(PayloadType::Batch);
-        header.variable_count = static_cast<uint16_t>(variables.size());
-        header.sequence_number = sequence_counter++;
-        header.timestamp_us = get_timestamp_us();
-        
-        // Total Size berechnen
-        size_t total = sizeof(BinaryPayloadHeader);
-        for (const auto& [name, type, data, len] : variables) {
-            total += sizeof(VariableHeader) + name.size() + len;
-        }
-        header.total_size = static_cast<uint32_t>(total);
-        
-        // Header schreiben
-        append_bytes(&header, sizeof(header));
-        
-        // Variables schreiben
-        for (const auto& [name, type, data, len] : variables) {
-            VariableHeader var_header{};
-            var_header.name_length = static_cast<uint16_t>(name.size());
-            var_header.data_type = static_cast<uint8_t>(type);
-            var_header.data_length = static_cast<uint32_t>(len);
-            var_header.timestamp_us = get_timestamp_us();
-            
-            append_bytes(&var_header, sizeof(var_header));
-            append_bytes(name.data(), name.size());
-            append_bytes(data, len);
-        }
-        
+        buffer.resize(batch_size(variables));
+        buffer.resize(encode_batch(buffer.data(), buffer.size(), variables));
         return buffer;
     }
     
@@ -133,9 +393,58 @@ public:
     }
     
 private:
-    void append_bytes(const void* data, size_t len) {
-        const uint8_t* bytes = static_cast<const uint8_t*>(data);
-        buffer.insert(buffer.end(), bytes, bytes + len);
+    static PayloadEntry entry_of(const PayloadEntry& entry) { return entry; }
+
+    static PayloadEntry entry_of(const std::tuple<std::string, AdsDataType, const void*, size_t>& variable) {
+        return PayloadEntry{std::get<0>(variable), std::get<1>(variable), std::get<2>(variable),
+                            std::get<3>(variable)};
+    }
+
+    template <typename It>
+    size_t encode(uint8_t* out, size_t capacity, PayloadType type, It first, It last) {
+        // Größe vorab prüfen - danach wird ohne weitere Checks geschrieben
+        size_t count = 0;
+        size_t total = sizeof(BinaryPayloadHeader);
+        for (It it = first; it != last; ++it) {
+            PayloadEntry entry = entry_of(*it);
+            if (entry.name.size() > UINT16_MAX) return 0;
+            total += sizeof(VariableHeader) + entry.name.size() + entry.length;
+            count++;
+        }
+        if (count > UINT16_MAX || total > UINT32_MAX || total > capacity || !out) return 0;
+
+        uint8_t* pos = out + sizeof(BinaryPayloadHeader);
+
+        // Variables: Header, Name, Daten
+        VariableHeader var_header{};
+        var_header.timestamp_us = write_header(out, type, count, total);
+        for (It it = first; it != last; ++it) {
+            PayloadEntry entry = entry_of(*it);
+            var_header.name_length = static_cast<uint16_t>(entry.name.size());
+            var_header.data_type = static_cast<uint8_t>(entry.type);
+            var_header.data_length = static_cast<uint32_t>(entry.length);
+            std::memcpy(pos, &var_header, sizeof(var_header));
+            pos += sizeof(var_header);
+            if (!entry.name.empty()) std::memcpy(pos, entry.name.data(), entry.name.size());
+            pos += entry.name.size();
+            if (entry.length) std::memcpy(pos, entry.data, entry.length);
+            pos += entry.length;
+        }
+        return total;
+    }
+
+protected:
+    // BinaryPayloadHeader schreiben, liefert dessen Timestamp (einer pro Payload)
+    uint64_t write_header(uint8_t* out, PayloadType type, size_t count, size_t total) {
+        BinaryPayloadHeader header{};
+        header.version = 1;
+        header.type = static_cast<uint8_t>(type);
+        header.variable_count = static_cast<uint16_t>(count);
+        header.total_size = static_cast<uint32_t>(total);
+        header.timestamp_us = get_timestamp_us();
+        header.sequence_number = sequence_counter++;
+        std::memcpy(out, &header, sizeof(header));
+        return header.timestamp_us;
     }
     
     static uint64_t get_timestamp_us() {
@@ -145,4 +454,174 @@ private:
     }
 };
 
+/**
+ * Read-only Sicht auf ein Single/Batch/IdBatch Payload (keine Kopie, keine Allokation)
+ *
+ * Der Konstruktor prüft Header und alle Variable-Grenzen einmalig gegen die
+ * Puffergröße; danach liefern die Iteratoren Name und Daten als Zeiger in den
+ * Puffer (unaligned - Werte per memcpy lesen). Der Puffer muss die View
+ * überleben. Komprimierte Payloads vorher dekomprimieren.
+ *
+ * IdBatch: Namen, Typen und Wertgrößen kommen aus dem PayloadSchema (muss die
+ * View ebenfalls überleben), Timestamp ist der des Batches. Ohne passendes
+ * Schema ist die View ungültig und needs_schema() liefert true.
+ */
+class BinaryPayloadView {
+public:
+    struct Entry {
+        std::string_view name;
+        AdsDataType type = AdsDataType::Custom;
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        uint64_t timestamp_us = 0;
+        uint16_t id = 0;                     // nur IdBatch
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Entry*;
+        using reference = const Entry&;
+
+        iterator() = default;
+
+        reference operator*() const { return entry_; }
+        pointer operator->() const { return &entry_; }
+
+        iterator& operator++() {
+            pos_ = entry_.data + entry_.length;
+            if (--remaining_ > 0) parse();
+            return *this;
+        }
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const iterator& other) const { return remaining_ == other.remaining_; }
+        bool operator!=(const iterator& other) const { return remaining_ != other.remaining_; }
+
+    private:
+        friend class BinaryPayloadView;
+
+        iterator(const uint8_t* pos, size_t remaining, const PayloadSchema* schema, uint64_t timestamp_us)
+            : pos_(pos), remaining_(remaining), schema_(schema) {
+            entry_.timestamp_us = timestamp_us;
+            if (remaining_ > 0) parse();
+        }
+
+        void parse() {
+            if (schema_) {
+                // IdBatch: [id][Wert] bzw. [id][len][Wert]
+                std::memcpy(&entry_.id, pos_, sizeof(entry_.id));
+                const PayloadSchema::Variable& variable = *schema_->find(entry_.id);
+                entry_.name = variable.name;
+                entry_.type = variable.type;
+                entry_.data = pos_ + sizeof(uint16_t);
+                if (variable.value_size > 0) {
+                    entry_.length = variable.value_size;
+                } else {
+                    uint16_t length;
+                    std::memcpy(&length, entry_.data, sizeof(length));
+                    entry_.length = length;
+                    entry_.data += sizeof(length);
+                }
+                return;
+            }
+            VariableHeader var_header;
+            std::memcpy(&var_header, pos_, sizeof(var_header));
+            const uint8_t* name = pos_ + sizeof(var_header);
+            entry_.name = std::string_view(reinterpret_cast<const char*>(name), var_header.name_length);
+            entry_.type = static_cast<AdsDataType>(var_header.data_type);
+            entry_.data = name + var_header.name_length;
+            entry_.length = var_header.data_length;
+            entry_.timestamp_us = var_header.timestamp_us;
+        }
+
+        const uint8_t* pos_ = nullptr;
+        size_t remaining_ = 0;
+        const PayloadSchema* schema_ = nullptr;
+        Entry entry_;
+    };
+
+    BinaryPayloadView(const uint8_t* data, size_t len, const PayloadSchema* schema = nullptr) : data_(data) {
+        if (!data || !BinaryPayloadBuilder::decode_header(data, len, header_)) return;
+        if (header_.total_size < sizeof(BinaryPayloadHeader) || header_.total_size > len) return;
+
+        // Alle Einträge müssen vollständig innerhalb von total_size liegen
+        size_t offset = sizeof(BinaryPayloadHeader);
+        if (header_.type == static_cast<uint8_t>(PayloadType::IdBatch)) {
+            SchemaVersionHeader version;
+            if (header_.total_size - offset < sizeof(version)) return;
+            std::memcpy(&version, data + offset, sizeof(version));
+            offset += sizeof(version);
+            schema_version_ = version.schema_version;
+            if (!schema || schema->version() != schema_version_) {
+                needs_schema_ = true;
+                return;
+            }
+            for (uint16_t i = 0; i < header_.variable_count; i++) {
+                uint16_t id;
+                if (header_.total_size - offset < sizeof(id)) return;
+                std::memcpy(&id, data + offset, sizeof(id));
+                offset += sizeof(id);
+                const PayloadSchema::Variable* variable = schema->find(id);
+                if (!variable) return;
+                size_t length = variable->value_size;
+                if (length == 0) {
+                    uint16_t value_length;
+                    if (header_.total_size - offset < sizeof(value_length)) return;
+                    std::memcpy(&value_length, data + offset, sizeof(value_length));
+                    offset += sizeof(value_length);
+                    length = value_length;
+                }
+                if (header_.total_size - offset < length) return;
+                offset += length;
+            }
+            schema_ = schema;
+            body_ = sizeof(BinaryPayloadHeader) + sizeof(SchemaVersionHeader);
+            valid_ = true;
+            return;
+        }
+
+        if (header_.type != static_cast<uint8_t>(PayloadType::Single) &&
+            header_.type != static_cast<uint8_t>(PayloadType::Batch)) return;
+        for (uint16_t i = 0; i < header_.variable_count; i++) {
+            if (header_.total_size - offset < sizeof(VariableHeader)) return;
+            VariableHeader var_header;
+            std::memcpy(&var_header, data + offset, sizeof(var_header));
+            offset += sizeof(VariableHeader);
+            uint64_t body = static_cast<uint64_t>(var_header.name_length) + var_header.data_length;
+            if (header_.total_size - offset < body) return;
+            offset += static_cast<size_t>(body);
+        }
+        valid_ = true;
+    }
+
+    bool valid() const { return valid_; }
+    const BinaryPayloadHeader& header() const { return header_; }
+    size_t size() const { return valid_ ? header_.variable_count : 0; }
+
+    // IdBatch: Schema fehlt oder ist veraltet - auf die nächste Schema-Nachricht warten
+    bool needs_schema() const { return needs_schema_; }
+    uint32_t schema_version() const { return schema_version_; }
+
+    iterator begin() const {
+        return valid_ ? iterator(data_ + body_, header_.variable_count, schema_, header_.timestamp_us) : iterator();
+    }
+    iterator end() const { return iterator(); }
+
+private:
+    const uint8_t* data_ = nullptr;
+    const PayloadSchema* schema_ = nullptr;  // nur IdBatch
+    BinaryPayloadHeader header_{};
+    size_t body_ = sizeof(BinaryPayloadHeader);
+    uint32_t schema_version_ = 0;
+    bool valid_ = false;
+    bool needs_schema_ = false;
+};
+
 } // namespace ads_realtime
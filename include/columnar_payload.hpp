@@ -0,0 +1,479 @@
+#pragma once
+
+#include "binary_payload.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace ads_realtime {
+
+// Columnar Payload (PayloadType::Columnar) - Struct-of-Arrays statt Eintrag für Eintrag
+//
+// [BinaryPayloadHeader][SchemaVersionHeader][ColumnarHeader][ColumnHeader x N][Spalten...]
+//
+// Spalte 0: Timestamps (uint64 µs), Spalte 1: Variable-IDs (uint16), danach
+// eine Werte-Spalte pro (AdsDataType, Wertgröße). Die Zeilen sind nach
+// Typ-Gruppe, dann Variable-ID sortiert (Reihenfolge pro Variable bleibt):
+// jede Werte-Spalte deckt die Zeilen first_row..first_row+row_count ab, die
+// Samples einer Variable liegen zusammenhängend. Jede Spalte beginnt
+// COLUMN_ALIGNMENT-aligned (ab Payload-Anfang) - ein aligned empfangener
+// Puffer lässt sich direkt als Array lesen (numpy.frombuffer, Arrow Buffer).
+//
+// Werte fester Größe: row_count * value_size Bytes. Variable Länge
+// (value_size 0): uint32 Offsets[row_count + 1] wie Arrow, danach die Bytes.
+// ColumnEncoding::Delta (Timestamps, optional Ganzzahlen): erster Wert
+// absolut, danach Differenz zum Vorgänger in gleicher Breite (modulo 2^n) -
+// ColumnarView::decode() bildet die Prefix-Summe.
+#pragma pack(push, 1)
+struct ColumnarHeader {
+    uint16_t column_count;
+    uint16_t reserved;
+};
+
+struct ColumnHeader {
+    uint8_t kind;              // ColumnKind
+    uint8_t data_type;         // AdsDataType (Timestamps: UInt64, IDs: Word)
+    uint8_t encoding;          // ColumnEncoding
+    uint8_t reserved;
+    uint16_t value_size;       // Bytes pro Wert, 0 = variable Länge
+    uint16_t reserved2;
+    uint32_t first_row;
+    uint32_t row_count;
+    uint32_t offset;           // ab Payload-Anfang
+    uint32_t length;           // Bytes
+};
+#pragma pack(pop)
+
+enum class ColumnKind : uint8_t {
+    Timestamps = 0,
+    Ids = 1,
+    Values = 2
+};
+
+enum class ColumnEncoding : uint8_t {
+    Plain = 0,
+    Delta = 1
+};
+
+// Eintrag für encode_columnar: Variable-ID, Sample-Timestamp und Wert des Aufrufers (keine Kopie)
+struct ColumnarEntry {
+    uint16_t id;
+    uint64_t timestamp_us;
+    const void* data;
+    size_t length;
+};
+
+struct ColumnarOptions {
+    bool delta_timestamps = true;    // Timestamps als Differenzen (klein, gut komprimierbar)
+    bool delta_integers = false;     // Ganzzahl-Spalten (1/2/4/8 Bytes) als Differenzen
+};
+
+/**
+ * Columnar Batch Encoder
+ *
+ * Typen und Wertgrößen kommen aus dem PayloadSchema (wie IdBatch), Namen
+ * nur aus der Schema-Payload. Sortier- und Gruppen-Puffer sind Member und
+ * werden wiederverwendet - nach dem ersten Batch keine Allokation.
+ */
+class ColumnarPayloadBuilder : public BinaryPayloadBuilder {
+public:
+    static constexpr size_t COLUMN_ALIGNMENT = 8;
+
+    explicit ColumnarPayloadBuilder(ColumnarOptions options = ColumnarOptions())
+        : options_(options) {}
+
+    // Exakte Payload-Größe (0 wenn eine ID fehlt oder ein Wert nicht zur Schema-Größe passt)
+    size_t columnar_size(const PayloadSchema& schema, const ColumnarEntry* entries, size_t count) {
+        return layout(schema, entries, count);
+    }
+
+    // Columnar Payload in out[0..capacity) schreiben
+    size_t encode_columnar(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                           const ColumnarEntry* entries, size_t count) {
+        size_t total = layout(schema, entries, count);
+        if (total == 0 || total > capacity || !out) return 0;
+
+        write_header(out, PayloadType::Columnar, count, total);
+        SchemaVersionHeader version{schema.version()};
+        ColumnarHeader columnar{static_cast<uint16_t>(2 + groups_.size()), 0};
+        uint8_t* pos = out + sizeof(BinaryPayloadHeader);
+        std::memcpy(pos, &version, sizeof(version));
+        pos += sizeof(version);
+        std::memcpy(pos, &columnar, sizeof(columnar));
+        pos += sizeof(columnar);
+
+        // Verzeichnis
+        uint32_t rows = static_cast<uint32_t>(count);
+        ColumnEncoding timestamp_encoding = options_.delta_timestamps ? ColumnEncoding::Delta : ColumnEncoding::Plain;
+        pos = write_column(pos, ColumnKind::Timestamps, AdsDataType::UInt64, timestamp_encoding, 8, 0, rows,
+                           timestamps_offset_, 8 * count);
+        pos = write_column(pos, ColumnKind::Ids, AdsDataType::Word, ColumnEncoding::Plain, 2, 0, rows,
+                           ids_offset_, 2 * count);
+        for (const Group& group : groups_) {
+            pos = write_column(pos, ColumnKind::Values, static_cast<AdsDataType>(group.type), group.encoding,
+                               group.value_size, group.first_row, group.rows, group.offset, group.length);
+        }
+        pad(out, static_cast<size_t>(pos - out), timestamps_offset_);
+
+        // Timestamps und IDs in Zeilenreihenfolge
+        uint8_t* timestamps = out + timestamps_offset_;
+        uint8_t* ids = out + ids_offset_;
+        uint64_t previous = 0;
+        for (size_t row = 0; row < count; row++) {
+            const ColumnarEntry& entry = entries[static_cast<uint32_t>(order_[row])];
+            uint64_t timestamp = entry.timestamp_us - (options_.delta_timestamps ? previous : 0);
+            previous = entry.timestamp_us;
+            std::memcpy(timestamps + 8 * row, &timestamp, sizeof(timestamp));
+            std::memcpy(ids + 2 * row, &entry.id, sizeof(entry.id));
+        }
+        pad(out, timestamps_offset_ + 8 * count, ids_offset_);
+        pad(out, ids_offset_ + 2 * count, groups_.empty() ? total : groups_[0].offset);
+
+        // Werte pro Gruppe
+        for (size_t g = 0; g < groups_.size(); g++) {
+            const Group& group = groups_[g];
+            uint8_t* column = out + group.offset;
+            if (group.value_size > 0) {
+                for (uint32_t k = 0; k < group.rows; k++) {
+                    const ColumnarEntry& entry = entries[static_cast<uint32_t>(order_[group.first_row + k])];
+                    std::memcpy(column + static_cast<size_t>(k) * group.value_size, entry.data, group.value_size);
+                }
+                if (group.encoding == ColumnEncoding::Delta) {
+                    delta_encode(column, group.rows, group.value_size);
+                }
+            } else {
+                uint8_t* bytes = column + 4 * (static_cast<size_t>(group.rows) + 1);
+                uint32_t offset = 0;
+                for (uint32_t k = 0; k < group.rows; k++) {
+                    const ColumnarEntry& entry = entries[static_cast<uint32_t>(order_[group.first_row + k])];
+                    std::memcpy(column + 4 * static_cast<size_t>(k), &offset, sizeof(offset));
+                    if (entry.length) std::memcpy(bytes + offset, entry.data, entry.length);
+                    offset += static_cast<uint32_t>(entry.length);
+                }
+                std::memcpy(column + 4 * static_cast<size_t>(group.rows), &offset, sizeof(offset));
+            }
+            pad(out, group.offset + group.length, g + 1 < groups_.size() ? groups_[g + 1].offset : total);
+        }
+        return total;
+    }
+
+    size_t encode_columnar(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                           const std::vector<ColumnarEntry>& entries) {
+        return encode_columnar(out, capacity, schema, entries.data(), entries.size());
+    }
+
+    std::vector<uint8_t> create_columnar(const PayloadSchema& schema, const std::vector<ColumnarEntry>& entries) {
+        std::vector<uint8_t> payload(columnar_size(schema, entries.data(), entries.size()));
+        payload.resize(encode_columnar(payload.data(), payload.size(), schema, entries));
+        return payload;
+    }
+
+    static bool is_integer(AdsDataType type) {
+        switch (type) {
+            case AdsDataType::Byte:
+            case AdsDataType::Word:
+            case AdsDataType::Dword:
+            case AdsDataType::Int8:
+            case AdsDataType::Int16:
+            case AdsDataType::Int32:
+            case AdsDataType::Int64:
+            case AdsDataType::UInt64: return true;
+            default:                  return false;
+        }
+    }
+
+private:
+    struct Group {
+        uint8_t type = 0;
+        uint16_t value_size = 0;
+        ColumnEncoding encoding = ColumnEncoding::Plain;
+        uint32_t first_row = 0;
+        uint32_t rows = 0;
+        size_t bytes = 0;        // Nutzdaten (variable Länge)
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    static size_t align(size_t offset) {
+        return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+    }
+
+    static void pad(uint8_t* out, size_t from, size_t to) {
+        if (to > from) std::memset(out + from, 0, to - from);
+    }
+
+    static uint8_t* write_column(uint8_t* pos, ColumnKind kind, AdsDataType type, ColumnEncoding encoding,
+                                 uint16_t value_size, uint32_t first_row, uint32_t rows, size_t offset,
+                                 size_t length) {
+        ColumnHeader column{};
+        column.kind = static_cast<uint8_t>(kind);
+        column.data_type = static_cast<uint8_t>(type);
+        column.encoding = static_cast<uint8_t>(encoding);
+        column.value_size = value_size;
+        column.first_row = first_row;
+        column.row_count = rows;
+        column.offset = static_cast<uint32_t>(offset);
+        column.length = static_cast<uint32_t>(length);
+        std::memcpy(pos, &column, sizeof(column));
+        return pos + sizeof(column);
+    }
+
+    template <typename T>
+    static void delta_encode_as(uint8_t* column, size_t rows) {
+        T previous = 0;
+        for (size_t k = 0; k < rows; k++) {
+            T value;
+            std::memcpy(&value, column + k * sizeof(T), sizeof(T));
+            T delta = static_cast<T>(value - previous);
+            previous = value;
+            std::memcpy(column + k * sizeof(T), &delta, sizeof(T));
+        }
+    }
+
+    static void delta_encode(uint8_t* column, size_t rows, uint16_t value_size) {
+        switch (value_size) {
+            case 1: delta_encode_as<uint8_t>(column, rows); break;
+            case 2: delta_encode_as<uint16_t>(column, rows); break;
+            case 4: delta_encode_as<uint32_t>(column, rows); break;
+            case 8: delta_encode_as<uint64_t>(column, rows); break;
+        }
+    }
+
+    // Gruppen bilden, Zeilen sortieren (Gruppe, ID, Eingabereihenfolge), Offsets berechnen
+    size_t layout(const PayloadSchema& schema, const ColumnarEntry* entries, size_t count) {
+        groups_.clear();
+        order_.resize(count);
+        if (count > UINT16_MAX || (count > 0 && !entries)) return 0;
+
+        size_t last = SIZE_MAX;
+        for (size_t i = 0; i < count; i++) {
+            const ColumnarEntry& entry = entries[i];
+            const PayloadSchema::Variable* variable = schema.find(entry.id);
+            if (!variable) return 0;
+            if (variable->value_size > 0 ? entry.length != variable->value_size : entry.length > UINT32_MAX) {
+                return 0;
+            }
+            uint8_t type = static_cast<uint8_t>(variable->type);
+            if (last == SIZE_MAX || groups_[last].type != type || groups_[last].value_size != variable->value_size) {
+                last = 0;
+                while (last < groups_.size() &&
+                       (groups_[last].type != type || groups_[last].value_size != variable->value_size)) {
+                    last++;
+                }
+                if (last == groups_.size()) {
+                    Group group;
+                    group.type = type;
+                    group.value_size = variable->value_size;
+                    bool delta = options_.delta_integers && is_integer(variable->type) &&
+                                 (group.value_size == 1 || group.value_size == 2 || group.value_size == 4 ||
+                                  group.value_size == 8);
+                    group.encoding = delta ? ColumnEncoding::Delta : ColumnEncoding::Plain;
+                    groups_.push_back(group);
+                }
+            }
+            groups_[last].rows++;
+            groups_[last].bytes += entry.length;
+            order_[i] = (static_cast<uint64_t>(last) << 48) | (static_cast<uint64_t>(entry.id) << 32) | i;
+        }
+        std::sort(order_.begin(), order_.end());
+
+        size_t pos = sizeof(BinaryPayloadHeader) + sizeof(SchemaVersionHeader) + sizeof(ColumnarHeader) +
+                     (2 + groups_.size()) * sizeof(ColumnHeader);
+        timestamps_offset_ = align(pos);
+        ids_offset_ = align(timestamps_offset_ + 8 * count);
+        pos = align(ids_offset_ + 2 * count);
+        uint32_t row = 0;
+        for (Group& group : groups_) {
+            group.first_row = row;
+            row += group.rows;
+            group.offset = pos;
+            group.length = group.value_size > 0 ? static_cast<size_t>(group.value_size) * group.rows
+                                                : 4 * (static_cast<size_t>(group.rows) + 1) + group.bytes;
+            pos = align(pos + group.length);
+        }
+        return pos <= UINT32_MAX ? pos : 0;
+    }
+
+    ColumnarOptions options_;
+    std::vector<Group> groups_;
+    std::vector<uint64_t> order_;        // Zeile -> (Gruppe << 48 | ID << 32 | Entry-Index)
+    size_t timestamps_offset_ = 0;
+    size_t ids_offset_ = 0;
+};
+
+/**
+ * Read-only Sicht auf ein Columnar Payload (keine Kopie, keine Allokation)
+ *
+ * Der Konstruktor prüft Verzeichnis, Spaltengrenzen, Alignment und Offsets
+ * variabler Spalten einmalig. Danach:
+ * - values<T>(): Plain-Spalte direkt als T-Array (Puffer aligned empfangen)
+ * - decode(): Spalte fester Größe in einen Ziel-Puffer (z.B. numpy/Arrow
+ *   Array) - Plain per memcpy, Delta per Prefix-Summe in einem Durchlauf
+ * - value(): k-ter Wert einer Spalte variabler Länge
+ */
+class ColumnarView {
+public:
+    struct Column {
+        ColumnKind kind = ColumnKind::Values;
+        AdsDataType type = AdsDataType::Custom;
+        ColumnEncoding encoding = ColumnEncoding::Plain;
+        uint16_t value_size = 0;
+        uint32_t first_row = 0;
+        uint32_t rows = 0;
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+    };
+
+    ColumnarView(const uint8_t* data, size_t len) : data_(data) {
+        if (!data || !BinaryPayloadBuilder::decode_header(data, len, header_)) return;
+        if (header_.type != static_cast<uint8_t>(PayloadType::Columnar) || header_.total_size > len) return;
+
+        size_t directory = sizeof(BinaryPayloadHeader) + sizeof(SchemaVersionHeader) + sizeof(ColumnarHeader);
+        if (header_.total_size < directory) return;
+        SchemaVersionHeader version;
+        ColumnarHeader columnar;
+        std::memcpy(&version, data + sizeof(BinaryPayloadHeader), sizeof(version));
+        std::memcpy(&columnar, data + sizeof(BinaryPayloadHeader) + sizeof(version), sizeof(columnar));
+        schema_version_ = version.schema_version;
+        column_count_ = columnar.column_count;
+        if (column_count_ < 2 || (header_.total_size - directory) / sizeof(ColumnHeader) < column_count_) return;
+        directory_ = data + directory;
+
+        uint32_t rows = header_.variable_count;
+        uint32_t value_rows = 0;
+        for (size_t i = 0; i < column_count_; i++) {
+            Column c = column(i);
+            size_t offset = static_cast<size_t>(c.data - data);
+            if (offset % ColumnarPayloadBuilder::COLUMN_ALIGNMENT != 0 || offset > header_.total_size ||
+                c.length > header_.total_size - offset) return;
+            if (c.first_row > rows || c.rows > rows - c.first_row) return;
+            if (c.encoding == ColumnEncoding::Delta &&
+                (c.value_size != 1 && c.value_size != 2 && c.value_size != 4 && c.value_size != 8)) return;
+            if (c.value_size > 0) {
+                if (c.length != static_cast<size_t>(c.value_size) * c.rows) return;
+            } else if (!valid_offsets(c)) {
+                return;
+            }
+
+            ColumnKind expected = i == 0 ? ColumnKind::Timestamps : i == 1 ? ColumnKind::Ids : ColumnKind::Values;
+            if (c.kind != expected) return;
+            if (i == 0 && (c.value_size != 8 || c.rows != rows)) return;
+            if (i == 1 && (c.value_size != 2 || c.rows != rows || c.encoding != ColumnEncoding::Plain)) return;
+            if (i >= 2) {
+                if (c.first_row != value_rows) return;   // Werte-Spalten decken die Zeilen lückenlos ab
+                value_rows += c.rows;
+            }
+        }
+        valid_ = value_rows == rows;
+    }
+
+    bool valid() const { return valid_; }
+    const BinaryPayloadHeader& header() const { return header_; }
+    uint32_t schema_version() const { return schema_version_; }
+    size_t rows() const { return valid_ ? header_.variable_count : 0; }
+    size_t column_count() const { return valid_ ? column_count_ : 0; }
+
+    // Spalte i (0 = Timestamps, 1 = IDs, ab 2 Werte) - nur nach valid()
+    Column column(size_t index) const {
+        ColumnHeader header;
+        std::memcpy(&header, directory_ + index * sizeof(ColumnHeader), sizeof(header));
+        Column c;
+        c.kind = static_cast<ColumnKind>(header.kind);
+        c.type = static_cast<AdsDataType>(header.data_type);
+        c.encoding = static_cast<ColumnEncoding>(header.encoding);
+        c.value_size = header.value_size;
+        c.first_row = header.first_row;
+        c.rows = header.row_count;
+        c.data = data_ + header.offset;
+        c.length = header.length;
+        return c;
+    }
+
+    Column timestamps() const { return column(0); }
+    Column ids() const { return column(1); }
+
+    // Plain-Spalte fester Größe ohne Kopie (nullptr: Delta, andere Größe oder Puffer nicht aligned)
+    template <typename T>
+    static const T* values(const Column& column) {
+        if (column.encoding != ColumnEncoding::Plain || column.value_size != sizeof(T) ||
+            reinterpret_cast<uintptr_t>(column.data) % alignof(T) != 0) return nullptr;
+        return reinterpret_cast<const T*>(column.data);
+    }
+
+    // Spalte fester Größe nach out (rows * value_size Bytes) dekodieren
+    static bool decode(const Column& column, void* out, size_t capacity) {
+        if (column.value_size == 0 || capacity < column.length) return false;
+        if (column.encoding == ColumnEncoding::Plain) {
+            if (column.length) std::memcpy(out, column.data, column.length);
+            return true;
+        }
+        uint8_t* target = static_cast<uint8_t*>(out);
+        switch (column.value_size) {
+            case 1: prefix_sum<uint8_t>(column.data, target, column.rows); break;
+            case 2: prefix_sum<uint16_t>(column.data, target, column.rows); break;
+            case 4: prefix_sum<uint32_t>(column.data, target, column.rows); break;
+            case 8: prefix_sum<uint64_t>(column.data, target, column.rows); break;
+            default: return false;
+        }
+        return true;
+    }
+
+    // k-ter Wert einer Spalte variabler Länge (value_size 0)
+    static std::string_view value(const Column& column, size_t k) {
+        uint32_t begin;
+        uint32_t end;
+        std::memcpy(&begin, column.data + 4 * k, sizeof(begin));
+        std::memcpy(&end, column.data + 4 * (k + 1), sizeof(end));
+        const char* bytes = reinterpret_cast<const char*>(column.data + 4 * (static_cast<size_t>(column.rows) + 1));
+        return std::string_view(bytes + begin, end - begin);
+    }
+
+private:
+    bool valid_offsets(const Column& column) const {
+        size_t table = 4 * (static_cast<size_t>(column.rows) + 1);
+        if (column.length < table) return false;
+        uint32_t previous = 0;
+        for (size_t k = 0; k <= column.rows; k++) {
+            uint32_t offset;
+            std::memcpy(&offset, column.data + 4 * k, sizeof(offset));
+            if ((k == 0 && offset != 0) || offset < previous) return false;
+            previous = offset;
+        }
+        return previous == column.length - table;
+    }
+
+    // 4-fach entrollt: ein Load/Store pro 4 Werte, nur die Addition ist seriell (1 Takt pro Wert)
+    template <typename T>
+    static void prefix_sum(const uint8_t* in, uint8_t* out, size_t rows) {
+        T sum = 0;
+        size_t k = 0;
+        for (; k + 4 <= rows; k += 4) {
+            T delta[4];
+            std::memcpy(delta, in + k * sizeof(T), sizeof(delta));
+            T value[4];
+            value[0] = sum = static_cast<T>(sum + delta[0]);
+            value[1] = sum = static_cast<T>(sum + delta[1]);
+            value[2] = sum = static_cast<T>(sum + delta[2]);
+            value[3] = sum = static_cast<T>(sum + delta[3]);
+            std::memcpy(out + k * sizeof(T), value, sizeof(value));
+        }
+        for (; k < rows; k++) {
+            T delta;
+            std::memcpy(&delta, in + k * sizeof(T), sizeof(T));
+            sum = static_cast<T>(sum + delta);
+            std::memcpy(out + k * sizeof(T), &sum, sizeof(T));
+        }
+    }
+
+    const uint8_t* data_ = nullptr;
+    const uint8_t* directory_ = nullptr;
+    BinaryPayloadHeader header_{};
+    uint32_t schema_version_ = 0;
+    size_t column_count_ = 0;
+    bool valid_ = false;
+};
+
+} // namespace ads_realtime
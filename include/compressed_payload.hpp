@@ -2,6 +2,8 @@
 
 #include "binary_payload.hpp"
 #include "payload_compression.hpp"
+#include "gorilla_codec.hpp"
+#include "compression_session.hpp"
 #include <vector>
 
 namespace ads_realtime {
@@ -11,6 +13,16 @@ class CompressedPayloadBuilder : public BinaryPayloadBuilder {
 private:
     bool enable_compression = true;
     PayloadCompressor::Method preferred_method = PayloadCompressor::Method::RLE;
+    std::vector<uint8_t> scratch;   // Unkomprimiertes Batch für encode_batch_compressed (wiederverwendet)
+    GorillaEncoder gorilla;         // Zustand pro Variable über alle Batches dieses Builders
+    AdaptiveCompressor selector;    // Methodenwahl pro Variable (Single) bzw. Stream (Batch)
+    
+    // Key für den Selector: FNV-1a über den Variablennamen
+    static uint32_t key_of(const std::string& name) {
+        uint32_t hash = 2166136261u;
+        for (char c : name) hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+        return hash;
+    }
     
 public:
     CompressedPayloadBuilder(bool compress = true) 
@@ -33,8 +45,7 @@ public:
         const uint8_t* payload_data = uncompressed.data() + header_size;
         size_t payload_size = uncompressed.size() - header_size;
         
-        auto [compressed_data, method] = PayloadCompressor::compress_auto(
-            payload_data, payload_size);
+        auto [compressed_data, method] = selector.compress(key_of(name), payload_data, payload_size);
         
         // Wenn Compression nicht lohnt, original zurückgeben
         if (method == PayloadCompressor::Method::None) {
@@ -65,9 +76,10 @@ public:
         return result;
     }
     
-    // Erstellt komprimiertes Batch Payload
+    // Erstellt komprimiertes Batch Payload (stream: Key für die Methodenwahl, z.B. pro Topic)
     std::vector<uint8_t> create_batch_compressed(
-        const std::vector<std::tuple<std::string, AdsDataType, const void*, size_t>>& variables) {
+        const std::vector<std::tuple<std::string, AdsDataType, const void*, size_t>>& variables,
+        uint32_t stream = 0) {
         
         // Erstelle unkomprimiertes Batch
         auto uncompressed = create_batch(variables);
@@ -81,8 +93,7 @@ public:
         const uint8_t* payload_data = uncompressed.data() + header_size;
         size_t payload_size = uncompressed.size() - header_size;
         
-        auto [compressed_data, method] = PayloadCompressor::compress_auto(
-            payload_data, payload_size);
+        auto [compressed_data, method] = selector.compress(stream, payload_data, payload_size);
         
         // Nur wenn signifikante Verbesserung
         if (method == PayloadCompressor::Method::None || 
@@ -110,6 +121,113 @@ public:
         return result;
     }
     
+    // Maximale Größe von encode_batch_compressed()
+    template <typename Range>
+    static size_t batch_compressed_bound(const Range& entries) {
+        size_t header_size = sizeof(BinaryPayloadHeader);
+        return header_size + 1 + LzCompressor::bound(batch_size(entries) - header_size);
+    }
+    
+    // Komprimiertes Batch direkt in out (nur LZ, ohne Mindestgröße - schnell genug für jeden Batch).
+    // Unkomprimiertes Batch wenn LZ nicht kleiner ist, 0 wenn capacity nicht reicht.
+    template <typename Range>
+    size_t encode_batch_compressed(uint8_t* out, size_t capacity, const Range& entries) {
+        if (!enable_compression) {
+            return encode_batch(out, capacity, entries);
+        }
+        
+        scratch.resize(batch_size(entries));
+        size_t total = encode_batch(scratch.data(), scratch.size(), entries);
+        if (total == 0) return 0;
+        
+        size_t header_size = sizeof(BinaryPayloadHeader);
+        size_t written = 0;
+        if (capacity > header_size + 1) {
+            written = LzCompressor::compress(scratch.data() + header_size, total - header_size,
+                                             out + header_size + 1, capacity - header_size - 1);
+        }
+        
+        if (written == 0 || header_size + 1 + written >= total) {
+            if (capacity < total) return 0;
+            std::memcpy(out, scratch.data(), total);
+            return total;
+        }
+        
+        BinaryPayloadHeader header;
+        std::memcpy(&header, scratch.data(), header_size);
+        header.type = static_cast<uint8_t>(PayloadType::Compressed);
+        header.total_size = static_cast<uint32_t>(header_size + 1 + written);
+        std::memcpy(out, &header, header_size);
+        out[header_size] = static_cast<uint8_t>(PayloadCompressor::Method::LZ);
+        return header_size + 1 + written;
+    }
+    
+    // Maximale Größe von encode_batch_session()
+    template <typename Range>
+    static size_t batch_session_bound(const Range& entries) {
+        return CompressionSession::bound(batch_size(entries));
+    }
+    
+    // Batch als Frame der Session des Topics direkt in out, 0 bei Fehler.
+    // Wiederholte Namen und unveränderte Werte kosten nur Matches auf den
+    // vorherigen Batch; der Consumer braucht eine DecompressionSession pro Topic.
+    template <typename Range>
+    size_t encode_batch_session(CompressionSession& session, uint8_t* out, size_t capacity, const Range& entries) {
+        scratch.resize(batch_size(entries));
+        size_t total = encode_batch(scratch.data(), scratch.size(), entries);
+        if (total == 0) return 0;
+        return session.compress(scratch.data(), total, out, capacity);
+    }
+    
+    // Maximale Größe von encode_gorilla()
+    static constexpr size_t gorilla_bound(size_t count) {
+        return sizeof(BinaryPayloadHeader) + 1 + GorillaCodec::bound(count);
+    }
+    
+    // Zeitreihen-Samples (ID, Timestamp, Wert) als Gorilla Frame direkt in out:
+    // [Header type=Compressed][Method::Gorilla][GorillaEncoder Frame], 0 bei Fehler.
+    // Ein Builder pro Topic - der Consumer braucht einen GorillaDecoder pro Topic.
+    size_t encode_gorilla(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                          const ColumnarEntry* entries, size_t count) {
+        size_t header_size = sizeof(BinaryPayloadHeader);
+        if (!out || capacity < header_size + 1 || count > UINT16_MAX) return 0;
+        
+        size_t written = gorilla.encode(out + header_size + 1, capacity - header_size - 1, schema, entries, count);
+        if (written == 0) return 0;
+        
+        size_t total = header_size + 1 + written;
+        write_header(out, PayloadType::Compressed, count, total);
+        out[header_size] = static_cast<uint8_t>(PayloadCompressor::Method::Gorilla);
+        return total;
+    }
+    
+    size_t encode_gorilla(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                          const std::vector<ColumnarEntry>& entries) {
+        return encode_gorilla(out, capacity, schema, entries.data(), entries.size());
+    }
+    
+    // Nächstes encode_gorilla() als Key Frame (z.B. nach Reconnect)
+    void request_key_frame() {
+        gorilla.request_key_frame();
+    }
+    
+    // Gorilla Payload dekodieren (Consumer Seite, ein decoder pro Topic)
+    static bool decode_gorilla(GorillaDecoder& decoder, const uint8_t* data, size_t len,
+                               const PayloadSchema& schema, GorillaSample* out, size_t capacity, size_t& count) {
+        BinaryPayloadHeader header;
+        size_t header_size = sizeof(BinaryPayloadHeader);
+        if (!decode_header(data, len, header) || len < header_size + 1 ||
+            header.type != static_cast<uint8_t>(PayloadType::Compressed) ||
+            header.total_size > len || header.total_size < header_size + 1 ||
+            data[header_size] != static_cast<uint8_t>(PayloadCompressor::Method::Gorilla)) {
+            return false;
+        }
+        if (!decoder.decode(data + header_size + 1, header.total_size - header_size - 1, schema, out, capacity, count)) {
+            return false;
+        }
+        return count == header.variable_count;
+    }
+    
     // Dekomprimiert Payload
     static std::vector<uint8_t> decompress_payload(const uint8_t* data, size_t len) {
         if (len < sizeof(BinaryPayloadHeader) + 1) {
@@ -132,6 +250,12 @@ public:
         const uint8_t* compressed_data = data + sizeof(BinaryPayloadHeader) + 1;
         size_t compressed_size = len - sizeof(BinaryPayloadHeader) - 1;
         
+        // Gorilla/Stream brauchen den Decoder-Zustand: unverändert zurück
+        // (decode_gorilla bzw. DecompressionSession)
+        if (method == PayloadCompressor::Method::Gorilla || method == PayloadCompressor::Method::Stream) {
+            return std::vector<uint8_t>(data, data + len);
+        }
+
         auto decompressed = PayloadCompressor::decompress(
             compressed_data, compressed_size, method);
         
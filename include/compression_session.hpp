@@ -0,0 +1,269 @@
+#pragma once
+
+#include "binary_payload.hpp"
+#include "lz_compressor.hpp"
+#include "payload_compression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ads_realtime {
+
+// Kompressions-Session pro Topic (PayloadCompressor::Method::Stream)
+//
+// [BinaryPayloadHeader type=Compressed][Method][SessionFrameHeader][LZ Block des Payload-Rumpfs]
+//
+// Aufeinanderfolgende Payloads eines Topics teilen eine LZ Historie
+// (LzStreamEncoder, 64 KB): Namen und Header, die sich in jedem Batch
+// wiederholen, kosten nur noch Matches auf den vorherigen Batch. Batch
+// Payloads tragen pro Variable den Timestamp des Payloads - die Session
+// speichert ihn als Differenz zum Header-Timestamp (TIMESTAMP_DELTA), sonst
+// bräche jeder Eintrag den Match. Ein unveränderter Batch kostet so wenige
+// Bytes, ein Batch mit wenigen geänderten Werten kaum mehr als diese Werte.
+//
+// Key Frames (erster Frame, alle key_frame_interval Frames,
+// request_key_frame(), neues Dictionary) beginnen ohne Historie bzw. nur mit
+// dem Start-Dictionary: Consumer, die später subscriben oder einen Frame
+// verloren haben, steigen dort wieder ein. Start-Dictionary z.B. die
+// Schema-Payload, die jeder Consumer ohnehin retained erhält - dann sind die
+// Namen schon im ersten Frame Matches.
+#pragma pack(push, 1)
+struct SessionFrameHeader {
+    uint32_t frame;            // fortlaufend pro Session
+    uint8_t flags;             // KEY_FRAME, TIMESTAMP_DELTA
+    uint8_t payload_type;      // PayloadType des Originals
+    uint16_t reserved;
+    uint32_t dictionary_id;    // FNV-1a des Start-Dictionarys, 0 = keins
+};
+#pragma pack(pop)
+
+/**
+ * Gemeinsame Teile von CompressionSession und DecompressionSession
+ */
+class SessionCodec {
+public:
+    static constexpr uint8_t KEY_FRAME = 0x01;
+    static constexpr uint8_t TIMESTAMP_DELTA = 0x02;
+
+    // Maximale Frame-Größe für ein Payload von payload_len Bytes
+    static constexpr size_t bound(size_t payload_len) {
+        return sizeof(BinaryPayloadHeader) + 1 + sizeof(SessionFrameHeader) +
+               LzCompressor::bound(payload_len > sizeof(BinaryPayloadHeader) ? payload_len - sizeof(BinaryPayloadHeader) : 0);
+    }
+
+protected:
+    static constexpr size_t FRAME_OFFSET = sizeof(BinaryPayloadHeader) + 1;
+    static constexpr size_t BLOCK_OFFSET = FRAME_OFFSET + sizeof(SessionFrameHeader);
+
+    static uint32_t dictionary_hash(const uint8_t* data, size_t len) {
+        if (len == 0) return 0;
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < len; i++) hash = (hash ^ data[i]) * 16777619u;
+        return hash != 0 ? hash : 1;
+    }
+
+    /**
+     * Timestamps der Single/Batch-Einträge im Rumpf relativ zu base setzen (sign -1)
+     * bzw. zurückrechnen (sign +1). false wenn die Einträge nicht in len passen.
+     */
+    static bool rebase_timestamps(uint8_t* body, size_t len, uint16_t count, uint64_t base, int sign) {
+        size_t offset = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            VariableHeader header;
+            if (len - offset < sizeof(header)) return false;
+            std::memcpy(&header, body + offset, sizeof(header));
+            header.timestamp_us = sign < 0 ? header.timestamp_us - base : header.timestamp_us + base;
+            std::memcpy(body + offset, &header, sizeof(header));
+            offset += sizeof(header);
+            if (len - offset < static_cast<size_t>(header.name_length) + header.data_length) return false;
+            offset += static_cast<size_t>(header.name_length) + header.data_length;
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> dictionary_;
+    uint32_t dictionary_id_ = 0;
+};
+
+/**
+ * Publisher Seite: eine Session pro Topic, Payloads in Sende-Reihenfolge
+ * Nicht thread-safe; Rumpf-Puffer wird wiederverwendet.
+ */
+class CompressionSession : public SessionCodec {
+public:
+    explicit CompressionSession(uint32_t key_frame_interval = 100)
+        : key_frame_interval_(key_frame_interval > 0 ? key_frame_interval : 1) {}
+
+    // Start-Dictionary für Key Frames (Consumer braucht dieselben Bytes); leer = keins
+    void set_dictionary(const uint8_t* data, size_t len) {
+        dictionary_.assign(data, data + len);
+        dictionary_id_ = dictionary_hash(data, len);
+        key_frame_pending_ = true;
+    }
+
+    // Nächster Frame als Key Frame (z.B. nach Reconnect)
+    void request_key_frame() { key_frame_pending_ = true; }
+
+    /**
+     * Payload (Single/Batch/IdBatch/... mit BinaryPayloadHeader) als Session
+     * Frame nach out[0..capacity) schreiben. Rückgabe: Bytes, 0 bei ungültigem
+     * Payload oder zu kleinem Puffer (nächster Frame ist dann Key Frame).
+     */
+    size_t compress(const uint8_t* payload, size_t len, uint8_t* out, size_t capacity) {
+        BinaryPayloadHeader header;
+        if (!payload || !out || !BinaryPayloadBuilder::decode_header(payload, len, header) ||
+            header.type == static_cast<uint8_t>(PayloadType::Compressed) || capacity < BLOCK_OFFSET) {
+            return 0;
+        }
+
+        bool key = key_frame_pending_ || frames_since_key_ >= key_frame_interval_;
+        if (key) {
+            if (dictionary_.empty()) {
+                encoder_.reset();
+            } else {
+                encoder_.prime(dictionary_.data(), dictionary_.size());
+            }
+            frames_since_key_ = 0;
+        }
+
+        size_t body = len - sizeof(BinaryPayloadHeader);
+        body_.assign(payload + sizeof(BinaryPayloadHeader), payload + len);
+        uint8_t flags = key ? KEY_FRAME : 0;
+        // Single/Batch (IdBatch ohne Schema ist hier nie valid, hat keine Timestamps pro Eintrag)
+        if (BinaryPayloadView(payload, len).valid() &&
+            rebase_timestamps(body_.data(), body, header.variable_count, header.timestamp_us, -1)) {
+            flags |= TIMESTAMP_DELTA;
+        }
+
+        size_t written = encoder_.compress(body_.data(), body, out + BLOCK_OFFSET, capacity - BLOCK_OFFSET);
+        if (written == 0) {
+            key_frame_pending_ = true;
+            return 0;
+        }
+
+        SessionFrameHeader frame{};
+        frame.frame = frame_++;
+        frame.flags = flags;
+        frame.payload_type = header.type;
+        frame.dictionary_id = dictionary_id_;
+        header.type = static_cast<uint8_t>(PayloadType::Compressed);
+        header.total_size = static_cast<uint32_t>(BLOCK_OFFSET + written);
+        std::memcpy(out, &header, sizeof(header));
+        out[sizeof(BinaryPayloadHeader)] = static_cast<uint8_t>(PayloadCompressor::Method::Stream);
+        std::memcpy(out + FRAME_OFFSET, &frame, sizeof(frame));
+
+        key_frame_pending_ = false;
+        frames_since_key_++;
+        return BLOCK_OFFSET + written;
+    }
+
+    uint32_t frames() const { return frame_; }
+
+private:
+    LzStreamEncoder encoder_;
+    std::vector<uint8_t> body_;
+    uint32_t key_frame_interval_;
+    uint32_t frames_since_key_ = 0;
+    uint32_t frame_ = 0;
+    bool key_frame_pending_ = true;
+};
+
+/**
+ * Consumer Seite: eine Session pro Topic
+ *
+ * Nimmt einen Frame nur an, wenn er ein Key Frame ist oder direkt auf den
+ * zuletzt dekodierten folgt, und nur mit passendem Start-Dictionary; sonst
+ * Rückgabe 0 und synced() false bis zum nächsten Key Frame.
+ */
+class DecompressionSession : public SessionCodec {
+public:
+    void set_dictionary(const uint8_t* data, size_t len) {
+        dictionary_.assign(data, data + len);
+        dictionary_id_ = dictionary_hash(data, len);
+        synced_ = false;
+    }
+
+    bool synced() const { return synced_; }
+
+    void reset() { synced_ = false; }
+
+    // Größe des Original-Payloads (für den Ziel-Puffer), SIZE_MAX wenn kein Session Frame
+    static size_t decompressed_size(const uint8_t* data, size_t len) {
+        BinaryPayloadHeader header;
+        if (!data || !BinaryPayloadBuilder::decode_header(data, len, header) ||
+            header.type != static_cast<uint8_t>(PayloadType::Compressed) ||
+            header.total_size > len || header.total_size < BLOCK_OFFSET ||
+            data[sizeof(BinaryPayloadHeader)] != static_cast<uint8_t>(PayloadCompressor::Method::Stream)) {
+            return SIZE_MAX;
+        }
+        size_t block = header.total_size - BLOCK_OFFSET;
+        size_t body = LzCompressor::decompressed_size(data + BLOCK_OFFSET, block);
+        // Größen-Präfix aus dem Frame: mehr kann ein gültiger Block nicht liefern
+        if (body == SIZE_MAX || body > block * 255 + 16) return SIZE_MAX;
+        return sizeof(BinaryPayloadHeader) + body;
+    }
+
+    // Original-Payload nach out[0..capacity), Rückgabe Bytes oder 0
+    size_t decompress(const uint8_t* data, size_t len, uint8_t* out, size_t capacity) {
+        size_t size = decompressed_size(data, len);
+        if (size == SIZE_MAX || size > capacity || !out) return fail();
+
+        BinaryPayloadHeader header;
+        SessionFrameHeader frame;
+        std::memcpy(&header, data, sizeof(header));
+        std::memcpy(&frame, data + FRAME_OFFSET, sizeof(frame));
+        if (frame.dictionary_id != dictionary_id_) return fail();
+
+        if (frame.flags & KEY_FRAME) {
+            if (dictionary_.empty()) {
+                decoder_.reset();
+            } else {
+                decoder_.prime(dictionary_.data(), dictionary_.size());
+            }
+        } else if (!synced_ || frame.frame != next_frame_) {
+            return fail();
+        }
+
+        size_t body = 0;
+        if (!decoder_.decompress(data + BLOCK_OFFSET, header.total_size - BLOCK_OFFSET,
+                                 out + sizeof(BinaryPayloadHeader), capacity - sizeof(BinaryPayloadHeader), body)) {
+            return fail();
+        }
+        if ((frame.flags & TIMESTAMP_DELTA) &&
+            !rebase_timestamps(out + sizeof(BinaryPayloadHeader), body, header.variable_count, header.timestamp_us, 1)) {
+            return fail();
+        }
+
+        header.type = frame.payload_type;
+        header.total_size = static_cast<uint32_t>(sizeof(BinaryPayloadHeader) + body);
+        std::memcpy(out, &header, sizeof(header));
+        synced_ = true;
+        next_frame_ = frame.frame + 1;
+        return sizeof(BinaryPayloadHeader) + body;
+    }
+
+    // Leer wenn der Frame nicht dekodierbar ist
+    std::vector<uint8_t> decompress(const uint8_t* data, size_t len) {
+        size_t size = decompressed_size(data, len);
+        if (size == SIZE_MAX) {
+            fail();
+            return {};
+        }
+        std::vector<uint8_t> payload(size);
+        payload.resize(decompress(data, len, payload.data(), payload.size()));
+        return payload;
+    }
+
+private:
+    size_t fail() {
+        synced_ = false;
+        return 0;
+    }
+
+    LzStreamDecoder decoder_;
+    uint32_t next_frame_ = 0;
+    bool synced_ = false;
+};
+
+} // namespace ads_realtime
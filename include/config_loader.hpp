@@ -0,0 +1,138 @@
+#pragma once
+
+#include "realtime_config.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace ads_realtime {
+
+// Minimaler INI-Parser für config.ini
+// Format: [section], key = value, Kommentare mit # oder ; (auch am Zeilenende)
+// Unbekannte Keys werden ignoriert, fehlende behalten die Defaults aus RealtimeConfig
+class ConfigLoader {
+public:
+    static bool load(const std::string& path, RealtimeConfig& config) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+
+        std::string line;
+        std::string section;
+        while (std::getline(file, line)) {
+            line = trim(strip_comment(line));
+            if (line.empty()) continue;
+
+            if (line.front() == '[' && line.back() == ']') {
+                section = line.substr(1, line.size() - 2);
+                continue;
+            }
+
+            auto eq = line.find('=');
+            if (eq == std::string::npos) continue;
+
+            std::string key = trim(line.substr(0, eq));
+            std::string value = trim(line.substr(eq + 1));
+            apply(section, key, value, config);
+        }
+
+        std::cout << "[CONFIG] Geladen: " << path << "\n";
+        return true;
+    }
+
+    // Kommagetrennte Zahlenliste ("10,50,100") -> aufsteigend sortiert
+    static std::vector<uint32_t> parse_list(const std::string& value) {
+        std::vector<uint32_t> result;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = trim(item);
+            if (!item.empty()) {
+                result.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10)));
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    static void apply(const std::string& section, const std::string& key,
+                      const std::string& value, RealtimeConfig& config) {
+        auto as_u32 = [&value]() { return static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10)); };
+        auto as_bool = [&value]() { return value == "true" || value == "1" || value == "yes"; };
+
+        if (section == "plc") {
+            if (key == "ip") config.ads_target_ip = value;
+            else if (key == "port") config.ads_port = static_cast<uint16_t>(as_u32());
+            else if (key == "ams_net_id") config.ads_target_netid = value;
+            else if (key == "ams_tcp_port") config.ams_tcp_port = static_cast<uint16_t>(as_u32());
+            else if (key == "local_ams_net_id") config.ads_local_netid = value;
+        } else if (section == "mqtt") {
+            if (key == "broker") config.mqtt_broker = value;
+            else if (key == "port") config.mqtt_port = static_cast<uint16_t>(as_u32());
+            else if (key == "topic_prefix") config.mqtt_topic_prefix = value;
+            else if (key == "message_pool_size") config.message_pool_size = as_u32();
+            else if (key == "client_id") config.mqtt_client_id = value;
+            else if (key == "publish_mode") config.mqtt_publish_mode = (value == "embedded")
+                ? MqttPublishMode::Embedded : (value == "native" || value == "pipelined")
+                ? MqttPublishMode::Native : MqttPublishMode::Paho;
+            else if (key == "qos") config.mqtt_qos = static_cast<uint8_t>(std::min<uint32_t>(as_u32(), 1));
+            else if (key == "keepalive") config.mqtt_keepalive_s = static_cast<uint16_t>(as_u32());
+            else if (key == "protocol_version") config.mqtt_protocol_version = (as_u32() == 5) ? 5 : 4;
+            else if (key == "max_inflight") config.mqtt_max_inflight = as_u32();
+            else if (key == "topic_alias") config.mqtt_topic_alias = as_bool();
+            else if (key == "connections") config.mqtt_connections = as_u32();
+            else if (key == "first_cpu") config.mqtt_first_cpu = as_u32();
+            else if (key == "listen") config.mqtt_listen_address = value;
+            else if (key == "retain") config.mqtt_retain = as_bool();
+            else if (key == "max_clients") config.mqtt_broker_max_clients = as_u32();
+            else if (key == "max_pending_bytes") config.mqtt_broker_max_pending = as_u32();
+            else if (key == "offline_dir") config.mqtt_offline_dir = value;
+            else if (key == "offline_max_mb") config.mqtt_offline_max_mb = as_u32();
+            else if (key == "offline_replay_rate") config.mqtt_offline_replay_rate = as_u32();
+            else if (key == "flush_interval_us") config.mqtt_flush_interval_us = as_u32();
+            else if (key == "flush_bytes") config.mqtt_flush_bytes = as_u32();
+        } else if (section == "realtime") {
+            if (key == "notification_cycle_us") config.notification_cycle_us = as_u32();
+            else if (key == "max_latency_us") config.max_latency_us = as_u32();
+            else if (key == "notification_queue_capacity") config.notification_queue_capacity = as_u32();
+            else if (key == "max_variables") config.max_variables = as_u32();
+            else if (key == "acquisition_mode") config.acquisition_mode = (value == "sumup")
+                ? AcquisitionMode::SumUpPolling : AcquisitionMode::Notification;
+            else if (key == "sumup_batch_size") config.sumup_batch_size = as_u32();
+            else if (key == "poll_cycle_us") config.poll_cycle_us = as_u32();
+            else if (key == "rt_priority") config.rt_priority = static_cast<int>(as_u32());
+            else if (key == "worker_threads") config.worker_threads = as_u32();
+            else if (key == "pin_to_cores") config.pin_to_cores = as_bool();
+        } else if (section == "filter") {
+            auto as_double = [&value]() { return std::strtod(value.c_str(), nullptr); };
+            if (key == "on_change") config.filter.on_change = as_bool();
+            else if (key == "deadband_abs") config.filter.deadband_abs = as_double();
+            else if (key == "deadband_percent") config.filter.deadband_percent = as_double();
+            else if (key == "min_interval_ms") config.filter.min_interval_ms = as_u32();
+            else if (key == "max_interval_ms") config.filter.max_interval_ms = as_u32();
+        } else if (section == "performance") {
+            if (key == "stats_interval_ms") config.stats_interval_ms = as_u32();
+            else if (key == "latency_buckets") config.latency_buckets_us = parse_list(value);
+            else if (key == "enable_histogram") config.enable_latency_tracking = as_bool();
+        }
+    }
+
+    static std::string strip_comment(const std::string& line) {
+        auto pos = line.find_first_of("#;");
+        return pos == std::string::npos ? line : line.substr(0, pos);
+    }
+
+    static std::string trim(const std::string& s) {
+        auto begin = s.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) return "";
+        auto end = s.find_last_not_of(" \t\r\n");
+        return s.substr(begin, end - begin + 1);
+    }
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,564 @@
+#pragma once
+
+#include "binary_payload.hpp"
+#include "columnar_payload.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ads_realtime {
+
+// Gorilla Zeitreihen-Codec (Facebook Gorilla, VLDB 2015) für numerische PLC Werte
+//
+// [SchemaVersionHeader][GorillaFrameHeader][Bitstrom, MSB zuerst]
+//
+// Samples werden pro Variable gruppiert (Variablen in Reihenfolge des ersten
+// Auftretens, Reihenfolge pro Variable bleibt):
+//   Block:     [ID:16][Anzahl-1: Varint]
+//   Timestamp: Delta-of-Delta zum Vorgänger, ZigZag:
+//              '0' = gleiche Schrittweite, '10'+7, '110'+12, '1110'+20, '1111'+64 Bit
+//   REAL/LREAL: XOR mit dem Vorgänger - '0' gleich, '10' + signifikante Bits im
+//              vorherigen Fenster, '11' + führende Nullen, Länge-1 (5/6 Bit) + Bits
+//   Ganzzahl/BOOL: Differenz modulo Wertbreite, ZigZag - '0' gleich, '1' + Varint (7 Bit Gruppen)
+//
+// Der Zustand pro Variable (letzter Timestamp, Schrittweite, Wert, XOR-Fenster)
+// bleibt über Batches erhalten - ein gleichmäßig abgetasteter, langsam
+// veränderlicher Wert kostet so nur wenige Bit pro Sample. Encoder und Decoder
+// müssen deshalb jeden Frame in Reihenfolge sehen: Frames sind nummeriert,
+// ein Key Frame setzt beide Seiten zurück (erster Frame, alle
+// key_frame_interval Frames, neue Schema-Version, request_key_frame() z.B.
+// nach Reconnect). Fehlt ein Frame, verwirft der Decoder bis zum nächsten
+// Key Frame statt falsche Werte zu liefern.
+//
+// Nur Werte fester Größe 1/2/4/8 Bytes (BOOL, Ganzzahlen, REAL, LREAL);
+// Strings und Strukturen über IdBatch/Columnar + LZ.
+#pragma pack(push, 1)
+struct GorillaFrameHeader {
+    uint32_t frame;            // fortlaufend pro Encoder
+    uint8_t flags;             // GorillaCodec::KEY_FRAME
+    uint8_t reserved;
+    uint16_t block_count;      // Variablen in diesem Frame
+};
+#pragma pack(pop)
+
+// Dekodiertes Sample: value enthält die Rohbits (little-endian, per memcpy in den Schema-Typ)
+struct GorillaSample {
+    uint16_t id;
+    uint64_t timestamp_us;
+    uint64_t value;
+};
+
+/**
+ * Gemeinsamer Zustand von GorillaEncoder und GorillaDecoder
+ */
+class GorillaCodec {
+public:
+    static constexpr uint8_t KEY_FRAME = 0x01;
+
+    // Maximale Frame-Größe für count Samples
+    static constexpr size_t bound(size_t count) {
+        return sizeof(SchemaVersionHeader) + sizeof(GorillaFrameHeader) + 24 * count + 1;
+    }
+
+    static bool supports(const PayloadSchema::Variable& variable) {
+        return variable.value_size == 1 || variable.value_size == 2 || variable.value_size == 4 ||
+               variable.value_size == 8;
+    }
+
+protected:
+    struct State {
+        uint64_t timestamp = 0;
+        uint64_t delta = 0;
+        uint64_t value = 0;
+        uint8_t leading = NO_WINDOW;
+        uint8_t trailing = 0;
+    };
+
+    static constexpr uint8_t NO_WINDOW = 0xFF;
+
+    State& state(uint16_t id) {
+        if (id >= states_.size()) states_.resize(static_cast<size_t>(id) + 1);
+        return states_[id];
+    }
+
+    void reset_states() {
+        std::fill(states_.begin(), states_.end(), State());
+    }
+
+    static bool is_float(const PayloadSchema::Variable& variable) {
+        return (variable.type == AdsDataType::Real32 && variable.value_size == 4) ||
+               (variable.type == AdsDataType::Real64 && variable.value_size == 8);
+    }
+
+    static uint64_t zigzag(uint64_t value) {
+        return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    }
+
+    static uint64_t unzigzag(uint64_t value) {
+        return (value >> 1) ^ (0 - (value & 1));
+    }
+
+    // Differenz modulo 2^(8*size), vorzeichenrichtig auf 64 Bit erweitert
+    static uint64_t sign_extend(uint64_t value, size_t size) {
+        unsigned shift = static_cast<unsigned>(64 - 8 * size);
+        return static_cast<uint64_t>(static_cast<int64_t>(value << shift) >> shift);
+    }
+
+    static uint64_t mask(size_t size) {
+        return size >= 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * size)) - 1;
+    }
+
+    static unsigned leading_zeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_clzll(value));
+#endif
+    }
+
+    static unsigned trailing_zeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+    }
+
+    std::vector<State> states_;                  // Index = Variable-ID
+};
+
+/**
+ * Gorilla Encoder (Publisher Seite)
+ *
+ * Sortier-Puffer und Zustände sind Member - nach dem ersten Frame keine
+ * Allokation. Ein Encoder pro Topic; nicht thread-safe.
+ */
+class GorillaEncoder : public GorillaCodec {
+public:
+    explicit GorillaEncoder(uint32_t key_frame_interval = 100)
+        : key_frame_interval_(key_frame_interval > 0 ? key_frame_interval : 1) {}
+
+    // Nächster Frame als Key Frame (z.B. nach Reconnect, damit neue Consumer einsteigen können)
+    void request_key_frame() { key_frame_pending_ = true; }
+
+    /**
+     * Frame für entries in out[0..capacity) schreiben
+     * Rückgabe: geschriebene Bytes, 0 wenn eine ID fehlt, der Typ nicht
+     * unterstützt wird oder capacity nicht reicht (nächster Frame ist dann Key Frame)
+     */
+    size_t encode(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                  const ColumnarEntry* entries, size_t count) {
+        if (!out || count > UINT16_MAX || (count > 0 && !entries)) return 0;
+
+        for (size_t i = 0; i < count; i++) {
+            const PayloadSchema::Variable* variable = schema.find(entries[i].id);
+            if (!variable || !supports(*variable) || entries[i].length != variable->value_size) return 0;
+        }
+
+        size_t headers = sizeof(SchemaVersionHeader) + sizeof(GorillaFrameHeader);
+        if (capacity < headers) return 0;
+
+        bool key = key_frame_pending_ || frames_since_key_ >= key_frame_interval_ ||
+                   schema.version() != schema_version_;
+        if (key) {
+            reset_states();
+            frames_since_key_ = 0;
+            schema_version_ = schema.version();
+        }
+
+        group(entries, count);
+        BitWriter writer(out + headers, capacity - headers);
+        size_t row = 0;
+        for (uint16_t id : blocks_) {
+            size_t end = cursor_[id];
+            cursor_[id] = 0;
+            const PayloadSchema::Variable& variable = *schema.find(id);
+            bool floating = is_float(variable);
+            State& s = state(id);
+            writer.write(id, 16);
+            writer.write_varint(end - row - 1);
+            for (; row < end; row++) {
+                const ColumnarEntry& entry = entries[order_[row]];
+                write_timestamp(writer, s, entry.timestamp_us);
+                uint64_t value = 0;
+                std::memcpy(&value, entry.data, variable.value_size);
+                if (floating) {
+                    write_float(writer, s, value, variable.value_size * 8);
+                } else {
+                    write_integer(writer, s, value, variable.value_size);
+                }
+            }
+        }
+        size_t bytes = writer.finish();
+        if (writer.overflow()) {
+            key_frame_pending_ = true;           // Zustand ist verändert, Decoder kennt den Frame nicht
+            return 0;
+        }
+
+        SchemaVersionHeader version{schema_version_};
+        GorillaFrameHeader frame{frame_++, static_cast<uint8_t>(key ? KEY_FRAME : 0), 0,
+                                 static_cast<uint16_t>(blocks_.size())};
+        std::memcpy(out, &version, sizeof(version));
+        std::memcpy(out + sizeof(version), &frame, sizeof(frame));
+        key_frame_pending_ = false;
+        frames_since_key_++;
+        return headers + bytes;
+    }
+
+    size_t encode(uint8_t* out, size_t capacity, const PayloadSchema& schema,
+                  const std::vector<ColumnarEntry>& entries) {
+        return encode(out, capacity, schema, entries.data(), entries.size());
+    }
+
+private:
+    // Bitstrom MSB zuerst in einen Puffer fester Größe; Überlauf wird gemerkt statt geschrieben
+    class BitWriter {
+    public:
+        BitWriter(uint8_t* out, size_t capacity) : out_(out), capacity_(capacity) {}
+
+        // bits 1..64 niederwertige Bits von value
+        void write(uint64_t value, unsigned bits) {
+            if (bits > 32) {
+                write32(value >> 32, bits - 32);
+                write32(value & 0xFFFFFFFFu, 32);
+            } else {
+                write32(value, bits);
+            }
+        }
+
+        void write_varint(uint64_t value) {
+            do {
+                uint64_t group = value & 0x7F;
+                value >>= 7;
+                write32(group | (value ? 0x80 : 0), 8);
+            } while (value);
+        }
+
+        // Letztes Byte mit Nullen auffüllen, liefert geschriebene Bytes
+        size_t finish() {
+            if (bits_ % 8) write32(0, 8 - bits_ % 8);
+            while (bits_ >= 8) {
+                bits_ -= 8;
+                put(static_cast<uint8_t>(accumulator_ >> bits_));
+            }
+            return pos_;
+        }
+
+        bool overflow() const { return overflow_; }
+
+    private:
+        // Akkumulator hält < 32 offene Bits, volle 32 Bit gehen als ein Wort raus
+        void write32(uint64_t value, unsigned bits) {
+            if (bits < 64) value &= (uint64_t(1) << bits) - 1;
+            accumulator_ = (accumulator_ << bits) | value;
+            bits_ += bits;
+            if (bits_ >= 32) {
+                bits_ -= 32;
+                uint32_t word = static_cast<uint32_t>(accumulator_ >> bits_);
+                if (capacity_ - pos_ >= 4) {
+                    out_[pos_] = static_cast<uint8_t>(word >> 24);
+                    out_[pos_ + 1] = static_cast<uint8_t>(word >> 16);
+                    out_[pos_ + 2] = static_cast<uint8_t>(word >> 8);
+                    out_[pos_ + 3] = static_cast<uint8_t>(word);
+                    pos_ += 4;
+                } else {
+                    overflow_ = true;
+                }
+            }
+        }
+
+        void put(uint8_t byte) {
+            if (pos_ < capacity_) {
+                out_[pos_++] = byte;
+            } else {
+                overflow_ = true;
+            }
+        }
+
+        uint8_t* out_;
+        size_t capacity_;
+        size_t pos_ = 0;
+        uint64_t accumulator_ = 0;
+        unsigned bits_ = 0;
+        bool overflow_ = false;
+    };
+
+    // Counting Sort nach Variable-ID (Reihenfolge des ersten Auftretens, pro Variable stabil):
+    // order_ = Entry-Indizes gruppiert, cursor_[id] = Ende des Blocks
+    void group(const ColumnarEntry* entries, size_t count) {
+        blocks_.clear();
+        order_.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            uint16_t id = entries[i].id;
+            if (id >= cursor_.size()) cursor_.resize(static_cast<size_t>(id) + 1, 0);
+            if (cursor_[id]++ == 0) blocks_.push_back(id);
+        }
+        uint32_t start = 0;
+        for (uint16_t id : blocks_) {
+            uint32_t rows = cursor_[id];
+            cursor_[id] = start;
+            start += rows;
+        }
+        for (size_t i = 0; i < count; i++) {
+            order_[cursor_[entries[i].id]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    static void write_timestamp(BitWriter& writer, State& s, uint64_t timestamp) {
+        uint64_t delta = timestamp - s.timestamp;
+        uint64_t encoded = zigzag(delta - s.delta);
+        if (encoded == 0) {
+            writer.write(0, 1);
+        } else if (encoded < (uint64_t(1) << 7)) {
+            writer.write(0x2, 2);
+            writer.write(encoded, 7);
+        } else if (encoded < (uint64_t(1) << 12)) {
+            writer.write(0x6, 3);
+            writer.write(encoded, 12);
+        } else if (encoded < (uint64_t(1) << 20)) {
+            writer.write(0xE, 4);
+            writer.write(encoded, 20);
+        } else {
+            writer.write(0xF, 4);
+            writer.write(encoded, 64);
+        }
+        s.timestamp = timestamp;
+        s.delta = delta;
+    }
+
+    static void write_float(BitWriter& writer, State& s, uint64_t value, unsigned width) {
+        uint64_t x = value ^ s.value;
+        s.value = value;
+        if (x == 0) {
+            writer.write(0, 1);
+            return;
+        }
+        unsigned leading = leading_zeros(x) - (64 - width);
+        unsigned trailing = trailing_zeros(x);
+        if (s.leading != NO_WINDOW && leading >= s.leading && trailing >= s.trailing) {
+            writer.write(0x2, 2);
+            writer.write(x >> s.trailing, width - s.leading - s.trailing);
+            return;
+        }
+        unsigned field = width == 64 ? 6 : 5;
+        unsigned length = width - leading - trailing;
+        writer.write(0x3, 2);
+        writer.write(leading, field);
+        writer.write(length - 1, field);
+        writer.write(x >> trailing, length);
+        s.leading = static_cast<uint8_t>(leading);
+        s.trailing = static_cast<uint8_t>(trailing);
+    }
+
+    static void write_integer(BitWriter& writer, State& s, uint64_t value, size_t size) {
+        uint64_t encoded = zigzag(sign_extend((value - s.value) & mask(size), size));
+        s.value = value;
+        if (encoded == 0) {
+            writer.write(0, 1);
+            return;
+        }
+        writer.write(1, 1);
+        writer.write_varint(encoded);
+    }
+
+    std::vector<uint32_t> order_;                // Entry-Indizes gruppiert nach Variable
+    std::vector<uint16_t> blocks_;               // Variablen in Reihenfolge des ersten Auftretens
+    std::vector<uint32_t> cursor_;               // Index = Variable-ID, zwischen Frames 0
+    uint32_t key_frame_interval_;
+    uint32_t frames_since_key_ = 0;
+    uint32_t frame_ = 0;
+    uint32_t schema_version_ = 0;
+    bool key_frame_pending_ = true;
+};
+
+/**
+ * Gorilla Decoder (Consumer Seite)
+ *
+ * decode() übernimmt einen Frame nur wenn er ein Key Frame ist oder direkt
+ * auf den zuletzt dekodierten folgt; sonst false und synced() bleibt false
+ * bis zum nächsten Key Frame. Beschädigte Frames werden ebenso verworfen.
+ */
+class GorillaDecoder : public GorillaCodec {
+public:
+    bool synced() const { return synced_; }
+
+    void reset() { synced_ = false; }
+
+    // Frame dekodieren: Samples nach out[0..capacity), Anzahl in count (gruppiert nach Variable)
+    bool decode(const uint8_t* data, size_t len, const PayloadSchema& schema, GorillaSample* out,
+                size_t capacity, size_t& count) {
+        SchemaVersionHeader version;
+        GorillaFrameHeader frame;
+        if (!data || len < sizeof(version) + sizeof(frame)) return fail();
+        std::memcpy(&version, data, sizeof(version));
+        std::memcpy(&frame, data + sizeof(version), sizeof(frame));
+        if (version.schema_version != schema.version()) return fail();
+
+        if (frame.flags & KEY_FRAME) {
+            reset_states();
+        } else if (!synced_ || frame.frame != next_frame_) {
+            return fail();
+        }
+
+        BitReader reader(data + sizeof(version) + sizeof(frame), len - sizeof(version) - sizeof(frame));
+        size_t samples = 0;
+        for (uint16_t b = 0; b < frame.block_count; b++) {
+            uint16_t id = static_cast<uint16_t>(reader.read(16));
+            uint64_t rows = reader.read_varint() + 1;
+            const PayloadSchema::Variable* variable = schema.find(id);
+            if (reader.overflow() || !variable || !supports(*variable) || rows > capacity - samples) return fail();
+
+            bool floating = is_float(*variable);
+            State& s = state(id);
+            for (uint64_t k = 0; k < rows; k++) {
+                GorillaSample& sample = out[samples++];
+                sample.id = id;
+                sample.timestamp_us = read_timestamp(reader, s);
+                sample.value = floating ? read_float(reader, s, variable->value_size * 8)
+                                        : read_integer(reader, s, variable->value_size);
+            }
+            if (reader.overflow()) return fail();
+        }
+
+        synced_ = true;
+        next_frame_ = frame.frame + 1;
+        count = samples;
+        return true;
+    }
+
+private:
+    // Gegenstück zu BitWriter; Lesen über das Ende liefert Nullen und setzt overflow()
+    class BitReader {
+    public:
+        BitReader(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+        uint64_t read(unsigned bits) {
+            if (bits > 32) {
+                uint64_t high = read32(bits - 32);
+                return (high << 32) | read32(32);
+            }
+            return read32(bits);
+        }
+
+        uint64_t read_varint() {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                uint64_t group = read32(8);
+                value |= (group & 0x7F) << shift;
+                if (!(group & 0x80)) return value;
+            }
+            overflow_ = true;
+            return 0;
+        }
+
+        bool overflow() const { return overflow_; }
+
+        // Beschädigte Daten erkannt - overflow() beendet den Frame
+        void invalidate() { overflow_ = true; }
+
+    private:
+        // Akkumulator hält < 32 ungelesene Bits, nachgeladen wird wortweise
+        uint64_t read32(unsigned bits) {
+            if (bits_ < bits) {
+                if (len_ - pos_ >= 4) {
+                    accumulator_ = (accumulator_ << 32) | (uint64_t(data_[pos_]) << 24) |
+                                   (uint64_t(data_[pos_ + 1]) << 16) | (uint64_t(data_[pos_ + 2]) << 8) |
+                                   data_[pos_ + 3];
+                    pos_ += 4;
+                    bits_ += 32;
+                } else {
+                    while (bits_ < bits) {
+                        if (pos_ < len_) {
+                            accumulator_ = (accumulator_ << 8) | data_[pos_++];
+                        } else {
+                            accumulator_ <<= 8;
+                            overflow_ = true;
+                        }
+                        bits_ += 8;
+                    }
+                }
+            }
+            bits_ -= bits;
+            return (accumulator_ >> bits_) & ((uint64_t(1) << bits) - 1);
+        }
+
+        const uint8_t* data_;
+        size_t len_;
+        size_t pos_ = 0;
+        uint64_t accumulator_ = 0;
+        unsigned bits_ = 0;
+        bool overflow_ = false;
+    };
+
+    bool fail() {
+        synced_ = false;
+        return false;
+    }
+
+    static uint64_t read_timestamp(BitReader& reader, State& s) {
+        uint64_t encoded = 0;
+        if (reader.read(1)) {
+            if (!reader.read(1)) {
+                encoded = reader.read(7);
+            } else if (!reader.read(1)) {
+                encoded = reader.read(12);
+            } else if (!reader.read(1)) {
+                encoded = reader.read(20);
+            } else {
+                encoded = reader.read(64);
+            }
+        }
+        s.delta += unzigzag(encoded);
+        s.timestamp += s.delta;
+        return s.timestamp;
+    }
+
+    static uint64_t read_float(BitReader& reader, State& s, unsigned width) {
+        if (!reader.read(1)) return s.value;
+        uint64_t x;
+        if (!reader.read(1)) {
+            if (s.leading == NO_WINDOW) {
+                reader.invalidate();             // Fenster ohne Vorgänger: beschädigt
+                return s.value;
+            } else {
+                x = reader.read(width - s.leading - s.trailing) << s.trailing;
+            }
+        } else {
+            unsigned field = width == 64 ? 6 : 5;
+            unsigned leading = static_cast<unsigned>(reader.read(field));
+            unsigned length = static_cast<unsigned>(reader.read(field)) + 1;
+            if (leading + length > width) {
+                reader.invalidate();
+                return s.value;
+            }
+            unsigned trailing = width - leading - length;
+            x = reader.read(length) << trailing;
+            s.leading = static_cast<uint8_t>(leading);
+            s.trailing = static_cast<uint8_t>(trailing);
+        }
+        s.value ^= x;
+        return s.value;
+    }
+
+    static uint64_t read_integer(BitReader& reader, State& s, size_t size) {
+        if (reader.read(1)) {
+            s.value = (s.value + unzigzag(reader.read_varint())) & mask(size);
+        }
+        return s.value;
+    }
+
+    uint32_t next_frame_ = 0;
+    bool synced_ = false;
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ads_realtime {
+
+// Log-lineare Bucket-Aufteilung (HDR-Style) für Latenzen in Nanosekunden
+// Werte < 32ns exakt, darüber 32 Sub-Buckets pro Zweierpotenz (max. ~3% Fehler)
+// Bereich: 0 .. 2^40 ns (~18 Minuten), darüber wird im letzten Bucket gezählt
+struct LatencyBuckets {
+    static constexpr uint32_t sub_bucket_bits = 5;
+    static constexpr uint32_t sub_bucket_count = 1u << sub_bucket_bits;  // 32
+    static constexpr uint32_t max_exponent = 39;
+    static constexpr size_t count =
+        sub_bucket_count + (max_exponent - sub_bucket_bits + 1) * sub_bucket_count;
+
+    static size_t index_of(uint64_t value_ns) {
+        if (value_ns < sub_bucket_count) {
+            return static_cast<size_t>(value_ns);
+        }
+        uint32_t msb = 63 - count_leading_zeros(value_ns);
+        if (msb > max_exponent) {
+            return count - 1;
+        }
+        uint32_t shift = msb - sub_bucket_bits;
+        size_t sub = static_cast<size_t>(value_ns >> shift) & (sub_bucket_count - 1);
+        return sub_bucket_count + static_cast<size_t>(shift) * sub_bucket_count + sub;
+    }
+
+    // Untere Grenze eines Buckets (inklusiv)
+    static uint64_t lower_bound(size_t index) {
+        if (index < sub_bucket_count) {
+            return index;
+        }
+        size_t shift = (index - sub_bucket_count) / sub_bucket_count;
+        size_t sub = (index - sub_bucket_count) % sub_bucket_count;
+        return (static_cast<uint64_t>(sub_bucket_count + sub)) << shift;
+    }
+
+    // Obere Grenze eines Buckets (inklusiv)
+    static uint64_t upper_bound(size_t index) {
+        if (index < sub_bucket_count) {
+            return index;
+        }
+        size_t shift = (index - sub_bucket_count) / sub_bucket_count;
+        return lower_bound(index) + ((uint64_t{1} << shift) - 1);
+    }
+
+private:
+    static uint32_t count_leading_zeros(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return 63 - idx;
+#else
+        return static_cast<uint32_t>(__builtin_clzll(v));
+#endif
+    }
+};
+
+// Zusammengeführter Snapshot (nicht thread-safe, nur für Auswertung)
+struct LatencySnapshot {
+    std::array<uint64_t, LatencyBuckets::count> counts{};
+    uint64_t total = 0;
+    uint64_t sum_ns = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+
+    // Percentile in O(buckets), Ergebnis = obere Bucket-Grenze (konservativ)
+    uint64_t percentile_ns(double percentile) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total));
+        if (rank >= total) rank = total - 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen > rank) {
+                uint64_t upper = LatencyBuckets::upper_bound(i);
+                return upper < max_ns ? upper : max_ns;
+            }
+        }
+        return max_ns;
+    }
+
+    double mean_ns() const {
+        return total > 0 ? static_cast<double>(sum_ns) / static_cast<double>(total) : 0.0;
+    }
+
+    // Snapshot eines weiteren Recorders dazunehmen (z.B. mehrere MQTT Verbindungen)
+    void merge(const LatencySnapshot& other) {
+        if (other.total == 0) return;
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        min_ns = (total == 0 || other.min_ns < min_ns) ? other.min_ns : min_ns;
+        max_ns = other.max_ns > max_ns ? other.max_ns : max_ns;
+        total += other.total;
+        sum_ns += other.sum_ns;
+    }
+
+    // Zählt Samples pro Bereich (bounds in µs, aufsteigend): (b[i-1], b[i]], letzter = Overflow
+    std::vector<uint64_t> bucketize_us(const std::vector<uint32_t>& bounds_us) const {
+        std::vector<uint64_t> result(bounds_us.size() + 1, 0);
+        size_t slot = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            if (counts[i] == 0) continue;
+            uint64_t value_ns = LatencyBuckets::lower_bound(i);
+            while (slot < bounds_us.size() && value_ns > uint64_t{bounds_us[slot]} * 1000) {
+                slot++;
+            }
+            result[slot] += counts[i];
+        }
+        return result;
+    }
+};
+
+// Lock-freier Latenz-Recorder mit fixem Speicher
+// Jeder Thread schreibt in seinen eigenen Shard (eigene Cache Lines),
+// snapshot() merged alle Shards. Kein Mutex, kein Sortieren, kein Wachstum.
+class LatencyRecorder {
+public:
+    static constexpr size_t max_shards = 8;
+
+    void record(uint64_t latency_ns) {
+        Shard& shard = shards_[shard_index()];
+        shard.counts[LatencyBuckets::index_of(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+        shard.total.fetch_add(1, std::memory_order_relaxed);
+        shard.sum_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+
+        uint64_t current_max = shard.max_ns.load(std::memory_order_relaxed);
+        while (latency_ns > current_max &&
+               !shard.max_ns.compare_exchange_weak(current_max, latency_ns, std::memory_order_relaxed)) {
+        }
+        uint64_t current_min = shard.min_ns.load(std::memory_order_relaxed);
+        while (latency_ns < current_min &&
+               !shard.min_ns.compare_exchange_weak(current_min, latency_ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencySnapshot snapshot() const {
+        LatencySnapshot snap;
+        snap.min_ns = UINT64_MAX;
+        for (const Shard& shard : shards_) {
+            uint64_t total = shard.total.load(std::memory_order_relaxed);
+            if (total == 0) continue;
+            for (size_t i = 0; i < LatencyBuckets::count; i++) {
+                snap.counts[i] += shard.counts[i].load(std::memory_order_relaxed);
+            }
+            snap.total += total;
+            snap.sum_ns += shard.sum_ns.load(std::memory_order_relaxed);
+            uint64_t shard_min = shard.min_ns.load(std::memory_order_relaxed);
+            uint64_t shard_max = shard.max_ns.load(std::memory_order_relaxed);
+            if (shard_min < snap.min_ns) snap.min_ns = shard_min;
+            if (shard_max > snap.max_ns) snap.max_ns = shard_max;
+        }
+        if (snap.total == 0) snap.min_ns = 0;
+        return snap;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, LatencyBuckets::count> counts{};
+        alignas(64) std::atomic<uint64_t> total{0};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> min_ns{UINT64_MAX};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    static size_t shard_index() {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t index = next_shard.fetch_add(1, std::memory_order_relaxed) % max_shards;
+        return index;
+    }
+
+    std::array<Shard, max_shards> shards_;
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,421 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ads_realtime {
+
+/**
+ * LZ Block Compressor (LZ4 Block-Format)
+ *
+ * Block: [uint32 Originalgröße][LZ4 Sequenzen] - identisch mit
+ * lz4.block.compress(store_size=True), Consumer können jede LZ4 Bibliothek
+ * verwenden. Sequenz: Token (4 Bit Literal-Länge, 4 Bit Match-Länge - 4),
+ * Längen-Erweiterung in 255er Schritten, Literale, Offset (2 Byte LE).
+ *
+ * Match-Suche über eine Hash-Tabelle (4 Byte -> letzte Position, 16 KB) statt
+ * das Fenster zu durchsuchen: O(n), Literal-Läufe ohne Einschränkung des
+ * Byte-Werts. Ohne Treffer wächst die Schrittweite (inkompressible Daten
+ * kosten kaum Zeit). Die Dekompression prüft jede Länge und jeden Offset
+ * gegen Ein- und Ausgabepuffer - beschädigte Daten liefern false statt
+ * fremden Speicher zu lesen.
+ *
+ * Little-Endian (x86, ARM).
+ */
+class LzCompressor {
+public:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t MAX_OFFSET = 65535;
+    static constexpr size_t HASH_LOG = 12;
+    static constexpr size_t HASH_SIZE = size_t(1) << HASH_LOG;
+    static constexpr size_t SIZE_PREFIX = 4;
+
+    // Maximale Blockgröße für len Eingabebytes (inkompressibel)
+    static constexpr size_t bound(size_t len) {
+        return SIZE_PREFIX + len + len / 255 + 16;
+    }
+
+    // Tabellenindex für 4 Eingabebytes (multiplikativer Hash)
+    static uint32_t hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_LOG);
+    }
+
+    // Block in out[0..capacity) komprimieren; 0 wenn der Puffer nicht reicht
+    static size_t compress(const uint8_t* data, size_t len, uint8_t* out, size_t capacity) {
+        uint32_t table[HASH_SIZE] = {};
+        if (len > UINT32_MAX || capacity < SIZE_PREFIX) return 0;
+        write32(out, static_cast<uint32_t>(len));
+        size_t written = compress_block(data, 0, len, table, out + SIZE_PREFIX, capacity - SIZE_PREFIX);
+        return written == 0 ? 0 : SIZE_PREFIX + written;
+    }
+
+    // Block nach out[0..capacity) dekomprimieren; false bei beschädigten Daten oder zu kleinem Puffer
+    static bool decompress(const uint8_t* data, size_t len, uint8_t* out, size_t capacity, size_t& out_len) {
+        if (len < SIZE_PREFIX) return false;
+        size_t size = read32(data);
+        if (size > capacity) return false;
+        if (!decompress_block(data + SIZE_PREFIX, len - SIZE_PREFIX, out, 0, size)) return false;
+        out_len = size;
+        return true;
+    }
+
+    // Originalgröße eines Blocks (für die Ziel-Allokation), SIZE_MAX wenn zu kurz
+    static size_t decompressed_size(const uint8_t* data, size_t len) {
+        return len < SIZE_PREFIX ? SIZE_MAX : read32(data);
+    }
+
+    static std::vector<uint8_t> compress(const uint8_t* data, size_t len) {
+        std::vector<uint8_t> compressed(bound(len));
+        compressed.resize(compress(data, len, compressed.data(), compressed.size()));
+        return compressed;
+    }
+
+    // Leer bei beschädigten Daten
+    static std::vector<uint8_t> decompress(const uint8_t* data, size_t len) {
+        size_t size = decompressed_size(data, len);
+        if (size == SIZE_MAX || size > len * 255 + 16) return {};   // mehr kann ein gültiger Block nicht liefern
+        std::vector<uint8_t> decompressed(size);
+        size_t out_len = 0;
+        if (!decompress(data, len, decompressed.data(), decompressed.size(), out_len)) return {};
+        return decompressed;
+    }
+
+    /**
+     * Sequenzen für base[start..end) nach out schreiben - base[0..start) ist
+     * Dictionary (vorherige Blöcke), table hält Positionen relativ zu base.
+     * repeat_offset (Streaming: Länge des vorherigen Blocks) wird an jeder
+     * Position zusätzlich zur Hash-Tabelle geprüft - bei Batches gleichen
+     * Layouts reicht ein Match dann bis zum nächsten geänderten Wert.
+     * Rückgabe: geschriebene Bytes, 0 wenn capacity nicht reicht.
+     */
+    static size_t compress_block(const uint8_t* base, size_t start, size_t end, uint32_t* table,
+                                 uint8_t* out, size_t capacity, size_t repeat_offset = 0) {
+        if (repeat_offset > MAX_OFFSET) repeat_offset = 0;
+        uint8_t* op = out;
+        uint8_t* const oend = out + capacity;
+        size_t anchor = start;
+        size_t ip = start;
+
+        // Letzte 5 Bytes immer Literale, kein Match-Beginn in den letzten 12 Bytes (LZ4 Regeln)
+        if (end - start >= MF_LIMIT + 1) {
+            const size_t match_limit = end - LAST_LITERALS;
+            const size_t mf_limit = end - MF_LIMIT;
+            ip++;
+
+            while (ip < mf_limit) {
+                // Match suchen, Schrittweite wächst ohne Treffer
+                size_t ref = 0;
+                size_t attempts = 1 << SKIP_TRIGGER;
+                for (;;) {
+                    uint32_t sequence = read32(base + ip);
+                    uint32_t h = hash(sequence);
+                    ref = table[h];
+                    table[h] = static_cast<uint32_t>(ip);
+                    bool found = ref < ip && ip - ref <= MAX_OFFSET && read32(base + ref) == sequence;
+
+                    // Gleiche Position im vorherigen Block: bei gleichem Layout der längere Kandidat
+                    if (repeat_offset && ip >= repeat_offset && ip - repeat_offset != ref &&
+                        read32(base + ip - repeat_offset) == sequence) {
+                        size_t repeat = ip - repeat_offset;
+                        if (!found || match_length(base + ip + MIN_MATCH, base + repeat + MIN_MATCH, base + match_limit) >
+                                      match_length(base + ip + MIN_MATCH, base + ref + MIN_MATCH, base + match_limit)) {
+                            ref = repeat;
+                        }
+                        found = true;
+                    }
+                    if (found) break;
+                    ip += attempts++ >> SKIP_TRIGGER;
+                    if (ip >= mf_limit) goto last_literals;
+                }
+
+                // Rückwärts verlängern
+                while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+                    ip--;
+                    ref--;
+                }
+
+                // Vorwärts verlängern (8 Byte pro Vergleich)
+                size_t length = MIN_MATCH + match_length(base + ip + MIN_MATCH, base + ref + MIN_MATCH,
+                                                         base + match_limit);
+
+                if (!emit_sequence(op, oend, base + anchor, ip - anchor, ip - ref, length)) return 0;
+                ip += length;
+                anchor = ip;
+                if (ip >= mf_limit) break;
+                table[hash(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+            }
+        }
+
+    last_literals:
+        size_t literals = end - anchor;
+        if (static_cast<size_t>(oend - op) < 1 + literals / 255 + 1 + literals) return 0;
+        *op++ = static_cast<uint8_t>((literals >= 15 ? 15 : literals) << 4);
+        if (literals >= 15) op = write_length(op, literals - 15);
+        if (literals) std::memcpy(op, base + anchor, literals);
+        op += literals;
+        return static_cast<size_t>(op - out);
+    }
+
+    /**
+     * Sequenzen nach base[start..start+size) dekodieren - Matches dürfen bis
+     * base[0] zurückreichen (Dictionary). true nur wenn genau size Bytes entstehen.
+     */
+    static bool decompress_block(const uint8_t* in, size_t len, uint8_t* base, size_t start, size_t size) {
+        const uint8_t* ip = in;
+        const uint8_t* const iend = in + len;
+        uint8_t* op = base + start;
+        uint8_t* const oend = op + size;
+
+        while (ip < iend) {
+            uint8_t token = *ip++;
+
+            size_t literals = token >> 4;
+            if (literals == 15 && !read_length(ip, iend, literals)) return false;
+            if (static_cast<size_t>(iend - ip) < literals || static_cast<size_t>(oend - op) < literals) return false;
+            if (literals) std::memcpy(op, ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == iend) break;                  // letzte Sequenz: nur Literale
+
+            if (iend - ip < 2) return false;
+            size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+            size_t length = token & 0x0F;
+            if (length == 15 && !read_length(ip, iend, length)) return false;
+            length += MIN_MATCH;
+            if (offset == 0 || offset > static_cast<size_t>(op - base) ||
+                static_cast<size_t>(oend - op) < length) return false;
+            copy_match(op, offset, length);
+            op += length;
+        }
+        return op == oend;
+    }
+
+private:
+    static constexpr size_t LAST_LITERALS = 5;
+    static constexpr size_t MF_LIMIT = 12;
+    static constexpr size_t SKIP_TRIGGER = 6;
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static uint64_t read64(const uint8_t* p) {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static void write32(uint8_t* p, uint32_t value) {
+        std::memcpy(p, &value, sizeof(value));
+    }
+
+    static size_t trailing_zero_bytes(uint64_t diff) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, diff);
+        return index >> 3;
+#else
+        return static_cast<size_t>(__builtin_ctzll(diff)) >> 3;
+#endif
+    }
+
+    // Gleiche Bytes ab a und b, a läuft höchstens bis limit
+    static size_t match_length(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+        const uint8_t* start = a;
+        while (a + 8 <= limit) {
+            uint64_t diff = read64(a) ^ read64(b);
+            if (diff) return static_cast<size_t>(a - start) + trailing_zero_bytes(diff);
+            a += 8;
+            b += 8;
+        }
+        while (a < limit && *a == *b) {
+            a++;
+            b++;
+        }
+        return static_cast<size_t>(a - start);
+    }
+
+    static uint8_t* write_length(uint8_t* op, size_t length) {
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = static_cast<uint8_t>(length);
+        return op;
+    }
+
+    static bool read_length(const uint8_t*& ip, const uint8_t* iend, size_t& length) {
+        uint8_t byte;
+        do {
+            if (ip >= iend) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+
+    static bool emit_sequence(uint8_t*& op, uint8_t* oend, const uint8_t* literals, size_t literal_count,
+                              size_t offset, size_t length) {
+        size_t match = length - MIN_MATCH;
+        size_t needed = 1 + literal_count / 255 + 1 + literal_count + 2 + match / 255 + 1;
+        if (static_cast<size_t>(oend - op) < needed) return false;
+
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(((literal_count >= 15 ? 15 : literal_count) << 4) | (match >= 15 ? 15 : match));
+        if (literal_count >= 15) op = write_length(op, literal_count - 15);
+        std::memcpy(op, literals, literal_count);
+        op += literal_count;
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        if (match >= 15) op = write_length(op, match - 15);
+        return true;
+    }
+
+    // Überlappende Kopie (offset < length): in Schritten von offset Bytes, Quelle und Ziel nie überlappend
+    static void copy_match(uint8_t* op, size_t offset, size_t length) {
+        const uint8_t* ref = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, ref, length);
+        } else if (offset == 1) {
+            std::memset(op, *ref, length);
+        } else {
+            while (length > 0) {
+                size_t chunk = length < offset ? length : offset;
+                std::memcpy(op, ref, chunk);
+                op += chunk;
+                length -= chunk;
+                offset += chunk;    // Quelle bleibt offset Bytes hinter dem Ziel, Schritte werden größer
+            }
+        }
+    }
+};
+
+/**
+ * Streaming-Modus: aufeinanderfolgende Blöcke (z.B. Batches eines Topics)
+ * dürfen auf die letzten 64 KB der vorherigen Blöcke verweisen - wiederholte
+ * Namen und Header kosten dann nur noch einen Match. Der Decoder muss jeden
+ * Block in derselben Reihenfolge sehen; reset() auf beiden Seiten beginnt
+ * unabhängig (Key Frame). prime() lädt ein gemeinsames Start-Dictionary.
+ * Blockformat wie LzCompressor (lz4.block mit dict=vorherige Daten).
+ */
+class LzStreamEncoder {
+public:
+    LzStreamEncoder() { reset(); }
+
+    void reset() {
+        history_.clear();
+        history_.reserve(HISTORY_LIMIT);
+        std::memset(table_, 0, sizeof(table_));
+        last_block_ = 0;
+    }
+
+    void prime(const uint8_t* dictionary, size_t len) {
+        reset();
+        if (len > LzCompressor::MAX_OFFSET) {
+            dictionary += len - LzCompressor::MAX_OFFSET;
+            len = LzCompressor::MAX_OFFSET;
+        }
+        history_.assign(dictionary, dictionary + len);
+        for (size_t i = 0; i + 4 <= len; i++) {
+            uint32_t sequence;
+            std::memcpy(&sequence, history_.data() + i, sizeof(sequence));
+            table_[LzCompressor::hash(sequence)] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Block komprimieren ([uint32 Größe][Sequenzen]); 0 wenn out nicht reicht (Zustand bleibt dann gültig)
+    size_t compress(const uint8_t* data, size_t len, uint8_t* out, size_t capacity) {
+        if (len > UINT32_MAX || capacity < LzCompressor::SIZE_PREFIX) return 0;
+        slide(len);
+        size_t start = history_.size();
+        history_.insert(history_.end(), data, data + len);
+        uint32_t size = static_cast<uint32_t>(len);
+        std::memcpy(out, &size, sizeof(size));
+        size_t written = LzCompressor::compress_block(history_.data(), start, history_.size(), table_,
+                                                      out + LzCompressor::SIZE_PREFIX,
+                                                      capacity - LzCompressor::SIZE_PREFIX, start > 0 ? last_block_ : 0);
+        if (written == 0) {
+            reset();   // Decoder kennt diesen Block nicht - nächster Block unabhängig
+            return 0;
+        }
+        last_block_ = len;
+        return LzCompressor::SIZE_PREFIX + written;
+    }
+
+private:
+    static constexpr size_t HISTORY_LIMIT = 4 * 65536;
+
+    // Vor dem nächsten Block: nur die letzten 64 KB behalten, Tabelle verschieben
+    void slide(size_t next) {
+        if (history_.size() + next <= HISTORY_LIMIT || history_.size() <= LzCompressor::MAX_OFFSET) return;
+        size_t shift = history_.size() - LzCompressor::MAX_OFFSET;
+        std::memmove(history_.data(), history_.data() + shift, LzCompressor::MAX_OFFSET);
+        history_.resize(LzCompressor::MAX_OFFSET);
+        for (uint32_t& position : table_) {
+            position = position >= shift ? static_cast<uint32_t>(position - shift) : 0;
+        }
+    }
+
+    std::vector<uint8_t> history_;
+    uint32_t table_[LzCompressor::HASH_SIZE];
+    size_t last_block_ = 0;
+};
+
+class LzStreamDecoder {
+public:
+    LzStreamDecoder() { reset(); }
+
+    void reset() {
+        history_.clear();
+        history_.reserve(HISTORY_LIMIT);
+    }
+
+    void prime(const uint8_t* dictionary, size_t len) {
+        reset();
+        if (len > LzCompressor::MAX_OFFSET) {
+            dictionary += len - LzCompressor::MAX_OFFSET;
+            len = LzCompressor::MAX_OFFSET;
+        }
+        history_.assign(dictionary, dictionary + len);
+    }
+
+    // Block dekomprimieren; false bei beschädigten Daten (danach reset() bzw. Key Frame abwarten)
+    bool decompress(const uint8_t* data, size_t len, uint8_t* out, size_t capacity, size_t& out_len) {
+        size_t size = LzCompressor::decompressed_size(data, len);
+        if (size == SIZE_MAX || size > capacity) return false;
+        slide(size);
+        size_t start = history_.size();
+        history_.resize(start + size);
+        if (!LzCompressor::decompress_block(data + LzCompressor::SIZE_PREFIX, len - LzCompressor::SIZE_PREFIX,
+                                            history_.data(), start, size)) {
+            history_.resize(start);
+            return false;
+        }
+        if (size) std::memcpy(out, history_.data() + start, size);
+        out_len = size;
+        return true;
+    }
+
+private:
+    static constexpr size_t HISTORY_LIMIT = 4 * 65536;
+
+    void slide(size_t next) {
+        if (history_.size() + next <= HISTORY_LIMIT || history_.size() <= LzCompressor::MAX_OFFSET) return;
+        size_t shift = history_.size() - LzCompressor::MAX_OFFSET;
+        std::memmove(history_.data(), history_.data() + shift, LzCompressor::MAX_OFFSET);
+        history_.resize(LzCompressor::MAX_OFFSET);
+    }
+
+    std::vector<uint8_t> history_;
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ads_realtime {
+
+/**
+ * Vorallokierter Nachrichten-Pool für den Publish-Pfad
+ *
+ * Feste Anzahl Puffer fester Größe, einmalig im Konstruktor allokiert.
+ * acquire()/release() sind lock-frei (Treiber-Stack über Slot-Indizes mit
+ * ABA-Zähler) und dürfen von beliebigen Threads aufgerufen werden.
+ * Ist der Pool leer, liefert acquire() nullptr - gezählt in exhausted().
+ */
+template<size_t BufferSize = 256>
+class MessagePool {
+public:
+    static constexpr size_t buffer_size = BufferSize;
+
+    struct Message {
+        uint32_t variable_id = 0;
+        uint32_t length = 0;            // belegte Bytes in data
+        uint64_t timestamp = 0;         // ADS Timestamp des Samples
+        uint32_t sequence = 0;          // Sequenznummer (nur gültig mit sequenced)
+        bool sequenced = false;         // vom Flush Thread bzw. beim Loggen vergeben
+        bool replayed = false;          // aus dem Offline-Log nachgesendet
+        uint8_t data[BufferSize];
+    };
+
+    explicit MessagePool(size_t capacity)
+        : capacity_(static_cast<uint32_t>(capacity > 0 ? capacity : 1)),
+          messages_(new Message[capacity_]),
+          next_(new std::atomic<uint32_t>[capacity_]) {
+        // Alle Slots auf den Free-Stack (0 -> 1 -> ... -> NIL)
+        for (uint32_t i = 0; i < capacity_; i++) {
+            next_[i].store(i + 1 < capacity_ ? i + 1 : NIL, std::memory_order_relaxed);
+        }
+        head_.store(pack(0, 0), std::memory_order_release);
+    }
+
+    MessagePool(const MessagePool&) = delete;
+    MessagePool& operator=(const MessagePool&) = delete;
+
+    Message* acquire() {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (;;) {
+            uint32_t index = index_of(head);
+            if (index == NIL) {
+                exhausted_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            uint32_t next = next_[index].load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, pack(next, tag_of(head) + 1),
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_acquire)) {
+                in_use_.fetch_add(1, std::memory_order_relaxed);
+                return &messages_[index];
+            }
+        }
+    }
+
+    void release(Message* message) {
+        uint32_t index = static_cast<uint32_t>(message - messages_.get());
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        do {
+            next_[index].store(index_of(head), std::memory_order_relaxed);
+        } while (!head_.compare_exchange_weak(head, pack(index, tag_of(head) + 1),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+        in_use_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t in_use() const { return in_use_.load(std::memory_order_relaxed); }
+    uint64_t exhausted() const { return exhausted_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    // [tag:32][index:32] - der Tag verhindert ABA beim CAS
+    static uint64_t pack(uint32_t index, uint32_t tag) { return (uint64_t{tag} << 32) | index; }
+    static uint32_t index_of(uint64_t head) { return static_cast<uint32_t>(head); }
+    static uint32_t tag_of(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+    const uint32_t capacity_;
+    std::unique_ptr<Message[]> messages_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_;
+
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<size_t> in_use_{0};
+    std::atomic<uint64_t> exhausted_{0};
+};
+
+} // namespace ads_realtime
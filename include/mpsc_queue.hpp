@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ads_realtime {
+
+// Bounded MPSC Queue für kleine, trivial kopierbare Elemente (Pointer, Handles)
+// Gleicher Algorithmus wie NotificationRing (Sequence pro Slot, Vyukov), aber
+// ohne Datenkopie - Producer: beliebige Threads, Consumer: genau ein Thread
+template<typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity) {
+        capacity_ = 2;
+        while (capacity_ < capacity) {
+            capacity_ <<= 1;
+        }
+        mask_ = capacity_ - 1;
+
+        slots_ = std::make_unique<Slot[]>(capacity_);
+        for (size_t i = 0; i < capacity_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // false wenn die Queue voll ist
+    bool try_push(const T& value) {
+        Slot* slot = nullptr;
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = value;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Nur Consumer Thread
+    bool try_pop(T& value) {
+        Slot& slot = slots_[dequeue_pos_ & mask_];
+        uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<int64_t>(seq) - static_cast<int64_t>(dequeue_pos_ + 1) < 0) {
+            return false;
+        }
+        value = slot.value;
+        slot.sequence.store(dequeue_pos_ + capacity_, std::memory_order_release);
+        dequeue_pos_++;
+        return true;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    // Näherungswert (für Statistiken)
+    size_t size() const {
+        uint64_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+        uint64_t dequeued = dequeue_count_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? static_cast<size_t>(enqueued - dequeued) : 0;
+    }
+
+    // Consumer meldet den Stand für size() (einmal pro Batch statt pro Element)
+    void publish_consumed() {
+        dequeue_count_.store(dequeue_pos_, std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};
+        T value{};
+    };
+
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) uint64_t dequeue_pos_ = 0;
+    std::atomic<uint64_t> dequeue_count_{0};
+};
+
+} // namespace ads_realtime
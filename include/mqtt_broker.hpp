@@ -0,0 +1,189 @@
+#pragma once
+
+#include "realtime_config.hpp"
+#include "message_pool.hpp"
+#include "mpsc_queue.hpp"
+#include "latency_histogram.hpp"
+#include "topic_trie.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ads_realtime {
+
+/**
+ * Eingebetteter MQTT Broker (MQTT 3.1.1 / 5.0, QoS 0/1, Linux/epoll)
+ *
+ * Ersetzt den externen Broker auf localhost:1883: Clients verbinden sich
+ * direkt mit der Bridge. Ein Broker Thread bedient alle Verbindungen über
+ * epoll (nicht-blockierende Sockets, EPOLLOUT nur solange Daten ausstehen).
+ *
+ * Injektion: Samples der AdsRealtimeEngine (Pool-Nachrichten) gehen ohne
+ * Loopback-TCP direkt in den Fan-out - inject() reiht nur in eine lock-freie
+ * Queue ein und weckt den Broker Thread über ein eventfd (höchstens ein
+ * write() pro Batch). Der Broker Thread löst die Subscriber über den
+ * TopicTrie auf, kodiert pro Subscriber ein PUBLISH in dessen Sendepuffer
+ * und gibt den Pool-Puffer zurück. Die Subscriber-Menge wird pro Variable
+ * gecacht und nur nach einer Änderung der Subscriptions neu aufgelöst
+ * (TopicTrie::generation()) - im Normalbetrieb kein Trie-Lookup pro Sample.
+ *
+ * - Subscriptions mit Wildcards ('+', '#'), QoS 0/1 (gewährt: min(angefragt, 1))
+ * - Retained Messages: letzter Wert pro Topic (config: mqtt_retain für
+ *   injizierte Samples), neue Subscriber erhalten ihn sofort
+ * - PUBLISH von externen Clients wird genauso verteilt (QoS 1: PUBACK)
+ * - Sessions sind immer clean (kein Offline-Puffer); gleiche Client-ID
+ *   übernimmt die ältere Verbindung
+ * - QoS 1 an Subscriber: höchstens mqtt_max_inflight (5.0: Receive Maximum
+ *   des Clients) unbestätigte PUBLISH, weitere warten bis zum PUBACK
+ * - Langsame Subscriber: ab mqtt_broker_max_pending Bytes (Sendepuffer +
+ *   wartende QoS 1) wird für diesen Subscriber verworfen (gezählt) statt
+ *   den Fan-out zu blockieren
+ * - Keepalive: Verbindungen ohne Paket für 1,5 x Keepalive werden getrennt
+ */
+class MqttBroker {
+public:
+    using Pool = MessagePool<256>;
+    using Message = Pool::Message;
+
+    MqttBroker(const RealtimeConfig& config, Pool& pool, int cpu = -1);
+    ~MqttBroker();
+
+    MqttBroker(const MqttBroker&) = delete;
+    MqttBroker& operator=(const MqttBroker&) = delete;
+
+    /**
+     * Listen Socket öffnen (mqtt_listen_address:mqtt_port), startet den Broker Thread
+     */
+    bool start();
+
+    void stop();
+
+    bool is_running() const { return running_.load(std::memory_order_acquire); }
+
+    /**
+     * Topic für eine Variable-ID (vor dem ersten inject, nicht im Hot Path)
+     */
+    void register_topic(uint32_t variable_id, const std::string& topic);
+
+    /**
+     * Nachricht in den Fan-out übernehmen - geht danach an den Pool zurück
+     */
+    void inject(Message* message);
+
+    /**
+     * Retained Nachricht (z.B. PayloadSchema) speichern und an aktuelle
+     * Subscriber verteilen - nicht im Hot Path, auch vor start() möglich
+     */
+    void publish_retained(const std::string& topic, const void* payload, size_t length);
+
+    /**
+     * Zähler zu stats addieren, Fan-out Latenz in fanout_latency mergen
+     */
+    void add_stats(PublisherStats& stats, LatencySnapshot& fanout_latency) const;
+
+    uint16_t port() const { return port_; }
+
+private:
+    struct Entry {
+        Message* message = nullptr;
+        uint64_t enqueue_ns = 0;
+    };
+
+    struct Session;
+    using SessionKey = Session*;
+    using Subscribers = std::vector<TopicTrie<SessionKey>::Subscriber>;
+
+    // Aufgelöste Subscriber eines Variable-Topics, gültig solange generation passt
+    struct TopicMatches {
+        uint64_t generation = 0;
+        Subscribers subscribers;
+    };
+
+    void broker_loop();
+    void accept_clients();
+    void drain_injected();
+    void apply_retained();
+    void read_session(Session& session);
+    bool handle_packet(Session& session, uint8_t header, const uint8_t* body, size_t size);
+    bool handle_connect(Session& session, const uint8_t* body, size_t size);
+    bool handle_publish(Session& session, uint8_t header, const uint8_t* body, size_t size);
+    bool handle_subscribe(Session& session, const uint8_t* body, size_t size);
+    bool handle_unsubscribe(Session& session, const uint8_t* body, size_t size);
+
+    const Subscribers& variable_subscribers(uint32_t variable_id);
+    void deliver(std::string_view topic, const Subscribers& subscribers, const uint8_t* payload, size_t length,
+                 uint8_t qos);
+    void send_retained(Session& session, std::string_view filter, uint8_t qos);
+    void queue_publish(Session& session, std::string_view topic, const uint8_t* payload, size_t length,
+                       uint8_t qos, bool retain);
+    void release_held(Session& session);
+    void store_retained(const std::string& topic, const uint8_t* payload, size_t length);
+    void queue_packet(Session& session, const uint8_t* data, size_t size);
+    void flush_sessions();
+    bool flush_session(Session& session);
+    void close_session(Session& session, const char* reason);
+    void reap_sessions();
+    void check_keepalive(uint64_t now);
+
+    static uint64_t now_ns();
+
+    RealtimeConfig config_;
+    Pool& pool_;
+    int cpu_ = -1;
+    uint16_t port_ = 0;
+
+    // Variable-ID -> Topic (vor dem Start befüllt, danach nur gelesen)
+    std::vector<std::string> topics_;
+
+    MpscQueue<Entry> queue_;
+    std::atomic<bool> wake_pending_{false};
+
+    // publish_retained() -> Broker Thread
+    std::mutex retained_mutex_;
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> pending_retained_;
+    std::atomic<bool> retained_pending_{false};
+
+    std::thread broker_thread_;
+    std::atomic<bool> running_{false};
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;                   // eventfd: inject() -> Broker Thread
+
+    // Ab hier nur Broker Thread
+    std::unordered_map<int, std::unique_ptr<Session>> sessions_;          // fd -> Session
+    std::unordered_map<std::string, Session*> client_ids_;
+    std::vector<Session*> dirty_;        // Sendepuffer gefüllt, noch nicht geschrieben
+    std::vector<Session*> closing_;      // nach dem Event-Durchlauf freigeben
+    TopicTrie<SessionKey> subscriptions_;
+    Subscribers matches_;                // Scratch für PUBLISH von Clients
+    std::vector<TopicMatches> topic_matches_;                            // pro Variable-ID
+    std::unordered_map<std::string, std::vector<uint8_t>> retained_;
+    std::vector<uint8_t> scratch_;       // PUBLISH Header Kodierung
+    uint64_t last_keepalive_check_ns_ = 0;
+
+    // Statistiken
+    std::atomic<uint64_t> injected_{0};
+    std::atomic<uint64_t> received_{0};          // PUBLISH von Clients
+    std::atomic<uint64_t> delivered_{0};         // PUBLISH an Subscriber
+    std::atomic<uint64_t> dropped_slow_{0};
+    std::atomic<uint64_t> dropped_queue_{0};
+    std::atomic<uint64_t> dropped_stopped_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> fanouts_{0};
+    std::atomic<uint64_t> acked_{0};
+    std::atomic<uint64_t> inflight_{0};
+    std::atomic<uint64_t> clients_{0};
+    std::atomic<uint64_t> subscription_count_{0};
+    std::atomic<uint64_t> retained_count_{0};
+    std::unique_ptr<LatencyRecorder> fanout_latency_;
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "realtime_config.hpp"
+#include "message_pool.hpp"
+#include "mpsc_queue.hpp"
+#include "latency_histogram.hpp"
+#include "offline_log.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ads_realtime {
+
+/**
+ * Nativer MQTT Client (Publish-only, MQTT 3.1.1 / 5.0, QoS 0/1)
+ *
+ * Eigene TCP Verbindung zum Broker statt Paho: Producer (Dispatcher Thread)
+ * reihen Pool-Nachrichten nur in eine lock-freie Queue ein. Ein Flush Thread
+ * sammelt bis flush_interval_us nach der ersten wartenden Nachricht (oder bis
+ * flush_bytes erreicht sind) und schreibt den Batch mit einem writev/sendmsg
+ * (Windows: WSASend): die PUBLISH Header liegen in einer vorallokierten
+ * Header-Arena, die Payloads werden direkt aus den Pool-Puffern referenziert
+ * (Scatter/Gather, keine Kopie).
+ *
+ * QoS 0: Pool-Puffer gehen nach dem Schreiben zurück an den Pool.
+ * QoS 1: Puffer bleiben im In-Flight Fenster (max_inflight, Packet-ID = Slot)
+ * bis der Reader Thread das PUBACK empfängt. Ist der Slot der nächsten
+ * Packet-ID noch belegt, wartet der Flush Thread (Backpressure statt Drop).
+ * Nach einem Reconnect werden unbestätigte Nachrichten mit DUP erneut gesendet.
+ *
+ * Keepalive: PINGREQ nach keepalive_s ohne Senden bzw. Empfangen; bleibt das
+ * PINGRESP eine weitere Keepalive-Periode aus, gilt die Verbindung als tot.
+ *
+ * MQTT 5: Der erste PUBLISH einer Variable trägt Topic + Topic Alias, alle
+ * weiteren nur noch den 2-Byte Alias (leeres Topic). Aliases gelten pro
+ * Verbindung und werden nach jedem Reconnect neu vergeben, höchstens bis zum
+ * Topic Alias Maximum aus dem CONNACK - weitere Variablen senden das Topic.
+ * Receive Maximum und Server Keep Alive aus dem CONNACK werden übernommen.
+ *
+ * MqttPublisher betreibt einen MqttClient pro Shard (eigene Verbindung,
+ * Queue und Threads); mit cpu >= 0 laufen Flush und Reader Thread auf
+ * diesem Kern.
+ *
+ * Fehler werden gezählt statt verschluckt (PublisherStats). Bei Verbindungs-
+ * verlust verwirft der Flush Thread wartende QoS 0 Nachrichten (gezählt),
+ * QoS 1 Nachrichten bleiben in der Queue; Reconnect im Sekundentakt.
+ * Der Verbindungsaufbau (non-blocking connect + CONNACK, höchstens 5 s) läuft
+ * in einem eigenen Connect Thread - der Flush Thread leert die Queue derweil
+ * weiter ins Offline-Log, disconnect() bricht einen laufenden Versuch ab.
+ *
+ * Offline-Log (mqtt_offline_dir): ohne Verbindung schreibt der Flush Thread
+ * stattdessen jede Nachricht (QoS 0 und 1) in ein memory-mapped Ringlog und
+ * gibt den Pool-Puffer sofort frei. Nach dem Reconnect sendet er das Log
+ * zwischen den Live-Batches nach (mqtt_offline_replay_rate, nur solange der
+ * Pool zu weniger als der Hälfte belegt ist) - Live-Daten haben Vorrang.
+ * QoS 0 Records bleiben im Log, bis ihr Batch gesendet ist.
+ * Beim Beenden ohne Verbindung landen wartende und unbestätigte Nachrichten
+ * ebenfalls im Log und werden beim nächsten Start nachgesendet.
+ *
+ * Sequenznummern: jede Nachricht bekommt beim Senden bzw. Loggen eine
+ * fortlaufende Nummer (mit Offline-Log persistiert über Neustarts), MQTT 5
+ * sendet sie als User Property "seq" auf jedem PUBLISH - live wie nachgesendet,
+ * der Payload bleibt unverändert. Lücken = verworfene Nachrichten, kleinere
+ * Nummern als zuletzt gesehen = nachgesendet. MQTT 3.1.1 hat keine Properties.
+ */
+class MqttClient {
+public:
+    using Pool = MessagePool<256>;
+    using Message = Pool::Message;
+
+    MqttClient(const RealtimeConfig& config, Pool& pool, int cpu = -1);
+    ~MqttClient();
+
+    MqttClient(const MqttClient&) = delete;
+    MqttClient& operator=(const MqttClient&) = delete;
+
+    /**
+     * TCP + MQTT CONNECT, startet den Flush Thread
+     */
+    bool connect();
+
+    void disconnect();
+
+    bool is_connected() const { return connected_.load(std::memory_order_acquire); }
+
+    /**
+     * Topic für eine Variable-ID (vor dem ersten enqueue, nicht im Hot Path)
+     */
+    void register_topic(uint32_t variable_id, const std::string& topic);
+
+    /**
+     * Nachricht übernehmen - geht nach dem Senden bzw. Verwerfen an den Pool zurück
+     */
+    void enqueue(Message* message);
+
+    /**
+     * Retained PUBLISH (z.B. PayloadSchema), nicht im Hot Path
+     * Der Flush Thread sendet ihn (QoS 0, Retain) und nach jedem Reconnect
+     * erneut - auch ein neu gestarteter Broker hat ihn wieder.
+     */
+    void publish_retained(const std::string& topic, const void* payload, size_t length);
+
+    /**
+     * Zähler zu stats addieren, Flush-Latenz in flush_latency mergen (mehrere Shards)
+     */
+    void add_stats(PublisherStats& stats, LatencySnapshot& flush_latency) const;
+
+private:
+    struct Entry {
+        Message* message = nullptr;
+        uint64_t enqueue_ns = 0;
+    };
+
+    // Header-Arena + Scatter/Gather Vektoren (plattformabhängig, siehe .cpp)
+    struct Batch;
+    // Socket + CONNACK eines Verbindungsaufbaus (Connect Thread -> Flush Thread)
+    struct Handshake;
+
+    bool open_connection(Handshake& handshake, bool background);
+    void activate_connection(Handshake& handshake);
+    void start_reconnect();
+    bool finish_reconnect();
+    void close_connection();
+    bool send_all(const uint8_t* data, size_t size);
+
+    void flush_loop();
+    void wait_for_batch();
+    bool flush(bool draining);
+    void discard_queue();
+    bool fits(const Message* message, const std::string& topic) const;
+    bool append(Message* message, const std::string& topic, uint16_t packet_id, bool dup,
+                uint64_t enqueue_ns);
+    bool send_batch();
+    bool resend_inflight();
+    void keepalive();
+    void wait_for_window();
+    void assign_sequence(Message* message);
+    void log_offline(Message* message);
+    void replay_offline();
+    void send_retained();
+
+    void reader_loop();
+    void handle_packet(uint8_t header, const uint8_t* body, size_t size);
+    void release_inflight();
+
+    const std::string& topic_of(const Message* message) const;
+    static uint64_t now_ns();
+
+    RealtimeConfig config_;
+    Pool& pool_;
+    int cpu_ = -1;
+
+    // Variable-ID -> Topic (vor dem Start befüllt, danach nur gelesen)
+    std::vector<std::string> topics_;
+    std::vector<uint32_t> topic_hashes_;     // Offline-Log: Topic-Prüfung beim Nachsenden
+
+    MpscQueue<Entry> queue_;
+    std::atomic<size_t> pending_bytes_{0};
+
+    uint8_t qos_ = 0;
+    uint8_t protocol_level_ = 4;
+
+    // Flush Thread
+    std::thread flush_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> connected_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::atomic<bool> flusher_waiting_{false};
+    std::unique_ptr<Batch> batch_;       // nur Flush Thread
+
+    // Reconnect: Connect Thread füllt handshake_, Flush Thread übernimmt ihn nach dem Join
+    std::thread connect_thread_;
+    std::atomic<bool> connecting_{false};
+    std::unique_ptr<Handshake> handshake_;
+
+    // QoS 1 In-Flight Fenster: Slot (Packet-ID - 1) -> unbestätigte Nachricht
+    // Flush Thread belegt, Reader Thread gibt frei (PUBACK)
+    std::unique_ptr<std::atomic<Message*>[]> inflight_;
+    size_t inflight_mask_ = 0;
+    uint64_t next_sequence_ = 0;         // nur Flush Thread
+    uint32_t next_publish_sequence_ = 0; // Sequenznummern ohne Offline-Log (nur Flush Thread)
+    std::atomic<size_t> inflight_count_{0};
+
+    // Reader Thread (PUBACK, PINGRESP, DISCONNECT) - läuft pro Verbindung
+    std::thread reader_thread_;
+    std::atomic<uint64_t> last_rx_ns_{0};
+    std::atomic<bool> ping_outstanding_{false};
+    uint64_t last_tx_ns_ = 0;            // nur Flush Thread
+    uint64_t ping_sent_ns_ = 0;
+
+    // Vom Broker vorgegeben (MQTT 5 CONNACK), nur Flush Thread
+    uint16_t keepalive_s_ = 0;
+    size_t receive_maximum_ = SIZE_MAX;
+
+    // MQTT 5 Topic Aliases, pro Verbindung neu vergeben (nur Flush Thread)
+    std::vector<uint16_t> topic_aliases_;    // Variable-ID -> Alias (0 = keiner)
+    uint16_t topic_alias_maximum_ = 0;
+    uint32_t next_topic_alias_ = 1;
+
+    std::intptr_t socket_ = -1;          // SOCKET bzw. fd
+
+    // Retained Nachrichten (publish_retained): Topic -> Payload, Flush Thread sendet
+    std::mutex retained_mutex_;
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> retained_;
+    std::atomic<bool> retained_pending_{false};
+
+    // Offline-Log (nur Flush Thread, nach dessen Ende disconnect())
+    std::unique_ptr<OfflineLog> offline_;
+    ReplayLimiter replay_limiter_;
+    uint64_t offline_synced_ns_ = 0;
+    bool offline_dirty_ = false;
+
+    // Statistiken
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> acked_{0};
+    std::atomic<uint64_t> retransmitted_{0};
+    std::atomic<uint64_t> topic_alias_hits_{0};
+    std::atomic<uint64_t> dropped_queue_{0};
+    std::atomic<uint64_t> dropped_disconnected_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> flushes_{0};
+    std::atomic<uint64_t> bytes_sent_{0};
+    std::atomic<uint64_t> offline_buffered_{0};
+    std::atomic<uint64_t> offline_logged_{0};
+    std::atomic<uint64_t> offline_replayed_{0};
+    std::atomic<uint64_t> offline_evicted_{0};
+    std::unique_ptr<LatencyRecorder> flush_latency_;
+};
+
+} // namespace ads_realtime
@@ -6,10 +6,15 @@
 #endif
 
 #include "realtime_config.hpp"
+#include "message_pool.hpp"
+#include "mqtt_client.hpp"
+#include "mqtt_broker.hpp"
+#include "offline_log.hpp"
 #include <mqtt/async_client.h>
 #include <string>
 #include <atomic>
 #include <memory>
+#include <vector>
 
 namespace ads_realtime {
 
@@ -17,9 +22,37 @@ namespace ads_realtime {
  * High-Performance MQTT Publisher
  * 
  * Zero-Copy Publishing mit QoS 0 für minimale Latenz
+ *
+ * Topics werden pro Variable-ID einmalig interniert (register_topic), Payloads
+ * in vorallokierte Pool-Puffer formatiert (acquire_message/publish).
+ *
+ * MqttPublishMode::Native: statt Paho übernimmt der In-Tree MqttClient die
+ * Nachrichten (Queue + Flush Thread, ein writev() pro Batch, Payload direkt aus
+ * dem Pool-Puffer, QoS 0/1, MQTT 3.1.1/5). Fehler und Drops beider Modi stehen
+ * in get_statistics().
+ *
+ * Sharding: mqtt_connections (0 = worker_threads) Broker-Verbindungen mit
+ * Client-ID <client_id>-<n>. Jede Variable wird über den Hash ihres Topics
+ * genau einem Shard zugeordnet - die Reihenfolge pro Topic bleibt erhalten.
+ * Native: pro Shard eigene Queue, Flush/Reader Thread und (pin_to_cores) CPU.
+ * Paho: pro Shard ein eigener async_client.
+ *
+ * MqttPublishMode::Embedded (Linux): kein externer Broker - der eingebettete
+ * MqttBroker lauscht auf mqtt_port und publish(Message*) reiht die Nachricht
+ * direkt in dessen Fan-out ein (kein Loopback-TCP, kein Sharding).
+ *
+ * Offline-Log (mqtt_offline_dir, Paho und Native): Samples ohne Broker-
+ * Verbindung landen pro Shard in einem memory-mapped Ringlog und werden nach
+ * dem Reconnect mit mqtt_offline_replay_rate nachgesendet. Native: im Flush
+ * Thread (MqttClient). Paho: in publish(Message*) nach dem Live-Sample - nur
+ * aus einem Thread (Dispatcher) aufrufen, nachgesendet wird nur solange
+ * weitere Samples eintreffen.
  */
 class MqttPublisher {
 public:
+    using Pool = MessagePool<256>;
+    using Message = Pool::Message;
+
     explicit MqttPublisher(const RealtimeConfig& config);
     ~MqttPublisher();
 
@@ -38,13 +71,14 @@ public:
     void disconnect();
 
     /**
-     * Wert publizieren (Zero-Copy, inline)
+     * Wert publizieren (Zero-Copy, inline) - nur MqttPublishMode::Paho
      * @param topic MQTT Topic
      * @param payload Daten
      * @param length Datenlänge
      */
     inline void publish(const std::string& topic, const void* payload, size_t length) {
-        if (!connected_.load(std::memory_order_acquire)) {
+        if (clients_.empty() || !connected_.load(std::memory_order_acquire)) {
+            dropped_disconnected_.fetch_add(1, std::memory_order_relaxed);
             return;
         }
 
@@ -53,15 +87,16 @@ public:
             topic,
             payload,
             length,
-            0,      // QoS 0 (Fire-and-Forget, minimale Latenz)
+            config_.mqtt_qos,
             false   // Nicht retained
         );
 
         // Async publish (blockiert nicht)
         try {
-            client_->publish(msg);
-        } catch (...) {
-            // Fehler ignorieren für maximale Performance
+            clients_[shard_of(topic, clients_.size())]->publish(msg);
+            published_.fetch_add(1, std::memory_order_relaxed);
+        } catch (const mqtt::exception&) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
         }
     }
 
@@ -70,10 +105,108 @@ public:
      */
     void publish_string(const std::string& topic, const std::string& value);
 
+    /**
+     * Topic für eine Variable-ID internieren (vor dem Start, nicht im Hot Path)
+     */
+    void register_topic(uint32_t variable_id, const std::string& topic);
+
+    /**
+     * Puffer aus dem Pool holen (nullptr wenn erschöpft)
+     * Caller füllt variable_id, data und length und übergibt ihn an publish().
+     */
+    Message* acquire_message() { return pool_->acquire(); }
+
+    /**
+     * Pool-Nachricht auf dem internierten Topic publizieren, Puffer geht zurück an den Pool
+     * (Native: nur Enqueue, Senden im Flush Thread)
+     */
+    void publish(Message* message);
+
+    /**
+     * Rohdaten auf dem Topic einer Variable-ID publizieren
+     */
+    inline void publish(uint32_t variable_id, const void* payload, size_t length) {
+        if (clients_.empty() || !connected_.load(std::memory_order_acquire)) {
+            dropped_disconnected_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (variable_id >= topics_.size()) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        try {
+            clients_[shards_[variable_id]]->publish(
+                mqtt::make_message(topics_[variable_id], payload, length, config_.mqtt_qos, false));
+            published_.fetch_add(1, std::memory_order_relaxed);
+        } catch (const mqtt::exception&) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Retained publizieren (z.B. PayloadSchema auf PayloadSchema::topic()), nicht im Hot Path
+     * Native: nach jedem Reconnect erneut gesendet. Embedded: direkt im Broker gespeichert.
+     */
+    void publish_retained(const std::string& topic, const void* payload, size_t length);
+
+    size_t pool_in_use() const { return pool_->in_use(); }
+    uint64_t pool_exhausted() const { return pool_->exhausted(); }
+
+    /**
+     * Durchsatz, Drops, Fehler, Queue-Tiefe und Flush-Latenz
+     */
+    PublisherStats get_statistics() const;
+
+    size_t shard_count() const { return shard_count_; }
+
+    /**
+     * Shard eines Topics (FNV-1a, stabil über Neustarts und Registrierungsreihenfolge)
+     */
+    static size_t shard_of(const std::string& topic, size_t shard_count) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : topic) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return shard_count > 1 ? hash % shard_count : 0;
+    }
+
 private:
+    // Paho + Offline-Log: Sample loggen (ohne Verbindung) bzw. publizieren und Log nachsenden
+    void publish_paho_offline(const Message* message);
+    void replay_paho_offline(size_t shard);
+    void update_offline_stats();
+
     RealtimeConfig config_;
-    std::unique_ptr<mqtt::async_client> client_;
+    size_t shard_count_ = 1;
+    std::vector<std::unique_ptr<mqtt::async_client>> clients_;   // nur MqttPublishMode::Paho
     std::atomic<bool> connected_{false};
+
+    // Variable-ID -> Topic (Paho string_ref: geteilt, keine Kopie pro Nachricht) und Shard
+    std::vector<mqtt::string_ref> topics_;
+    std::vector<uint32_t> shards_;
+    std::vector<uint32_t> topic_hashes_;                         // Offline-Log: Topic-Prüfung
+    std::unique_ptr<Pool> pool_;
+    std::vector<std::unique_ptr<MqttClient>> native_;            // nur MqttPublishMode::Native
+#ifndef _WIN32
+    std::unique_ptr<MqttBroker> broker_;                         // nur MqttPublishMode::Embedded
+#endif
+
+    // Paho + Offline-Log: pro Shard, nur Dispatcher Thread
+    struct PahoOffline {
+        std::unique_ptr<OfflineLog> log;
+        ReplayLimiter limiter;
+        uint64_t synced_ns = 0;
+    };
+    std::vector<PahoOffline> paho_offline_;
+
+    // Paho-Modus Statistiken
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> dropped_disconnected_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> offline_buffered_{0};
+    std::atomic<uint64_t> offline_logged_{0};
+    std::atomic<uint64_t> offline_replayed_{0};
+    std::atomic<uint64_t> offline_evicted_{0};
 };
 
 } // namespace ads_realtime
@@ -0,0 +1,401 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ads_realtime {
+namespace mqtt_wire {
+
+// MQTT 3.1.1 / 5.0 Paket-Kodierung (OASIS Standard, Kapitel 2/3)
+// Fixed Header: [Typ:4|Flags:4][Remaining Length: 1-4 Bytes, 7 Bit pro Byte]
+// Alle Mehrbyte-Felder Big Endian
+// MQTT 5 ergänzt Properties ([Länge als Variable Byte Integer][Properties]) in
+// CONNECT, CONNACK, PUBLISH, PUBACK und DISCONNECT
+
+enum class PacketType : uint8_t {
+    Connect = 1,
+    Connack = 2,
+    Publish = 3,
+    Puback = 4,
+    Pubrec = 5,
+    Pubrel = 6,
+    Pubcomp = 7,
+    Subscribe = 8,
+    Suback = 9,
+    Unsubscribe = 10,
+    Unsuback = 11,
+    Pingreq = 12,
+    Pingresp = 13,
+    Disconnect = 14
+};
+
+constexpr uint8_t PROTOCOL_LEVEL_311 = 4;
+constexpr uint8_t PROTOCOL_LEVEL_5 = 5;
+constexpr size_t MAX_FIXED_HEADER = 5;                 // Typ + 4 Bytes Remaining Length
+
+// MQTT 5 Property Identifier (Kapitel 2.2.2.2)
+enum class Property : uint8_t {
+    PayloadFormat = 0x01,
+    MessageExpiry = 0x02,
+    ContentType = 0x03,
+    ResponseTopic = 0x08,
+    CorrelationData = 0x09,
+    SubscriptionId = 0x0B,
+    SessionExpiry = 0x11,
+    AssignedClientId = 0x12,
+    ServerKeepAlive = 0x13,
+    AuthMethod = 0x15,
+    AuthData = 0x16,
+    RequestProblemInfo = 0x17,
+    WillDelay = 0x18,
+    RequestResponseInfo = 0x19,
+    ResponseInfo = 0x1A,
+    ServerReference = 0x1C,
+    ReasonString = 0x1F,
+    ReceiveMaximum = 0x21,
+    TopicAliasMaximum = 0x22,
+    TopicAlias = 0x23,
+    MaximumQos = 0x24,
+    RetainAvailable = 0x25,
+    UserProperty = 0x26,
+    MaximumPacketSize = 0x27,
+    WildcardSubAvailable = 0x28,
+    SubIdAvailable = 0x29,
+    SharedSubAvailable = 0x2A
+};
+constexpr uint32_t MAX_REMAINING_LENGTH = 268435455;   // 0x0FFFFFFF
+
+inline uint8_t fixed_header_byte(PacketType type, uint8_t flags = 0) {
+    return static_cast<uint8_t>((static_cast<uint8_t>(type) << 4) | (flags & 0x0F));
+}
+
+inline size_t remaining_length_size(uint32_t length) {
+    return length < 128 ? 1 : length < 16384 ? 2 : length < 2097152 ? 3 : 4;
+}
+
+// Variable Byte Integer, Rückgabe: geschriebene Bytes (1-4)
+inline size_t encode_remaining_length(uint32_t length, uint8_t* out) {
+    size_t n = 0;
+    do {
+        uint8_t byte = static_cast<uint8_t>(length & 0x7F);
+        length >>= 7;
+        if (length > 0) byte |= 0x80;
+        out[n++] = byte;
+    } while (length > 0 && n < 4);
+    return n;
+}
+
+// false = noch nicht vollständig empfangen bzw. ungültig (used = 0)
+inline bool decode_remaining_length(const uint8_t* data, size_t size, uint32_t& length, size_t& used) {
+    length = 0;
+    used = 0;
+    for (size_t i = 0; i < 4 && i < size; i++) {
+        length |= static_cast<uint32_t>(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0) {
+            used = i + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline size_t encode_u16(uint16_t value, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(value >> 8);
+    out[1] = static_cast<uint8_t>(value & 0xFF);
+    return 2;
+}
+
+inline uint16_t decode_u16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+inline size_t encode_string(const std::string& value, uint8_t* out) {
+    encode_u16(static_cast<uint16_t>(value.size()), out);
+    std::memcpy(out + 2, value.data(), value.size());
+    return 2 + value.size();
+}
+
+// CONNECT ohne Will/Username/Password (MQTT 5: ohne Properties)
+inline std::vector<uint8_t> build_connect(const std::string& client_id, uint16_t keepalive_s,
+                                          bool clean_session, uint8_t protocol_level = PROTOCOL_LEVEL_311) {
+    static const std::string protocol_name = "MQTT";
+    bool v5 = protocol_level >= PROTOCOL_LEVEL_5;
+    uint32_t remaining = static_cast<uint32_t>(2 + protocol_name.size() + 1 + 1 + 2 + (v5 ? 1 : 0) +
+                                               2 + client_id.size());
+
+    std::vector<uint8_t> packet(1 + remaining_length_size(remaining) + remaining);
+    uint8_t* p = packet.data();
+    *p++ = fixed_header_byte(PacketType::Connect);
+    p += encode_remaining_length(remaining, p);
+    p += encode_string(protocol_name, p);
+    *p++ = protocol_level;
+    *p++ = clean_session ? 0x02 : 0x00;       // Connect Flags
+    p += encode_u16(keepalive_s, p);
+    if (v5) *p++ = 0;                         // Properties Länge
+    encode_string(client_id, p);
+    return packet;
+}
+
+inline std::vector<uint8_t> build_disconnect() {
+    return {fixed_header_byte(PacketType::Disconnect), 0};
+}
+
+constexpr uint8_t PINGREQ_PACKET[2] = {static_cast<uint8_t>(PacketType::Pingreq) << 4, 0};
+
+// Vom Broker gemeldete Grenzen (MQTT 5 CONNACK Properties, 0 = nicht gesetzt)
+struct ConnackInfo {
+    uint8_t reason_code = 0;                  // MQTT 3.1.1: Return Code
+    bool session_present = false;
+    uint16_t topic_alias_maximum = 0;         // 0 = keine Topic Aliases erlaubt
+    uint16_t receive_maximum = 0;             // max. unbestätigte QoS 1/2 PUBLISH
+    uint16_t server_keepalive = 0;            // ersetzt den Keepalive des Clients
+    bool has_server_keepalive = false;
+    uint8_t maximum_qos = 2;
+    uint32_t maximum_packet_size = 0;
+};
+
+// CONNACK: [Session Present][Return/Reason Code]{MQTT 5: Properties}
+// Rückgabe false bei ungültigem Paket, info.reason_code = 0 bei Erfolg
+inline bool parse_connack(const uint8_t* body, size_t size, uint8_t protocol_level, ConnackInfo& info) {
+    if (size < 2) return false;
+    info.session_present = (body[0] & 0x01) != 0;
+    info.reason_code = body[1];
+    if (protocol_level < PROTOCOL_LEVEL_5 || size == 2) return true;
+
+    uint32_t properties_length = 0;
+    size_t used = 0;
+    if (!decode_remaining_length(body + 2, size - 2, properties_length, used) ||
+        2 + used + properties_length > size) {
+        return false;
+    }
+    const uint8_t* p = body + 2 + used;
+    const uint8_t* end = p + properties_length;
+    while (p < end) {
+        auto id = static_cast<Property>(*p++);
+        size_t left = static_cast<size_t>(end - p);
+        switch (id) {
+            case Property::TopicAliasMaximum:
+            case Property::ReceiveMaximum:
+            case Property::ServerKeepAlive: {
+                if (left < 2) return false;
+                uint16_t value = decode_u16(p);
+                if (id == Property::TopicAliasMaximum) info.topic_alias_maximum = value;
+                else if (id == Property::ReceiveMaximum) info.receive_maximum = value;
+                else { info.server_keepalive = value; info.has_server_keepalive = true; }
+                p += 2;
+                break;
+            }
+            case Property::MaximumQos:
+            case Property::RetainAvailable:
+            case Property::WildcardSubAvailable:
+            case Property::SubIdAvailable:
+            case Property::SharedSubAvailable:
+                if (left < 1) return false;
+                if (id == Property::MaximumQos) info.maximum_qos = *p;
+                p += 1;
+                break;
+            case Property::SessionExpiry:
+            case Property::MaximumPacketSize:
+                if (left < 4) return false;
+                if (id == Property::MaximumPacketSize) {
+                    info.maximum_packet_size = (static_cast<uint32_t>(decode_u16(p)) << 16) | decode_u16(p + 2);
+                }
+                p += 4;
+                break;
+            case Property::AssignedClientId:
+            case Property::ReasonString:
+            case Property::ResponseInfo:
+            case Property::ServerReference:
+            case Property::AuthMethod:
+            case Property::AuthData: {
+                if (left < 2 || left < 2u + decode_u16(p)) return false;
+                p += 2 + decode_u16(p);
+                break;
+            }
+            case Property::UserProperty: {
+                for (int i = 0; i < 2; i++) {             // Name + Wert
+                    left = static_cast<size_t>(end - p);
+                    if (left < 2 || left < 2u + decode_u16(p)) return false;
+                    p += 2 + decode_u16(p);
+                }
+                break;
+            }
+            default:
+                return false;                             // in CONNACK nicht erlaubt
+        }
+    }
+    return true;
+}
+
+// Properties-Block [Länge][Properties] durchlaufen: fn(Property, Wert, Wertlänge) -> false = ablehnen
+// Rückgabe: Länge des ganzen Blocks, 0 = ungültig bzw. abgelehnt
+template<typename F>
+inline size_t parse_properties(const uint8_t* data, size_t size, F&& fn) {
+    uint32_t properties_length = 0;
+    size_t used = 0;
+    if (!decode_remaining_length(data, size, properties_length, used) || used + properties_length > size) {
+        return 0;
+    }
+    const uint8_t* p = data + used;
+    const uint8_t* end = p + properties_length;
+    while (p < end) {
+        auto id = static_cast<Property>(*p++);
+        size_t left = static_cast<size_t>(end - p);
+        size_t value_size = 0;
+        switch (id) {
+            case Property::PayloadFormat:
+            case Property::RequestProblemInfo:
+            case Property::RequestResponseInfo:
+            case Property::MaximumQos:
+            case Property::RetainAvailable:
+            case Property::WildcardSubAvailable:
+            case Property::SubIdAvailable:
+            case Property::SharedSubAvailable:
+                value_size = 1;
+                break;
+            case Property::ServerKeepAlive:
+            case Property::ReceiveMaximum:
+            case Property::TopicAliasMaximum:
+            case Property::TopicAlias:
+                value_size = 2;
+                break;
+            case Property::MessageExpiry:
+            case Property::SessionExpiry:
+            case Property::WillDelay:
+            case Property::MaximumPacketSize:
+                value_size = 4;
+                break;
+            case Property::SubscriptionId: {
+                uint32_t ignored = 0;
+                if (!decode_remaining_length(p, left, ignored, value_size)) return 0;
+                break;
+            }
+            case Property::ContentType:
+            case Property::ResponseTopic:
+            case Property::CorrelationData:
+            case Property::AssignedClientId:
+            case Property::AuthMethod:
+            case Property::AuthData:
+            case Property::ResponseInfo:
+            case Property::ServerReference:
+            case Property::ReasonString:
+                if (left < 2) return 0;
+                value_size = 2u + decode_u16(p);
+                break;
+            case Property::UserProperty:
+                if (left < 2 || left < 4u + decode_u16(p)) return 0;
+                value_size = 2u + decode_u16(p);
+                value_size += 2u + decode_u16(p + value_size);
+                break;
+            default:
+                return 0;
+        }
+        if (value_size > left || !fn(id, p, value_size)) return 0;
+        p += value_size;
+    }
+    return used + properties_length;
+}
+
+// Sequenznummer als MQTT 5 User Property "seq" (Dezimalstring) auf jedem PUBLISH
+constexpr char SEQUENCE_PROPERTY[] = "seq";
+constexpr size_t SEQUENCE_PROPERTY_MAX = 1 + 2 + 3 + 2 + 10;
+
+inline size_t sequence_property_size(uint32_t sequence) {
+    size_t digits = 1;
+    while (sequence >= 10) {
+        sequence /= 10;
+        digits++;
+    }
+    return 1 + 2 + 3 + 2 + digits;
+}
+
+inline size_t encode_sequence_property(uint32_t sequence, uint8_t* out) {
+    size_t size = sequence_property_size(sequence);
+    uint8_t* p = out;
+    *p++ = static_cast<uint8_t>(Property::UserProperty);
+    p += encode_u16(3, p);
+    std::memcpy(p, SEQUENCE_PROPERTY, 3);
+    p += 3;
+    size_t digits = size - (1 + 2 + 3 + 2);
+    p += encode_u16(static_cast<uint16_t>(digits), p);
+    for (size_t i = digits; i > 0; i--) {
+        p[i - 1] = static_cast<uint8_t>('0' + sequence % 10);
+        sequence /= 10;
+    }
+    return size;
+}
+
+// PUBLISH Header (alles außer Payload) - Fixed Header, Topic, Packet Id, Properties
+// Maximale Größe: 5 + 2 + topic + 2 + 1 + 3 (Topic Alias) + 18 (User Property "seq")
+inline size_t publish_header_size(size_t topic_length) {
+    return MAX_FIXED_HEADER + 2 + topic_length + 2 + 1 + 3 + SEQUENCE_PROPERTY_MAX;
+}
+
+// topic_alias != 0 (nur MQTT 5): Topic Alias Property; bei leerem Topic
+// (topic_length = 0) löst der Broker das Topic über den zuvor gesendeten Alias auf
+// sequence >= 0 (nur MQTT 5): User Property "seq" mit der Sequenznummer
+inline size_t encode_publish_header(uint8_t* out, const char* topic, size_t topic_length,
+                                    size_t payload_length, uint8_t qos, uint16_t packet_id, bool dup,
+                                    uint8_t protocol_level = PROTOCOL_LEVEL_311, uint16_t topic_alias = 0,
+                                    bool retain = false, int64_t sequence = -1) {
+    bool v5 = protocol_level >= PROTOCOL_LEVEL_5;
+    bool with_sequence = v5 && sequence >= 0;
+    size_t properties = (v5 && topic_alias != 0) ? 3 : 0;
+    if (with_sequence) {
+        properties += sequence_property_size(static_cast<uint32_t>(sequence));
+    }
+    uint32_t remaining = static_cast<uint32_t>(2 + topic_length + (qos > 0 ? 2 : 0) +
+                                               (v5 ? 1 + properties : 0) + payload_length);
+    uint8_t flags = static_cast<uint8_t>((dup ? 0x08 : 0) | ((qos & 0x03) << 1) | (retain ? 0x01 : 0));
+    uint8_t* p = out;
+    *p++ = fixed_header_byte(PacketType::Publish, flags);
+    p += encode_remaining_length(remaining, p);
+    p += encode_u16(static_cast<uint16_t>(topic_length), p);
+    std::memcpy(p, topic, topic_length);
+    p += topic_length;
+    if (qos > 0) p += encode_u16(packet_id, p);
+    if (v5) {
+        *p++ = static_cast<uint8_t>(properties);  // Properties Länge (< 128)
+        if (topic_alias != 0) {
+            *p++ = static_cast<uint8_t>(Property::TopicAlias);
+            p += encode_u16(topic_alias, p);
+        }
+        if (with_sequence) {
+            p += encode_sequence_property(static_cast<uint32_t>(sequence), p);
+        }
+    }
+    return static_cast<size_t>(p - out);
+}
+
+inline size_t encode_publish_header(uint8_t* out, const std::string& topic, size_t payload_length,
+                                    uint8_t qos, uint16_t packet_id, bool dup,
+                                    uint8_t protocol_level = PROTOCOL_LEVEL_311, bool retain = false) {
+    return encode_publish_header(out, topic.data(), topic.size(), payload_length, qos, packet_id, dup,
+                                 protocol_level, 0, retain);
+}
+
+// Größe eines PUBLISH Pakets
+inline size_t publish_size(size_t topic_length, size_t payload_length, uint8_t qos = 0,
+                           uint8_t protocol_level = PROTOCOL_LEVEL_311) {
+    uint32_t remaining = static_cast<uint32_t>(2 + topic_length + (qos > 0 ? 2 : 0) +
+                                               (protocol_level >= PROTOCOL_LEVEL_5 ? 1 : 0) + payload_length);
+    return 1 + remaining_length_size(remaining) + remaining;
+}
+
+// Komplettes QoS 0 PUBLISH in out schreiben (out muss publish_size() Bytes fassen)
+inline size_t encode_publish(uint8_t* out, const std::string& topic, const void* payload,
+                             size_t payload_length, bool retain = false) {
+    uint32_t remaining = static_cast<uint32_t>(2 + topic.size() + payload_length);
+    uint8_t* p = out;
+    *p++ = fixed_header_byte(PacketType::Publish, retain ? 0x01 : 0x00);
+    p += encode_remaining_length(remaining, p);
+    p += encode_string(topic, p);
+    std::memcpy(p, payload, payload_length);
+    return static_cast<size_t>(p - out) + payload_length;
+}
+
+} // namespace mqtt_wire
+} // namespace ads_realtime
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace ads_realtime {
+
+// Metadaten einer ADS Notification (Kopie von AdsNotificationHeader + Kontext)
+struct NotificationSample {
+    uintptr_t user = 0;                 // Variable-ID (bzw. hUser der Notification)
+    uint32_t notification_handle = 0;   // AdsNotificationHeader::hNotification
+    uint32_t sample_size = 0;           // AdsNotificationHeader::cbSampleSize
+    int64_t ads_timestamp = 0;          // ADS Timestamp (100ns seit 1601)
+    uint64_t receive_timestamp_ns = 0;  // Empfangszeitpunkt im Callback
+};
+
+// Bounded MPSC Ring Buffer mit vorallokierten, festen Slots
+// Producer: ADS Router Thread(s) - kopiert nur Header + Sample, blockiert nie
+// Consumer: genau ein Dispatcher Thread
+// Algorithmus: Sequence-Nummer pro Slot (Vyukov), keine Allokation nach dem Konstruktor
+template<size_t SlotDataSize = 256>
+class NotificationRing {
+public:
+    static constexpr size_t slot_data_size = SlotDataSize;
+
+    explicit NotificationRing(size_t capacity) {
+        // Auf Zweierpotenz aufrunden (Index per Maske statt Modulo)
+        capacity_ = 2;
+        while (capacity_ < capacity) {
+            capacity_ <<= 1;
+        }
+        mask_ = capacity_ - 1;
+
+        slots_ = std::make_unique<Slot[]>(capacity_);
+        for (size_t i = 0; i < capacity_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    NotificationRing(const NotificationRing&) = delete;
+    NotificationRing& operator=(const NotificationRing&) = delete;
+
+    // Schreibt ein Sample (Producer, wait-free bis auf CAS-Retry)
+    // Gibt false zurück wenn der Ring voll oder das Sample zu groß ist
+    bool try_push(const NotificationSample& meta, const void* data) {
+        if (meta.sample_size > SlotDataSize) {
+            oversized_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Slot* slot = nullptr;
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // Ring voll - Sample verwerfen statt zu blockieren
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->meta = meta;
+        std::memcpy(slot->data, data, meta.sample_size);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Liest bis zu max_items Samples (nur Consumer Thread)
+    // fn(const NotificationSample&, const uint8_t* data) wird direkt auf dem Slot aufgerufen
+    template<typename Fn>
+    size_t drain(Fn&& fn, size_t max_items = SIZE_MAX) {
+        size_t count = 0;
+        uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (count < max_items) {
+            Slot& slot = slots_[pos & mask_];
+            uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+            if (seq != pos + 1) {
+                break; // Leer
+            }
+
+            fn(slot.meta, slot.data);
+
+            slot.sequence.store(pos + capacity_, std::memory_order_release);
+            pos++;
+            count++;
+        }
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+        return count;
+    }
+
+    bool empty() const {
+        uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return slots_[pos & mask_].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    // Ungefähre Füllung (für Monitoring)
+    size_t size_approx() const {
+        uint64_t head = enqueue_pos_.load(std::memory_order_relaxed);
+        uint64_t tail = dequeue_pos_.load(std::memory_order_relaxed);
+        return head > tail ? static_cast<size_t>(head - tail) : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    uint64_t oversized() const { return oversized_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence{0};
+        NotificationSample meta;
+        alignas(8) uint8_t data[SlotDataSize];
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    uint64_t mask_ = 0;
+
+    // Producer- und Consumer-Index auf getrennten Cache Lines (kein False Sharing)
+    alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> oversized_{0};
+};
+
+} // namespace ads_realtime
@@ -0,0 +1,403 @@
+#pragma once
+
+// Windows max/min Makro deaktivieren BEVOR andere Headers
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "binary_payload.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ads_realtime {
+
+/**
+ * Offline-Log: Store-and-Forward Puffer für Samples während Broker-Ausfällen
+ *
+ * Memory-mapped Ringdatei fester Größe: eine Kopfseite mit Lese- und
+ * Schreibposition, danach der Ring mit Records
+ *   [BinaryPayloadHeader][variable_id][Topic-Hash][ADS Timestamp][Payload]
+ * (type = Single, total_size = Record-Größe, timestamp_us = Aufnahmezeit).
+ * Der Topic-Hash (FNV-1a) erkennt beim Nachsenden nach einem Neustart,
+ * ob die Variable-ID noch zum selben Topic gehört.
+ * sequence_number stammt aus take_sequence(): der Zähler im Dateikopf läuft
+ * über Neustarts weiter und nummeriert alle Nachrichten des Clients (live
+ * gesendete und geloggte). Ist der Ring voll, werden die ältesten Records
+ * verworfen (evicted) - die Lücke ist in den Sequenznummern sichtbar.
+ *
+ * Nachsenden: peek()/skip() lesen ab einer Leseposition, ohne freizugeben;
+ * commit() gibt erst die tatsächlich gesendeten Records frei, rewind() setzt
+ * nach einem Sendefehler auf den ältesten zurück - die Reihenfolge bleibt
+ * erhalten. Nachgesendete Nachrichten tragen die Sequenznummer, die sie bei
+ * der Aufnahme bekommen haben.
+ *
+ * append()/front()/pop() kopieren nur in bzw. aus dem Mapping (kein Syscall);
+ * sync() stößt das Zurückschreiben asynchron an. Ein Prozessabsturz verliert
+ * nichts, bei Stromausfall höchstens die noch nicht geschriebenen Seiten.
+ * Beim Öffnen wird der Ring geprüft und hinter dem letzten gültigen Record
+ * abgeschnitten.
+ *
+ * Nicht thread-safe - gehört genau einem Thread (Flush Thread bzw. Dispatcher).
+ */
+class OfflineLog {
+public:
+    struct Record {
+        uint32_t sequence = 0;
+        uint32_t variable_id = 0;
+        uint32_t topic_hash = 0;
+        uint64_t timestamp = 0;         // ADS Timestamp des Samples
+        uint64_t logged_us = 0;         // Aufnahme ins Log (Unix µs)
+        uint32_t length = 0;            // Payload Bytes
+    };
+
+    OfflineLog() = default;
+    ~OfflineLog() { close(); }
+
+    OfflineLog(const OfflineLog&) = delete;
+    OfflineLog& operator=(const OfflineLog&) = delete;
+
+    /**
+     * Datei öffnen bzw. anlegen; vorhandene Records bleiben erhalten, wenn
+     * Format und Größe passen (sonst wird das Log neu initialisiert)
+     */
+    bool open(const std::string& path, size_t max_bytes) {
+        close();
+        if (max_bytes <= HEADER_SPACE + 2 * sizeof(RecordHeader)) {
+            return false;
+        }
+        size_t file_size = max_bytes;
+        if (!map_file(path, file_size)) {
+            close();
+            return false;
+        }
+        header_ = reinterpret_cast<FileHeader*>(base_);
+        ring_ = base_ + HEADER_SPACE;
+        capacity_ = file_size - HEADER_SPACE;
+
+        if (std::memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 || header_->version != VERSION ||
+            header_->capacity != capacity_ || header_->tail < header_->head ||
+            header_->tail - header_->head > capacity_) {
+            std::memset(header_, 0, sizeof(FileHeader));
+            std::memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+            header_->version = VERSION;
+            header_->capacity = capacity_;
+        } else {
+            recover();
+        }
+        read_ = header_->head;
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (base_) UnmapViewOfFile(base_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (base_) munmap(base_, HEADER_SPACE + capacity_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        base_ = nullptr;
+        header_ = nullptr;
+        ring_ = nullptr;
+        capacity_ = 0;
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+
+    /**
+     * Nächste Sequenznummer vergeben (persistiert, auch für nicht geloggte Nachrichten)
+     */
+    uint32_t take_sequence() { return header_ ? header_->next_sequence++ : 0; }
+
+    /**
+     * Sample mit seiner Sequenznummer anhängen, älteste Records verwerfen bis es passt
+     */
+    bool append(uint32_t sequence, uint32_t variable_id, uint32_t topic_hash, uint64_t timestamp,
+                const void* data, size_t length) {
+        size_t size = sizeof(RecordHeader) + length;
+        if (!header_ || size > capacity_ / 2) {
+            return false;
+        }
+        while (capacity_ - (header_->tail - header_->head) < size) {
+            RecordHeader oldest;
+            read_wrapped(&oldest, sizeof(oldest), header_->head);
+            header_->head += oldest.payload.total_size;
+            header_->records--;
+            header_->evicted++;
+        }
+        if (read_ < header_->head) read_ = header_->head;
+
+        RecordHeader record{};
+        record.payload.version = 1;
+        record.payload.type = static_cast<uint8_t>(PayloadType::Single);
+        record.payload.variable_count = 1;
+        record.payload.total_size = static_cast<uint32_t>(size);
+        record.payload.timestamp_us = now_us();
+        record.payload.sequence_number = sequence;
+        record.variable_id = variable_id;
+        record.topic_hash = topic_hash;
+        record.timestamp = timestamp;
+        write_wrapped(&record, sizeof(record), header_->tail);
+        write_wrapped(data, length, header_->tail + sizeof(record));
+
+        // Erst nach den Daten sichtbar machen (Absturz mitten im Schreiben: Record fehlt nur)
+        header_->tail += size;
+        header_->records++;
+        return true;
+    }
+
+    /**
+     * Ältesten Record lesen (Payload nach data, höchstens capacity Bytes)
+     */
+    bool front(Record& record, void* data, size_t capacity) const {
+        return !empty() && read_record(header_->head, record, data, capacity);
+    }
+
+    void pop() {
+        if (empty()) {
+            return;
+        }
+        RecordHeader stored;
+        read_wrapped(&stored, sizeof(stored), header_->head);
+        header_->head += stored.payload.total_size;
+        header_->records--;
+        if (read_ < header_->head) read_ = header_->head;
+    }
+
+    /**
+     * Record an der Leseposition lesen (false wenn keiner mehr ungelesen ist
+     * oder der Payload nicht in capacity passt)
+     */
+    bool peek(Record& record, void* data, size_t capacity) const {
+        return has_unread() && read_record(read_, record, data, capacity);
+    }
+
+    // Leseposition hinter den Record von peek()
+    void skip() {
+        if (!has_unread()) {
+            return;
+        }
+        RecordHeader stored;
+        read_wrapped(&stored, sizeof(stored), read_);
+        read_ += stored.payload.total_size;
+    }
+
+    // Alle Records vor der Leseposition freigeben (gesendet)
+    void commit() {
+        while (header_ && header_->head < read_) {
+            pop();
+        }
+    }
+
+    // Leseposition zurück auf den ältesten Record (Senden fehlgeschlagen)
+    void rewind() {
+        if (header_) read_ = header_->head;
+    }
+
+    bool has_unread() const { return header_ && read_ < header_->tail; }
+
+    /**
+     * Geänderte Seiten asynchron zurückschreiben
+     */
+    void sync() {
+        if (!base_) return;
+#ifdef _WIN32
+        FlushViewOfFile(base_, 0);
+#else
+        msync(base_, HEADER_SPACE + capacity_, MS_ASYNC);
+#endif
+    }
+
+    bool empty() const { return !header_ || header_->head == header_->tail; }
+    uint64_t records() const { return header_ ? header_->records : 0; }
+    uint64_t bytes() const { return header_ ? header_->tail - header_->head : 0; }
+    uint64_t evicted() const { return header_ ? header_->evicted : 0; }
+    uint32_t next_sequence() const { return header_ ? header_->next_sequence : 0; }
+
+    // Sequenznummer des ältesten Records (next_sequence() wenn leer)
+    uint32_t first_sequence() const {
+        if (empty()) {
+            return next_sequence();
+        }
+        RecordHeader oldest;
+        read_wrapped(&oldest, sizeof(oldest), header_->head);
+        return oldest.payload.sequence_number;
+    }
+
+    static uint32_t topic_hash(const std::string& topic) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : topic) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+private:
+    static constexpr char MAGIC[8] = {'A', 'D', 'S', 'O', 'L', 'O', 'G', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SPACE = 4096;    // Ring beginnt seitenausgerichtet
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t next_sequence;         // nächste Sequenznummer (take_sequence)
+        uint64_t capacity;              // Ringgröße in Bytes
+        uint64_t head;                  // Absolute Position des ältesten Records
+        uint64_t tail;                  // Absolute Schreibposition
+        uint64_t records;
+        uint64_t evicted;               // Wegen vollem Ring verworfen (gesamt)
+    };
+
+#pragma pack(push, 1)
+    struct RecordHeader {
+        BinaryPayloadHeader payload;
+        uint32_t variable_id;
+        uint32_t topic_hash;
+        uint64_t timestamp;
+    };
+#pragma pack(pop)
+
+    bool read_record(uint64_t position, Record& record, void* data, size_t capacity) const {
+        RecordHeader stored;
+        read_wrapped(&stored, sizeof(stored), position);
+        record.sequence = stored.payload.sequence_number;
+        record.variable_id = stored.variable_id;
+        record.topic_hash = stored.topic_hash;
+        record.timestamp = stored.timestamp;
+        record.logged_us = stored.payload.timestamp_us;
+        record.length = stored.payload.total_size - static_cast<uint32_t>(sizeof(RecordHeader));
+        if (record.length > capacity) {
+            return false;
+        }
+        read_wrapped(data, record.length, position + sizeof(stored));
+        return true;
+    }
+
+    // Records von head bis tail prüfen, nach dem ersten ungültigen abschneiden
+    void recover() {
+        uint64_t position = header_->head;
+        uint64_t records = 0;
+        while (position < header_->tail) {
+            RecordHeader stored;
+            if (header_->tail - position < sizeof(stored)) break;
+            read_wrapped(&stored, sizeof(stored), position);
+            if (stored.payload.version != 1 || stored.payload.total_size < sizeof(stored) ||
+                stored.payload.total_size > header_->tail - position) {
+                break;
+            }
+            position += stored.payload.total_size;
+            records++;
+        }
+        header_->tail = position;
+        header_->records = records;
+    }
+
+    void write_wrapped(const void* data, size_t length, uint64_t position) {
+        size_t offset = static_cast<size_t>(position % capacity_);
+        const uint8_t* source = static_cast<const uint8_t*>(data);
+        size_t first = std::min(length, capacity_ - offset);
+        std::memcpy(ring_ + offset, source, first);
+        std::memcpy(ring_, source + first, length - first);
+    }
+
+    void read_wrapped(void* data, size_t length, uint64_t position) const {
+        size_t offset = static_cast<size_t>(position % capacity_);
+        uint8_t* target = static_cast<uint8_t*>(data);
+        size_t first = std::min(length, capacity_ - offset);
+        std::memcpy(target, ring_ + offset, first);
+        std::memcpy(target + first, ring_, length - first);
+    }
+
+    bool map_file(const std::string& path, size_t size) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER length;
+        length.QuadPart = static_cast<LONGLONG>(size);
+        if (!SetFilePointerEx(file_, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file_)) return false;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (!mapping_) return false;
+        base_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size));
+        return base_ != nullptr;
+#else
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) return false;
+        struct stat info;
+        if (fstat(fd_, &info) != 0) return false;
+        if (static_cast<size_t>(info.st_size) != size && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            return false;
+        }
+        void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapped == MAP_FAILED) return false;
+        base_ = static_cast<uint8_t*>(mapped);
+        capacity_ = size - HEADER_SPACE;   // für munmap() in close() bei späterem Fehler
+        return true;
+#endif
+    }
+
+    static uint64_t now_us() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    uint8_t* base_ = nullptr;
+    FileHeader* header_ = nullptr;
+    uint8_t* ring_ = nullptr;
+    size_t capacity_ = 0;
+    uint64_t read_ = 0;                 // Leseposition fürs Nachsenden (nicht persistiert)
+};
+
+/**
+ * Token Bucket für das Nachsenden aus dem Offline-Log: rate Nachrichten/s
+ * (0 = unbegrenzt), höchstens 100ms Vorrat - nach langer Pause kein Burst
+ */
+class ReplayLimiter {
+public:
+    explicit ReplayLimiter(uint32_t rate = 0) : rate_(rate) {}
+
+    // Nachrichten, die jetzt gesendet werden dürfen (höchstens limit)
+    size_t available(uint64_t now_ns, size_t limit) {
+        if (rate_ == 0) {
+            return limit;
+        }
+        double elapsed_s = last_ns_ == 0 ? 0.0 : static_cast<double>(now_ns - last_ns_) / 1e9;
+        last_ns_ = now_ns;
+        credit_ = std::min(credit_ + elapsed_s * rate_, std::max(rate_ / 10.0, 1.0));
+        return std::min(static_cast<size_t>(credit_), limit);
+    }
+
+    void consume(size_t count) {
+        if (rate_ > 0) credit_ -= static_cast<double>(count);
+    }
+
+private:
+    uint32_t rate_ = 0;
+    double credit_ = 0.0;
+    uint64_t last_ns_ = 0;
+};
+
+} // namespace ads_realtime
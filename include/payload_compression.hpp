@@ -4,79 +4,71 @@
 #include <cstdint>
 #include <cstring>
 #include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include "lz_compressor.hpp"
+#include "rle_kernels.hpp"
 
 namespace ads_realtime {
 
 // Einfache, schnelle Run-Length Encoding (RLE) Kompression
 // Optimal für repetitive Daten (z.B. viele gleiche Werte)
 // Sehr schnell (<1µs für kleine Payloads), moderate Compression Ratio
+//
+// Format: Run [0xFF][count 3..255][value], Literal 0xFF als [0xFF][0x00],
+// alle anderen Bytes unverändert. Encoder sucht Runs und Escape-Bytes per
+// SIMD (RleKernel, AVX2/SSE2 zur Laufzeit gewählt) und kopiert die Literale
+// dazwischen am Stück; Decoder springt per memchr von Marker zu Marker und
+// füllt Runs per memset.
 class SimpleCompressor {
 public:
     // Komprimiert Daten mit RLE
     static std::vector<uint8_t> compress(const uint8_t* data, size_t len) {
-        std::vector<uint8_t> compressed;
-        compressed.reserve(len); // Worst case: keine Kompression
+        return compress(data, len, RleKernel::select());
+    }
+    
+    // Mit explizitem Kernel (Benchmark, Vergleich mit dem Skalar-Pfad)
+    static std::vector<uint8_t> compress(const uint8_t* data, size_t len, const RleKernel& kernel) {
+        std::vector<uint8_t> compressed(len * 2); // Worst case: nur Literal 0xFF
+        uint8_t* out = compressed.data();
         
         size_t i = 0;
         while (i < len) {
-            uint8_t current = data[i];
-            size_t run_length = 1;
-            
-            // Zähle aufeinanderfolgende gleiche Bytes
-            while (i + run_length < len && data[i + run_length] == current && run_length < 255) {
-                run_length++;
+            // Literale bis zum nächsten Run bzw. 0xFF direkt kopieren
+            size_t literals = kernel.find_special(data + i, len - i);
+            if (literals > 0) {
+                std::memcpy(out, data + i, literals);
+                out += literals;
+                i += literals;
+                if (i >= len) break;
             }
             
+            uint8_t current = data[i];
+            size_t run_length = kernel.run_length(data + i, std::min(len - i, size_t(255)));
+            
             if (run_length >= 3) {
                 // RLE: [0xFF][count][value]
-                compressed.push_back(0xFF); // Escape marker
-                compressed.push_back(static_cast<uint8_t>(run_length));
-                compressed.push_back(current);
+                *out++ = 0xFF; // Escape marker
+                *out++ = static_cast<uint8_t>(run_length);
+                *out++ = current;
                 i += run_length;
             } else {
-                // Literal: schreibe direkt (escape 0xFF)
-                if (current == 0xFF) {
-                    compressed.push_back(0xFF);
-                    compressed.push_back(0x00); // 0xFF 0x00 = literal 0xFF
-                } else {
-                    compressed.push_back(current);
-                }
+                // Literal 0xFF
+                *out++ = 0xFF;
+                *out++ = 0x00; // 0xFF 0x00 = literal 0xFF
                 i++;
             }
         }
         
+        compressed.resize(out - compressed.data());
         return compressed;
     }
     
     // Dekomprimiert RLE Daten
     static std::vector<uint8_t> decompress(const uint8_t* data, size_t len) {
-        std::vector<uint8_t> decompressed;
-        decompressed.reserve(len * 2); // Schätzung
-        
-        size_t i = 0;
-        while (i < len) {
-            if (data[i] == 0xFF) {
-                if (i + 1 < len && data[i + 1] == 0x00) {
-                    // Literal 0xFF
-                    decompressed.push_back(0xFF);
-                    i += 2;
-                } else if (i + 2 < len) {
-                    // RLE: [0xFF][count][value]
-                    uint8_t count = data[i + 1];
-                    uint8_t value = data[i + 2];
-                    for (int j = 0; j < count; j++) {
-                        decompressed.push_back(value);
-                    }
-                    i += 3;
-                } else {
-                    i++;
-                }
-            } else {
-                decompressed.push_back(data[i]);
-                i++;
-            }
-        }
-        
+        // Erst Größe bestimmen, dann ohne push_back füllen
+        std::vector<uint8_t> decompressed(expand(data, len, nullptr));
+        expand(data, len, decompressed.data());
         return decompressed;
     }
     
@@ -93,13 +85,45 @@ public:
         // Wenn >20% repetitiv, lohnt sich Kompression
         return (repetitions * 100 / std::min(len, size_t(100))) > 20;
     }
+    
+private:
+    // Dekodiert nach out (nullptr: nur zählen), Rückgabe Originalgröße.
+    // Unvollständiger Marker am Ende: 0xFF wird übersprungen, wie bisher.
+    static size_t expand(const uint8_t* data, size_t len, uint8_t* out) {
+        size_t size = 0;
+        size_t i = 0;
+        while (i < len) {
+            const void* marker = std::memchr(data + i, 0xFF, len - i);
+            size_t literals = marker ? static_cast<const uint8_t*>(marker) - (data + i) : len - i;
+            if (out) std::memcpy(out + size, data + i, literals);
+            size += literals;
+            i += literals;
+            if (i >= len) break;
+            
+            if (i + 1 < len && data[i + 1] == 0x00) {
+                // Literal 0xFF
+                if (out) out[size] = 0xFF;
+                size++;
+                i += 2;
+            } else if (i + 2 < len) {
+                // RLE: [0xFF][count][value]
+                if (out) std::memset(out + size, data[i + 2], data[i + 1]);
+                size += data[i + 1];
+                i += 3;
+            } else {
+                i++;
+            }
+        }
+        return size;
+    }
 };
 
 // Dictionary-based Kompression (LZ77-Style)
-// Bessere Compression Ratio als RLE, etwas langsamer
+// Legacy: O(n * Fenster) Suche, nur noch für explizite Aufrufe und alte Payloads -
+// compress_auto verwendet LzCompressor
 class DictionaryCompressor {
 private:
-    static constexpr size_t WINDOW_SIZE = 4096;
+    static constexpr size_t WINDOW_SIZE = 4095;     // Offset hat 12 Bit
     static constexpr size_t MIN_MATCH = 3;
     static constexpr size_t MAX_MATCH = 18;
     
@@ -144,9 +168,15 @@ public:
                 compressed.push_back(offset & 0xFF);
                 compressed.push_back((match_len - MIN_MATCH) & 0x0F);
                 pos += match_len;
+            } else if (data[pos] & 0x80) {
+                // Literal >= 0x80: Match mit Offset 0 als Escape [0x80][0x00][value]
+                compressed.push_back(0x80);
+                compressed.push_back(0x00);
+                compressed.push_back(data[pos]);
+                pos++;
             } else {
                 // Literal: [0][value]
-                compressed.push_back(data[pos] & 0x7F);
+                compressed.push_back(data[pos]);
                 pos++;
             }
         }
@@ -163,16 +193,22 @@ public:
         while (i < len) {
             if (data[i] & 0x80) {
                 // Match: [1][offset:12bit][length:4bit]
-                if (i + 2 < len) {
-                    uint16_t offset = ((data[i] & 0x0F) << 8) | data[i + 1];
-                    uint8_t match_len = (data[i + 2] & 0x0F) + MIN_MATCH;
-                    
-                    size_t copy_pos = decompressed.size() - offset;
-                    for (int j = 0; j < match_len; j++) {
-                        decompressed.push_back(decompressed[copy_pos + j]);
-                    }
+                if (i + 2 >= len) break;
+                uint16_t offset = ((data[i] & 0x0F) << 8) | data[i + 1];
+                if (offset == 0) {
+                    // Escape: Literal >= 0x80
+                    decompressed.push_back(data[i + 2]);
                     i += 3;
+                    continue;
+                }
+                if (offset > decompressed.size()) return {};   // Beschädigt
+                
+                uint8_t match_len = (data[i + 2] & 0x0F) + MIN_MATCH;
+                size_t copy_pos = decompressed.size() - offset;
+                for (int j = 0; j < match_len; j++) {
+                    decompressed.push_back(decompressed[copy_pos + j]);
                 }
+                i += 3;
             } else {
                 // Literal
                 decompressed.push_back(data[i]);
@@ -190,9 +226,24 @@ public:
     enum class Method : uint8_t {
         None = 0,
         RLE = 1,
-        Dictionary = 2
+        Dictionary = 2,
+        LZ = 3,         // LzCompressor Block (LZ4 Format mit Größen-Präfix)
+        Gorilla = 4,    // GorillaEncoder Frame (zustandsbehaftet, nur per GorillaDecoder lesbar)
+        Stream = 5      // CompressionSession Frame (zustandsbehaftet, nur per DecompressionSession lesbar)
     };
     
+    static const char* method_name(Method method) {
+        switch (method) {
+            case Method::None:       return "None";
+            case Method::RLE:        return "RLE";
+            case Method::Dictionary: return "Dictionary";
+            case Method::LZ:         return "LZ";
+            case Method::Gorilla:    return "Gorilla";
+            case Method::Stream:     return "Stream";
+            default:                 return "?";
+        }
+    }
+    
     // Komprimiert automatisch mit bester Methode
     static std::pair<std::vector<uint8_t>, Method> compress_auto(
         const uint8_t* data, size_t len) {
@@ -202,15 +253,15 @@ public:
             return {std::vector<uint8_t>(data, data + len), Method::None};
         }
         
-        // Teste beide Methoden
+        // Teste beide Methoden (beide O(n))
         auto rle = SimpleCompressor::compress(data, len);
-        auto dict = DictionaryCompressor::compress(data, len);
+        auto lz = LzCompressor::compress(data, len);
         
         // Wähle kleinere
-        if (rle.size() < dict.size() && rle.size() < len * 0.9) {
+        if (rle.size() < lz.size() && rle.size() < len * 0.9) {
             return {rle, Method::RLE};
-        } else if (dict.size() < len * 0.9) {
-            return {dict, Method::Dictionary};
+        } else if (!lz.empty() && lz.size() < len * 0.9) {
+            return {lz, Method::LZ};
         } else {
             return {std::vector<uint8_t>(data, data + len), Method::None};
         }
@@ -225,6 +276,12 @@ public:
                 return SimpleCompressor::decompress(data, len);
             case Method::Dictionary:
                 return DictionaryCompressor::decompress(data, len);
+            case Method::LZ:
+                return LzCompressor::decompress(data, len);
+            case Method::Gorilla:
+                return {};      // Braucht den Zustand vorheriger Frames: GorillaDecoder
+            case Method::Stream:
+                return {};      // Braucht die Historie vorheriger Frames: DecompressionSession
             case Method::None:
             default:
                 return std::vector<uint8_t>(data, data + len);
@@ -240,22 +297,140 @@ public:
         Method method;
     };
     
-    static CompressionStats benchmark(const uint8_t* data, size_t len) {
-        auto start = std::chrono::high_resolution_clock::now();
-        auto [compressed, method] = compress_auto(data, len);
-        auto end = std::chrono::high_resolution_clock::now();
+    // Mittelt über repetitions Aufrufe von compress_auto (ns-Auflösung, Ergebnis in µs pro Aufruf)
+    static CompressionStats benchmark(const uint8_t* data, size_t len, size_t repetitions = 1) {
+        if (repetitions == 0) repetitions = 1;
+        std::pair<std::vector<uint8_t>, Method> result;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repetitions; i++) {
+            result = compress_auto(data, len);
+        }
+        auto end = std::chrono::steady_clock::now();
         
-        auto duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
-            end - start).count();
+        double duration_us = std::chrono::duration<double, std::micro>(end - start).count() / repetitions;
         
         return {
             len,
-            compressed.size(),
-            len > 0 ? static_cast<double>(len) / compressed.size() : 1.0,
-            static_cast<double>(duration_us),
-            method
+            result.first.size(),
+            len > 0 ? static_cast<double>(len) / result.first.size() : 1.0,
+            duration_us,
+            result.second
         };
     }
 };
 
+// Adaptive Methodenwahl pro Variable (bzw. Stream-Key)
+//
+// compress_auto() komprimiert jedes Payload mit allen Kandidaten. Der
+// Charakter der Daten einer Variable ändert sich aber selten: hier werden
+// alle Kandidaten (RLE, LZ) nur beim ersten und danach bei jedem
+// probe_interval-ten Payload eines Keys getestet. Pro Methode läuft ein
+// gleitender Mittelwert der Ratio (komprimiert / original); dazwischen wird
+// nur mit der besten Methode komprimiert und deren Mittelwert nachgeführt.
+// Lohnt keine Methode (Mittel >= min_ratio), bleibt das Payload bis zur
+// nächsten Probe unkomprimiert - ohne Rechenzeit. Ergebnis wie compress_auto,
+// Dekompression über PayloadCompressor::decompress().
+//
+// Nicht thread-safe; eine Instanz pro Publisher-Thread.
+class AdaptiveCompressor {
+public:
+    using Method = PayloadCompressor::Method;
+
+    struct Options {
+        uint32_t probe_interval = 64;   // alle Kandidaten erneut testen
+        double min_ratio = 0.9;         // darüber lohnt Kompression nicht
+        double smoothing = 0.25;        // Gewicht einer neuen Messung im Mittelwert
+    };
+
+    AdaptiveCompressor() : AdaptiveCompressor(Options()) {}
+    explicit AdaptiveCompressor(Options options) : options_(options) {
+        if (options_.probe_interval == 0) options_.probe_interval = 1;
+    }
+
+    std::pair<std::vector<uint8_t>, Method> compress(uint32_t key, const uint8_t* data, size_t len) {
+        if (len < 64) {
+            return {std::vector<uint8_t>(data, data + len), Method::None};
+        }
+        payloads_++;
+        Stats& stats = stats_[key];
+
+        if (stats.payloads++ % options_.probe_interval == 0) {
+            probes_++;
+            std::vector<uint8_t> best;
+            Method best_method = Method::None;
+            for (size_t c = 0; c < CANDIDATES; c++) {
+                std::vector<uint8_t> compressed = run(CANDIDATE_METHODS[c], data, len);
+                update(stats, c, compressed, len, stats.payloads == 1);
+                if (!compressed.empty() && (best_method == Method::None || compressed.size() < best.size())) {
+                    best = std::move(compressed);
+                    best_method = CANDIDATE_METHODS[c];
+                }
+            }
+            select(stats);
+            if (best_method != Method::None && best.size() < len * options_.min_ratio) {
+                return {std::move(best), best_method};
+            }
+            return {std::vector<uint8_t>(data, data + len), Method::None};
+        }
+
+        if (stats.method == Method::None) {
+            return {std::vector<uint8_t>(data, data + len), Method::None};
+        }
+        size_t c = candidate(stats.method);
+        std::vector<uint8_t> compressed = run(stats.method, data, len);
+        update(stats, c, compressed, len, false);
+        Method method = stats.method;
+        select(stats);
+        if (compressed.empty() || compressed.size() >= len * options_.min_ratio) {
+            return {std::vector<uint8_t>(data, data + len), Method::None};
+        }
+        return {std::move(compressed), method};
+    }
+
+    // Aktuell gewählte Methode eines Keys (None: unbekannt oder lohnt nicht)
+    Method selected(uint32_t key) const {
+        auto it = stats_.find(key);
+        return it != stats_.end() ? it->second.method : Method::None;
+    }
+
+    uint64_t payloads() const { return payloads_; }
+    uint64_t probes() const { return probes_; }      // Payloads mit allen Kandidaten
+
+private:
+    static constexpr size_t CANDIDATES = 2;
+    static constexpr Method CANDIDATE_METHODS[CANDIDATES] = {Method::RLE, Method::LZ};
+
+    struct Stats {
+        double ratio[CANDIDATES] = {};
+        uint64_t payloads = 0;
+        Method method = Method::None;
+    };
+
+    static std::vector<uint8_t> run(Method method, const uint8_t* data, size_t len) {
+        return method == Method::RLE ? SimpleCompressor::compress(data, len) : LzCompressor::compress(data, len);
+    }
+
+    static size_t candidate(Method method) {
+        return method == Method::RLE ? 0 : 1;
+    }
+
+    void update(Stats& stats, size_t c, const std::vector<uint8_t>& compressed, size_t len, bool first) {
+        double ratio = compressed.empty() ? 1.0 : static_cast<double>(compressed.size()) / len;
+        stats.ratio[c] = first ? ratio : stats.ratio[c] + options_.smoothing * (ratio - stats.ratio[c]);
+    }
+
+    void select(Stats& stats) {
+        size_t best = 0;
+        for (size_t c = 1; c < CANDIDATES; c++) {
+            if (stats.ratio[c] < stats.ratio[best]) best = c;
+        }
+        stats.method = stats.ratio[best] < options_.min_ratio ? CANDIDATE_METHODS[best] : Method::None;
+    }
+
+    Options options_;
+    std::unordered_map<uint32_t, Stats> stats_;
+    uint64_t payloads_ = 0;
+    uint64_t probes_ = 0;
+};
+
 } // namespace ads_realtime
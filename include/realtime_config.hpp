@@ -2,9 +2,39 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace ads_realtime {
 
+/**
+ * Erfassungsart der PLC-Werte
+ */
+enum class AcquisitionMode : uint8_t {
+    Notification = 0,   // Eine ADS Device Notification pro Symbol
+    SumUpPolling = 1    // Zyklisches Sum-Up Read (0xF080), nur Änderungen weiterreichen
+};
+
+/**
+ * Change-of-Value / Totzonen-Filter (pro Variable, siehe ValueFilter)
+ * Alle Werte 0/false = jedes Sample wird weitergereicht.
+ */
+struct FilterConfig {
+    bool on_change = false;          // Nur bei Änderung (Bit-Vergleich)
+    double deadband_abs = 0.0;       // Analoge Typen: absolute Totzone
+    double deadband_percent = 0.0;   // Analoge Typen: Totzone in % vom letzten Wert
+    uint32_t min_interval_ms = 0;    // Höchstens ein Sample pro Intervall
+    uint32_t max_interval_ms = 0;    // Heartbeat: spätestens nach Intervall auch ohne Änderung
+};
+
+/**
+ * Publish-Pfad zum MQTT Broker
+ */
+enum class MqttPublishMode : uint8_t {
+    Paho = 0,        // mqtt::async_client, ein publish() pro Nachricht
+    Native = 1,      // MqttClient: Queue + Flush Thread, ein writev() pro Batch (Zero-Copy)
+    Embedded = 2     // MqttBroker im Prozess (Linux): Samples direkt in den Subscription Fan-out
+};
+
 /**
  * Hard Real-Time Configuration
  * Garantierte Latenz: <1ms
@@ -13,25 +43,93 @@ struct RealtimeConfig {
     // ADS Configuration
     std::string ads_target_ip = "192.168.3.42";
     uint16_t ads_port = 851;
+    uint16_t ams_tcp_port = 48898;         // nur AMS/TCP (Router-Port der PLC)
+    std::string ads_target_netid;          // leer = Windows: lokaler Router, sonst <ip>.1.1
+    std::string ads_local_netid;           // nur AMS/TCP: leer = <lokale IP>.1.1 (Route auf der PLC nötig)
     
     // Real-Time Settings
     uint32_t notification_cycle_us = 100;  // 100µs = 0.1ms (10kHz)
     uint32_t max_latency_us = 1000;        // <1ms hard deadline
     
+    // Sum-Up Polling (für große Symbolmengen statt tausender Notification Handles)
+    AcquisitionMode acquisition_mode = AcquisitionMode::Notification;
+    uint32_t sumup_batch_size = 500;       // Symbole pro Sum-Up Request (ADS Limit: 500)
+    uint32_t poll_cycle_us = 10000;        // Polling-Zyklus (10ms)
+    
+    // Standard-Filter für add_variable()/add_variables() ohne eigenen FilterConfig
+    // (Sum-Up Polling filtert immer mindestens auf Änderung)
+    FilterConfig filter;
+    
+    // Notification Hand-off (ADS Router Thread -> Dispatcher Thread)
+    uint32_t notification_queue_capacity = 65536;  // Slots (auf Zweierpotenz gerundet)
+    uint32_t max_variables = 65536;                // Größe der Variable-ID Tabelle (max. 2^24)
+    
     // MQTT Settings
     std::string mqtt_broker = "localhost";
     uint16_t mqtt_port = 1883;
-    uint8_t mqtt_qos = 0;  // QoS 0 für minimale Latenz
+    uint8_t mqtt_qos = 0;  // QoS 0 für minimale Latenz (0 oder 1)
+    uint16_t mqtt_keepalive_s = 60;                // 0 = kein Keepalive
+    uint8_t mqtt_protocol_version = 4;             // Native: 4 = MQTT 3.1.1, 5 = MQTT 5.0 (Paho: immer 3.1.1)
+    uint32_t mqtt_max_inflight = 1024;             // Native QoS 1: unbestätigte PUBLISH (max. 32768)
+    bool mqtt_topic_alias = true;                  // Native MQTT 5: Topic Alias pro Variable (falls Broker erlaubt)
+    std::string mqtt_topic_prefix = "ads";         // Topic = <prefix>/<Variablenname>
+    uint32_t message_pool_size = 4096;             // Vorallokierte Publish-Puffer
+    std::string mqtt_client_id = "ADS-Realtime-Bridge";
+    MqttPublishMode mqtt_publish_mode = MqttPublishMode::Paho;
+    uint32_t mqtt_flush_interval_us = 200;         // Native: max. Wartezeit zum Sammeln
+    uint32_t mqtt_flush_bytes = 64 * 1024;         // Native: sofort senden ab dieser Batch-Größe
+    uint32_t mqtt_connections = 0;                 // Broker-Verbindungen (Shards), 0 = worker_threads
+    uint32_t mqtt_first_cpu = 2;                   // Native + pin_to_cores: Shard i auf CPU first_cpu + i
+    std::string mqtt_listen_address = "0.0.0.0";   // Embedded: Listen-Adresse (Port = mqtt_port)
+    bool mqtt_retain = true;                       // Embedded: letzten Wert pro Variable als Retained halten
+    uint32_t mqtt_broker_max_clients = 1024;       // Embedded: gleichzeitige Verbindungen
+    uint32_t mqtt_broker_max_pending = 4 * 1024 * 1024;  // Embedded: Sendepuffer pro Subscriber (Bytes)
+    std::string mqtt_offline_dir = "";             // Offline-Log Verzeichnis (leer = aus), Datei <client_id>.olog
+    uint32_t mqtt_offline_max_mb = 64;             // Ringgröße pro Verbindung, älteste Samples werden verworfen
+    uint32_t mqtt_offline_replay_rate = 5000;      // Nachsenden nach Reconnect: Nachrichten/s (0 = unbegrenzt)
     
     // Performance Monitoring
     bool enable_latency_tracking = true;
     bool enable_deadline_monitoring = true;
     uint32_t stats_interval_ms = 1000;
+    std::vector<uint32_t> latency_buckets_us = {10, 50, 100, 250, 500, 750, 1000, 2000, 5000};
     
     // Threading
-    uint32_t worker_threads = 4;
+    uint32_t worker_threads = 4;  // MQTT Publish-Shards (Verbindung + Queue + Flush Thread)
     bool pin_to_cores = true;  // CPU affinity für deterministische Performance
     int8_t priority_boost = 2;  // Thread priority (Windows: THREAD_PRIORITY_HIGHEST)
+    int rt_priority = 80;       // Linux: SCHED_FIFO Priorität (1-99) für IO/Poll Thread
+};
+
+/**
+ * MQTT Publisher Statistics
+ */
+struct PublisherStats {
+    uint64_t published = 0;             // An Socket bzw. Paho übergeben
+    uint64_t queue_depth = 0;           // Native: wartende Nachrichten
+    uint64_t dropped_pool = 0;          // Kein Pool-Puffer frei
+    uint64_t dropped_queue = 0;         // Native: Queue voll
+    uint64_t dropped_disconnected = 0;  // Keine Verbindung zum Broker
+    uint64_t errors = 0;                // Fehlgeschlagene Sends / Paho Exceptions
+    uint64_t flushes = 0;               // Native: Batches (= writev() Aufrufe)
+    uint64_t bytes_sent = 0;
+    uint64_t inflight = 0;              // Native QoS 1: gesendet, noch ohne PUBACK
+    uint64_t acked = 0;                 // Native QoS 1: PUBACK empfangen
+    uint64_t retransmitted = 0;         // Native QoS 1: nach Reconnect mit DUP erneut gesendet
+    uint64_t topic_alias_hits = 0;      // Native MQTT 5: PUBLISH nur mit Topic Alias (ohne Topic)
+    uint64_t broker_clients = 0;        // Embedded: verbundene Clients
+    uint64_t broker_subscriptions = 0;  // Embedded: aktive Subscriptions
+    uint64_t broker_retained = 0;       // Embedded: Topics mit Retained Message
+    uint64_t broker_received = 0;       // Embedded: PUBLISH von Clients
+    uint64_t broker_delivered = 0;      // Embedded: PUBLISH an Subscriber (Fan-out)
+    uint64_t broker_dropped_slow = 0;   // Embedded: Sendepuffer/QoS 1 Fenster eines Subscribers voll
+    uint64_t offline_buffered = 0;      // Offline-Log: Samples auf Platte, noch nicht nachgesendet
+    uint64_t offline_logged = 0;        // Offline-Log: während Ausfällen aufgenommen
+    uint64_t offline_replayed = 0;      // Offline-Log: nach Reconnect nachgesendet
+    uint64_t offline_evicted = 0;       // Offline-Log: Ring voll, älteste verworfen
+    double flush_latency_p50_us = 0.0;  // Native: Enqueue der ältesten Nachricht bis writev() fertig (Embedded: Fan-out)
+    double flush_latency_p99_us = 0.0;
+    double flush_latency_max_us = 0.0;
 };
 
 /**
@@ -46,7 +144,19 @@ struct PerformanceStats {
     double p50_latency_us = 0.0;
     double p95_latency_us = 0.0;
     double p99_latency_us = 0.0;
+    double p999_latency_us = 0.0;
     uint32_t throughput_hz = 0;
+    uint64_t queue_drops = 0;      // Verworfene Samples (Queue voll / Sample zu groß)
+    uint64_t queue_depth = 0;      // Aktuelle Queue-Füllung
+    uint64_t poll_cycles = 0;      // Sum-Up Polling: abgeschlossene Zyklen
+    uint64_t poll_overruns = 0;    // Sum-Up Polling: Zyklen länger als poll_cycle_us
+    uint64_t filtered_samples = 0; // Vom Change-of-Value / Totzonen-Filter verworfen
+    bool ads_connected = false;    // false = Verbindung zur PLC verloren (siehe is_connected())
+    
+    // Histogramm nach latency_buckets_us: counts[i] = Samples in (bounds[i-1], bounds[i]]
+    // Letzter Eintrag = Overflow (> größte Grenze)
+    std::vector<uint32_t> latency_bucket_bounds_us;
+    std::vector<uint64_t> latency_bucket_counts;
 };
 
 } // namespace ads_realtime
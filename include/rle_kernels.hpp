@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ADS_RLE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 Kernel auch ohne -march=native/-mavx2 übersetzen (Auswahl erst zur Laufzeit)
+#if defined(ADS_RLE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ADS_RLE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ADS_RLE_TARGET_AVX2
+#endif
+
+namespace ads_realtime {
+
+/**
+ * Such-Kernel für SimpleCompressor (RLE)
+ *
+ * find_special() liefert die erste Position, an der der Encoder nicht
+ * einfach kopieren kann: Beginn eines Runs (3 gleiche Bytes) oder Escape-Byte
+ * 0xFF. run_length() zählt gleiche Bytes ab p[0]. Beides vergleicht 16 (SSE2)
+ * bzw. 32 Bytes (AVX2) pro Schritt per Compare + Movemask; die Literale
+ * dazwischen kopiert der Encoder am Stück.
+ *
+ * select() wählt einmalig zur Laufzeit (CPUID), ob AVX2 verfügbar ist - die
+ * Binaries laufen so auch auf Zielen ohne AVX2. SSE2 ist auf x86-64 immer
+ * vorhanden, andere Architekturen nutzen den Skalar-Kernel.
+ */
+struct RleKernel {
+    const char* name;
+    size_t (*find_special)(const uint8_t* p, size_t len);   // len wenn nichts gefunden
+    size_t (*run_length)(const uint8_t* p, size_t limit);   // 1..limit (limit >= 1)
+
+    static const RleKernel& scalar() {
+        static const RleKernel kernel{"scalar", &scalar_find_special, &scalar_run_length};
+        return kernel;
+    }
+
+    // nullptr wenn die CPU den Kernel nicht unterstützt
+    static const RleKernel* sse2() {
+#ifdef ADS_RLE_X86
+        static const RleKernel kernel{"sse2", &sse2_find_special, &sse2_run_length};
+        return &kernel;
+#else
+        return nullptr;
+#endif
+    }
+
+    static const RleKernel* avx2() {
+#ifdef ADS_RLE_X86
+        static const RleKernel kernel{"avx2", &avx2_find_special, &avx2_run_length};
+        static const bool supported = cpu_has_avx2();
+        return supported ? &kernel : nullptr;
+#else
+        return nullptr;
+#endif
+    }
+
+    // Schnellster verfügbarer Kernel
+    static const RleKernel& select() {
+        static const RleKernel& kernel = avx2() ? *avx2() : sse2() ? *sse2() : scalar();
+        return kernel;
+    }
+
+private:
+    static size_t scalar_find_special(const uint8_t* p, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (p[i] == 0xFF) return i;
+            if (i + 2 < len && p[i] == p[i + 1] && p[i] == p[i + 2]) return i;
+        }
+        return len;
+    }
+
+    static size_t scalar_run_length(const uint8_t* p, size_t limit) {
+        size_t n = 1;
+        while (n < limit && p[n] == p[0]) n++;
+        return n;
+    }
+
+#ifdef ADS_RLE_X86
+    static unsigned trailing_zeros(uint32_t mask) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+    }
+
+    static bool cpu_has_avx2() {
+#ifdef __AVX2__
+        return true;                    // mit -march=native/-mavx2 bzw. /arch:AVX2 übersetzt
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;   // OS sichert YMM
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+
+    static size_t sse2_find_special(const uint8_t* p, size_t len) {
+        const __m128i escape = _mm_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for (; i + 2 + 16 <= len; i += 16) {
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+            __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 2));
+            __m128i run = _mm_and_si128(_mm_cmpeq_epi8(v0, v1), _mm_cmpeq_epi8(v1, v2));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(run, _mm_cmpeq_epi8(v0, escape))));
+            if (mask) return i + trailing_zeros(mask);
+        }
+        return i + scalar_find_special(p + i, len - i);
+    }
+
+    static size_t sse2_run_length(const uint8_t* p, size_t limit) {
+        const __m128i value = _mm_set1_epi8(static_cast<char>(p[0]));
+        size_t n = 1;
+        for (; n + 16 <= limit; n += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, value))) ^ 0xFFFFu;
+            if (mask) return n + trailing_zeros(mask);
+        }
+        return n - 1 + scalar_run_length(p + n - 1, limit - n + 1);
+    }
+
+    ADS_RLE_TARGET_AVX2 static size_t avx2_find_special(const uint8_t* p, size_t len) {
+        const __m256i escape = _mm256_set1_epi8(static_cast<char>(0xFF));
+        size_t i = 0;
+        for (; i + 2 + 32 <= len; i += 32) {
+            __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 1));
+            __m256i v2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 2));
+            __m256i run = _mm256_and_si256(_mm256_cmpeq_epi8(v0, v1), _mm256_cmpeq_epi8(v1, v2));
+            uint32_t mask = static_cast<uint32_t>(
+                _mm256_movemask_epi8(_mm256_or_si256(run, _mm256_cmpeq_epi8(v0, escape))));
+            if (mask) return i + trailing_zeros(mask);
+        }
+        return i + sse2_find_special(p + i, len - i);
+    }
+
+    ADS_RLE_TARGET_AVX2 static size_t avx2_run_length(const uint8_t* p, size_t limit) {
+        const __m256i value = _mm256_set1_epi8(static_cast<char>(p[0]));
+        size_t n = 1;
+        for (; n + 32 <= limit; n += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n));
+            uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, value)));
+            if (mask) return n + trailing_zeros(mask);
+        }
+        return n - 1 + sse2_run_length(p + n - 1, limit - n + 1);
+    }
+#endif
+};
+
+} // namespace ads_realtime
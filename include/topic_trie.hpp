@@ -0,0 +1,337 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ads_realtime {
+
+/**
+ * Topic-Hilfsfunktionen (MQTT 3.1.1 Kapitel 4.7)
+ *
+ * Topic-Namen: keine Wildcards, nicht leer. Filter: '+' ersetzt genau eine
+ * Ebene, '#' den Rest (nur als letzte Ebene). Topics mit '$' am Anfang
+ * ($SYS/...) passen nicht auf Filter, die mit einer Wildcard beginnen.
+ */
+namespace topic {
+
+inline bool valid_name(std::string_view name) {
+    return !name.empty() && name.size() <= 65535 &&
+           name.find_first_of("+#") == std::string_view::npos &&
+           name.find('\0') == std::string_view::npos;
+}
+
+inline bool valid_filter(std::string_view filter) {
+    if (filter.empty() || filter.size() > 65535 || filter.find('\0') != std::string_view::npos) {
+        return false;
+    }
+    size_t start = 0;
+    for (;;) {
+        size_t end = filter.find('/', start);
+        std::string_view level = filter.substr(start, end == std::string_view::npos ? std::string_view::npos
+                                                                                      : end - start);
+        if (level.find_first_of("+#") != std::string_view::npos && level.size() != 1) return false;
+        if (level == "#" && end != std::string_view::npos) return false;   // '#' nur am Ende
+        if (end == std::string_view::npos) return true;
+        start = end + 1;
+    }
+}
+
+// Ebenen ohne Allokation zerlegen (levels wird wiederverwendet)
+inline void split(std::string_view topic, std::vector<std::string_view>& levels) {
+    levels.clear();
+    size_t start = 0;
+    for (;;) {
+        size_t end = topic.find('/', start);
+        if (end == std::string_view::npos) {
+            levels.push_back(topic.substr(start));
+            return;
+        }
+        levels.push_back(topic.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+// Einzelvergleich Filter <-> Topic (Retained Messages bei SUBSCRIBE)
+inline bool matches(std::string_view filter, std::string_view name) {
+    if (!name.empty() && name[0] == '$' && !filter.empty() && (filter[0] == '+' || filter[0] == '#')) {
+        return false;
+    }
+    size_t f = 0;
+    size_t n = 0;
+    for (;;) {
+        size_t f_end = filter.find('/', f);
+        std::string_view f_level = filter.substr(f, f_end == std::string_view::npos ? std::string_view::npos
+                                                                                      : f_end - f);
+        if (f_level == "#") return true;
+
+        size_t n_end = name.find('/', n);
+        std::string_view n_level = name.substr(n, n_end == std::string_view::npos ? std::string_view::npos
+                                                                                    : n_end - n);
+        if (f_level != "+" && f_level != n_level) return false;
+
+        bool f_last = f_end == std::string_view::npos;
+        bool n_last = n_end == std::string_view::npos;
+        if (f_last || n_last) {
+            // "a/#" passt auch auf "a"
+            return f_last == n_last ||
+                   (n_last && filter.substr(f_end + 1) == "#");
+        }
+        f = f_end + 1;
+        n = n_end + 1;
+    }
+}
+
+} // namespace topic
+
+/**
+ * Subscription-Trie als flacher Index
+ *
+ * Knoten liegen in einem zusammenhängenden Array (Index statt Zeiger,
+ * freigegebene Knoten werden wiederverwendet). Ebenen werden interniert:
+ * jeder Ebenen-Name bekommt eine Token-ID, normale Kanten liegen in einer
+ * Hash-Tabelle (Eltern-Knoten, Token) -> Kind. '+' und '#' sind keine
+ * Kanten, sondern direkte Kind-Indizes im Knoten - match() prüft sie ohne
+ * Lookup. Eine Topic-Ebene ohne Token kann nur über Wildcards passen.
+ *
+ * Subscriber = (Key, QoS); ein Key (Session) hat pro Filter höchstens einen
+ * Eintrag. match() läuft ohne Allokation und liefert jeden Key höchstens
+ * einmal mit der höchsten QoS aller passenden Filter (MQTT 3.1.1 Kapitel 3.3.5).
+ *
+ * generation() ändert sich bei jeder Änderung der Subscriptions - Aufrufer
+ * können match() Ergebnisse pro Topic cachen und nur dann neu auflösen.
+ *
+ * Nicht thread-safe - gehört dem Broker Thread.
+ */
+template<typename Key>
+class TopicTrie {
+public:
+    struct Subscriber {
+        Key key;
+        uint8_t qos;
+    };
+
+    TopicTrie() { nodes_.emplace_back(); }   // Knoten 0 = Wurzel
+
+    // true = neu, false = vorhandener Eintrag aktualisiert (QoS)
+    bool subscribe(std::string_view filter, Key key, uint8_t qos) {
+        topic::split(filter, levels_);
+        uint32_t node = ROOT;
+        for (std::string_view level : levels_) {
+            node = child_or_create(node, level);
+        }
+        for (auto& subscriber : nodes_[node].subscribers) {
+            if (subscriber.key == key) {
+                if (subscriber.qos != qos) {
+                    subscriber.qos = qos;
+                    generation_++;
+                }
+                return false;
+            }
+        }
+        nodes_[node].subscribers.push_back(Subscriber{key, qos});
+        size_++;
+        generation_++;
+        return true;
+    }
+
+    bool unsubscribe(std::string_view filter, Key key) {
+        topic::split(filter, levels_);
+        path_.clear();
+        path_.push_back(ROOT);
+        for (std::string_view level : levels_) {
+            uint32_t next = child(path_.back(), level);
+            if (next == NONE) return false;
+            path_.push_back(next);
+        }
+
+        auto& subscribers = nodes_[path_.back()].subscribers;
+        auto it = std::find_if(subscribers.begin(), subscribers.end(),
+                               [&](const Subscriber& s) { return s.key == key; });
+        if (it == subscribers.end()) return false;
+        subscribers.erase(it);
+        size_--;
+        generation_++;
+
+        // Leere Knoten vom Blatt zur Wurzel abbauen
+        for (size_t i = path_.size() - 1; i > 0; i--) {
+            const Node& node = nodes_[path_[i]];
+            if (node.children > 0 || !node.subscribers.empty()) break;
+            release_node(path_[i]);
+        }
+        return true;
+    }
+
+    size_t size() const { return size_; }
+
+    // Startet bei 1 - ein Cache mit Generation 0 ist immer veraltet
+    uint64_t generation() const { return generation_; }
+
+    /**
+     * Alle Subscriber eines Topics (ohne Duplikate, höchste QoS) nach out
+     */
+    void match(std::string_view name, std::vector<Subscriber>& out) {
+        out.clear();
+        topic::split(name, levels_);
+        tokens_.resize(levels_.size());
+        for (size_t i = 0; i < levels_.size(); i++) {
+            auto it = token_ids_.find(levels_[i]);
+            tokens_[i] = it == token_ids_.end() ? NONE : it->second;
+        }
+        collect(ROOT, 0, !name.empty() && name[0] == '$', out);
+        if (out.size() > 1) {
+            std::sort(out.begin(), out.end(), [](const Subscriber& a, const Subscriber& b) {
+                return std::less<Key>()(a.key, b.key);
+            });
+            size_t unique = 0;
+            for (size_t i = 0; i < out.size(); i++) {
+                if (unique > 0 && out[unique - 1].key == out[i].key) {
+                    out[unique - 1].qos = std::max(out[unique - 1].qos, out[i].qos);
+                } else {
+                    out[unique++] = out[i];
+                }
+            }
+            out.resize(unique);
+        }
+    }
+
+private:
+    static constexpr uint32_t ROOT = 0;
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+    static constexpr uint32_t PLUS = 0xFFFFFFFE;   // Token der Kanten '+' / '#'
+    static constexpr uint32_t HASH = 0xFFFFFFFD;
+
+    struct Node {
+        uint32_t parent = NONE;
+        uint32_t token = NONE;       // Kante vom Eltern-Knoten
+        uint32_t plus = NONE;        // Kind '+'
+        uint32_t hash = NONE;        // Kind '#'
+        uint32_t children = 0;       // Anzahl Kinder inkl. Wildcards
+        std::vector<Subscriber> subscribers;
+    };
+
+    static uint64_t edge(uint32_t parent, uint32_t token) {
+        return (static_cast<uint64_t>(parent) << 32) | token;
+    }
+
+    uint32_t child(uint32_t node, std::string_view level) const {
+        if (level == "+") return nodes_[node].plus;
+        if (level == "#") return nodes_[node].hash;
+        auto token = token_ids_.find(level);
+        if (token == token_ids_.end()) return NONE;
+        auto it = edges_.find(edge(node, token->second));
+        return it == edges_.end() ? NONE : it->second;
+    }
+
+    uint32_t child_or_create(uint32_t node, std::string_view level) {
+        uint32_t existing = child(node, level);
+        if (existing != NONE) return existing;
+
+        uint32_t token = level == "+" ? PLUS : level == "#" ? HASH : intern(level);
+        uint32_t index;
+        if (!free_nodes_.empty()) {
+            index = free_nodes_.back();
+            free_nodes_.pop_back();
+        } else {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+        nodes_[index].parent = node;
+        nodes_[index].token = token;
+
+        if (token == PLUS) nodes_[node].plus = index;
+        else if (token == HASH) nodes_[node].hash = index;
+        else edges_.emplace(edge(node, token), index);
+        nodes_[node].children++;
+        return index;
+    }
+
+    void release_node(uint32_t index) {
+        Node& node = nodes_[index];
+        Node& parent = nodes_[node.parent];
+        if (node.token == PLUS) parent.plus = NONE;
+        else if (node.token == HASH) parent.hash = NONE;
+        else {
+            edges_.erase(edge(node.parent, node.token));
+            release_token(node.token);
+        }
+        parent.children--;
+        node.parent = node.token = NONE;
+        free_nodes_.push_back(index);
+    }
+
+    // Token-ID pro Ebenen-Name, Referenz pro Kante
+    uint32_t intern(std::string_view level) {
+        auto it = token_ids_.find(level);
+        if (it != token_ids_.end()) {
+            token_refs_[it->second]++;
+            return it->second;
+        }
+        uint32_t token;
+        if (!free_tokens_.empty()) {
+            token = free_tokens_.back();
+            free_tokens_.pop_back();
+            token_names_[token].assign(level.data(), level.size());
+        } else {
+            token = static_cast<uint32_t>(token_names_.size());
+            token_names_.emplace_back(level);
+            token_refs_.push_back(0);
+        }
+        token_refs_[token] = 1;
+        token_ids_.emplace(token_names_[token], token);   // View auf den Deque-Eintrag (stabil)
+        return token;
+    }
+
+    void release_token(uint32_t token) {
+        if (--token_refs_[token] > 0) return;
+        token_ids_.erase(token_names_[token]);
+        free_tokens_.push_back(token);
+    }
+
+    void collect(uint32_t index, size_t depth, bool system_topic, std::vector<Subscriber>& out) const {
+        const Node& node = nodes_[index];
+        bool first_level = depth == 0 && system_topic;   // $-Topics: keine Wildcard auf Ebene 1
+
+        if (!first_level && node.hash != NONE) {
+            const auto& subscribers = nodes_[node.hash].subscribers;
+            out.insert(out.end(), subscribers.begin(), subscribers.end());
+        }
+        if (depth == tokens_.size()) {
+            out.insert(out.end(), node.subscribers.begin(), node.subscribers.end());
+            return;
+        }
+
+        if (tokens_[depth] != NONE) {
+            auto exact = edges_.find(edge(index, tokens_[depth]));
+            if (exact != edges_.end()) {
+                collect(exact->second, depth + 1, system_topic, out);
+            }
+        }
+        if (!first_level && node.plus != NONE) {
+            collect(node.plus, depth + 1, system_topic, out);
+        }
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_nodes_;
+    std::unordered_map<uint64_t, uint32_t> edges_;             // (Eltern, Token) -> Kind
+
+    std::deque<std::string> token_names_;                     // Token-ID -> Name (Adressen stabil)
+    std::unordered_map<std::string_view, uint32_t> token_ids_;
+    std::vector<uint32_t> token_refs_;
+    std::vector<uint32_t> free_tokens_;
+
+    size_t size_ = 0;
+    uint64_t generation_ = 1;
+    std::vector<std::string_view> levels_;   // Scratch für split()
+    std::vector<uint32_t> tokens_;           // Scratch für match()
+    std::vector<uint32_t> path_;             // Scratch für unsubscribe()
+};
+
+} // namespace ads_realtime
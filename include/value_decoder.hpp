@@ -0,0 +1,237 @@
+#pragma once
+
+#include "ams_protocol.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ads_realtime {
+
+/**
+ * Typisierter Wert-Decoder pro Variable
+ *
+ * Wird einmalig bei der Registrierung aus AdsSymbolEntry::dataType und ::size
+ * aufgelöst (resolve). Danach ist nur noch ein Funktionspointer auf ein fertig
+ * instanziiertes Template übrig - kein switch über den Datentyp pro Sample.
+ *
+ * Abbildung der ADS Symbole:
+ *   - Skalare:          dataType = Elementtyp, size = Elementgröße
+ *   - Arrays primitiver Typen: dataType = Elementtyp, size = n * Elementgröße
+ *   - STRING(n)/WSTRING(n): nullterminiert, size = (n + 1) * Zeichengröße
+ *   - Strukturen/FBs/sonstige Arrays (ADST_BIGTYPE): roh, als Hex-String
+ *
+ * Der Formatierer schreibt Klartext (42, 1.5, true, text, [1,2], 0a1b) in
+ * einen Caller-Puffer und allokiert nicht. to_text() liefert false, wenn der
+ * Puffer nicht reicht oder das Sample kürzer als der Typ ist - ein leerer
+ * STRING ist dagegen gültig (true, length = 0).
+ */
+struct ValueDecoder {
+    using FormatFn = size_t (*)(const uint8_t* data, size_t size, char* out, size_t capacity);
+
+    uint32_t ads_type = 0;                           // ams::DataType des Symbols
+    uint32_t element_size = 0;                       // 0 = variabel (String/Struct)
+    uint32_t element_count = 1;                      // > 1 = Array
+    const char* type_name = "RAW";                   // IEC 61131-3 Name (Logging)
+
+    FormatFn text_fn = nullptr;       // Geschriebene Bytes bzw. NO_SPACE
+
+    static constexpr size_t NO_SPACE = SIZE_MAX;
+
+    bool is_array() const { return element_count > 1; }
+
+    bool to_text(const void* data, size_t size, char* out, size_t capacity, size_t& length) const {
+        length = text_fn(static_cast<const uint8_t*>(data), size, out, capacity);
+        if (length == NO_SPACE) {
+            length = 0;
+            return false;
+        }
+        return true;
+    }
+
+    static ValueDecoder resolve(uint32_t ads_type, size_t size);
+};
+
+namespace value_format {
+
+// Kennzeichnung der PLC Typen ohne eigenen C++ Typ
+struct Bit {};
+
+template<typename T>
+inline T load(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template<typename T>
+inline char* write_value(const uint8_t* data, char* out, char* end) {
+    if constexpr (std::is_same_v<T, Bit>) {
+        const char* text = data[0] ? "true" : "false";
+        size_t length = data[0] ? 4 : 5;
+        if (static_cast<size_t>(end - out) < length) return nullptr;
+        std::memcpy(out, text, length);
+        return out + length;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        T value = load<T>(data);
+        if (!std::isfinite(value)) {
+            // NaN/Inf als null - Consumer müssen nur Zahlen parsen
+            if (end - out < 4) return nullptr;
+            std::memcpy(out, "null", 4);
+            return out + 4;
+        }
+        auto [ptr, ec] = std::to_chars(out, end, value);
+        return ec == std::errc() ? ptr : nullptr;
+    } else {
+        auto [ptr, ec] = std::to_chars(out, end, load<T>(data));
+        return ec == std::errc() ? ptr : nullptr;
+    }
+}
+
+template<typename T>
+constexpr size_t element_size() {
+    if constexpr (std::is_same_v<T, Bit>) return 1;
+    else return sizeof(T);
+}
+
+template<typename T>
+size_t scalar(const uint8_t* data, size_t size, char* out, size_t capacity) {
+    if (size < element_size<T>()) return ValueDecoder::NO_SPACE;
+    char* end = write_value<T>(data, out, out + capacity);
+    return end ? static_cast<size_t>(end - out) : ValueDecoder::NO_SPACE;
+}
+
+template<typename T>
+size_t array(const uint8_t* data, size_t size, char* out, size_t capacity) {
+    constexpr size_t step = element_size<T>();
+    char* pos = out;
+    char* end = out + capacity;
+    if (pos == end) return ValueDecoder::NO_SPACE;
+    *pos++ = '[';
+    for (size_t offset = 0; offset + step <= size; offset += step) {
+        if (offset > 0) {
+            if (pos == end) return ValueDecoder::NO_SPACE;
+            *pos++ = ',';
+        }
+        pos = write_value<T>(data + offset, pos, end);
+        if (!pos) return ValueDecoder::NO_SPACE;
+    }
+    if (pos == end) return ValueDecoder::NO_SPACE;
+    *pos++ = ']';
+    return static_cast<size_t>(pos - out);
+}
+
+// Ein Codepoint als UTF-8
+inline char* write_codepoint(uint32_t cp, char* out, char* end) {
+    if (cp < 0x80) {
+        if (out == end) return nullptr;
+        *out++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        if (end - out < 2) return nullptr;
+        *out++ = static_cast<char>(0xC0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        if (end - out < 3) return nullptr;
+        *out++ = static_cast<char>(0xE0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        if (end - out < 4) return nullptr;
+        *out++ = static_cast<char>(0xF0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+// STRING: TwinCAT verwendet Windows-1252, Bytes >= 0x80 werden als Latin-1 nach UTF-8 gehoben
+inline size_t string(const uint8_t* data, size_t size, char* out, size_t capacity) {
+    char* pos = out;
+    char* end = out + capacity;
+    for (size_t i = 0; i < size && data[i] != 0; i++) {
+        pos = write_codepoint(data[i], pos, end);
+        if (!pos) return ValueDecoder::NO_SPACE;
+    }
+    return static_cast<size_t>(pos - out);
+}
+
+// WSTRING: UTF-16LE inkl. Surrogate-Paaren
+inline size_t wstring(const uint8_t* data, size_t size, char* out, size_t capacity) {
+    char* pos = out;
+    char* end = out + capacity;
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint32_t cp = load<uint16_t>(data + i);
+        if (cp == 0) break;
+        if (cp >= 0xD800 && cp < 0xDC00 && i + 3 < size) {
+            uint32_t low = load<uint16_t>(data + i + 2);
+            if (low >= 0xDC00 && low < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+        }
+        pos = write_codepoint(cp, pos, end);
+        if (!pos) return ValueDecoder::NO_SPACE;
+    }
+    return static_cast<size_t>(pos - out);
+}
+
+// Strukturen/FBs: Bytes unverändert als Hex (Layout kennt nur der Empfänger)
+inline size_t raw(const uint8_t* data, size_t size, char* out, size_t capacity) {
+    static const char hex[] = "0123456789abcdef";
+    size_t needed = size * 2;
+    if (needed > capacity) return ValueDecoder::NO_SPACE;
+    char* pos = out;
+    for (size_t i = 0; i < size; i++) {
+        *pos++ = hex[data[i] >> 4];
+        *pos++ = hex[data[i] & 0xF];
+    }
+    return needed;
+}
+
+template<typename T>
+ValueDecoder make(uint32_t ads_type, const char* type_name, size_t size) {
+    ValueDecoder decoder;
+    decoder.ads_type = ads_type;
+    decoder.type_name = type_name;
+    decoder.element_size = static_cast<uint32_t>(element_size<T>());
+    decoder.element_count = static_cast<uint32_t>(size >= element_size<T>() ? size / element_size<T>() : 1);
+    decoder.text_fn = decoder.element_count > 1 ? &array<T> : &scalar<T>;
+    return decoder;
+}
+
+inline ValueDecoder make_variable(uint32_t ads_type, const char* type_name, ValueDecoder::FormatFn text_fn) {
+    ValueDecoder decoder;
+    decoder.ads_type = ads_type;
+    decoder.type_name = type_name;
+    decoder.text_fn = text_fn;
+    return decoder;
+}
+
+} // namespace value_format
+
+inline ValueDecoder ValueDecoder::resolve(uint32_t ads_type, size_t size) {
+    using namespace value_format;
+    using ams::DataType;
+
+    switch (static_cast<DataType>(ads_type)) {
+        case DataType::Bit:     return make<Bit>(ads_type, "BOOL", size);
+        case DataType::Int8:    return make<int8_t>(ads_type, "SINT", size);
+        case DataType::UInt8:   return make<uint8_t>(ads_type, "USINT", size);
+        case DataType::Int16:   return make<int16_t>(ads_type, "INT", size);
+        case DataType::UInt16:  return make<uint16_t>(ads_type, "UINT", size);
+        case DataType::Int32:   return make<int32_t>(ads_type, "DINT", size);
+        case DataType::UInt32:  return make<uint32_t>(ads_type, "UDINT", size);
+        case DataType::Int64:   return make<int64_t>(ads_type, "LINT", size);
+        case DataType::UInt64:  return make<uint64_t>(ads_type, "ULINT", size);
+        case DataType::Real32:  return make<float>(ads_type, "REAL", size);
+        case DataType::Real64:  return make<double>(ads_type, "LREAL", size);
+        case DataType::String:  return make_variable(ads_type, "STRING", &string);
+        case DataType::WString: return make_variable(ads_type, "WSTRING", &wstring);
+        default:                return make_variable(ads_type, "STRUCT", &raw);
+    }
+}
+
+} // namespace ads_realtime
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "realtime_config.hpp"
+#include "value_decoder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace ads_realtime {
+
+/**
+ * Change-of-Value / Totzonen-Filter pro Variable
+ *
+ * Sitzt in der Engine vor dem Notification Ring: verworfene Samples kosten
+ * weder Ring-Slot noch Dispatcher noch MQTT. Verglichen wird immer gegen den
+ * zuletzt *weitergereichten* Wert - langsames Driften unterhalb der Totzone
+ * summiert sich also auf und geht nicht verloren.
+ *
+ *   - REAL/LREAL und vorzeichenbehaftete Ganzzahlen: Totzone absolut und/oder
+ *     relativ (die größere Schwelle gilt), elementweise für Arrays
+ *   - BOOL, BYTE/WORD/DWORD (= vorzeichenlose Typen), STRING, Strukturen:
+ *     jede Bit-Änderung
+ *   - min_interval: höchstens ein Sample pro Intervall; die Änderung kommt mit
+ *     dem nächsten Zyklus nach Ablauf (ADSTRANS_SERVERCYCLE liefert weiter)
+ *   - max_interval: Heartbeat, auch ohne Änderung
+ *
+ * Zeitbasis ist der ADS Timestamp des Samples (100ns) - kein Clock-Aufruf.
+ * Zustand wird nur vom einliefernden Thread (ADS Callback / Poll Thread)
+ * geschrieben; der Vergleichspuffer wird bei configure() einmalig allokiert.
+ *
+ * Ablauf: pass() entscheidet, commit() übernimmt den Wert erst wenn das Sample
+ * tatsächlich im Ring gelandet ist (volle Queue -> nächster Versuch vergleicht
+ * weiter gegen den alten Wert).
+ */
+class ValueFilter {
+public:
+    void configure(const FilterConfig& config, const ValueDecoder& decoder, size_t data_size) {
+        config_ = config;
+        last_.assign(data_size, 0);
+        has_last_ = false;
+        last_size_ = 0;
+        last_publish_ = 0;
+        min_interval_ = static_cast<int64_t>(config.min_interval_ms) * TICKS_PER_MS;
+        max_interval_ = static_cast<int64_t>(config.max_interval_ms) * TICKS_PER_MS;
+        check_value_ = config.on_change || config.deadband_abs > 0.0 || config.deadband_percent > 0.0;
+
+        compare_ = &changed_bits;
+        if (config.deadband_abs > 0.0 || config.deadband_percent > 0.0) {
+            switch (static_cast<ams::DataType>(decoder.ads_type)) {
+                case ams::DataType::Real32: compare_ = &exceeds_deadband<float>; break;
+                case ams::DataType::Real64: compare_ = &exceeds_deadband<double>; break;
+                case ams::DataType::Int8:   compare_ = &exceeds_deadband<int8_t>; break;
+                case ams::DataType::Int16:  compare_ = &exceeds_deadband<int16_t>; break;
+                case ams::DataType::Int32:  compare_ = &exceeds_deadband<int32_t>; break;
+                case ams::DataType::Int64:  compare_ = &exceeds_deadband<int64_t>; break;
+                default: break;   // Bit-Vergleich
+            }
+        }
+    }
+
+    bool enabled() const { return check_value_ || min_interval_ > 0 || max_interval_ > 0; }
+
+    /**
+     * Soll das Sample weitergereicht werden?
+     */
+    bool pass(const void* data, uint32_t size, int64_t ads_timestamp) const {
+        if (!has_last_ || size != last_size_ || size > last_.size()) {
+            return true;
+        }
+        int64_t elapsed = ads_timestamp - last_publish_;
+        if (elapsed < 0) {
+            return true;   // Timestamp-Sprung (PLC Neustart, Zeitsync)
+        }
+        if (min_interval_ > 0 && elapsed < min_interval_) {
+            return false;
+        }
+        if (max_interval_ > 0 && elapsed >= max_interval_) {
+            return true;
+        }
+        if (!check_value_) {
+            return true;
+        }
+        return compare_(static_cast<const uint8_t*>(data), last_.data(), size, config_);
+    }
+
+    /**
+     * Sample wurde weitergereicht - neuer Referenzwert
+     */
+    void commit(const void* data, uint32_t size, int64_t ads_timestamp) {
+        if (size <= last_.size()) {
+            std::memcpy(last_.data(), data, size);
+            has_last_ = true;
+        }
+        last_size_ = size;
+        last_publish_ = ads_timestamp;
+    }
+
+private:
+    using CompareFn = bool (*)(const uint8_t* value, const uint8_t* last, size_t size,
+                               const FilterConfig& config);
+
+    static constexpr int64_t TICKS_PER_MS = 10000;   // ADS Timestamp: 100ns
+    static constexpr size_t BLOCK_BYTES = 64;
+
+    // Bit-Änderung: XOR/OR-Reduktion über 8-Byte Worte, Abbruch nur an
+    // Blockgrenzen - die innere Schleife hat keinen Branch und wird vektorisiert
+    static bool changed_bits(const uint8_t* value, const uint8_t* last, size_t size,
+                             const FilterConfig&) {
+        size_t offset = 0;
+        for (; offset + BLOCK_BYTES <= size; offset += BLOCK_BYTES) {
+            uint64_t diff = 0;
+            for (size_t i = 0; i < BLOCK_BYTES; i += sizeof(uint64_t)) {
+                uint64_t a, b;
+                std::memcpy(&a, value + offset + i, sizeof(a));
+                std::memcpy(&b, last + offset + i, sizeof(b));
+                diff |= a ^ b;
+            }
+            if (diff != 0) return true;
+        }
+        uint8_t diff = 0;
+        for (; offset < size; offset++) {
+            diff |= value[offset] ^ last[offset];
+        }
+        return diff != 0;
+    }
+
+    // NaN über das Bitmuster (Exponent alle Einsen, Mantisse != 0): x != x
+    // entfernt der Compiler unter -ffast-math
+    template<typename T>
+    static bool is_nan(const uint8_t* p) {
+        if constexpr (std::is_same_v<T, float>) {
+            uint32_t bits;
+            std::memcpy(&bits, p, sizeof(bits));
+            return (bits & 0x7FFFFFFFu) > 0x7F800000u;
+        } else if constexpr (std::is_same_v<T, double>) {
+            uint64_t bits;
+            std::memcpy(&bits, p, sizeof(bits));
+            return (bits & 0x7FFFFFFFFFFFFFFFull) > 0x7FF0000000000000ull;
+        } else {
+            return false;
+        }
+    }
+
+    // Totzone: |x - x_last| > max(abs, percent * |x_last|), elementweise.
+    // NaN <-> Zahl zählt als Änderung. Blöcke zu 16 Elementen ohne Branch.
+    template<typename T>
+    static bool exceeds_deadband(const uint8_t* value, const uint8_t* last, size_t size,
+                                 const FilterConfig& config) {
+        using Calc = std::conditional_t<std::is_same_v<T, float>, float, double>;
+        constexpr size_t BLOCK = 16;
+        const Calc absolute = static_cast<Calc>(config.deadband_abs);
+        const Calc relative = static_cast<Calc>(config.deadband_percent / 100.0);
+        const size_t count = size / sizeof(T);
+
+        auto element = [&](size_t i) {
+            T x, y;
+            std::memcpy(&x, value + i * sizeof(T), sizeof(T));
+            std::memcpy(&y, last + i * sizeof(T), sizeof(T));
+            Calc a = static_cast<Calc>(x);
+            Calc b = static_cast<Calc>(y);
+            Calc threshold = std::max(absolute, relative * std::abs(b));
+            return static_cast<int>(std::abs(a - b) > threshold) |
+                   static_cast<int>(is_nan<T>(value + i * sizeof(T)) != is_nan<T>(last + i * sizeof(T)));
+        };
+
+        size_t i = 0;
+        for (; i + BLOCK <= count; i += BLOCK) {
+            int exceeded = 0;
+            for (size_t j = 0; j < BLOCK; j++) {
+                exceeded |= element(i + j);
+            }
+            if (exceeded) return true;
+        }
+        int exceeded = 0;
+        for (; i < count; i++) {
+            exceeded |= element(i);
+        }
+        return exceeded != 0;
+    }
+
+    FilterConfig config_;
+    CompareFn compare_ = &changed_bits;
+    bool check_value_ = false;
+    bool has_last_ = false;
+    uint32_t last_size_ = 0;
+    int64_t last_publish_ = 0;
+    int64_t min_interval_ = 0;
+    int64_t max_interval_ = 0;
+    std::vector<uint8_t> last_;
+};
+
+} // namespace ads_realtime
@@ -1,113 +1,278 @@
 ﻿#pragma once
 
-#include <vector>
-#include <string>
-#include <cstring>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 namespace ads_realtime {
 
-// Binary batch format für effizientes Senden mehrerer Variables
-struct VariableBatch {
-    struct Entry {
-        std::string name;
-        std::vector<uint8_t> data;
-        uint64_t timestamp_us;
-        
-        Entry(const std::string& n, const void* d, size_t len)
-            : name(n), data(static_cast<const uint8_t*>(d), static_cast<const uint8_t*>(d) + len) {
-            auto now = std::chrono::high_resolution_clock::now();
-            timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
-                now.time_since_epoch()).count();
+/**
+ * Bump-Arena aus Slabs fester Größe
+ *
+ * Alle Slabs werden im Konstruktor allokiert; allocate() schiebt nur einen
+ * Zeiger weiter, reset() gibt alles auf einmal frei. Passt eine Anforderung
+ * nicht mehr in den Rest des Slabs, geht es im nächsten weiter; ist kein
+ * Slab mehr frei (oder n > slab_size), liefert allocate() nullptr.
+ */
+class BatchArena {
+public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 64 * 1024;
+
+    BatchArena() = default;
+
+    explicit BatchArena(size_t capacity, size_t slab_size = DEFAULT_SLAB_SIZE) {
+        init(capacity, slab_size);
+    }
+
+    void init(size_t capacity, size_t slab_size = DEFAULT_SLAB_SIZE) {
+        slab_size_ = slab_size > 0 ? slab_size : DEFAULT_SLAB_SIZE;
+        size_t count = capacity > 0 ? (capacity + slab_size_ - 1) / slab_size_ : 1;
+        slabs_.clear();
+        for (size_t i = 0; i < count; i++) {
+            slabs_.emplace_back(new uint8_t[slab_size_]);
         }
+        reset();
+    }
+
+    uint8_t* allocate(size_t n) {
+        if (n > slab_size_ || slabs_.empty()) return nullptr;
+        if (slab_size_ - used_ < n) {
+            if (slab_ + 1 >= slabs_.size()) return nullptr;
+            slab_++;
+            used_ = 0;
+        }
+        uint8_t* p = slabs_[slab_].get() + used_;
+        used_ += n;
+        return p;
+    }
+
+    void reset() {
+        slab_ = 0;
+        used_ = 0;
+    }
+
+    size_t capacity() const { return slabs_.size() * slab_size_; }
+    size_t slab_size() const { return slab_size_; }
+
+private:
+    std::vector<std::unique_ptr<uint8_t[]>> slabs_;
+    size_t slab_size_ = DEFAULT_SLAB_SIZE;
+    size_t slab_ = 0;
+    size_t used_ = 0;
+};
+
+/**
+ * Binary batch format für effizientes Senden mehrerer Variables
+ *
+ * Doppelt gepuffert: der Producer füllt den aktiven Puffer (add_variable),
+ * swap() übergibt ihn an den Flusher und schaltet auf den zweiten um; der
+ * Flusher schreibt den übergebenen Puffer per serialize_ready() direkt in
+ * seinen Sende-Puffer und gibt ihn damit frei. Name und Daten jedes Eintrags
+ * liegen in der BatchArena des Puffers, die Einträge in einem festen Array -
+ * nach dem Konstruktor keine Heap-Allokation mehr. Ein Producer- und ein
+ * Flusher-Thread; ohne Flusher-Thread wie bisher add_variable() ->
+ * serialize() -> clear().
+ *
+ * Ist ein Puffer voll (max_batch_size Einträge oder Arena erschöpft), wird
+ * der Eintrag verworfen (dropped()) und should_flush() liefert true.
+ */
+class VariableBatch {
+public:
+    static constexpr size_t DEFAULT_ENTRY_BYTES = 128;     // Arena pro Eintrag (Name + Daten)
+
+    struct Entry {
+        std::string_view name;
+        const uint8_t* data = nullptr;
+        uint32_t length = 0;
+        uint64_t timestamp_us = 0;
     };
-    
-    std::vector<Entry> entries;
-    size_t max_batch_size;
-    std::chrono::microseconds batch_timeout;
-    std::chrono::high_resolution_clock::time_point last_flush;
-    
-    VariableBatch(size_t max_size = 100, std::chrono::microseconds timeout = std::chrono::milliseconds(10))
-        : max_batch_size(max_size), batch_timeout(timeout), last_flush(std::chrono::high_resolution_clock::now()) {}
-    
-    // Fügt Variable zum Batch hinzu
-    bool add_variable(const std::string& name, const void* data, size_t size) {
-        entries.emplace_back(name, data, size);
-        return should_flush();
-    }
-    
+
+    // arena_bytes: Arena pro Puffer, 0 = max_size * DEFAULT_ENTRY_BYTES
+    VariableBatch(size_t max_size = 100, std::chrono::microseconds timeout = std::chrono::milliseconds(10),
+                  size_t arena_bytes = 0)
+        : max_batch_size(max_size > 0 ? max_size : 1), batch_timeout(timeout),
+          last_flush(std::chrono::high_resolution_clock::now()) {
+        if (arena_bytes == 0) arena_bytes = max_batch_size * DEFAULT_ENTRY_BYTES;
+        for (Buffer& buffer : buffers_) {
+            buffer.arena.init(arena_bytes, std::min(arena_bytes, BatchArena::DEFAULT_SLAB_SIZE));
+            buffer.entries.reset(new Entry[max_batch_size]);
+        }
+    }
+
+    VariableBatch(const VariableBatch&) = delete;
+    VariableBatch& operator=(const VariableBatch&) = delete;
+
+    // Fügt Variable zum Batch hinzu (Timestamp = jetzt), Rückgabe should_flush()
+    bool add_variable(std::string_view name, const void* data, size_t size) {
+        auto now = std::chrono::high_resolution_clock::now();
+        uint64_t timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            now.time_since_epoch()).count();
+        add(name, data, size, timestamp_us);
+        return should_flush(now);
+    }
+
+    // Mit Timestamp des Samples (z.B. ADS Notification)
+    bool add_variable(std::string_view name, const void* data, size_t size, uint64_t timestamp_us) {
+        add(name, data, size, timestamp_us);
+        return should_flush(std::chrono::high_resolution_clock::now());
+    }
+
     // Prüft ob Batch geflusht werden soll
     bool should_flush() const {
-        if (entries.size() >= max_batch_size) return true;
-        
-        auto now = std::chrono::high_resolution_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last_flush);
-        return elapsed >= batch_timeout;
+        return should_flush(std::chrono::high_resolution_clock::now());
     }
-    
-    // Serialisiert Batch in Binary Format
+
+    // Producer: aktiven Puffer an den Flusher übergeben. false wenn der Batch
+    // leer ist oder der Flusher den vorherigen noch nicht serialisiert hat
+    // (dann weiter in den aktiven Puffer).
+    bool swap() {
+        Buffer& current = buffers_[active_];
+        if (current.count == 0) {
+            last_flush = std::chrono::high_resolution_clock::now();
+            return false;
+        }
+        if (ready_.load(std::memory_order_acquire) != NONE) return false;
+        ready_.store(active_, std::memory_order_release);
+        active_ ^= 1;
+        buffers_[active_].clear();
+        last_flush = std::chrono::high_resolution_clock::now();
+        return true;
+    }
+
+    // Flusher: Größe des übergebenen Batches, 0 wenn keiner bereit
+    size_t ready_size() const {
+        int ready = ready_.load(std::memory_order_acquire);
+        return ready != NONE ? buffers_[ready].wire_size : 0;
+    }
+
+    // Flusher: übergebenen Batch nach out[0..capacity) schreiben und freigeben.
+    // 0 wenn keiner bereit oder capacity < ready_size() (Batch bleibt dann bereit).
+    size_t serialize_ready(uint8_t* out, size_t capacity) {
+        int ready = ready_.load(std::memory_order_acquire);
+        if (ready == NONE) return 0;
+        size_t written = buffers_[ready].serialize(out, capacity);
+        if (written > 0) ready_.store(NONE, std::memory_order_release);
+        return written;
+    }
+
+    // Serialisiert den aktiven Batch in Binary Format
     // Format: [count:4][entry1_len:4][entry1_data][entry2_len:4][entry2_data]...
     // Entry Format: [name_len:2][name][timestamp:8][data_len:4][data]
+    size_t serialized_size() const { return buffers_[active_].wire_size; }
+
+    // Direkt in out[0..capacity), 0 wenn der Puffer zu klein ist
+    size_t serialize(uint8_t* out, size_t capacity) const {
+        return buffers_[active_].serialize(out, capacity);
+    }
+
     std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> buffer;
-        
-        // Reserve geschätzte Größe
-        size_t estimated_size = 4; // count
-        for (const auto& entry : entries) {
-            estimated_size += 4 + 2 + entry.name.size() + 8 + 4 + entry.data.size();
-        }
-        buffer.reserve(estimated_size);
-        
-        // Anzahl Entries
-        uint32_t count = static_cast<uint32_t>(entries.size());
-        buffer.insert(buffer.end(), reinterpret_cast<const uint8_t*>(&count), 
-                      reinterpret_cast<const uint8_t*>(&count) + sizeof(count));
-        
-        // Entries
-        for (const auto& entry : entries) {
-            // Entry Length (placeholder, wird später gefüllt)
-            size_t entry_start = buffer.size();
-            uint32_t entry_len = 0;
-            buffer.insert(buffer.end(), reinterpret_cast<const uint8_t*>(&entry_len), 
-                         reinterpret_cast<const uint8_t*>(&entry_len) + sizeof(entry_len));
-            
-            size_t data_start = buffer.size();
-            
-            // Name Length + Name
-            uint16_t name_len = static_cast<uint16_t>(entry.name.size());
-            buffer.insert(buffer.end(), reinterpret_cast<const uint8_t*>(&name_len), 
-                         reinterpret_cast<const uint8_t*>(&name_len) + sizeof(name_len));
-            buffer.insert(buffer.end(), entry.name.begin(), entry.name.end());
-            
-            // Timestamp
-            buffer.insert(buffer.end(), reinterpret_cast<const uint8_t*>(&entry.timestamp_us), 
-                         reinterpret_cast<const uint8_t*>(&entry.timestamp_us) + sizeof(entry.timestamp_us));
-            
-            // Data Length + Data
-            uint32_t data_len = static_cast<uint32_t>(entry.data.size());
-            buffer.insert(buffer.end(), reinterpret_cast<const uint8_t*>(&data_len), 
-                         reinterpret_cast<const uint8_t*>(&data_len) + sizeof(data_len));
-            buffer.insert(buffer.end(), entry.data.begin(), entry.data.end());
-            
-            // Entry Length zurückschreiben
-            entry_len = static_cast<uint32_t>(buffer.size() - data_start);
-            std::memcpy(&buffer[entry_start], &entry_len, sizeof(entry_len));
-        }
-        
+        std::vector<uint8_t> buffer(serialized_size());
+        serialize(buffer.data(), buffer.size());
         return buffer;
     }
-    
-    // Leert Batch
+
+    // Leert den aktiven Batch
     void clear() {
-        entries.clear();
+        buffers_[active_].clear();
         last_flush = std::chrono::high_resolution_clock::now();
     }
-    
+
+    // Einträge des aktiven Batches
+    const Entry* begin() const { return buffers_[active_].entries.get(); }
+    const Entry* end() const { return begin() + size(); }
+
     // Anzahl Entries
-    size_t size() const { return entries.size(); }
-    
+    size_t size() const { return buffers_[active_].count; }
+
     // Ist leer?
-    bool empty() const { return entries.empty(); }
+    bool empty() const { return size() == 0; }
+
+    // Verworfene Einträge (Puffer voll), nur vom Producer gezählt
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    static constexpr int NONE = -1;
+    static constexpr size_t ENTRY_OVERHEAD = 4 + 2 + 8 + 4;  // entry_len, name_len, timestamp, data_len
+
+    struct Buffer {
+        BatchArena arena;
+        std::unique_ptr<Entry[]> entries;
+        size_t count = 0;
+        size_t wire_size = 4;       // count
+        bool full = false;
+
+        void clear() {
+            arena.reset();
+            count = 0;
+            wire_size = 4;
+            full = false;
+        }
+
+        size_t serialize(uint8_t* out, size_t capacity) const {
+            if (!out || capacity < wire_size) return 0;
+            uint8_t* p = out;
+            uint32_t entry_count = static_cast<uint32_t>(count);
+            std::memcpy(p, &entry_count, 4);
+            p += 4;
+            for (size_t i = 0; i < count; i++) {
+                const Entry& entry = entries[i];
+                uint32_t entry_len = static_cast<uint32_t>(ENTRY_OVERHEAD - 4 + entry.name.size() + entry.length);
+                uint16_t name_len = static_cast<uint16_t>(entry.name.size());
+                std::memcpy(p, &entry_len, 4);
+                std::memcpy(p + 4, &name_len, 2);
+                std::memcpy(p + 6, entry.name.data(), entry.name.size());
+                p += 6 + entry.name.size();
+                std::memcpy(p, &entry.timestamp_us, 8);
+                std::memcpy(p + 8, &entry.length, 4);
+                std::memcpy(p + 12, entry.data, entry.length);
+                p += 12 + entry.length;
+            }
+            return static_cast<size_t>(p - out);
+        }
+    };
+
+    void add(std::string_view name, const void* data, size_t size, uint64_t timestamp_us) {
+        Buffer& buffer = buffers_[active_];
+        uint8_t* storage = nullptr;
+        if (buffer.count < max_batch_size && name.size() <= UINT16_MAX && size <= UINT32_MAX) {
+            storage = buffer.arena.allocate(name.size() + size);
+        }
+        if (!storage) {
+            buffer.full = true;
+            dropped_++;
+            return;
+        }
+        std::memcpy(storage, name.data(), name.size());
+        if (size > 0) std::memcpy(storage + name.size(), data, size);
+
+        Entry& entry = buffer.entries[buffer.count++];
+        entry.name = std::string_view(reinterpret_cast<const char*>(storage), name.size());
+        entry.data = storage + name.size();
+        entry.length = static_cast<uint32_t>(size);
+        entry.timestamp_us = timestamp_us;
+        buffer.wire_size += ENTRY_OVERHEAD + name.size() + size;
+    }
+
+    bool should_flush(std::chrono::high_resolution_clock::time_point now) const {
+        const Buffer& buffer = buffers_[active_];
+        if (buffer.count >= max_batch_size || buffer.full) return true;
+        return now - last_flush >= batch_timeout;
+    }
+
+    size_t max_batch_size;
+    std::chrono::microseconds batch_timeout;
+    std::chrono::high_resolution_clock::time_point last_flush;
+
+    Buffer buffers_[2];
+    int active_ = 0;                            // nur Producer
+    std::atomic<int> ready_{NONE};              // an den Flusher übergebener Puffer
+    uint64_t dropped_ = 0;
 };
 
 } // namespace ads_realtime
@@ -1,9 +1,14 @@
 #include "ads_realtime_engine.hpp"
 #include <iostream>
 #include <algorithm>
-#include <numeric>
 #include <cstring>
 
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
 // Windows max/min Makro-Konflikte verhindern
 #ifndef NOMINMAX
 #define NOMINMAX
@@ -17,34 +22,110 @@
 #define ADSIGRP_SYM_VALBYHND 0xF005
 #endif
 #ifndef ADSIGRP_SYM_INFOBYNAMEEX
-#define ADSIGRP_SYM_INFOBYNAMEEX 0xF040
+#define ADSIGRP_SYM_INFOBYNAMEEX 0xF009
+#endif
+#ifndef ADSIGRP_SYM_RELEASEHND
+#define ADSIGRP_SYM_RELEASEHND 0xF006
+#endif
+#ifndef THREAD_PRIORITY_TIME_CRITICAL
+#define THREAD_PRIORITY_TIME_CRITICAL 15  // Windows-Wert, unter Linux ohne Bedeutung
 #endif
 
 namespace ads_realtime {
 
+// Puffer für AdsSymbolEntry + Name + Typ + Kommentar (INFOBYNAMEEX)
+static constexpr uint32_t SYMBOL_INFO_READ_LENGTH = 1024;
+
+// Aktuelle Systemzeit als FILETIME (100ns seit 1601) - gleiche Basis wie ADS Timestamps
+static int64_t current_ads_timestamp() {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    return (static_cast<int64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+#else
+    constexpr int64_t FILETIME_UNIX_EPOCH = 116444736000000000LL; // 1601 -> 1970
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return FILETIME_UNIX_EPOCH + static_cast<int64_t>(ts.tv_sec) * 10000000LL + ts.tv_nsec / 100;
+#endif
+}
+
+// Echtzeit-Priorität setzen (Windows: Thread Priority, Linux: SCHED_FIFO)
+static void set_thread_priority(std::thread::native_handle_type thread, int windows_priority, int fifo_priority) {
+#ifdef _WIN32
+    SetThreadPriority(thread, windows_priority);
+    (void)fifo_priority;
+#else
+    (void)windows_priority;
+    sched_param param{};
+    param.sched_priority = std::clamp(fifo_priority, sched_get_priority_min(SCHED_FIFO),
+                                      sched_get_priority_max(SCHED_FIFO));
+    int result = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (result != 0) {
+        std::cerr << "[ADS RT] WARNING: SCHED_FIFO nicht verfügbar (" << std::strerror(result)
+                  << ") - CAP_SYS_NICE bzw. rtprio Limit prüfen\n";
+    }
+#endif
+}
+
 AdsRealtimeEngine::AdsRealtimeEngine(const RealtimeConfig& config)
     : config_(config) {
     
+#ifdef _WIN32
     // High-Resolution Performance Counter initialisieren
     QueryPerformanceFrequency(&qpc_frequency_);
+#endif
+    
+    // Latenz-Histogramm (fixer Speicher, unabhängig von Laufzeit und Rate)
+    latency_recorder_ = std::make_unique<LatencyRecorder>();
     
-    // Latency samples reservieren (60 Sekunden bei 10kHz = 600k samples)
-    latency_samples_.reserve(600000);
+    // Notification Ring vorallokieren (keine Allokation im ADS Callback)
+    ring_ = std::make_unique<Ring>(config_.notification_queue_capacity);
+    
+    // Variable-ID Tabelle vorallokieren (Lookup im Dispatcher ohne Map/Lock)
+    variable_table_.assign(std::min<uint32_t>(config_.max_variables, 1u << 24), nullptr);
+    
+#ifdef _WIN32
+    // Engine-Slot für den hUser der ADS Notifications belegen
+    engine_slot_ = MAX_ENGINES;
+    for (uint32_t slot = 0; slot < MAX_ENGINES; slot++) {
+        AdsRealtimeEngine* expected = nullptr;
+        if (engines_[slot].compare_exchange_strong(expected, this)) {
+            engine_slot_ = slot;
+            break;
+        }
+    }
+    if (engine_slot_ == MAX_ENGINES) {
+        std::cerr << "[ADS RT] ERROR: Mehr als " << MAX_ENGINES << " Engines - Notifications deaktiviert\n";
+    }
+#endif
     
     std::cout << "[ADS RT] Engine initialisiert\n";
     std::cout << "[ADS RT] Notification Cycle: " << config_.notification_cycle_us << "µs\n";
     std::cout << "[ADS RT] Max Latency: " << config_.max_latency_us << "µs\n";
+    std::cout << "[ADS RT] Notification Queue: " << ring_->capacity() << " Slots à "
+              << Ring::slot_data_size << " bytes\n";
 }
 
 AdsRealtimeEngine::~AdsRealtimeEngine() {
     stop();
     
+#ifdef _WIN32
     if (ads_port_ != 0) {
         AdsPortCloseEx(ads_port_);
     }
+    if (engine_slot_ < MAX_ENGINES) {
+        engines_[engine_slot_].store(nullptr, std::memory_order_release);
+    }
+#else
+    if (ams_client_) {
+        ams_client_->disconnect();
+    }
+#endif
 }
 
 bool AdsRealtimeEngine::connect() {
+#ifdef _WIN32
     // ADS Port öffnen
     ads_port_ = AdsPortOpenEx();
     if (ads_port_ == 0) {
@@ -52,30 +133,118 @@ bool AdsRealtimeEngine::connect() {
         return false;
     }
 
-    // AMS NetId manuell setzen (AdsGetNetIdForHostName nicht in allen TcAdsAPI verfügbar)
-    AmsNetId netId;
-    // Für lokale Verbindung: 127.0.0.1.1.1 (Standard TwinCAT)
-    netId.b[0] = 127;
-    netId.b[1] = 0;
-    netId.b[2] = 0;
-    netId.b[3] = 1;
-    netId.b[4] = 1;
-    netId.b[5] = 1;
+    // Ohne konfigurierte NetId: lokaler Router 127.0.0.1.1.1 (Standard TwinCAT)
+    std::string target_netid = config_.ads_target_netid.empty()
+        ? std::string("127.0.0.1.1.1") : config_.ads_target_netid;
+#else
+    // Direkte TCP Verbindung zum AMS Router der PLC (kein TcAdsDll)
+    ams_client_ = std::make_unique<AmsTcpClient>();
+    if (!ams_client_->connect(config_.ads_target_ip, config_.ads_local_netid, config_.ams_tcp_port)) {
+        std::cerr << "[ADS RT] ERROR: AMS/TCP Verbindung zu " << config_.ads_target_ip
+                  << " fehlgeschlagen\n";
+        return false;
+    }
+
+    // Ohne konfigurierte NetId: <ip>.1.1 (TwinCAT Default)
+    std::string target_netid = config_.ads_target_netid.empty()
+        ? config_.ads_target_ip + ".1.1" : config_.ads_target_netid;
+#endif
 
-    // AMS Adresse setzen
-    ams_addr_.netId = netId;
+    // AMS Adresse setzen (AmsNetId hat auf allen Plattformen das Layout b[6])
+    ams::NetId netId;
+    if (!ams::parse_net_id(target_netid, netId)) {
+        std::cerr << "[ADS RT] ERROR: Ungültige AMS NetId " << target_netid << "\n";
+        return false;
+    }
+    std::memcpy(&ams_addr_.netId, &netId, sizeof(netId));
     ams_addr_.port = config_.ads_port;
 
     std::cout << "[ADS RT] Verbunden mit " << config_.ads_target_ip 
-              << ":" << config_.ads_port << "\n";
+              << ":" << config_.ads_port << " (NetId " << target_netid << ")\n";
     
     return true;
 }
 
+long AdsRealtimeEngine::ads_read_write(
+    uint32_t index_group,
+    uint32_t index_offset,
+    uint32_t read_length,
+    void* read_data,
+    uint32_t write_length,
+    const void* write_data,
+    uint32_t* bytes_read) {
+    
+#ifdef _WIN32
+    unsigned long returned = 0;
+    long result = AdsSyncReadWriteReqEx2(
+        ads_port_,
+        &ams_addr_,
+        index_group,
+        index_offset,
+        read_length,
+        read_data,
+        write_length,
+        const_cast<void*>(write_data),
+        &returned
+    );
+    if (bytes_read) *bytes_read = static_cast<uint32_t>(returned);
+    return result;
+#else
+    return ams_client_->read_write(ams_addr_, index_group, index_offset,
+                                   read_length, read_data, write_length, write_data, bytes_read);
+#endif
+}
+
+long AdsRealtimeEngine::ads_add_notification(
+    VariableHandle* var_handle,
+    const AdsNotificationAttrib& attrib,
+    uint32_t* notification_handle) {
+    
+#ifdef _WIN32
+    if (engine_slot_ >= MAX_ENGINES) {
+        return ams::ERR_CLIENT_INVALIDPARM;
+    }
+    
+    // hUser: Engine-Slot + Variable-ID (ein Pointer passt unter Win64 nicht in 32 Bit)
+    AdsNotificationAttrib attrib_copy = attrib;
+    unsigned long handle = 0;
+    long result = AdsSyncAddDeviceNotificationReqEx(
+        ads_port_,
+        &ams_addr_,
+        ADSIGRP_SYM_VALBYHND,
+        var_handle->handle,
+        &attrib_copy,
+        reinterpret_cast<PAdsNotificationFuncEx>(&AdsRealtimeEngine::ads_notification_callback),
+        (engine_slot_ << VARIABLE_ID_BITS) | var_handle->id,
+        &handle
+    );
+    *notification_handle = static_cast<uint32_t>(handle);
+    return result;
+#else
+    return ams_client_->add_notification(
+        ams_addr_,
+        ADSIGRP_SYM_VALBYHND,
+        var_handle->handle,
+        attrib,
+        &AdsRealtimeEngine::ams_notification_callback,
+        reinterpret_cast<uintptr_t>(var_handle),
+        notification_handle
+    );
+#endif
+}
+
 bool AdsRealtimeEngine::add_variable(
     const std::string& variable_name,
     NotificationCallback callback) {
     
+    return add_variable(variable_name, std::move(callback), config_.filter);
+}
+
+bool AdsRealtimeEngine::add_variable(
+    const std::string& variable_name,
+    NotificationCallback callback,
+    const FilterConfig& filter) {
+    
     if (!callback) {
         std::cerr << "[ADS RT] ERROR: Invalid callback\n";
         return false;
@@ -84,19 +253,17 @@ bool AdsRealtimeEngine::add_variable(
     auto var_handle = std::make_unique<VariableHandle>();
     var_handle->name = variable_name;
     var_handle->callback = std::move(callback);
+    var_handle->filter_config = filter;
+    var_handle->engine = this;
 
     // Symbol-Handle für Variable abrufen
-    unsigned long bytes_read = 0;
-    long result = AdsSyncReadWriteReqEx2(
-        ads_port_,
-        &ams_addr_,
+    long result = ads_read_write(
         ADSIGRP_SYM_HNDBYNAME,
         0,
         sizeof(var_handle->handle),
         &var_handle->handle,
-        static_cast<unsigned long>(variable_name.length()),
-        const_cast<char*>(variable_name.c_str()),
-        &bytes_read
+        static_cast<uint32_t>(variable_name.length()),
+        variable_name.c_str()
     );
 
     if (result != 0) {
@@ -105,73 +272,466 @@ bool AdsRealtimeEngine::add_variable(
         return false;
     }
 
-    // Variablen-Info abrufen (Datentyp, Größe)
-    AdsSymbolEntry symbol_entry{};
-    unsigned long bytes_read2 = 0;
-    result = AdsSyncReadReqEx2(
-        ads_port_,
-        &ams_addr_,
+    // Variablen-Info abrufen (Datentyp, Größe) - Name muss mitgeschickt werden
+    uint8_t symbol_buffer[SYMBOL_INFO_READ_LENGTH] = {};
+    uint32_t bytes_read2 = 0;
+    result = ads_read_write(
         ADSIGRP_SYM_INFOBYNAMEEX,
         0,
-        sizeof(symbol_entry),
-        &symbol_entry,
+        sizeof(symbol_buffer),
+        symbol_buffer,
+        static_cast<uint32_t>(variable_name.length()),
+        variable_name.c_str(),
         &bytes_read2
     );
 
-    if (result != 0) {
+    if (result != 0 || bytes_read2 < sizeof(AdsSymbolEntry)) {
         std::cerr << "[ADS RT] WARNING: Cannot get symbol info for " << variable_name << "\n";
-        var_handle->data_size = 4; // Default: 4 bytes
+        var_handle->data_size = 4; // Default: 4 bytes (DINT)
     } else {
+        AdsSymbolEntry symbol_entry;
+        std::memcpy(&symbol_entry, symbol_buffer, sizeof(symbol_entry));
         var_handle->data_size = symbol_entry.size;
+        var_handle->data_type = symbol_entry.dataType;
+    }
+
+    return register_variable(std::move(var_handle));
+}
+
+bool AdsRealtimeEngine::prepare_variable(VariableHandle* var_handle, uint32_t id) {
+    if (id >= variable_table_.size()) {
+        std::cerr << "[ADS RT] ERROR: max_variables (" << variable_table_.size()
+                  << ") erreicht - " << var_handle->name << " nicht registriert\n";
+        return false;
+    }
+    var_handle->id = id;
+    var_handle->topic = config_.mqtt_topic_prefix + "/" + var_handle->name;
+    var_handle->decoder = ValueDecoder::resolve(var_handle->data_type, var_handle->data_size);
+    
+    // Sum-Up Polling liest jeden Zyklus - nur Änderungen weiterreichen
+    FilterConfig filter = var_handle->filter_config;
+    if (config_.acquisition_mode == AcquisitionMode::SumUpPolling) {
+        filter.on_change = true;
+    }
+    var_handle->filter.configure(filter, var_handle->decoder, var_handle->data_size);
+    
+    // Eintrag vor dem Anlegen der Notification setzen (erste Samples kommen sofort)
+    variable_table_[id] = var_handle;
+    
+    if (var_handle->data_size > Ring::slot_data_size) {
+        std::cerr << "[ADS RT] WARNING: " << var_handle->name << " (" << var_handle->data_size
+                  << " bytes) überschreitet Slot-Größe " << Ring::slot_data_size
+                  << " bytes - Samples werden verworfen\n";
+    }
+    return true;
+}
+
+bool AdsRealtimeEngine::register_variable(std::unique_ptr<VariableHandle> var_handle) {
+    // ID und Topic einmalig vergeben - im Sample-Pfad wird nur noch indiziert
+    uint32_t id = variable_count_.load(std::memory_order_relaxed);
+    if (!prepare_variable(var_handle.get(), id)) {
+        return false;
+    }
+
+    if (config_.acquisition_mode == AcquisitionMode::SumUpPolling) {
+        // Kein Notification Handle - Wert wird zyklisch per Sum-Up Read gelesen
+        std::cout << "[ADS RT] Variable registriert: " << var_handle->name 
+                  << " (" << var_handle->decoder.type_name
+              << ", Size: " << var_handle->data_size << " bytes, "
+                  << "Sum-Up Polling: " << config_.poll_cycle_us << "µs)\n";
+    } else if (!add_notification(var_handle.get())) {
+        variable_table_[id] = nullptr;
+        return false;
+    }
+
+    // Variable speichern und ID freigeben
+    {
+        std::lock_guard<std::mutex> lock(variables_mutex_);
+        variables_[var_handle->handle] = std::move(var_handle);
+    }
+    variable_count_.store(id + 1, std::memory_order_release);
+
+    return true;
+}
+
+size_t AdsRealtimeEngine::add_variables(
+    const std::vector<std::string>& variable_names,
+    NotificationCallback callback) {
+    
+    return add_variables(variable_names, std::move(callback), config_.filter);
+}
+
+size_t AdsRealtimeEngine::add_variables(
+    const std::vector<std::string>& variable_names,
+    NotificationCallback callback,
+    const FilterConfig& filter) {
+    
+    if (!callback) {
+        std::cerr << "[ADS RT] ERROR: Invalid callback\n";
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t registered = 0;
+    
+    for (size_t begin = 0; begin < variable_names.size(); begin += ADS_SUMUP_MAX_ITEMS) {
+        size_t end = std::min(begin + ADS_SUMUP_MAX_ITEMS, variable_names.size());
+        registered += add_variable_batch(variable_names, begin, end, callback, filter);
+    }
+
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "[ADS RT] " << registered << "/" << variable_names.size()
+              << " Variablen registriert (Sum-Up, " << elapsed_ms << "ms)\n";
+
+    return registered;
+}
+
+size_t AdsRealtimeEngine::add_variable_batch(
+    const std::vector<std::string>& variable_names,
+    size_t begin,
+    size_t end,
+    const NotificationCallback& callback,
+    const FilterConfig& filter) {
+    
+    // 1. Handles per Name auflösen (ein Round Trip für den ganzen Block)
+    SumUpReadWriteRequest handle_request;
+    for (size_t i = begin; i < end; i++) {
+        const std::string& name = variable_names[i];
+        handle_request.add(ADSIGRP_SYM_HNDBYNAME, 0, sizeof(uint32_t),
+                           name.data(), static_cast<uint32_t>(name.size()));
+    }
+    handle_request.finalize();
+
+    uint32_t bytes_read = 0;
+    long result = ads_read_write(
+        ADSIGRP_SUMUP_READWRITE,
+        handle_request.count(),
+        handle_request.read_size(),
+        handle_request.read_data(),
+        handle_request.write_size(),
+        handle_request.write_data(),
+        &bytes_read
+    );
+
+    if (result != 0 || !handle_request.parse(bytes_read)) {
+        // Sum-Up nicht unterstützt (alte Runtime) -> Einzelregistrierung
+        std::cerr << "[ADS RT] WARNING: Sum-Up Handle Request fehlgeschlagen (Error: " << result
+                  << ") - Fallback auf Einzelregistrierung\n";
+        size_t registered = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (add_variable(variable_names[i], callback, filter)) {
+                registered++;
+            }
+        }
+        return registered;
+    }
+
+    std::vector<std::unique_ptr<VariableHandle>> resolved;
+    resolved.reserve(end - begin);
+    for (size_t i = 0; i < handle_request.count(); i++) {
+        const std::string& name = variable_names[begin + i];
+        if (handle_request.result(i) != 0 || handle_request.returned_length(i) < sizeof(uint32_t)) {
+            std::cerr << "[ADS RT] ERROR: Cannot get handle for " << name 
+                      << " (Error: " << handle_request.result(i) << ")\n";
+            continue;
+        }
+
+        auto var_handle = std::make_unique<VariableHandle>();
+        var_handle->name = name;
+        var_handle->callback = callback;
+        var_handle->filter_config = filter;
+        var_handle->engine = this;
+        std::memcpy(&var_handle->handle, handle_request.value(i), sizeof(uint32_t));
+        resolved.push_back(std::move(var_handle));
     }
 
+    // 2. Symbol-Infos (Größe) für alle aufgelösten Handles in einem Round Trip
+    SumUpReadWriteRequest info_request;
+    for (const auto& var_handle : resolved) {
+        info_request.add(ADSIGRP_SYM_INFOBYNAMEEX, 0, SYMBOL_INFO_READ_LENGTH,
+                         var_handle->name.data(), static_cast<uint32_t>(var_handle->name.size()));
+    }
+    info_request.finalize();
+
+    bytes_read = 0;
+    result = ads_read_write(
+        ADSIGRP_SUMUP_READWRITE,
+        info_request.count(),
+        info_request.read_size(),
+        info_request.read_data(),
+        info_request.write_size(),
+        info_request.write_data(),
+        &bytes_read
+    );
+    bool info_ok = (result == 0 && info_request.parse(bytes_read));
+
+    for (size_t i = 0; i < resolved.size(); i++) {
+        auto& var_handle = resolved[i];
+        if (info_ok && info_request.result(i) == 0 &&
+            info_request.returned_length(i) >= sizeof(AdsSymbolEntry)) {
+            AdsSymbolEntry symbol_entry;
+            std::memcpy(&symbol_entry, info_request.value(i), sizeof(symbol_entry));
+            var_handle->data_size = symbol_entry.size;
+            var_handle->data_type = symbol_entry.dataType;
+        } else {
+            std::cerr << "[ADS RT] WARNING: Cannot get symbol info for " << var_handle->name << "\n";
+            var_handle->data_size = 4; // Default: 4 bytes (DINT)
+        }
+    }
+
+#ifndef _WIN32
+    // AMS/TCP: Notifications ebenfalls blockweise anlegen (TcAdsDll kann Sum-Up
+    // Notifications keinem Callback zuordnen, dort bleibt es bei Einzel-Requests)
+    if (config_.acquisition_mode == AcquisitionMode::Notification) {
+        return register_variables_sumup(resolved);
+    }
+#endif
+
+    // 3. Variablen übernehmen (Notifications einzeln anlegen)
+    size_t registered = 0;
+    for (auto& var_handle : resolved) {
+        if (register_variable(std::move(var_handle))) {
+            registered++;
+        }
+    }
+
+    return registered;
+}
+
+void AdsRealtimeEngine::release_handles() {
+    // Aufrufer hält variables_mutex_
+    std::vector<uint32_t> handles;
+    handles.reserve(variables_.size());
+    for (auto& [handle, var] : variables_) {
+        handles.push_back(var->handle);
+    }
+
+    for (size_t begin = 0; begin < handles.size(); begin += ADS_SUMUP_MAX_ITEMS) {
+        size_t end = std::min(begin + ADS_SUMUP_MAX_ITEMS, handles.size());
+        
+        SumUpWriteRequest request;
+        for (size_t i = begin; i < end; i++) {
+            request.add(ADSIGRP_SYM_RELEASEHND, 0, &handles[i], sizeof(uint32_t));
+        }
+        request.finalize();
+
+        long result = ads_read_write(
+            ADSIGRP_SUMUP_WRITE,
+            request.count(),
+            request.read_size(),
+            request.read_data(),
+            request.write_size(),
+            request.write_data()
+        );
+
+        if (result != 0) {
+            std::cerr << "[ADS RT] WARNING: Handle-Freigabe fehlgeschlagen (Error: " << result << ")\n";
+        }
+    }
+}
+
+bool AdsRealtimeEngine::add_notification(VariableHandle* var_handle) {
     // ADS Device Notification erstellen (HARTE ECHTZEIT)
     AdsNotificationAttrib attrib{};
     attrib.cbLength = var_handle->data_size;
     attrib.nTransMode = ADSTRANS_SERVERCYCLE;  // Bei JEDER Änderung
     attrib.nMaxDelay = 0;  // Keine Verzögerung
-    attrib.nCycleTime = config_.notification_cycle_us / 1000;  // µs -> ms
+    attrib.nCycleTime = config_.notification_cycle_us * 10;  // µs -> 100ns Einheiten
 
-    unsigned long notification_handle = 0;
-    result = AdsSyncAddDeviceNotificationReqEx(
-        ads_port_,
-        &ams_addr_,
-        ADSIGRP_SYM_VALBYHND,
-        var_handle->handle,
-        &attrib,
-        reinterpret_cast<PAdsNotificationFuncEx>(&AdsRealtimeEngine::ads_notification_callback),
-        reinterpret_cast<unsigned long>(var_handle.get()),
-        &notification_handle
-    );
+    uint32_t notification_handle = 0;
+    long result = ads_add_notification(var_handle, attrib, &notification_handle);
 
     if (result != 0) {
-        std::cerr << "[ADS RT] ERROR: Cannot create notification for " << variable_name 
+        std::cerr << "[ADS RT] ERROR: Cannot create notification for " << var_handle->name 
                   << " (Error: " << result << ")\n";
         return false;
     }
 
     var_handle->notification_handle = notification_handle;
 
-    std::cout << "[ADS RT] Variable registriert: " << variable_name 
-              << " (Size: " << var_handle->data_size << " bytes, "
+    std::cout << "[ADS RT] Variable registriert: " << var_handle->name 
+              << " (" << var_handle->decoder.type_name
+                  << ", Size: " << var_handle->data_size << " bytes, "
               << "Cycle: " << config_.notification_cycle_us << "µs)\n";
 
-    // Variable speichern
+    return true;
+}
+
+#ifndef _WIN32
+size_t AdsRealtimeEngine::register_variables_sumup(std::vector<std::unique_ptr<VariableHandle>>& variables) {
+    // IDs fortlaufend ab variable_count() vergeben und Tabelleneinträge setzen, BEVOR
+    // der PLC Notifications schickt; was über max_variables hinausgeht, wird gar nicht erst angelegt
+    uint32_t first = variable_count_.load(std::memory_order_relaxed);
+    size_t capacity = variable_table_.size() - first;
+    if (variables.size() > capacity) {
+        std::cerr << "[ADS RT] ERROR: max_variables (" << variable_table_.size() << ") erreicht - "
+                  << variables.size() - capacity << " Variablen nicht registriert\n";
+        variables.resize(capacity);
+    }
+    for (size_t i = 0; i < variables.size(); i++) {
+        prepare_variable(variables[i].get(), first + static_cast<uint32_t>(i));
+    }
+
+    if (!add_notifications_sumup(variables)) {
+        // Noch keine Notification aktiv - einzeln anlegen, IDs dabei neu vergeben
+        std::fill(variable_table_.begin() + first, variable_table_.begin() + first + variables.size(), nullptr);
+        size_t registered = 0;
+        for (auto& var_handle : variables) {
+            if (register_variable(std::move(var_handle))) {
+                registered++;
+            }
+        }
+        return registered;
+    }
+
+    // Einzelne fehlgeschlagene Einträge nachholen; die IDs dahinter liefern schon
+    // Samples, eine weiterhin fehlende Notification behält daher ihre ID (IDs bleiben dicht)
+    size_t registered = 0;
+    for (const auto& var_handle : variables) {
+        if (var_handle->notification_handle != 0) {
+            std::cout << "[ADS RT] Variable registriert: " << var_handle->name 
+                      << " (" << var_handle->decoder.type_name
+                      << ", Size: " << var_handle->data_size << " bytes, "
+                      << "Cycle: " << config_.notification_cycle_us << "µs)\n";
+            registered++;
+        } else if (add_notification(var_handle.get())) {
+            registered++;
+        } else {
+            std::cerr << "[ADS RT] WARNING: " << var_handle->name << " (ID " << var_handle->id
+                      << ") ohne Notification - liefert keine Samples\n";
+        }
+    }
+
     {
         std::lock_guard<std::mutex> lock(variables_mutex_);
-        variables_[notification_handle] = std::move(var_handle);
+        for (auto& var_handle : variables) {
+            uint32_t handle = var_handle->handle;
+            variables_[handle] = std::move(var_handle);
+        }
     }
+    variable_count_.store(first + static_cast<uint32_t>(variables.size()), std::memory_order_release);
+    return registered;
+}
 
+bool AdsRealtimeEngine::add_notifications_sumup(std::vector<std::unique_ptr<VariableHandle>>& variables) {
+    if (variables.empty()) {
+        return true;
+    }
+
+    SumUpAddNotificationRequest request;
+    for (const auto& var_handle : variables) {
+        request.add(ADSIGRP_SYM_VALBYHND, var_handle->handle,
+                    static_cast<uint32_t>(var_handle->data_size),
+                    ADSTRANS_SERVERCYCLE, 0, config_.notification_cycle_us * 10);
+    }
+    request.finalize();
+
+    long result = ads_read_write(
+        ADSIGRP_SUMUP_ADDDEVNOTE,
+        request.count(),
+        request.read_size(),
+        request.read_data(),
+        request.write_size(),
+        request.write_data()
+    );
+    if (result != 0) {
+        std::cerr << "[ADS RT] WARNING: Sum-Up Notification Request fehlgeschlagen (Error: "
+                  << result << ") - Fallback auf Einzel-Requests\n";
+        return false;
+    }
+
+    // Samples, die vor register_notification() eintreffen, zählt der Client als unbekannt
+    for (size_t i = 0; i < variables.size(); i++) {
+        if (request.result(i) != 0) {
+            continue;
+        }
+        VariableHandle* var_handle = variables[i].get();
+        var_handle->notification_handle = request.notification_handle(i);
+        ams_client_->register_notification(var_handle->notification_handle,
+                                           &AdsRealtimeEngine::ams_notification_callback,
+                                           reinterpret_cast<uintptr_t>(var_handle));
+    }
     return true;
 }
+#endif
+
+void AdsRealtimeEngine::delete_notifications() {
+#ifdef _WIN32
+    for (auto& [handle, var] : variables_) {
+        if (var->notification_handle != 0) {
+            AdsSyncDelDeviceNotificationReqEx(
+                ads_port_,
+                &ams_addr_,
+                var->notification_handle
+            );
+        }
+    }
+#else
+    if (!ams_client_) {
+        return;
+    }
+
+    // Erst lokal austragen (keine Callbacks mehr), dann blockweise per 0xF085 löschen
+    std::vector<uint32_t> handles;
+    handles.reserve(variables_.size());
+    for (auto& [handle, var] : variables_) {
+        if (var->notification_handle != 0) {
+            ams_client_->unregister_notification(var->notification_handle);
+            handles.push_back(var->notification_handle);
+        }
+    }
+
+    for (size_t begin = 0; begin < handles.size(); begin += ADS_SUMUP_MAX_ITEMS) {
+        size_t end = std::min(begin + ADS_SUMUP_MAX_ITEMS, handles.size());
+
+        SumUpDelNotificationRequest request;
+        for (size_t i = begin; i < end; i++) {
+            request.add(handles[i]);
+        }
+        request.finalize();
+
+        long result = ads_read_write(
+            ADSIGRP_SUMUP_DELDEVNOTE,
+            request.count(),
+            request.read_size(),
+            request.read_data(),
+            request.write_size(),
+            request.write_data()
+        );
+        if (result != 0) {
+            std::cerr << "[ADS RT] WARNING: Notification-Löschung fehlgeschlagen (Error: " << result << ")\n";
+        }
+    }
+#endif
+}
 
 void AdsRealtimeEngine::start() {
     if (running_.exchange(true)) {
         return; // Bereits gestartet
     }
 
-    // Thread-Priorität erhöhen (Windows)
-    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    // Dispatcher Thread starten (leert den Notification Ring)
+    dispatch_thread_ = std::thread(&AdsRealtimeEngine::dispatch_loop, this);
+
+    // Thread-Priorität erhöhen (Dispatcher knapp unter IO/Poll Thread)
+    set_thread_priority(dispatch_thread_.native_handle(), config_.priority_boost, config_.rt_priority - 1);
+#ifndef _WIN32
+    // IO Thread des AMS/TCP Clients liefert die Notifications
+    if (ams_client_) {
+        set_thread_priority(ams_client_->io_thread_handle(), 0, config_.rt_priority);
+    }
+#endif
+
+    if (config_.acquisition_mode == AcquisitionMode::SumUpPolling) {
+        build_poll_groups();
+        poll_thread_ = std::thread(&AdsRealtimeEngine::poll_loop, this);
+        set_thread_priority(poll_thread_.native_handle(), THREAD_PRIORITY_TIME_CRITICAL, config_.rt_priority);
+        
+        std::cout << "[ADS RT] Engine gestartet (Sum-Up Polling, " << poll_groups_.size()
+                  << " Requests/Zyklus)\n";
+        return;
+    }
 
     std::cout << "[ADS RT] Engine gestartet (Hard Realtime Mode)\n";
     std::cout << "[ADS RT] Warte auf Notifications...\n";
@@ -182,68 +742,298 @@ void AdsRealtimeEngine::stop() {
         return; // Bereits gestoppt
     }
 
+    // Polling beenden (schreibt nicht mehr in den Ring)
+    if (poll_thread_.joinable()) {
+        poll_thread_.join();
+    }
+    poll_groups_.clear();
+
     // Alle Notifications entfernen
     std::lock_guard<std::mutex> lock(variables_mutex_);
-    for (auto& [handle, var] : variables_) {
-        if (var->notification_handle != 0) {
-            AdsSyncDelDeviceNotificationReqEx(
-                ads_port_,
-                &ams_addr_,
-                var->notification_handle
-            );
-        }
+    delete_notifications();
+
+    // Dispatcher beenden BEVOR die VariableHandles freigegeben werden
+    dispatch_cv_.notify_all();
+    if (dispatch_thread_.joinable()) {
+        dispatch_thread_.join();
     }
+
+    // Symbol-Handles blockweise freigeben (statt N einzelner Requests)
+    release_handles();
+    std::fill(variable_table_.begin(), variable_table_.end(), nullptr);
+    variable_count_.store(0, std::memory_order_release);
     variables_.clear();
 
     std::cout << "[ADS RT] Engine gestoppt\n";
 }
 
+#ifdef _WIN32
 void __stdcall AdsRealtimeEngine::ads_notification_callback(
     const AmsAddr* pAddr,
     const AdsNotificationHeader* pNotification,
     uint32_t hUser) {
     
-    auto* var_handle = reinterpret_cast<VariableHandle*>(hUser);
+    AdsRealtimeEngine* engine = engines_[hUser >> VARIABLE_ID_BITS].load(std::memory_order_acquire);
+    if (!engine) {
+        return;
+    }
+    VariableHandle* var_handle = engine->variable_table_[hUser & ((1u << VARIABLE_ID_BITS) - 1)];
     if (!var_handle) {
         return;
     }
 
-    // Timestamp SOFORT erfassen (minimale Latenz)
-    LARGE_INTEGER qpc_now;
-    QueryPerformanceCounter(&qpc_now);
+    // Nur Header + Sample kopieren - keine Allokation, keine Locks, kein MQTT
+    var_handle->engine->enqueue_sample(
+        var_handle,
+        pNotification->data,
+        pNotification->cbSampleSize,
+        pNotification->nTimeStamp, // ADS-Timestamp (100ns Einheiten)
+        pNotification->hNotification
+    );
+}
+#else
+void AdsRealtimeEngine::ams_notification_callback(
+    uintptr_t user,
+    const AmsTcpClient::Notification& notification) {
+    
+    auto* var_handle = reinterpret_cast<VariableHandle*>(user);
+    
+    // Sample liegt im Empfangspuffer des Clients - direkt in den Ring kopieren
+    var_handle->engine->enqueue_sample(
+        var_handle,
+        notification.data,
+        notification.size,
+        notification.timestamp,
+        notification.notification_handle
+    );
+}
+#endif
 
-    // Notification verarbeiten (in Realtime-Kontext!)
-    const void* data = pNotification + 1; // Data folgt nach Header
+bool AdsRealtimeEngine::enqueue_sample(
+    VariableHandle* var_handle,
+    const void* data,
+    uint32_t size,
+    int64_t ads_timestamp,
+    uint32_t notification_handle) {
     
-    if (var_handle->callback) {
+    // Change-of-Value / Totzone: verworfene Samples belegen keinen Ring-Slot
+    ValueFilter& filter = var_handle->filter;
+    if (!filter.pass(data, size, ads_timestamp)) {
+        samples_filtered_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    NotificationSample sample;
+    sample.user = var_handle->id;
+    sample.notification_handle = notification_handle;   // aus dem Frame: VariableHandle kennt ihn erst nach der Antwort
+    sample.sample_size = size;
+    sample.ads_timestamp = ads_timestamp;
+    sample.receive_timestamp_ns = get_timestamp_ns();
+
+    if (!ring_->try_push(sample, data)) {
+        return false; // Queue voll - Drop wird im Ring gezählt
+    }
+    filter.commit(data, size, ads_timestamp);
+
+    // Dispatcher nur wecken wenn er schläft (notify_one nimmt keinen Lock)
+    if (dispatcher_waiting_.load(std::memory_order_acquire)) {
+        dispatch_cv_.notify_one();
+    }
+    return true;
+}
+
+void AdsRealtimeEngine::build_poll_groups() {
+    std::lock_guard<std::mutex> lock(variables_mutex_);
+    
+    poll_groups_.clear();
+    uint32_t batch_size = config_.sumup_batch_size;
+    if (batch_size == 0 || batch_size > ADS_SUMUP_MAX_ITEMS) {
+        batch_size = ADS_SUMUP_MAX_ITEMS;
+    }
+    
+    for (auto& [handle, var] : variables_) {
+        if (poll_groups_.empty() || poll_groups_.back().variables.size() >= batch_size) {
+            poll_groups_.emplace_back();
+        }
+        PollGroup& group = poll_groups_.back();
+        group.request.add(ADSIGRP_SYM_VALBYHND, var->handle, static_cast<uint32_t>(var->data_size));
+        group.variables.push_back(var.get());
+    }
+    
+    // Request-Puffer einmalig allokieren
+    for (auto& group : poll_groups_) {
+        group.request.finalize();
+    }
+}
+
+void AdsRealtimeEngine::poll_loop() {
+    using clock = std::chrono::steady_clock;
+    const auto cycle = std::chrono::microseconds(config_.poll_cycle_us);
+    auto next_cycle = clock::now();
+    
+    while (running_.load(std::memory_order_acquire)) {
+        // Ein ADS Timestamp pro Zyklus (FILETIME, 100ns seit 1601 - wie Notifications)
+        int64_t ads_timestamp = current_ads_timestamp();
+        
+        for (auto& group : poll_groups_) {
+            poll_group(group, ads_timestamp);
+        }
+        poll_cycles_.fetch_add(1, std::memory_order_relaxed);
+        
+        // Absolute Deadlines (kein Drift); bei Überlauf nächsten Zyklus sofort starten
+        next_cycle += cycle;
+        auto now = clock::now();
+        if (now > next_cycle) {
+            poll_overruns_.fetch_add(1, std::memory_order_relaxed);
+            next_cycle = now;
+            continue;
+        }
+        std::this_thread::sleep_until(next_cycle);
+    }
+}
+
+void AdsRealtimeEngine::poll_group(PollGroup& group, int64_t ads_timestamp) {
+    SumUpReadRequest& request = group.request;
+    
+    long result = ads_read_write(
+        ADSIGRP_SUMUP_READ,
+        request.count(),
+        request.read_size(),
+        request.read_data(),
+        request.write_size(),
+        request.write_data()
+    );
+    
+    if (result != 0) {
+        return; // Ganzer Request fehlgeschlagen - nächster Zyklus
+    }
+    
+    // Nur geänderte Werte weiterreichen - der Filter jeder Variable vergleicht gegen
+    // den zuletzt eingereihten Wert (bei voller Queue versucht der nächste Zyklus erneut)
+    for (size_t i = 0; i < group.variables.size(); i++) {
+        if (request.result(i) != 0) {
+            continue;
+        }
+        enqueue_sample(group.variables[i], request.value(i), request.length(i), ads_timestamp);
+    }
+}
+
+void AdsRealtimeEngine::dispatch_loop() {
+    auto handler = [this](const NotificationSample& sample, const uint8_t* data) {
+        process_notification(sample, data);
+    };
+
+    while (running_.load(std::memory_order_acquire)) {
+        if (ring_->drain(handler) > 0) {
+            continue;
+        }
+
+        // Kurz spinnen bevor geschlafen wird (typisch < 1 Cycle bis zum nächsten Sample)
+        for (int spin = 0; spin < 64 && ring_->empty(); spin++) {
+            std::this_thread::yield();
+        }
+        if (!ring_->empty()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(dispatch_mutex_);
+        dispatcher_waiting_.store(true, std::memory_order_release);
+        if (ring_->empty() && running_.load(std::memory_order_acquire)) {
+            // Timeout als Absicherung gegen verpasste Wakeups
+            dispatch_cv_.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        dispatcher_waiting_.store(false, std::memory_order_release);
+    }
+}
+
+void AdsRealtimeEngine::process_notification(
+    const NotificationSample& sample,
+    const uint8_t* data) {
+    
+    VariableHandle* var_handle = variable_table_[sample.user];
+    
+    if (var_handle && var_handle->callback) {
         var_handle->callback(
-            var_handle->name,
+            var_handle->id,
             data,
-            pNotification->cbSampleSize,
-            pNotification->nTimeStamp // ADS-Timestamp (100ns Einheiten)
+            sample.sample_size,
+            sample.ads_timestamp
         );
     }
+    
+    notifications_dispatched_.fetch_add(1, std::memory_order_relaxed);
+    
+    // Latenz: ADS Callback -> Callback-Verarbeitung abgeschlossen
+    if (config_.enable_latency_tracking) {
+        uint64_t latency_ns = get_timestamp_ns() - sample.receive_timestamp_ns;
+        latency_recorder_->record(latency_ns);
+        
+        if (config_.enable_deadline_monitoring &&
+            latency_ns > uint64_t{config_.max_latency_us} * 1000) {
+            deadline_misses_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 }
 
 uint64_t AdsRealtimeEngine::get_timestamp_ns() const {
+#ifdef _WIN32
     LARGE_INTEGER now;
     QueryPerformanceCounter(&now);
-    return (now.QuadPart * 1000000000ULL) / qpc_frequency_.QuadPart;
+    // Sekunden und Rest getrennt umrechnen (ticks * 1e9 läuft nach ~15 min Uptime über)
+    uint64_t ticks = static_cast<uint64_t>(now.QuadPart);
+    uint64_t freq = static_cast<uint64_t>(qpc_frequency_.QuadPart);
+    return (ticks / freq) * 1000000000ULL + (ticks % freq) * 1000000000ULL / freq;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+bool AdsRealtimeEngine::is_connected() const {
+#ifdef _WIN32
+    return ads_port_ != 0;
+#else
+    return ams_client_ && ams_client_->is_connected();
+#endif
 }
 
 PerformanceStats AdsRealtimeEngine::get_statistics() const {
-    std::lock_guard<std::mutex> lock(stats_mutex_);
+    PerformanceStats stats;
+    stats.ads_connected = is_connected();
+    stats.total_notifications = notifications_dispatched_.load(std::memory_order_relaxed);
+    stats.deadline_misses = deadline_misses_.load(std::memory_order_relaxed);
+    stats.queue_drops = ring_->dropped() + ring_->oversized();
+    stats.queue_depth = ring_->size_approx();
+    stats.poll_cycles = poll_cycles_.load(std::memory_order_relaxed);
+    stats.filtered_samples = samples_filtered_.load(std::memory_order_relaxed);
+    stats.poll_overruns = poll_overruns_.load(std::memory_order_relaxed);
     
-    PerformanceStats stats = stats_;
+    // Shards mergen und Percentile in O(Buckets) bestimmen (kein Sortieren, kein Lock)
+    LatencySnapshot snap = latency_recorder_->snapshot();
+    if (snap.total > 0) {
+        stats.min_latency_us = snap.min_ns / 1000.0;
+        stats.max_latency_us = snap.max_ns / 1000.0;
+        stats.avg_latency_us = snap.mean_ns() / 1000.0;
+        stats.p50_latency_us = snap.percentile_ns(50.0) / 1000.0;
+        stats.p95_latency_us = snap.percentile_ns(95.0) / 1000.0;
+        stats.p99_latency_us = snap.percentile_ns(99.0) / 1000.0;
+        stats.p999_latency_us = snap.percentile_ns(99.9) / 1000.0;
+    }
+    stats.latency_bucket_bounds_us = config_.latency_buckets_us;
+    stats.latency_bucket_counts = snap.bucketize_us(config_.latency_buckets_us);
     
-    // Percentile berechnen
-    if (!latency_samples_.empty()) {
-        auto samples = latency_samples_;
-        std::sort(samples.begin(), samples.end());
-        
-        stats.p50_latency_us = samples[samples.size() / 2];
-        stats.p95_latency_us = samples[samples.size() * 95 / 100];
-        stats.p99_latency_us = samples[samples.size() * 99 / 100];
+    // Throughput seit dem letzten Aufruf
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        uint64_t now_ns = get_timestamp_ns();
+        if (last_stats_time_ns_ != 0 && now_ns > last_stats_time_ns_) {
+            uint64_t delta = stats.total_notifications - last_stats_count_;
+            stats.throughput_hz = static_cast<uint32_t>(
+                delta * 1000000000ULL / (now_ns - last_stats_time_ns_));
+        }
+        last_stats_count_ = stats.total_notifications;
+        last_stats_time_ns_ = now_ns;
     }
     
     return stats;
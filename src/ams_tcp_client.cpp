@@ -0,0 +1,529 @@
+#include "ams_tcp_client.hpp"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace ads_realtime {
+
+// Empfangspuffer: wächst nur wenn ein einzelner Frame größer ist
+static constexpr size_t RX_BUFFER_INITIAL = 1024 * 1024;
+
+// process_frames(): TcpHeader::length über max_frame_length_ -> Verbindung trennen
+static constexpr size_t FRAME_INVALID = SIZE_MAX;
+
+AmsTcpClient::AmsTcpClient() {
+    rx_buffer_.resize(RX_BUFFER_INITIAL);
+}
+
+AmsTcpClient::~AmsTcpClient() {
+    disconnect();
+}
+
+bool AmsTcpClient::connect(const std::string& ip, const std::string& local_net_id, uint16_t tcp_port) {
+    if (connected_.load()) {
+        return true;
+    }
+
+    socket_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (socket_fd_ < 0) {
+        std::cerr << "[AMS] ERROR: socket() failed: " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Kein Nagle - jeder Request geht sofort raus
+    int one = 1;
+    setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(tcp_port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "[AMS] ERROR: Ungültige IP " << ip << "\n";
+        close_socket();
+        return false;
+    }
+
+    // Non-blocking connect mit Timeout
+    if (::connect(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (errno != EINPROGRESS) {
+            std::cerr << "[AMS] ERROR: connect() failed: " << std::strerror(errno) << "\n";
+            close_socket();
+            return false;
+        }
+        pollfd pfd{socket_fd_, POLLOUT, 0};
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (::poll(&pfd, 1, static_cast<int>(timeout_ms_)) != 1 ||
+            getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &len) != 0 || error != 0) {
+            std::cerr << "[AMS] ERROR: Verbindung zu " << ip << ":" << tcp_port
+                      << " fehlgeschlagen: " << std::strerror(error ? error : ETIMEDOUT) << "\n";
+            close_socket();
+            return false;
+        }
+    }
+
+    // Lokale AMS Adresse: explizit oder <lokale IP>.1.1
+    if (local_net_id.empty() || !ams::parse_net_id(local_net_id, local_addr_.netId)) {
+        sockaddr_in local{};
+        socklen_t local_len = sizeof(local);
+        getsockname(socket_fd_, reinterpret_cast<sockaddr*>(&local), &local_len);
+        std::memcpy(local_addr_.netId.b, &local.sin_addr.s_addr, 4);
+        local_addr_.netId.b[4] = 1;
+        local_addr_.netId.b[5] = 1;
+    }
+    local_addr_.port = ams::AMS_DEFAULT_SOURCE_PORT;
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "[AMS] ERROR: epoll/eventfd failed: " << std::strerror(errno) << "\n";
+        close_socket();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = socket_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd_, &ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    rx_size_ = 0;
+    running_.store(true, std::memory_order_release);
+    connected_.store(true, std::memory_order_release);
+    io_thread_ = std::thread(&AmsTcpClient::io_loop, this);
+
+    std::cout << "[AMS] Verbunden mit " << ip << ":" << tcp_port
+              << " (lokale NetId " << ams::to_string(local_addr_.netId) << ")\n";
+    return true;
+}
+
+void AmsTcpClient::disconnect() {
+    if (running_.exchange(false)) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        if (io_thread_.joinable()) {
+            io_thread_.join();
+        }
+    }
+
+    bool was_connected = connected_.exchange(false);
+    fail_pending(ams::ERR_CLIENT_PORTNOTOPEN);
+    close_socket();
+
+    if (was_connected) {
+        std::cout << "[AMS] Getrennt\n";
+    }
+}
+
+void AmsTcpClient::close_socket() {
+    if (socket_fd_ >= 0) { ::close(socket_fd_); socket_fd_ = -1; }
+    if (epoll_fd_ >= 0) { ::close(epoll_fd_); epoll_fd_ = -1; }
+    if (wake_fd_ >= 0) { ::close(wake_fd_); wake_fd_ = -1; }
+}
+
+long AmsTcpClient::read(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                        uint32_t length, void* data, uint32_t* bytes_read) {
+    ams::ReadRequest request{index_group, index_offset, length};
+    PendingRequest pending;
+    pending.read_data = data;
+    pending.read_capacity = length;
+
+    long result = transact(target, ams::Command::Read, &request, sizeof(request), nullptr, 0, pending);
+    if (bytes_read) *bytes_read = pending.bytes_read;
+    return result;
+}
+
+long AmsTcpClient::write(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                         uint32_t length, const void* data) {
+    ams::WriteRequest request{index_group, index_offset, length};
+    PendingRequest pending;
+    return transact(target, ams::Command::Write, &request, sizeof(request), data, length, pending);
+}
+
+long AmsTcpClient::read_write(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                              uint32_t read_length, void* read_data,
+                              uint32_t write_length, const void* write_data,
+                              uint32_t* bytes_read) {
+    ams::ReadWriteRequest request{index_group, index_offset, read_length, write_length};
+    PendingRequest pending;
+    pending.read_data = read_data;
+    pending.read_capacity = read_length;
+
+    long result = transact(target, ams::Command::ReadWrite, &request, sizeof(request),
+                           write_data, write_length, pending);
+    if (bytes_read) *bytes_read = pending.bytes_read;
+    return result;
+}
+
+long AmsTcpClient::add_notification(const AmsAddr& target, uint32_t index_group, uint32_t index_offset,
+                                    const AdsNotificationAttrib& attrib, NotificationFunc func,
+                                    uintptr_t user, uint32_t* notification_handle) {
+    if (!func || !notification_handle) {
+        return ams::ERR_CLIENT_INVALIDPARM;
+    }
+
+    ams::AddNotificationRequest request{};
+    request.index_group = index_group;
+    request.index_offset = index_offset;
+    request.length = attrib.cbLength;
+    request.trans_mode = attrib.nTransMode;
+    request.max_delay = attrib.nMaxDelay;
+    request.cycle_time = attrib.nCycleTime;
+
+    // Samples, die vor der Antwort eintreffen, zählen als notifications_unknown
+    PendingRequest pending;
+    long result = transact(target, ams::Command::AddNotification, &request, sizeof(request),
+                           nullptr, 0, pending);
+    if (result == 0) {
+        *notification_handle = pending.value;
+        register_notification(pending.value, func, user);
+    }
+    return result;
+}
+
+long AmsTcpClient::del_notification(const AmsAddr& target, uint32_t notification_handle) {
+    unregister_notification(notification_handle);
+
+    ams::DelNotificationRequest request{notification_handle};
+    PendingRequest pending;
+    return transact(target, ams::Command::DelNotification, &request, sizeof(request),
+                    nullptr, 0, pending);
+}
+
+void AmsTcpClient::register_notification(uint32_t notification_handle, NotificationFunc func, uintptr_t user) {
+    std::lock_guard<std::mutex> lock(notifications_mutex_);
+    notifications_[notification_handle] = NotificationTarget{func, user};
+}
+
+void AmsTcpClient::unregister_notification(uint32_t notification_handle) {
+    std::lock_guard<std::mutex> lock(notifications_mutex_);
+    notifications_.erase(notification_handle);
+}
+
+long AmsTcpClient::transact(const AmsAddr& target, ams::Command command,
+                            const void* header, uint32_t header_size,
+                            const void* payload, uint32_t payload_size,
+                            PendingRequest& pending) {
+    if (!connected_.load(std::memory_order_acquire)) {
+        return ams::ERR_CLIENT_PORTNOTOPEN;
+    }
+
+    pending.command = command;
+    raise_frame_limit(pending.read_capacity);
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (next_invoke_id_ == 0) next_invoke_id_ = 1;
+        pending.invoke_id = next_invoke_id_++;
+        pending_[pending.invoke_id] = &pending;
+    }
+
+    if (!send_frame(target, command, ams::STATE_FLAGS_REQUEST, pending.invoke_id,
+                    header, header_size, payload, payload_size)) {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_.erase(pending.invoke_id);
+        return ams::ERR_CLIENT_PORTNOTOPEN;
+    }
+
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    bool done = pending_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms_),
+                                     [&pending]() { return pending.done; });
+    if (!done) {
+        // Nach dem Erase schreibt der IO Thread nicht mehr in den Caller-Puffer
+        pending_.erase(pending.invoke_id);
+        return ams::ERR_CLIENT_SYNCTIMEOUT;
+    }
+    return static_cast<long>(pending.result);
+}
+
+void AmsTcpClient::raise_frame_limit(uint32_t read_capacity) {
+    // Antwort auf Read/ReadWrite: AMS Header + ReadResponse + read_capacity
+    uint64_t needed = uint64_t{sizeof(ams::Header)} + sizeof(ams::ReadResponse) + read_capacity;
+    uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(needed, UINT32_MAX));
+    uint32_t current = max_frame_length_.load(std::memory_order_relaxed);
+    while (current < length &&
+           !max_frame_length_.compare_exchange_weak(current, length, std::memory_order_relaxed)) {
+    }
+}
+
+bool AmsTcpClient::send_frame(const AmsAddr& target, ams::Command command, uint16_t state_flags,
+                              uint32_t invoke_id, const void* header, uint32_t header_size,
+                              const void* payload, uint32_t payload_size) {
+    uint32_t data_length = header_size + payload_size;
+
+    ams::TcpHeader tcp_header{0, static_cast<uint32_t>(sizeof(ams::Header)) + data_length};
+    ams::Header ams_header{};
+    ams_header.target_net_id = target.netId;
+    ams_header.target_port = target.port;
+    ams_header.source_net_id = local_addr_.netId;
+    ams_header.source_port = local_addr_.port;
+    ams_header.command_id = static_cast<uint16_t>(command);
+    ams_header.state_flags = state_flags;
+    ams_header.data_length = data_length;
+    ams_header.error_code = 0;
+    ams_header.invoke_id = invoke_id;
+
+    // Scatter/Gather: Header und Nutzdaten ohne Zwischenkopie
+    iovec iov[4];
+    int iov_count = 0;
+    iov[iov_count++] = {&tcp_header, sizeof(tcp_header)};
+    iov[iov_count++] = {&ams_header, sizeof(ams_header)};
+    if (header_size > 0) iov[iov_count++] = {const_cast<void*>(header), header_size};
+    if (payload_size > 0) iov[iov_count++] = {const_cast<void*>(payload), payload_size};
+
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    iovec* current = iov;
+    while (iov_count > 0) {
+        msghdr msg{};
+        msg.msg_iov = current;
+        msg.msg_iovlen = static_cast<size_t>(iov_count);
+
+        ssize_t sent = ::sendmsg(socket_fd_, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                pollfd pfd{socket_fd_, POLLOUT, 0};
+                if (::poll(&pfd, 1, static_cast<int>(timeout_ms_)) <= 0) {
+                    return false;
+                }
+                continue;
+            }
+            return false;
+        }
+
+        // Teilweise gesendet: iovecs weiterschieben
+        size_t remaining = static_cast<size_t>(sent);
+        while (iov_count > 0 && remaining >= current->iov_len) {
+            remaining -= current->iov_len;
+            current++;
+            iov_count--;
+        }
+        if (iov_count > 0) {
+            current->iov_base = static_cast<uint8_t*>(current->iov_base) + remaining;
+            current->iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+void AmsTcpClient::io_loop() {
+    epoll_event events[4];
+
+    while (running_.load(std::memory_order_acquire)) {
+        int count = epoll_wait(epoll_fd_, events, 4, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == wake_fd_) {
+                continue; // disconnect() - Schleifenbedingung prüfen
+            }
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                if (!receive()) {
+                    std::cerr << "[AMS] ERROR: Verbindung verloren\n";
+                    connected_.store(false, std::memory_order_release);
+                    fail_pending(ams::ERR_CLIENT_PORTNOTOPEN);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+bool AmsTcpClient::receive() {
+    for (;;) {
+        if (rx_size_ == rx_buffer_.size()) {
+            // Einzelner Frame größer als der Puffer -> vergrößern, höchstens auf
+            // den größten zulässigen Frame (process_frames() hat die Länge geprüft)
+            size_t limit = sizeof(ams::TcpHeader) + max_frame_length_.load(std::memory_order_relaxed);
+            rx_buffer_.resize(std::min(rx_buffer_.size() * 2, limit));
+        }
+
+        ssize_t received = ::recv(socket_fd_, rx_buffer_.data() + rx_size_,
+                                  rx_buffer_.size() - rx_size_, 0);
+        if (received == 0) {
+            return false; // Gegenstelle hat geschlossen
+        }
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            return false;
+        }
+        rx_size_ += static_cast<size_t>(received);
+
+        size_t consumed = process_frames(rx_buffer_.data(), rx_size_);
+        if (consumed == FRAME_INVALID) {
+            return false;
+        }
+        if (consumed > 0) {
+            std::memmove(rx_buffer_.data(), rx_buffer_.data() + consumed, rx_size_ - consumed);
+            rx_size_ -= consumed;
+        }
+    }
+}
+
+size_t AmsTcpClient::process_frames(const uint8_t* data, size_t size) {
+    size_t offset = 0;
+
+    while (size - offset >= sizeof(ams::TcpHeader)) {
+        ams::TcpHeader tcp_header;
+        std::memcpy(&tcp_header, data + offset, sizeof(tcp_header));
+        uint32_t max_length = max_frame_length_.load(std::memory_order_relaxed);
+        if (tcp_header.length > max_length) {
+            // Kaputter Stream oder fremde Gegenstelle - nicht auf Gigabytes warten
+            std::cerr << "[AMS] ERROR: Ungültige Frame-Länge " << tcp_header.length
+                      << " (max " << max_length << ")\n";
+            return FRAME_INVALID;
+        }
+        size_t frame_size = sizeof(ams::TcpHeader) + tcp_header.length;
+        if (size - offset < frame_size) {
+            break; // Frame unvollständig (receive() vergrößert den Puffer bei Bedarf)
+        }
+
+        if (tcp_header.reserved == 0 && tcp_header.length >= sizeof(ams::Header)) {
+            ams::Header header;
+            std::memcpy(&header, data + offset + sizeof(ams::TcpHeader), sizeof(header));
+            const uint8_t* payload = data + offset + ams::FRAME_HEADER_SIZE;
+            uint32_t payload_size = std::min<uint32_t>(header.data_length,
+                static_cast<uint32_t>(tcp_header.length - sizeof(ams::Header)));
+
+            if (header.state_flags & ams::STATE_FLAG_RESPONSE) {
+                handle_response(header, payload, payload_size);
+            } else if (header.command_id == static_cast<uint16_t>(ams::Command::Notification)) {
+                handle_notification_stream(payload, payload_size);
+            }
+        }
+
+        offset += frame_size;
+    }
+
+    return offset;
+}
+
+void AmsTcpClient::handle_response(const ams::Header& header, const uint8_t* data, uint32_t size) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+
+    auto it = pending_.find(header.invoke_id);
+    if (it == pending_.end()) {
+        return; // Timeout bereits abgelaufen oder unbekannte Invoke-ID
+    }
+    PendingRequest& pending = *it->second;
+    pending_.erase(it);
+
+    if (header.error_code != 0) {
+        pending.result = header.error_code;
+    } else {
+        switch (pending.command) {
+            case ams::Command::Read:
+            case ams::Command::ReadWrite: {
+                ams::ReadResponse response{ams::ERR_CLIENT_SYNCRESINVALID, 0};
+                if (size >= sizeof(response)) {
+                    std::memcpy(&response, data, sizeof(response));
+                }
+                uint32_t available = size >= sizeof(response) ? size - sizeof(response) : 0;
+                uint32_t length = std::min({response.length, available, pending.read_capacity});
+                if (length > 0 && pending.read_data) {
+                    std::memcpy(pending.read_data, data + sizeof(response), length);
+                }
+                pending.bytes_read = length;
+                pending.result = response.result;
+                break;
+            }
+            case ams::Command::AddNotification: {
+                ams::AddNotificationResponse response{ams::ERR_CLIENT_SYNCRESINVALID, 0};
+                if (size >= sizeof(response)) {
+                    std::memcpy(&response, data, sizeof(response));
+                }
+                pending.result = response.result;
+                pending.value = response.notification_handle;
+                break;
+            }
+            default: {
+                ams::WriteResponse response{ams::ERR_CLIENT_SYNCRESINVALID};
+                if (size >= sizeof(response)) {
+                    std::memcpy(&response, data, sizeof(response));
+                }
+                pending.result = response.result;
+                break;
+            }
+        }
+    }
+
+    pending.done = true;
+    pending_cv_.notify_all();
+}
+
+void AmsTcpClient::handle_notification_stream(const uint8_t* data, uint32_t size) {
+    if (size < sizeof(ams::NotificationStreamHeader)) {
+        return;
+    }
+
+    ams::NotificationStreamHeader stream;
+    std::memcpy(&stream, data, sizeof(stream));
+    const uint8_t* pos = data + sizeof(stream);
+    const uint8_t* end = data + size;
+
+    // Ein Lock pro Frame (nicht pro Sample)
+    std::lock_guard<std::mutex> lock(notifications_mutex_);
+
+    for (uint32_t s = 0; s < stream.stamps; s++) {
+        if (end - pos < static_cast<ptrdiff_t>(sizeof(ams::NotificationStampHeader))) {
+            return;
+        }
+        ams::NotificationStampHeader stamp;
+        std::memcpy(&stamp, pos, sizeof(stamp));
+        pos += sizeof(stamp);
+
+        for (uint32_t i = 0; i < stamp.samples; i++) {
+            if (end - pos < static_cast<ptrdiff_t>(sizeof(ams::NotificationSampleHeader))) {
+                return;
+            }
+            ams::NotificationSampleHeader sample;
+            std::memcpy(&sample, pos, sizeof(sample));
+            pos += sizeof(sample);
+            if (end - pos < static_cast<ptrdiff_t>(sample.sample_size)) {
+                return;
+            }
+
+            auto it = notifications_.find(sample.notification_handle);
+            if (it != notifications_.end()) {
+                Notification notification{sample.notification_handle, stamp.timestamp,
+                                           pos, sample.sample_size};
+                it->second.func(it->second.user, notification);
+                notifications_received_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                notifications_unknown_.fetch_add(1, std::memory_order_relaxed);
+            }
+            pos += sample.sample_size;
+        }
+    }
+}
+
+void AmsTcpClient::fail_pending(uint32_t error) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto& [invoke_id, pending] : pending_) {
+        pending->result = error;
+        pending->done = true;
+    }
+    pending_.clear();
+    pending_cv_.notify_all();
+}
+
+} // namespace ads_realtime
@@ -3,12 +3,12 @@
 #define NOMINMAX
 #endif
 
-#ifdef _WIN32
 #include "ads_realtime_engine.hpp"
-#endif
 #include "mqtt_publisher.hpp"
 #include "realtime_config.hpp"
+#include "config_loader.hpp"
 #include <iostream>
+#include <cstring>
 #include <csignal>
 #include <atomic>
 #include <thread>
@@ -46,8 +46,21 @@ int main(int argc, char* argv[]) {
     config.mqtt_port = 1883;
     config.mqtt_qos = 0;
 
+    // config.ini (oder Pfad aus argv[1]) überschreibt die Defaults
+    const char* config_path = argc > 1 ? argv[1] : "config.ini";
+    if (!ConfigLoader::load(config_path, config)) {
+        std::cout << "[CONFIG] " << config_path << " nicht gefunden - verwende Defaults\n";
+    }
+
     std::cout << "[CONFIG] ADS Target: " << config.ads_target_ip << ":" << config.ads_port << "\n";
-    std::cout << "[CONFIG] MQTT Broker: " << config.mqtt_broker << ":" << config.mqtt_port << "\n";
+    if (config.mqtt_publish_mode == MqttPublishMode::Embedded) {
+        std::cout << "[CONFIG] MQTT Broker: eingebettet, " << config.mqtt_listen_address << ":"
+                  << config.mqtt_port << "\n";
+    } else {
+        std::cout << "[CONFIG] MQTT Broker: " << config.mqtt_broker << ":" << config.mqtt_port << "\n";
+        std::cout << "[CONFIG] MQTT Verbindungen: "
+                  << (config.mqtt_connections > 0 ? config.mqtt_connections : config.worker_threads) << "\n";
+    }
     std::cout << "[CONFIG] Notification Cycle: " << config.notification_cycle_us << "µs\n";
     std::cout << "[CONFIG] Max Latency: " << config.max_latency_us << "µs (<1ms)\n\n";
 
@@ -57,20 +70,15 @@ int main(int argc, char* argv[]) {
     SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
     std::cout << "[SYSTEM] Thread-Priorität: TIME_CRITICAL\n";
 #else
-    std::cout << "[SYSTEM] Thread-Priorität: Standard (Linux)\n";
+    std::cout << "[SYSTEM] Thread-Priorität: SCHED_FIFO " << config.rt_priority << " (Engine Threads)\n";
 #endif
 
-#ifdef _WIN32
-    // ADS Engine initialisieren (nur Windows RTSS)
+    // ADS Engine initialisieren (Windows: TcAdsDll, Linux: nativer AMS/TCP Client)
     AdsRealtimeEngine ads_engine(config);
     if (!ads_engine.connect()) {
         std::cerr << "[MAIN] FEHLER: ADS Verbindung fehlgeschlagen!\n";
         return 1;
     }
-#else
-    // Linux: Kein RTSS, verwende Standard-ADS
-    std::cout << "[MAIN] WARNUNG: Linux Build - RTSS nicht verfügbar\n";
-#endif
 
     // MQTT Publisher initialisieren
     MqttPublisher mqtt_publisher(config);
@@ -79,58 +87,69 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-#ifdef _WIN32
-    // Variablen registrieren mit Realtime-Callbacks (nur Windows RTSS)
+    // Variablen registrieren mit Realtime-Callbacks
     std::cout << "\n[MAIN] Registriere Variablen...\n";
 
     // Beispiel: GVL.abc Variable
-    ads_engine.add_variable("GVL.abc", [&mqtt_publisher](
-        const std::string& name,
+    ads_engine.add_variable("GVL.abc", [&ads_engine, &mqtt_publisher](
+        uint32_t variable_id,
         const void* data,
         size_t data_size,
-        uint64_t timestamp_ns
+        uint64_t timestamp
     ) {
-        // Realtime Callback - wird in ADS Notification Thread aufgerufen!
-        // KRITISCH: Minimale Verarbeitung, keine Blockierung!
-        
-        // Wert als INT32 interpretieren (Beispiel)
-        int32_t value = *static_cast<const int32_t*>(data);
-        
-        // MQTT Topic: ads/GVL.abc
-        std::string topic = "ads/" + name;
-        std::string payload = std::to_string(value);
+        // Wird im Dispatcher Thread der Engine aufgerufen (nicht im ADS Router Thread).
+        // Der ADS Callback kopiert nur in die Notification Queue, MQTT blockiert ihn nie.
+        // Keine Heap-Allokation: Topic ist pro ID interniert, Payload geht in einen Pool-Puffer.
+        MqttPublisher::Message* message = mqtt_publisher.acquire_message();
+        if (!message) {
+            return; // Pool erschöpft (gezählt in pool_exhausted)
+        }
         
-        // Zero-Copy publish
-        mqtt_publisher.publish(topic, payload.data(), payload.size());
+        // Decoder wurde bei der Registrierung aus dem PLC Datentyp gewählt
+        // (BOOL/INT/DINT/REAL/LREAL/STRING/Arrays als Text, Strukturen als Hex)
+        const ValueDecoder& decoder = ads_engine.variable_decoder(variable_id);
+        size_t length = 0;
+        if (!decoder.to_text(data, data_size, reinterpret_cast<char*>(message->data),
+                             sizeof(message->data), length) && data_size <= sizeof(message->data)) {
+            // Passt formatiert nicht in den Puffer - Rohbytes publizieren
+            // (ein leerer STRING bleibt eine leere Payload)
+            std::memcpy(message->data, data, data_size);
+            length = data_size;
+        }
+        message->variable_id = variable_id;
+        message->length = static_cast<uint32_t>(length);
+        message->timestamp = timestamp;
         
-        // Optional: Latenz-Tracking
-        // auto now = std::chrono::high_resolution_clock::now();
-        // auto latency_ns = now.time_since_epoch().count() - timestamp_ns;
+        mqtt_publisher.publish(message);
     });
 
     // Weitere Variablen können hier registriert werden
     // ads_engine.add_variable("GVL.temperature", callback);
     // ads_engine.add_variable("GVL.pressure", callback);
 
+    // Topics einmalig internieren (<topic_prefix>/<Name>), danach nur noch Variable-IDs
+    for (uint32_t id = 0; id < ads_engine.variable_count(); id++) {
+        mqtt_publisher.register_topic(id, ads_engine.variable_topic(id));
+    }
+
     // Engine starten
     ads_engine.start();
 
     std::cout << "\n[MAIN] ✅ System läuft - Hard Realtime Mode aktiv\n";
-#else
-    std::cout << "\n[MAIN] ✅ System läuft - Standard Mode (Linux)\n";
-#endif
     std::cout << "[MAIN] Garantierte Latenz: <1ms\n";
     std::cout << "[MAIN] Notification Rate: " << (1000000 / config.notification_cycle_us) << " Hz\n";
     std::cout << "[MAIN] Drücke Ctrl+C zum Beenden...\n\n";
 
-#ifdef _WIN32
-    // Performance Monitor Thread (nur Windows RTSS)
-    std::thread monitor_thread([&ads_engine]() {
+    // Performance Monitor Thread
+    std::thread monitor_thread([&ads_engine, &mqtt_publisher, &config]() {
         while (g_running.load()) {
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+            std::this_thread::sleep_for(std::chrono::milliseconds(config.stats_interval_ms));
             
             auto stats = ads_engine.get_statistics();
             std::cout << "\n[STATS] Performance Report:\n";
+            if (!stats.ads_connected) {
+                std::cout << "  ADS Verbindung: getrennt\n";
+            }
             std::cout << "  Notifications: " << stats.total_notifications << "\n";
             std::cout << "  Deadline Misses: " << stats.deadline_misses << "\n";
             std::cout << "  Min Latency: " << stats.min_latency_us << "µs\n";
@@ -139,13 +158,75 @@ int main(int argc, char* argv[]) {
             std::cout << "  P50: " << stats.p50_latency_us << "µs\n";
             std::cout << "  P95: " << stats.p95_latency_us << "µs\n";
             std::cout << "  P99: " << stats.p99_latency_us << "µs\n";
+            std::cout << "  P99.9: " << stats.p999_latency_us << "µs\n";
             std::cout << "  Throughput: " << stats.throughput_hz << " Hz\n";
+            std::cout << "  Queue Depth: " << stats.queue_depth << "\n";
+            std::cout << "  Queue Drops: " << stats.queue_drops << "\n";
+            if (stats.filtered_samples > 0) {
+                uint64_t offered = stats.filtered_samples + stats.total_notifications;
+                std::cout << "  Filtered: " << stats.filtered_samples << " ("
+                          << (100 * stats.filtered_samples / offered) << "% verworfen)\n";
+            }
+            auto mqtt_stats = mqtt_publisher.get_statistics();
+            std::cout << "  MQTT Pool: " << mqtt_publisher.pool_in_use() << " belegt, "
+                      << mqtt_publisher.pool_exhausted() << " x erschöpft\n";
+            std::cout << "  MQTT Published: " << mqtt_stats.published
+                      << " (Drops Pool/Queue/Offline: " << mqtt_stats.dropped_pool << "/"
+                      << mqtt_stats.dropped_queue << "/" << mqtt_stats.dropped_disconnected
+                      << ", Fehler: " << mqtt_stats.errors << ")\n";
+            if (mqtt_stats.flushes > 0) {
+                std::cout << "  MQTT Flush: " << mqtt_stats.flushes << " Batches, Queue "
+                          << mqtt_stats.queue_depth << ", Latenz P50/P99/Max "
+                          << mqtt_stats.flush_latency_p50_us << "/" << mqtt_stats.flush_latency_p99_us
+                          << "/" << mqtt_stats.flush_latency_max_us << "µs\n";
+            }
+            if (mqtt_stats.acked > 0 || mqtt_stats.inflight > 0) {
+                std::cout << "  MQTT QoS 1: " << mqtt_stats.acked << " bestätigt, "
+                          << mqtt_stats.inflight << " in flight, "
+                          << mqtt_stats.retransmitted << " wiederholt\n";
+            }
+            if (mqtt_stats.topic_alias_hits > 0) {
+                std::cout << "  MQTT Topic Alias: " << mqtt_stats.topic_alias_hits << " PUBLISH ohne Topic\n";
+            }
+            if (mqtt_stats.offline_logged > 0 || mqtt_stats.offline_buffered > 0) {
+                std::cout << "  MQTT Offline-Log: " << mqtt_stats.offline_buffered << " gepuffert, "
+                          << mqtt_stats.offline_logged << " aufgenommen, " << mqtt_stats.offline_replayed
+                          << " nachgesendet, " << mqtt_stats.offline_evicted << " verworfen (Log voll)\n";
+            }
+            if (config.mqtt_publish_mode == MqttPublishMode::Embedded) {
+                std::cout << "  MQTT Broker: " << mqtt_stats.broker_clients << " Clients, "
+                          << mqtt_stats.broker_subscriptions << " Subscriptions, "
+                          << mqtt_stats.broker_retained << " Retained, Fan-out "
+                          << mqtt_stats.broker_delivered << " (langsam verworfen "
+                          << mqtt_stats.broker_dropped_slow << "), von Clients " << mqtt_stats.broker_received << "\n";
+            }
+            if (stats.poll_cycles > 0) {
+                std::cout << "  Poll Cycles: " << stats.poll_cycles
+                          << " (Overruns: " << stats.poll_overruns << ")\n";
+            }
+            std::cout << "  Histogram:";
+            for (size_t i = 0; i < stats.latency_bucket_counts.size(); i++) {
+                if (i < stats.latency_bucket_bounds_us.size()) {
+                    std::cout << " <=" << stats.latency_bucket_bounds_us[i] << "µs:";
+                } else {
+                    std::cout << " >:";
+                }
+                std::cout << stats.latency_bucket_counts[i];
+            }
+            std::cout << "\n";
         }
     });
 
-    // Main Loop - warten auf Shutdown
+    // Main Loop - warten auf Shutdown oder Verbindungsverlust zur PLC
+    // (Exit-Code 1: der Service-Manager startet neu, Registrierung läuft dann komplett neu)
+    int exit_code = 0;
     while (g_running.load()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!ads_engine.is_connected()) {
+            std::cerr << "[MAIN] FEHLER: ADS Verbindung verloren - beende mit Exit-Code 1\n";
+            exit_code = 1;
+            g_running.store(false);
+        }
     }
 
     // Shutdown
@@ -156,16 +237,7 @@ int main(int argc, char* argv[]) {
     if (monitor_thread.joinable()) {
         monitor_thread.join();
     }
-#else
-    // Linux: Kein RTSS Engine
-    while (g_running.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-    
-    std::cout << "\n[MAIN] Fahre System herunter...\n";
-    mqtt_publisher.disconnect();
-#endif
 
     std::cout << "[MAIN] Beendet.\n";
-    return 0;
+    return exit_code;
 }
@@ -0,0 +1,963 @@
+// Eingebetteter MQTT Broker - nur Linux (epoll/eventfd), siehe CMakeLists.txt
+
+#include "mqtt_broker.hpp"
+#include "mqtt_wire.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ads_realtime {
+
+static constexpr int MAX_EVENTS = 256;
+static constexpr int EPOLL_TIMEOUT_MS = 100;
+static constexpr size_t MAX_DRAIN_BATCH = 1024;       // injizierte Nachrichten pro Fan-out Runde
+static constexpr size_t RX_BUFFER_SIZE = 4096;
+static constexpr size_t MAX_PACKET_SIZE = 1024 * 1024;
+static constexpr uint64_t CONNECT_TIMEOUT_NS = 10ull * 1000 * 1000 * 1000;
+static constexpr uint64_t KEEPALIVE_CHECK_NS = 1000ull * 1000 * 1000;
+static constexpr uint16_t MAX_PACKET_ID_WINDOW = 65535;
+
+// CONNACK Return Codes (3.1.1) bzw. Reason Codes (5.0)
+static constexpr uint8_t CONNACK_UNACCEPTABLE_PROTOCOL_311 = 0x01;
+static constexpr uint8_t CONNACK_UNSUPPORTED_PROTOCOL_5 = 0x84;
+static constexpr uint8_t SUBACK_FAILURE = 0x80;
+static constexpr uint8_t SUBACK_TOPIC_FILTER_INVALID_5 = 0x8F;
+static constexpr uint8_t SUBACK_SHARED_NOT_SUPPORTED_5 = 0x9E;
+static constexpr uint8_t UNSUBACK_NO_SUBSCRIPTION_5 = 0x11;
+
+/**
+ * Verbindung eines Clients (nur Broker Thread)
+ */
+struct MqttBroker::Session {
+    int fd = -1;
+    bool connected = false;              // CONNECT angenommen
+    bool closed = false;
+    bool dirty = false;                  // in dirty_ eingetragen
+    bool want_write = false;             // EPOLLOUT registriert
+    uint8_t protocol_level = mqtt_wire::PROTOCOL_LEVEL_311;
+    uint16_t keepalive_s = 0;
+    uint64_t connected_ns = 0;
+    uint64_t last_rx_ns = 0;
+    std::string client_id;
+
+    std::vector<uint8_t> rx;
+    size_t rx_used = 0;
+    std::vector<uint8_t> tx;
+    size_t tx_offset = 0;
+
+    std::vector<std::string> filters;    // für den Abbau beim Trennen
+
+    // QoS 1 an diesen Subscriber: Fenster voll -> PUBLISH wartet (Packet-ID erst beim Senden)
+    struct Held {
+        std::vector<uint8_t> packet;
+        size_t packet_id_offset;
+    };
+    uint16_t next_packet_id = 1;
+    uint32_t inflight = 0;
+    uint32_t window = MAX_PACKET_ID_WINDOW;
+    uint32_t maximum_packet_size = 0;    // MQTT 5, 0 = unbegrenzt
+    std::deque<Held> held;
+    size_t held_bytes = 0;
+
+    size_t unsent() const { return tx.size() - tx_offset; }
+    size_t pending() const { return unsent() + held_bytes; }
+};
+
+static void pin_thread(std::thread& thread, int cpu) {
+    if (cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int result = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+    if (result != 0) {
+        std::cerr << "[BROKER] WARNING: CPU " << cpu << " nicht verfügbar (" << std::strerror(result) << ")\n";
+    }
+}
+
+MqttBroker::MqttBroker(const RealtimeConfig& config, Pool& pool, int cpu)
+    : config_(config),
+      pool_(pool),
+      cpu_(cpu),
+      queue_(pool.capacity()),   // jede Nachricht stammt aus dem Pool -> Queue läuft nie über
+      fanout_latency_(std::make_unique<LatencyRecorder>()) {
+    config_.mqtt_qos = std::min<uint8_t>(config_.mqtt_qos, 1);
+    if (config_.mqtt_broker_max_pending == 0) {
+        config_.mqtt_broker_max_pending = 4 * 1024 * 1024;
+    }
+    scratch_.resize(mqtt_wire::publish_header_size(65535));
+}
+
+MqttBroker::~MqttBroker() {
+    stop();
+}
+
+bool MqttBroker::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "[BROKER] ERROR: socket() fehlgeschlagen (" << errno << ")\n";
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.mqtt_port);
+    const std::string& address = config_.mqtt_listen_address;
+    if (::inet_pton(AF_INET, address.empty() ? "0.0.0.0" : address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "[BROKER] ERROR: Ungültige Listen-Adresse " << address << "\n";
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    socklen_t length = sizeof(addr);
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listen_fd_, SOMAXCONN) != 0 ||
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        std::cerr << "[BROKER] ERROR: Port " << config_.mqtt_port << " nicht verfügbar ("
+                  << std::strerror(errno) << ")\n";
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event listen_event{};
+    listen_event.events = EPOLLIN;
+    listen_event.data.ptr = &listen_fd_;
+    epoll_event wake_event{};
+    wake_event.events = EPOLLIN;
+    wake_event.data.ptr = &wake_fd_;
+    if (epoll_fd_ < 0 || wake_fd_ < 0 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &listen_event) != 0 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &wake_event) != 0) {
+        std::cerr << "[BROKER] ERROR: epoll/eventfd fehlgeschlagen (" << errno << ")\n";
+        if (epoll_fd_ >= 0) ::close(epoll_fd_);
+        if (wake_fd_ >= 0) ::close(wake_fd_);
+        ::close(listen_fd_);
+        epoll_fd_ = wake_fd_ = listen_fd_ = -1;
+        return false;
+    }
+
+    running_.store(true, std::memory_order_release);
+    broker_thread_ = std::thread(&MqttBroker::broker_loop, this);
+    pin_thread(broker_thread_, cpu_);
+
+    std::cout << "[BROKER] Eingebetteter MQTT Broker auf " << (address.empty() ? "0.0.0.0" : address)
+              << ":" << port_ << " (MQTT 3.1.1/5.0, QoS " << static_cast<int>(config_.mqtt_qos)
+              << ", Retain " << (config_.mqtt_retain ? "an" : "aus") << ")\n";
+    return true;
+}
+
+void MqttBroker::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+    (void)ignored;
+    if (broker_thread_.joinable()) {
+        broker_thread_.join();
+    }
+
+    // Nicht mehr verteilte Nachrichten zurück an den Pool
+    Entry entry;
+    while (queue_.try_pop(entry)) {
+        pool_.release(entry.message);
+    }
+    queue_.publish_consumed();
+
+    ::close(epoll_fd_);
+    ::close(wake_fd_);
+    ::close(listen_fd_);
+    epoll_fd_ = wake_fd_ = listen_fd_ = -1;
+    std::cout << "[BROKER] Gestoppt\n";
+}
+
+void MqttBroker::register_topic(uint32_t variable_id, const std::string& topic) {
+    if (variable_id >= topics_.size()) {
+        topics_.resize(variable_id + 1);
+        topic_matches_.resize(variable_id + 1);
+    }
+    topics_[variable_id] = topic.substr(0, 65535);
+    topic_matches_[variable_id].generation = 0;
+}
+
+void MqttBroker::inject(Message* message) {
+    if (!running_.load(std::memory_order_acquire)) {
+        dropped_stopped_.fetch_add(1, std::memory_order_relaxed);
+        pool_.release(message);
+        return;
+    }
+    if (!queue_.try_push(Entry{message, now_ns()})) {
+        dropped_queue_.fetch_add(1, std::memory_order_relaxed);
+        pool_.release(message);
+        return;
+    }
+
+    // Höchstens ein eventfd write() bis der Broker Thread die Queue leert
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void MqttBroker::publish_retained(const std::string& topic, const void* payload, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(payload);
+    {
+        std::lock_guard<std::mutex> lock(retained_mutex_);
+        pending_retained_.emplace_back(topic.substr(0, 65535), std::vector<uint8_t>(bytes, bytes + length));
+    }
+    retained_pending_.store(true, std::memory_order_release);
+
+    // Vor start(): übernimmt der Broker Thread beim Start
+    if (running_.load(std::memory_order_acquire) && !wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+// ============================================================================
+// Broker Thread
+// ============================================================================
+
+void MqttBroker::broker_loop() {
+    std::vector<epoll_event> events(MAX_EVENTS);
+    apply_retained();
+
+    while (running_.load(std::memory_order_acquire)) {
+        int count = ::epoll_wait(epoll_fd_, events.data(), MAX_EVENTS, EPOLL_TIMEOUT_MS);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[BROKER] ERROR: epoll_wait fehlgeschlagen (" << errno << ")\n";
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+            uint32_t flags = events[i].events;
+            if (tag == &listen_fd_) {
+                accept_clients();
+            } else if (tag == &wake_fd_) {
+                drain_injected();
+            } else {
+                Session& session = *static_cast<Session*>(tag);
+                if (session.closed) continue;
+                if (flags & EPOLLIN) {
+                    read_session(session);
+                }
+                if (!session.closed && (flags & (EPOLLERR | EPOLLHUP)) && !(flags & EPOLLIN)) {
+                    close_session(session, "Verbindung getrennt");
+                }
+                if (!session.closed && (flags & EPOLLOUT) && !flush_session(session)) {
+                    close_session(session, "Senden fehlgeschlagen");
+                }
+            }
+        }
+
+        // Antworten (CONNACK, SUBACK, PUBACK, Retained) und Fan-out eingehender PUBLISH
+        flush_sessions();
+
+        uint64_t now = now_ns();
+        if (now - last_keepalive_check_ns_ >= KEEPALIVE_CHECK_NS) {
+            check_keepalive(now);
+            last_keepalive_check_ns_ = now;
+        }
+        reap_sessions();
+    }
+
+    for (auto& entry : sessions_) {
+        close_session(*entry.second, nullptr);
+    }
+    reap_sessions();
+}
+
+void MqttBroker::accept_clients() {
+    for (;;) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                errors_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (sessions_.size() >= config_.mqtt_broker_max_clients) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+            continue;
+        }
+        int nodelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        auto session = std::make_unique<Session>();
+        session->fd = fd;
+        session->rx.resize(RX_BUFFER_SIZE);
+        session->connected_ns = now_ns();
+        session->last_rx_ns = session->connected_ns;
+        session->window = std::min<uint32_t>(std::max<uint32_t>(config_.mqtt_max_inflight, 1), MAX_PACKET_ID_WINDOW);
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = session.get();
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            ::close(fd);
+            continue;
+        }
+        sessions_[fd] = std::move(session);
+        clients_.store(sessions_.size(), std::memory_order_relaxed);
+    }
+}
+
+void MqttBroker::drain_injected() {
+    uint64_t counter = 0;
+    ssize_t ignored = ::read(wake_fd_, &counter, sizeof(counter));
+    (void)ignored;
+
+    // Vor dem Leeren zurücksetzen: später eingereihte Nachrichten wecken erneut
+    wake_pending_.exchange(false, std::memory_order_acq_rel);
+    if (retained_pending_.load(std::memory_order_acquire)) {
+        apply_retained();
+    }
+
+    for (;;) {
+        Entry entry;
+        size_t drained = 0;
+        uint64_t oldest_ns = 0;
+        while (drained < MAX_DRAIN_BATCH && queue_.try_pop(entry)) {
+            Message* message = entry.message;
+            if (oldest_ns == 0) oldest_ns = entry.enqueue_ns;
+            if (message->variable_id < topics_.size() && !topics_[message->variable_id].empty()) {
+                const std::string& topic = topics_[message->variable_id];
+                if (config_.mqtt_retain) {
+                    store_retained(topic, message->data, message->length);
+                }
+                deliver(topic, variable_subscribers(message->variable_id), message->data, message->length,
+                        config_.mqtt_qos);
+                injected_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                errors_.fetch_add(1, std::memory_order_relaxed);   // Variable-ID ohne Topic
+            }
+            pool_.release(message);
+            drained++;
+        }
+        queue_.publish_consumed();
+        if (drained == 0) {
+            return;
+        }
+
+        flush_sessions();
+        fanouts_.fetch_add(1, std::memory_order_relaxed);
+        fanout_latency_->record(now_ns() - oldest_ns);
+        if (drained < MAX_DRAIN_BATCH) {
+            return;
+        }
+    }
+}
+
+void MqttBroker::apply_retained() {
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> pending;
+    {
+        std::lock_guard<std::mutex> lock(retained_mutex_);
+        retained_pending_.store(false, std::memory_order_release);
+        pending.swap(pending_retained_);
+    }
+    for (const auto& [topic, payload] : pending) {
+        if (!topic::valid_name(topic)) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        store_retained(topic, payload.data(), payload.size());
+        subscriptions_.match(topic, matches_);
+        deliver(topic, matches_, payload.data(), payload.size(), config_.mqtt_qos);
+    }
+    if (!pending.empty()) {
+        flush_sessions();
+    }
+}
+
+void MqttBroker::read_session(Session& session) {
+    for (;;) {
+        if (session.rx_used == session.rx.size()) {
+            if (session.rx.size() >= MAX_PACKET_SIZE + mqtt_wire::MAX_FIXED_HEADER) {
+                close_session(session, "Paket zu groß");
+                return;
+            }
+            session.rx.resize(std::min(session.rx.size() * 2, MAX_PACKET_SIZE + mqtt_wire::MAX_FIXED_HEADER));
+        }
+        ssize_t n = ::recv(session.fd, session.rx.data() + session.rx_used,
+                           session.rx.size() - session.rx_used, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (errno == EINTR) continue;
+            close_session(session, errno == ECONNRESET ? nullptr : "Lesefehler");
+            return;
+        }
+        if (n == 0) {
+            close_session(session, nullptr);   // Client hat die Verbindung beendet
+            return;
+        }
+        session.rx_used += static_cast<size_t>(n);
+        session.last_rx_ns = now_ns();
+
+        const uint8_t* data = session.rx.data();
+        size_t offset = 0;
+        while (session.rx_used - offset >= 2) {
+            uint32_t remaining = 0;
+            size_t length_bytes = 0;
+            if (!mqtt_wire::decode_remaining_length(data + offset + 1, session.rx_used - offset - 1,
+                                                    remaining, length_bytes)) {
+                if (session.rx_used - offset - 1 >= 4) {
+                    close_session(session, "ungültige Paketlänge");
+                    return;
+                }
+                break;
+            }
+            if (remaining > MAX_PACKET_SIZE) {
+                close_session(session, "Paket zu groß");
+                return;
+            }
+            size_t total = 1 + length_bytes + remaining;
+            if (session.rx_used - offset < total) break;
+            if (!handle_packet(session, data[offset], data + offset + 1 + length_bytes, remaining)) {
+                if (!session.closed) close_session(session, "Protokollfehler");
+                return;
+            }
+            offset += total;
+        }
+        std::memmove(session.rx.data(), session.rx.data() + offset, session.rx_used - offset);
+        session.rx_used -= offset;
+    }
+}
+
+bool MqttBroker::handle_packet(Session& session, uint8_t header, const uint8_t* body, size_t size) {
+    auto type = static_cast<mqtt_wire::PacketType>(header >> 4);
+    if (!session.connected && type != mqtt_wire::PacketType::Connect) {
+        return false;   // Erstes Paket muss CONNECT sein
+    }
+
+    switch (type) {
+    case mqtt_wire::PacketType::Connect:
+        return !session.connected && handle_connect(session, body, size);
+    case mqtt_wire::PacketType::Publish:
+        return handle_publish(session, header, body, size);
+    case mqtt_wire::PacketType::Puback:
+        if (size < 2) return false;
+        if (session.inflight > 0) {
+            session.inflight--;
+            inflight_.fetch_sub(1, std::memory_order_relaxed);
+            acked_.fetch_add(1, std::memory_order_relaxed);
+        }
+        release_held(session);
+        return true;
+    case mqtt_wire::PacketType::Subscribe:
+        return header == 0x82 && handle_subscribe(session, body, size);
+    case mqtt_wire::PacketType::Unsubscribe:
+        return header == 0xA2 && handle_unsubscribe(session, body, size);
+    case mqtt_wire::PacketType::Pingreq: {
+        static const uint8_t pingresp[2] = {mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Pingresp), 0};
+        queue_packet(session, pingresp, sizeof(pingresp));
+        return true;
+    }
+    case mqtt_wire::PacketType::Disconnect:
+        close_session(session, nullptr);
+        return false;
+    default:
+        return false;   // QoS 2 (PUBREC/PUBREL/PUBCOMP) und AUTH nicht unterstützt
+    }
+}
+
+bool MqttBroker::handle_connect(Session& session, const uint8_t* body, size_t size) {
+    // [00 04 'MQTT'][Level][Flags][Keepalive]{5.0: Properties}[Client-ID]{Will}{User}{Passwort}
+    if (size < 10 || mqtt_wire::decode_u16(body) != 4 || std::memcmp(body + 2, "MQTT", 4) != 0) {
+        return false;
+    }
+    uint8_t level = body[6];
+    uint8_t flags = body[7];
+    session.keepalive_s = mqtt_wire::decode_u16(body + 8);
+
+    if (level != mqtt_wire::PROTOCOL_LEVEL_311 && level != mqtt_wire::PROTOCOL_LEVEL_5) {
+        uint8_t code = level > mqtt_wire::PROTOCOL_LEVEL_5 ? CONNACK_UNSUPPORTED_PROTOCOL_5
+                                                           : CONNACK_UNACCEPTABLE_PROTOCOL_311;
+        uint8_t connack[4] = {mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Connack), 2, 0, code};
+        queue_packet(session, connack, sizeof(connack));
+        flush_session(session);
+        close_session(session, "Protokollversion nicht unterstützt");
+        return false;
+    }
+    session.protocol_level = level;
+
+    const uint8_t* p = body + 10;
+    const uint8_t* end = body + size;
+    if (level >= mqtt_wire::PROTOCOL_LEVEL_5) {
+        size_t used = mqtt_wire::parse_properties(p, static_cast<size_t>(end - p),
+            [&](mqtt_wire::Property id, const uint8_t* value, size_t) {
+                if (id == mqtt_wire::Property::ReceiveMaximum) {
+                    session.window = std::min<uint32_t>(session.window, mqtt_wire::decode_u16(value));
+                    return session.window > 0;
+                }
+                if (id == mqtt_wire::Property::MaximumPacketSize) {
+                    session.maximum_packet_size = (static_cast<uint32_t>(mqtt_wire::decode_u16(value)) << 16) |
+                                                  mqtt_wire::decode_u16(value + 2);
+                }
+                return true;
+            });
+        if (used == 0) return false;
+        p += used;
+    }
+
+    if (end - p < 2 || end - p < 2 + mqtt_wire::decode_u16(p)) return false;
+    session.client_id.assign(reinterpret_cast<const char*>(p + 2), mqtt_wire::decode_u16(p));
+    // Will, Username und Passwort werden nicht ausgewertet (kein Will, keine Authentifizierung)
+
+    bool assigned = session.client_id.empty();
+    if (assigned) {
+        session.client_id = "bridge-" + std::to_string(session.fd) + "-" + std::to_string(session.connected_ns);
+    }
+    (void)flags;
+
+    // Gleiche Client-ID: ältere Verbindung wird übernommen (MQTT 3.1.4-2)
+    auto existing = client_ids_.find(session.client_id);
+    if (existing != client_ids_.end() && existing->second != &session) {
+        close_session(*existing->second, "Client-ID übernommen");
+    }
+    client_ids_[session.client_id] = &session;
+    session.connected = true;
+
+    // CONNACK: Session Present = 0 (immer clean); 5.0: Maximum QoS 1, keine Shared Subscriptions
+    uint8_t connack[64];
+    size_t length = 0;
+    connack[length++] = mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Connack);
+    connack[length++] = 0;   // Remaining Length, unten gesetzt
+    connack[length++] = 0;
+    connack[length++] = 0;
+    if (level >= mqtt_wire::PROTOCOL_LEVEL_5) {
+        size_t properties_at = length++;
+        connack[length++] = static_cast<uint8_t>(mqtt_wire::Property::MaximumQos);
+        connack[length++] = 1;
+        connack[length++] = static_cast<uint8_t>(mqtt_wire::Property::SubIdAvailable);
+        connack[length++] = 0;
+        connack[length++] = static_cast<uint8_t>(mqtt_wire::Property::SharedSubAvailable);
+        connack[length++] = 0;
+        if (assigned && session.client_id.size() <= sizeof(connack) - length - 3) {
+            connack[length++] = static_cast<uint8_t>(mqtt_wire::Property::AssignedClientId);
+            length += mqtt_wire::encode_string(session.client_id, connack + length);
+        }
+        connack[properties_at] = static_cast<uint8_t>(length - properties_at - 1);
+    }
+    connack[1] = static_cast<uint8_t>(length - 2);
+    queue_packet(session, connack, length);
+    return true;
+}
+
+bool MqttBroker::handle_publish(Session& session, uint8_t header, const uint8_t* body, size_t size) {
+    uint8_t qos = (header >> 1) & 0x03;
+    bool retain = (header & 0x01) != 0;
+    if (qos > 1) return false;   // QoS 2 nicht unterstützt (5.0: Maximum QoS 1 im CONNACK)
+
+    if (size < 2 || size < 2u + mqtt_wire::decode_u16(body)) return false;
+    std::string_view topic(reinterpret_cast<const char*>(body + 2), mqtt_wire::decode_u16(body));
+    const uint8_t* p = body + 2 + topic.size();
+    const uint8_t* end = body + size;
+
+    uint16_t packet_id = 0;
+    if (qos > 0) {
+        if (end - p < 2) return false;
+        packet_id = mqtt_wire::decode_u16(p);
+        p += 2;
+        if (packet_id == 0) return false;
+    }
+    if (session.protocol_level >= mqtt_wire::PROTOCOL_LEVEL_5) {
+        // Topic Alias Maximum = 0 (nicht im CONNACK) -> Topic Alias ist ein Protokollfehler
+        size_t used = mqtt_wire::parse_properties(p, static_cast<size_t>(end - p),
+            [](mqtt_wire::Property id, const uint8_t*, size_t) { return id != mqtt_wire::Property::TopicAlias; });
+        if (used == 0) return false;
+        p += used;
+    }
+    if (!topic::valid_name(topic)) return false;
+
+    const uint8_t* payload = p;
+    size_t length = static_cast<size_t>(end - p);
+    received_.fetch_add(1, std::memory_order_relaxed);
+
+    if (retain) {
+        store_retained(std::string(topic), payload, length);
+    }
+    subscriptions_.match(topic, matches_);
+    deliver(topic, matches_, payload, length, qos);
+
+    if (qos == 1) {
+        uint8_t puback[4] = {mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Puback), 2, 0, 0};
+        mqtt_wire::encode_u16(packet_id, puback + 2);
+        queue_packet(session, puback, sizeof(puback));
+    }
+    return true;
+}
+
+bool MqttBroker::handle_subscribe(Session& session, const uint8_t* body, size_t size) {
+    if (size < 2) return false;
+    uint16_t packet_id = mqtt_wire::decode_u16(body);
+    const uint8_t* p = body + 2;
+    const uint8_t* end = body + size;
+    bool v5 = session.protocol_level >= mqtt_wire::PROTOCOL_LEVEL_5;
+    if (v5) {
+        size_t used = mqtt_wire::parse_properties(p, static_cast<size_t>(end - p),
+            [](mqtt_wire::Property, const uint8_t*, size_t) { return true; });
+        if (used == 0) return false;
+        p += used;
+    }
+
+    struct Granted {
+        std::string filter;
+        uint8_t qos;
+        bool send_retained;
+    };
+    std::vector<Granted> granted;
+    std::vector<uint8_t> codes;
+    while (p < end) {
+        if (end - p < 3 || end - p < 3 + mqtt_wire::decode_u16(p)) return false;
+        std::string filter(reinterpret_cast<const char*>(p + 2), mqtt_wire::decode_u16(p));
+        p += 2 + filter.size();
+        uint8_t options = *p++;
+        uint8_t qos = std::min<uint8_t>(options & 0x03, 1);
+        uint8_t retain_handling = v5 ? (options >> 4) & 0x03 : 0;
+
+        if (filter.compare(0, 7, "$share/") == 0) {
+            codes.push_back(v5 ? SUBACK_SHARED_NOT_SUPPORTED_5 : SUBACK_FAILURE);
+            continue;
+        }
+        if (!topic::valid_filter(filter) || (options & 0x03) == 3) {
+            codes.push_back(v5 ? SUBACK_TOPIC_FILTER_INVALID_5 : SUBACK_FAILURE);
+            continue;
+        }
+
+        bool added = subscriptions_.subscribe(filter, &session, qos);
+        if (added) {
+            session.filters.push_back(filter);
+        }
+        codes.push_back(qos);
+        // 5.0 Retain Handling: 0 = immer, 1 = nur bei neuer Subscription, 2 = nie
+        bool send = retain_handling == 0 || (retain_handling == 1 && added);
+        granted.push_back(Granted{std::move(filter), qos, send});
+    }
+    if (codes.empty()) return false;   // SUBSCRIBE ohne Filter ist ein Protokollfehler
+    subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
+
+    // SUBACK: [Packet-ID]{5.0: Properties}[Return Code pro Filter]
+    uint32_t remaining = static_cast<uint32_t>(2 + (v5 ? 1 : 0) + codes.size());
+    std::vector<uint8_t> suback(1 + mqtt_wire::remaining_length_size(remaining) + remaining);
+    uint8_t* out = suback.data();
+    *out++ = mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Suback);
+    out += mqtt_wire::encode_remaining_length(remaining, out);
+    out += mqtt_wire::encode_u16(packet_id, out);
+    if (v5) *out++ = 0;
+    std::memcpy(out, codes.data(), codes.size());
+    queue_packet(session, suback.data(), suback.size());
+
+    // Retained Messages nach dem SUBACK
+    for (const auto& subscription : granted) {
+        if (subscription.send_retained) {
+            send_retained(session, subscription.filter, subscription.qos);
+        }
+    }
+    return true;
+}
+
+bool MqttBroker::handle_unsubscribe(Session& session, const uint8_t* body, size_t size) {
+    if (size < 2) return false;
+    uint16_t packet_id = mqtt_wire::decode_u16(body);
+    const uint8_t* p = body + 2;
+    const uint8_t* end = body + size;
+    bool v5 = session.protocol_level >= mqtt_wire::PROTOCOL_LEVEL_5;
+    if (v5) {
+        size_t used = mqtt_wire::parse_properties(p, static_cast<size_t>(end - p),
+            [](mqtt_wire::Property, const uint8_t*, size_t) { return true; });
+        if (used == 0) return false;
+        p += used;
+    }
+
+    std::vector<uint8_t> codes;
+    while (p < end) {
+        if (end - p < 2 || end - p < 2 + mqtt_wire::decode_u16(p)) return false;
+        std::string_view filter(reinterpret_cast<const char*>(p + 2), mqtt_wire::decode_u16(p));
+        p += 2 + filter.size();
+        bool removed = subscriptions_.unsubscribe(filter, &session);
+        if (removed) {
+            auto& filters = session.filters;
+            filters.erase(std::find(filters.begin(), filters.end(), filter));
+        }
+        codes.push_back(removed ? 0x00 : UNSUBACK_NO_SUBSCRIPTION_5);
+    }
+    if (codes.empty()) return false;
+    subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
+
+    // UNSUBACK: 3.1.1 nur die Packet-ID, 5.0 zusätzlich Properties + Reason Code pro Filter
+    uint32_t remaining = static_cast<uint32_t>(v5 ? 2 + 1 + codes.size() : 2);
+    std::vector<uint8_t> unsuback(1 + mqtt_wire::remaining_length_size(remaining) + remaining);
+    uint8_t* out = unsuback.data();
+    *out++ = mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Unsuback);
+    out += mqtt_wire::encode_remaining_length(remaining, out);
+    out += mqtt_wire::encode_u16(packet_id, out);
+    if (v5) {
+        *out++ = 0;
+        std::memcpy(out, codes.data(), codes.size());
+    }
+    queue_packet(session, unsuback.data(), unsuback.size());
+    return true;
+}
+
+// ============================================================================
+// Fan-out
+// ============================================================================
+
+const MqttBroker::Subscribers& MqttBroker::variable_subscribers(uint32_t variable_id) {
+    TopicMatches& cached = topic_matches_[variable_id];
+    if (cached.generation != subscriptions_.generation()) {
+        // Erste Nachricht nach SUBSCRIBE/UNSUBSCRIBE/Disconnect: einmal neu auflösen
+        subscriptions_.match(topics_[variable_id], cached.subscribers);
+        cached.generation = subscriptions_.generation();
+    }
+    return cached.subscribers;
+}
+
+void MqttBroker::deliver(std::string_view topic, const Subscribers& subscribers, const uint8_t* payload,
+                         size_t length, uint8_t qos) {
+    for (const auto& subscriber : subscribers) {
+        queue_publish(*subscriber.key, topic, payload, length, std::min(qos, subscriber.qos), false);
+    }
+}
+
+void MqttBroker::send_retained(Session& session, std::string_view filter, uint8_t qos) {
+    for (const auto& retained : retained_) {
+        if (topic::matches(filter, retained.first)) {
+            queue_publish(session, retained.first, retained.second.data(), retained.second.size(), qos, true);
+        }
+    }
+}
+
+void MqttBroker::store_retained(const std::string& topic, const uint8_t* payload, size_t length) {
+    if (length == 0) {
+        retained_.erase(topic);   // Leerer Retained PUBLISH löscht den Wert
+    } else {
+        auto it = retained_.find(topic);
+        if (it == retained_.end()) {
+            it = retained_.emplace(topic, std::vector<uint8_t>()).first;
+        }
+        it->second.assign(payload, payload + length);
+    }
+    retained_count_.store(retained_.size(), std::memory_order_relaxed);
+}
+
+void MqttBroker::queue_publish(Session& session, std::string_view topic, const uint8_t* payload, size_t length,
+                               uint8_t qos, bool retain) {
+    if (session.closed || !session.connected) return;
+
+    size_t header = mqtt_wire::encode_publish_header(scratch_.data(), topic.data(), topic.size(), length, qos,
+                                                     session.next_packet_id, false, session.protocol_level,
+                                                     0, retain);
+    size_t packet = header + length;
+    if (session.pending() + packet > config_.mqtt_broker_max_pending ||
+        (session.maximum_packet_size > 0 && packet > session.maximum_packet_size)) {
+        dropped_slow_.fetch_add(1, std::memory_order_relaxed);   // Subscriber kommt nicht hinterher
+        return;
+    }
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+
+    if (qos > 0 && (session.inflight >= session.window || !session.held.empty())) {
+        // Packet-ID steht vor den Properties (5.0: 1 Byte Länge 0) bzw. direkt vor dem Payload
+        size_t packet_id_offset = header - 2 - (session.protocol_level >= mqtt_wire::PROTOCOL_LEVEL_5 ? 1 : 0);
+        Session::Held held{std::vector<uint8_t>(packet), packet_id_offset};
+        std::memcpy(held.packet.data(), scratch_.data(), header);
+        std::memcpy(held.packet.data() + header, payload, length);
+        session.held_bytes += packet;
+        session.held.push_back(std::move(held));
+        return;
+    }
+
+    if (qos > 0) {
+        session.inflight++;
+        inflight_.fetch_add(1, std::memory_order_relaxed);
+        if (++session.next_packet_id == 0) session.next_packet_id = 1;
+    }
+    size_t offset = session.tx.size();
+    session.tx.resize(offset + packet);
+    std::memcpy(session.tx.data() + offset, scratch_.data(), header);
+    std::memcpy(session.tx.data() + offset + header, payload, length);
+
+    if (!session.dirty) {
+        session.dirty = true;
+        dirty_.push_back(&session);
+    }
+}
+
+void MqttBroker::release_held(Session& session) {
+    while (!session.held.empty() && session.inflight < session.window) {
+        Session::Held& held = session.held.front();
+        mqtt_wire::encode_u16(session.next_packet_id, held.packet.data() + held.packet_id_offset);
+        if (++session.next_packet_id == 0) session.next_packet_id = 1;
+        session.inflight++;
+        inflight_.fetch_add(1, std::memory_order_relaxed);
+
+        session.held_bytes -= held.packet.size();
+        queue_packet(session, held.packet.data(), held.packet.size());
+        session.held.pop_front();
+    }
+}
+
+void MqttBroker::queue_packet(Session& session, const uint8_t* data, size_t size) {
+    if (session.closed) return;
+    session.tx.insert(session.tx.end(), data, data + size);
+    if (!session.dirty) {
+        session.dirty = true;
+        dirty_.push_back(&session);
+    }
+}
+
+void MqttBroker::flush_sessions() {
+    for (Session* session : dirty_) {
+        session->dirty = false;
+        if (!session->closed && !flush_session(*session)) {
+            close_session(*session, "Senden fehlgeschlagen");
+        }
+    }
+    dirty_.clear();
+}
+
+bool MqttBroker::flush_session(Session& session) {
+    while (session.unsent() > 0) {
+        ssize_t n = ::send(session.fd, session.tx.data() + session.tx_offset, session.unsent(),
+                           MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+
+            // Socket voll: Rest beim nächsten EPOLLOUT
+            if (!session.want_write) {
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLOUT;
+                event.data.ptr = &session;
+                ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, session.fd, &event);
+                session.want_write = true;
+            }
+            if (session.tx_offset > session.tx.size() / 2) {
+                session.tx.erase(session.tx.begin(), session.tx.begin() + static_cast<ptrdiff_t>(session.tx_offset));
+                session.tx_offset = 0;
+            }
+            return true;
+        }
+        session.tx_offset += static_cast<size_t>(n);
+        bytes_sent_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+    }
+
+    session.tx.clear();
+    session.tx_offset = 0;
+    if (session.want_write) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = &session;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, session.fd, &event);
+        session.want_write = false;
+    }
+    return true;
+}
+
+void MqttBroker::close_session(Session& session, const char* reason) {
+    if (session.closed) return;
+    session.closed = true;
+
+    for (const auto& filter : session.filters) {
+        subscriptions_.unsubscribe(filter, &session);
+    }
+    session.filters.clear();
+    subscription_count_.store(subscriptions_.size(), std::memory_order_relaxed);
+
+    auto id = client_ids_.find(session.client_id);
+    if (id != client_ids_.end() && id->second == &session) {
+        client_ids_.erase(id);
+    }
+    inflight_.fetch_sub(session.inflight, std::memory_order_relaxed);
+    session.inflight = 0;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, session.fd, nullptr);
+
+    if (reason) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[BROKER] Client " << (session.client_id.empty() ? "(ohne CONNECT)" : session.client_id)
+                  << " getrennt: " << reason << "\n";
+    }
+    // fd und Speicher erst in reap_sessions() - Events dieser Runde zeigen noch auf die Session
+    closing_.push_back(&session);
+}
+
+void MqttBroker::reap_sessions() {
+    for (Session* session : closing_) {
+        int fd = session->fd;
+        sessions_.erase(fd);
+        ::close(fd);
+    }
+    closing_.clear();
+    clients_.store(sessions_.size(), std::memory_order_relaxed);
+}
+
+void MqttBroker::check_keepalive(uint64_t now) {
+    for (auto& entry : sessions_) {
+        Session& session = *entry.second;
+        if (session.closed) continue;
+        if (!session.connected) {
+            if (now - session.connected_ns > CONNECT_TIMEOUT_NS) {
+                close_session(session, "kein CONNECT");
+            }
+            continue;
+        }
+        // MQTT 3.1.2.10: nach 1,5 x Keepalive ohne Paket trennen
+        uint64_t limit_ns = static_cast<uint64_t>(session.keepalive_s) * 1500ull * 1000 * 1000;
+        if (session.keepalive_s > 0 && now - session.last_rx_ns > limit_ns) {
+            close_session(session, "Keepalive abgelaufen");
+        }
+    }
+}
+
+void MqttBroker::add_stats(PublisherStats& stats, LatencySnapshot& fanout_latency) const {
+    stats.published += injected_.load(std::memory_order_relaxed);
+    stats.queue_depth += queue_.size();
+    stats.dropped_queue += dropped_queue_.load(std::memory_order_relaxed);
+    stats.dropped_disconnected += dropped_stopped_.load(std::memory_order_relaxed);
+    stats.errors += errors_.load(std::memory_order_relaxed);
+    stats.flushes += fanouts_.load(std::memory_order_relaxed);
+    stats.bytes_sent += bytes_sent_.load(std::memory_order_relaxed);
+    stats.inflight += inflight_.load(std::memory_order_relaxed);
+    stats.acked += acked_.load(std::memory_order_relaxed);
+    stats.broker_clients += clients_.load(std::memory_order_relaxed);
+    stats.broker_subscriptions += subscription_count_.load(std::memory_order_relaxed);
+    stats.broker_retained += retained_count_.load(std::memory_order_relaxed);
+    stats.broker_received += received_.load(std::memory_order_relaxed);
+    stats.broker_delivered += delivered_.load(std::memory_order_relaxed);
+    stats.broker_dropped_slow += dropped_slow_.load(std::memory_order_relaxed);
+    fanout_latency.merge(fanout_latency_->snapshot());
+}
+
+uint64_t MqttBroker::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace ads_realtime
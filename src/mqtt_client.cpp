@@ -0,0 +1,1169 @@
+// Windows max/min Makro deaktivieren BEVOR andere Headers
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "mqtt_client.hpp"
+#include "mqtt_wire.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace ads_realtime {
+
+#ifdef _WIN32
+using socket_type = SOCKET;
+using io_vector = WSABUF;
+static constexpr int SHUTDOWN_BOTH = SD_BOTH;
+static void close_native_socket(socket_type s) { closesocket(s); }
+static int last_socket_error() { return WSAGetLastError(); }
+static bool is_retryable(int error) { return error == WSAETIMEDOUT || error == WSAEINTR; }
+static void set_io_vector(io_vector& v, const void* data, size_t size) {
+    v.buf = const_cast<char*>(static_cast<const char*>(data));
+    v.len = static_cast<ULONG>(size);
+}
+static size_t io_length(const io_vector& v) { return v.len; }
+static void io_advance(io_vector& v, size_t n) {
+    v.buf += n;
+    v.len -= static_cast<ULONG>(n);
+}
+#else
+using socket_type = int;
+using io_vector = iovec;
+static constexpr int SHUTDOWN_BOTH = SHUT_RDWR;
+static void close_native_socket(socket_type s) { ::close(s); }
+static int last_socket_error() { return errno; }
+static bool is_retryable(int error) { return error == EAGAIN || error == EWOULDBLOCK || error == EINTR; }
+static void set_io_vector(io_vector& v, const void* data, size_t size) {
+    v.iov_base = const_cast<void*>(data);
+    v.iov_len = size;
+}
+static size_t io_length(const io_vector& v) { return v.iov_len; }
+static void io_advance(io_vector& v, size_t n) {
+    v.iov_base = static_cast<uint8_t*>(v.iov_base) + n;
+    v.iov_len -= n;
+}
+#endif
+
+static constexpr std::intptr_t NO_SOCKET = -1;
+static constexpr auto RECONNECT_INTERVAL = std::chrono::seconds(1);
+static constexpr auto SHUTDOWN_ACK_TIMEOUT = std::chrono::seconds(1);
+static constexpr uint32_t CONNECT_TIMEOUT_MS = 5000;
+static constexpr int CONNECT_POLL_SLICE_MS = 100;      // Connect Thread prüft so oft auf disconnect()
+static constexpr size_t MAX_TOPIC_LENGTH = 65535;
+static constexpr size_t MAX_BATCH_MESSAGES = 512;     // 2 Vektoren pro Nachricht, IOV_MAX = 1024
+static constexpr size_t MAX_IO_VECTORS = 2 * MAX_BATCH_MESSAGES;
+static constexpr size_t MAX_INFLIGHT = 32768;         // Packet-ID 1..65535, Fenster als Zweierpotenz
+static constexpr size_t RX_BUFFER_SIZE = 4096;        // PUBACK/PINGRESP/DISCONNECT
+static constexpr uint64_t OFFLINE_SYNC_NS = 1000000000ULL;   // Offline-Log höchstens 1x/s zurückschreiben
+
+/**
+ * Ein Batch = ein writev(): pro Nachricht [PUBLISH Header aus der Arena][Payload im Pool-Puffer]
+ */
+struct MqttClient::Batch {
+    std::vector<uint8_t> headers;       // Header-Arena, pro Batch von vorne belegt
+    size_t header_used = 0;
+    std::vector<io_vector> vectors;
+    size_t vector_count = 0;
+    std::vector<Message*> completed;    // QoS 0: nach dem Schreiben zurück an den Pool
+    std::vector<size_t> completed_end;  // Batch-Bytes bis zum Ende der jeweiligen Nachricht
+    size_t completed_count = 0;
+    size_t bytes = 0;
+    size_t messages = 0;
+    size_t retransmits = 0;
+    uint64_t oldest_enqueue_ns = 0;
+
+    void reset() {
+        header_used = 0;
+        vector_count = 0;
+        completed_count = 0;
+        bytes = 0;
+        messages = 0;
+        retransmits = 0;
+        oldest_enqueue_ns = 0;
+    }
+};
+
+// Thread auf einen Kern festlegen (Shard-Threads konkurrieren nicht um Caches)
+static void pin_thread(std::thread& thread, int cpu) {
+    if (cpu < 0) return;
+#ifdef _WIN32
+    SetThreadAffinityMask(reinterpret_cast<HANDLE>(thread.native_handle()), static_cast<DWORD_PTR>(1) << cpu);
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int result = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+    if (result != 0) {
+        std::cerr << "[MQTT] WARNING: CPU " << cpu << " nicht verfügbar (" << std::strerror(result) << ")\n";
+    }
+#endif
+}
+
+// Alle Vektoren schreiben (Teil-Writes werden fortgesetzt), false bei Socket-Fehler;
+// total = bis dahin geschriebene Bytes
+static bool send_vectors(socket_type s, io_vector* vectors, size_t count, size_t& total) {
+    total = 0;
+    while (count > 0) {
+        size_t chunk = std::min(count, MAX_IO_VECTORS);
+#ifdef _WIN32
+        DWORD sent = 0;
+        if (WSASend(s, vectors, static_cast<DWORD>(chunk), &sent, 0, nullptr, nullptr) != 0) {
+            return false;
+        }
+        size_t written = sent;
+#else
+        msghdr message{};
+        message.msg_iov = vectors;
+        message.msg_iovlen = chunk;
+        ssize_t sent = ::sendmsg(s, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        size_t written = static_cast<size_t>(sent);
+#endif
+        total += written;
+        while (count > 0 && written >= io_length(*vectors)) {
+            written -= io_length(*vectors);
+            vectors++;
+            count--;
+        }
+        if (written > 0) {
+            io_advance(*vectors, written);
+        }
+    }
+    return true;
+}
+
+MqttClient::MqttClient(const RealtimeConfig& config, Pool& pool, int cpu)
+    : config_(config),
+      pool_(pool),
+      cpu_(cpu),
+      queue_(pool.capacity()),   // jede Nachricht stammt aus dem Pool -> Queue läuft nie über
+      batch_(std::make_unique<Batch>()),
+      handshake_(std::make_unique<Handshake>()),
+      flush_latency_(std::make_unique<LatencyRecorder>()) {
+    if (config_.mqtt_flush_bytes == 0) {
+        config_.mqtt_flush_bytes = 64 * 1024;
+    }
+    qos_ = std::min<uint8_t>(config_.mqtt_qos, 1);
+    protocol_level_ = config_.mqtt_protocol_version >= mqtt_wire::PROTOCOL_LEVEL_5
+        ? mqtt_wire::PROTOCOL_LEVEL_5 : mqtt_wire::PROTOCOL_LEVEL_311;
+
+    // Header eines vollen Batches + der größte Einzelheader (Payloads liegen im Pool)
+    batch_->headers.resize(config_.mqtt_flush_bytes + mqtt_wire::publish_header_size(MAX_TOPIC_LENGTH));
+    batch_->vectors.resize(MAX_IO_VECTORS);
+    batch_->completed.resize(MAX_BATCH_MESSAGES);
+    batch_->completed_end.resize(MAX_BATCH_MESSAGES);
+
+    if (qos_ > 0) {
+        size_t limit = std::min<size_t>(std::max<uint32_t>(config_.mqtt_max_inflight, 1), MAX_INFLIGHT);
+        size_t window = 1;
+        while (window < limit) {
+            window <<= 1;
+        }
+        inflight_ = std::make_unique<std::atomic<Message*>[]>(window);
+        for (size_t i = 0; i < window; i++) {
+            inflight_[i].store(nullptr, std::memory_order_relaxed);
+        }
+        inflight_mask_ = window - 1;
+    }
+
+    if (!config_.mqtt_offline_dir.empty()) {
+        std::string path = config_.mqtt_offline_dir + "/" + config_.mqtt_client_id + ".olog";
+        offline_ = std::make_unique<OfflineLog>();
+        replay_limiter_ = ReplayLimiter(config_.mqtt_offline_replay_rate);
+        if (!offline_->open(path, static_cast<size_t>(config_.mqtt_offline_max_mb) * 1024 * 1024)) {
+            std::cerr << "[MQTT] WARNING: Offline-Log " << path << " nicht nutzbar - Ausfälle verwerfen Daten\n";
+            offline_.reset();
+        } else {
+            offline_buffered_.store(offline_->records(), std::memory_order_relaxed);
+            offline_evicted_.store(offline_->evicted(), std::memory_order_relaxed);
+            if (!offline_->empty()) {
+                std::cout << "[MQTT] Offline-Log " << path << ": " << offline_->records()
+                          << " Samples vom letzten Lauf nachzusenden\n";
+            }
+        }
+    }
+#ifdef _WIN32
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+}
+
+MqttClient::~MqttClient() {
+    disconnect();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool MqttClient::connect() {
+    if (running_.load()) {
+        return true;
+    }
+    if (!open_connection(*handshake_, false)) {
+        return false;
+    }
+    activate_connection(*handshake_);
+    running_.store(true, std::memory_order_release);
+    flush_thread_ = std::thread(&MqttClient::flush_loop, this);
+    pin_thread(flush_thread_, cpu_);
+    return true;
+}
+
+void MqttClient::disconnect() {
+    if (running_.exchange(false)) {
+        wake_cv_.notify_one();
+        if (flush_thread_.joinable()) {
+            flush_thread_.join();
+        }
+    }
+
+    // QoS 1: ausstehende PUBACKs kurz abwarten
+    auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_ACK_TIMEOUT;
+    while (connected_.load() && inflight_count_.load() > 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (connected_.load()) {
+        auto packet = mqtt_wire::build_disconnect();
+        send_all(packet.data(), packet.size());
+    }
+    close_connection();
+    release_inflight();
+    if (offline_) {
+        offline_->sync();
+    }
+}
+
+void MqttClient::register_topic(uint32_t variable_id, const std::string& topic) {
+    if (variable_id >= topics_.size()) {
+        topics_.resize(variable_id + 1);
+    }
+    topics_[variable_id] = topic.substr(0, MAX_TOPIC_LENGTH);
+    topic_aliases_.resize(topics_.size(), 0);
+    topic_hashes_.resize(topics_.size(), 0);
+    topic_hashes_[variable_id] = OfflineLog::topic_hash(topics_[variable_id]);
+}
+
+const std::string& MqttClient::topic_of(const Message* message) const {
+    static const std::string empty_topic;
+    uint32_t id = message->variable_id;
+    return id < topics_.size() ? topics_[id] : empty_topic;
+}
+
+/**
+ * Ergebnis eines Verbindungsaufbaus: der Connect Thread liefert Socket + CONNACK,
+ * erst der Flush Thread übernimmt sie (activate_connection)
+ */
+struct MqttClient::Handshake {
+    std::intptr_t socket = NO_SOCKET;
+    mqtt_wire::ConnackInfo connack;
+};
+
+#ifdef _WIN32
+using poll_fd = WSAPOLLFD;
+static int poll_sockets(poll_fd* fds, size_t count, int timeout_ms) {
+    return WSAPoll(fds, static_cast<ULONG>(count), timeout_ms);
+}
+static bool connect_pending(int error) { return error == WSAEWOULDBLOCK; }
+static constexpr int CONNECT_TIMED_OUT = WSAETIMEDOUT;
+static void set_blocking(socket_type s, bool blocking) {
+    u_long mode = blocking ? 0 : 1;
+    ioctlsocket(s, FIONBIO, &mode);
+}
+#else
+using poll_fd = pollfd;
+static int poll_sockets(poll_fd* fds, size_t count, int timeout_ms) {
+    return ::poll(fds, static_cast<nfds_t>(count), timeout_ms);
+}
+static bool connect_pending(int error) { return error == EINPROGRESS; }
+static constexpr int CONNECT_TIMED_OUT = ETIMEDOUT;
+static void set_blocking(socket_type s, bool blocking) {
+    int flags = fcntl(s, F_GETFL, 0);
+    fcntl(s, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+}
+#endif
+
+// Alle Bytes auf einen (blockierenden) Socket schreiben, false bei Socket-Fehler
+static bool send_bytes(socket_type s, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1 << 30));
+        int sent = ::send(s, reinterpret_cast<const char*>(data), chunk, MSG_NOSIGNAL);
+        if (sent <= 0) {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR) continue;
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * Auf Lesbarkeit/Schreibbarkeit warten, höchstens bis deadline
+ * Wartet in Scheiben von CONNECT_POLL_SLICE_MS, damit aborted() (disconnect) schnell greift
+ */
+template <typename Abort>
+static bool wait_socket(socket_type s, short events, std::chrono::steady_clock::time_point deadline,
+                        const Abort& aborted) {
+    while (!aborted()) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            return false;
+        }
+        poll_fd fd{};
+        fd.fd = s;
+        fd.events = events;
+        int result = poll_sockets(&fd, 1, static_cast<int>(std::min<long long>(left, CONNECT_POLL_SLICE_MS)));
+        if (result > 0) {
+            return true;   // auch POLLERR/POLLHUP - der folgende Aufruf liefert den Fehler
+        }
+#ifndef _WIN32
+        if (result < 0 && errno != EINTR) return false;
+#else
+        if (result < 0) return false;
+#endif
+    }
+    return false;
+}
+
+bool MqttClient::open_connection(Handshake& handshake, bool background) {
+    // Connect, CONNECT und CONNACK zusammen höchstens CONNECT_TIMEOUT_MS;
+    // im Connect Thread bricht disconnect() (running_ = false) das Warten ab
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CONNECT_TIMEOUT_MS);
+    auto aborted = [this, background]() {
+        return background && !running_.load(std::memory_order_acquire);
+    };
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* result = nullptr;
+    std::string port = std::to_string(config_.mqtt_port);
+    if (getaddrinfo(config_.mqtt_broker.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+        std::cerr << "[MQTT] ERROR: Broker " << config_.mqtt_broker << " nicht auflösbar\n";
+        return false;
+    }
+
+    // Non-blocking connect + poll (wie AmsTcpClient): ein Broker, der SYNs verwirft,
+    // blockiert sonst bis zum TCP-Timeout des Kernels (Minuten)
+    socket_type s = static_cast<socket_type>(NO_SOCKET);
+    int error = 0;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        s = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (s == static_cast<socket_type>(NO_SOCKET)) continue;
+        set_blocking(s, false);
+        bool connected = ::connect(s, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0;
+        error = connected ? 0 : last_socket_error();
+        if (!connected && connect_pending(error)) {
+            socklen_t length = sizeof(error);
+            error = CONNECT_TIMED_OUT;
+            if (wait_socket(s, POLLOUT, deadline, aborted) &&
+                getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length) != 0) {
+                error = last_socket_error();
+            }
+            connected = error == 0;
+        }
+        if (connected) {
+            set_blocking(s, true);
+            break;
+        }
+        close_native_socket(s);
+        s = static_cast<socket_type>(NO_SOCKET);
+    }
+    freeaddrinfo(result);
+    if (s == static_cast<socket_type>(NO_SOCKET)) {
+        if (!aborted()) {
+            std::cerr << "[MQTT] ERROR: Verbindung zu " << config_.mqtt_broker << ":"
+                      << config_.mqtt_port << " fehlgeschlagen (" << error << ")\n";
+        }
+        return false;
+    }
+
+    // Kein Nagle - Batching macht der Flush Thread selbst
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+
+    // Timeouts für blockierende Sends (Reader: periodisches Aufwachen)
+#ifdef _WIN32
+    DWORD timeout = CONNECT_TIMEOUT_MS;
+#else
+    timeval timeout{CONNECT_TIMEOUT_MS / 1000, (CONNECT_TIMEOUT_MS % 1000) * 1000};
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+    auto connect_packet = mqtt_wire::build_connect(config_.mqtt_client_id, config_.mqtt_keepalive_s,
+                                                   true, protocol_level_);
+    if (!send_bytes(s, connect_packet.data(), connect_packet.size())) {
+        std::cerr << "[MQTT] ERROR: CONNECT konnte nicht gesendet werden\n";
+        close_native_socket(s);
+        return false;
+    }
+
+    // CONNACK: Fixed Header + Remaining Length byteweise, dann Body
+    // (MQTT 5 Properties: Receive Maximum begrenzt das QoS 1 Fenster, Topic Alias Maximum die Aliases)
+    auto receive_exact = [s, deadline, &aborted](uint8_t* data, size_t size) {
+        while (size > 0) {
+            if (!wait_socket(s, POLLIN, deadline, aborted)) return false;
+            int n = ::recv(s, reinterpret_cast<char*>(data), static_cast<int>(size), 0);
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+    uint8_t header[1 + 4];
+    uint32_t remaining = 0;
+    size_t length_bytes = 0;
+    size_t received = 1;
+    bool ok = receive_exact(header, 2);
+    while (ok && !mqtt_wire::decode_remaining_length(header + 1, received, remaining, length_bytes)) {
+        ok = received < 4 && receive_exact(header + 1 + received, 1);
+        received++;
+    }
+    std::vector<uint8_t> body(ok ? remaining : 0);
+    ok = ok && header[0] == mqtt_wire::fixed_header_byte(mqtt_wire::PacketType::Connack) &&
+         remaining <= RX_BUFFER_SIZE && receive_exact(body.data(), body.size());
+    mqtt_wire::ConnackInfo connack;
+    if (!ok || !mqtt_wire::parse_connack(body.data(), body.size(), protocol_level_, connack)) {
+        if (!aborted()) {
+            std::cerr << "[MQTT] ERROR: Kein CONNACK vom Broker\n";
+        }
+        close_native_socket(s);
+        return false;
+    }
+    if (connack.reason_code != 0) {
+        std::cerr << "[MQTT] ERROR: CONNECT abgelehnt (" << (protocol_level_ >= 5 ? "Reason" : "Return")
+                  << " Code " << static_cast<int>(connack.reason_code) << ")\n";
+        close_native_socket(s);
+        return false;
+    }
+
+    handshake.socket = static_cast<std::intptr_t>(s);
+    handshake.connack = connack;
+    return true;
+}
+
+void MqttClient::activate_connection(Handshake& handshake) {
+    const mqtt_wire::ConnackInfo& connack = handshake.connack;
+    socket_ = handshake.socket;
+    handshake.socket = NO_SOCKET;
+
+    // Grenzen des Brokers übernehmen, Topic Aliases gelten nur für diese Verbindung
+    keepalive_s_ = connack.has_server_keepalive ? connack.server_keepalive : config_.mqtt_keepalive_s;
+    receive_maximum_ = connack.receive_maximum > 0 ? connack.receive_maximum : SIZE_MAX;
+    topic_alias_maximum_ = config_.mqtt_topic_alias ? connack.topic_alias_maximum : 0;
+    std::fill(topic_aliases_.begin(), topic_aliases_.end(), 0);
+    next_topic_alias_ = 1;
+
+    uint64_t now = now_ns();
+    last_tx_ns_ = now;
+    last_rx_ns_.store(now, std::memory_order_relaxed);
+    ping_outstanding_.store(false, std::memory_order_relaxed);
+    connected_.store(true, std::memory_order_release);
+    reader_thread_ = std::thread(&MqttClient::reader_loop, this);
+    pin_thread(reader_thread_, cpu_);
+
+    std::cout << "[MQTT] Native Verbindung " << config_.mqtt_client_id << " zu " << config_.mqtt_broker
+              << ":" << config_.mqtt_port << " (MQTT " << (protocol_level_ >= 5 ? "5.0" : "3.1.1") << ", QoS "
+              << static_cast<int>(qos_) << ", Keepalive " << keepalive_s_ << "s, Flush: "
+              << config_.mqtt_flush_interval_us << "µs / " << config_.mqtt_flush_bytes << " Bytes";
+    if (topic_alias_maximum_ > 0) {
+        std::cout << ", Topic Aliases: " << topic_alias_maximum_;
+    }
+    std::cout << ")\n";
+}
+
+void MqttClient::start_reconnect() {
+    close_connection();
+    connecting_.store(true, std::memory_order_release);
+    connect_thread_ = std::thread([this]() {
+        open_connection(*handshake_, true);
+        connecting_.store(false, std::memory_order_release);
+    });
+}
+
+bool MqttClient::finish_reconnect() {
+    connect_thread_.join();
+    if (handshake_->socket == NO_SOCKET) {
+        return false;
+    }
+    activate_connection(*handshake_);
+    retained_pending_.store(true, std::memory_order_release);
+    resend_inflight();
+    if (offline_ && !offline_->empty()) {
+        std::cout << "[MQTT] Offline-Log: " << offline_->records() << " Samples nachzusenden (ab Sequenz "
+                  << offline_->first_sequence() << ", " << config_.mqtt_offline_replay_rate << "/s)\n";
+    }
+    return true;
+}
+
+void MqttClient::close_connection() {
+    connected_.store(false, std::memory_order_release);
+    // shutdown() weckt den Reader aus recv(), erst nach dem Join wird der Socket geschlossen
+    if (socket_ != NO_SOCKET) {
+        ::shutdown(static_cast<socket_type>(socket_), SHUTDOWN_BOTH);
+    }
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+    if (socket_ != NO_SOCKET) {
+        close_native_socket(static_cast<socket_type>(socket_));
+        socket_ = NO_SOCKET;
+    }
+}
+
+bool MqttClient::send_all(const uint8_t* data, size_t size) {
+    return send_bytes(static_cast<socket_type>(socket_), data, size);
+}
+
+void MqttClient::enqueue(Message* message) {
+    message->sequenced = false;
+    message->replayed = false;
+    size_t bytes = mqtt_wire::publish_size(topic_of(message).size(), message->length, qos_, protocol_level_);
+
+    // Vor dem Push zählen - der Flush Thread zieht erst nach dem Pop ab (kein Unterlauf)
+    size_t before = pending_bytes_.fetch_add(bytes, std::memory_order_acq_rel);
+    if (!queue_.try_push(Entry{message, now_ns()})) {
+        pending_bytes_.fetch_sub(bytes, std::memory_order_acq_rel);
+        dropped_queue_.fetch_add(1, std::memory_order_relaxed);
+        pool_.release(message);
+        return;
+    }
+
+    // Flush Thread wecken: erste Nachricht (Tick starten) oder Byte-Schwelle erreicht
+    if (flusher_waiting_.load(std::memory_order_acquire) &&
+        (before == 0 || before + bytes >= config_.mqtt_flush_bytes)) {
+        wake_cv_.notify_one();
+    }
+}
+
+void MqttClient::flush_loop() {
+    auto last_reconnect = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_acquire)) {
+        wait_for_batch();
+
+        // Reconnect im Connect Thread: bis zu CONNECT_TIMEOUT_MS ohne Antwort des Brokers
+        // leert der Flush Thread die Queue weiter (Offline-Log bzw. verwerfen)
+        if (!connected_.load(std::memory_order_acquire)) {
+            auto now = std::chrono::steady_clock::now();
+            if (connect_thread_.joinable() && !connecting_.load(std::memory_order_acquire)) {
+                if (!finish_reconnect()) {
+                    last_reconnect = now;
+                }
+            } else if (!connect_thread_.joinable() && now - last_reconnect >= RECONNECT_INTERVAL) {
+                last_reconnect = now;
+                start_reconnect();
+            }
+        }
+
+        if (retained_pending_.load(std::memory_order_acquire) && connected_.load(std::memory_order_acquire)) {
+            send_retained();
+        }
+        if (flush(false)) {
+            wait_for_window();
+        } else if (offline_ && connected_.load(std::memory_order_acquire)) {
+            replay_offline();
+        }
+        keepalive();
+
+        if (offline_dirty_ && now_ns() - offline_synced_ns_ >= OFFLINE_SYNC_NS) {
+            offline_->sync();
+            offline_synced_ns_ = now_ns();
+            offline_dirty_ = false;
+        }
+    }
+
+    // Laufender Verbindungsaufbau bricht nach spätestens CONNECT_POLL_SLICE_MS ab (running_ = false);
+    // war er schon erfolgreich, geht der Rest noch über die neue Verbindung
+    if (connect_thread_.joinable()) {
+        finish_reconnect();
+    }
+
+    // Rest noch senden (QoS 1: solange das Fenster frei wird), dann alle Puffer zurück an den Pool
+    auto deadline = std::chrono::steady_clock::now() + SHUTDOWN_ACK_TIMEOUT;
+    while (flush(true) && std::chrono::steady_clock::now() < deadline) {
+        wait_for_window();
+    }
+    discard_queue();
+}
+
+void MqttClient::wait_for_batch() {
+    using clock = std::chrono::steady_clock;
+
+    // Leerlauf: schlafen bis die erste Nachricht eintrifft (Timeout als Sicherheitsnetz,
+    // QoS 1 ohne Verbindung und ohne Offline-Log: Nachrichten bleiben in der Queue, nur auf Reconnect warten)
+    auto idle = [this]() {
+        return pending_bytes_.load(std::memory_order_acquire) == 0 ||
+               (qos_ > 0 && !offline_ && !connected_.load(std::memory_order_acquire));
+    };
+    if (idle()) {
+        // Offline-Log nachzusenden: im Millisekundentakt aufwachen (Rate begrenzt der Token Bucket)
+        bool replaying = offline_ && !offline_->empty() && connected_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flusher_waiting_.store(true, std::memory_order_release);
+        wake_cv_.wait_for(lock, std::chrono::milliseconds(replaying ? 1 : 10), [this, &idle]() {
+            return !running_.load(std::memory_order_acquire) || !idle();
+        });
+        flusher_waiting_.store(false, std::memory_order_release);
+    }
+
+    // Sammeln: bis zum Tick nach der ersten Nachricht oder bis die Byte-Schwelle erreicht ist
+    auto deadline = clock::now() + std::chrono::microseconds(config_.mqtt_flush_interval_us);
+    auto batch_full = [this]() {
+        return !running_.load(std::memory_order_acquire) ||
+               pending_bytes_.load(std::memory_order_acquire) >= config_.mqtt_flush_bytes;
+    };
+    if (config_.mqtt_flush_interval_us > 0 && !batch_full()) {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        flusher_waiting_.store(true, std::memory_order_release);
+        wake_cv_.wait_until(lock, deadline, batch_full);
+        flusher_waiting_.store(false, std::memory_order_release);
+    }
+}
+
+void MqttClient::wait_for_window() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    flusher_waiting_.store(true, std::memory_order_release);
+    wake_cv_.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+        return !connected_.load(std::memory_order_acquire) ||
+               (inflight_[next_sequence_ & inflight_mask_].load(std::memory_order_acquire) == nullptr &&
+                inflight_count_.load(std::memory_order_acquire) < receive_maximum_);
+    });
+    flusher_waiting_.store(false, std::memory_order_release);
+}
+
+bool MqttClient::flush(bool draining) {
+    bool connected = connected_.load(std::memory_order_acquire);
+    bool window_full = false;
+    size_t consumed = 0;
+
+    Entry entry;
+    for (;;) {
+        // QoS 1 ohne Verbindung: in der Queue lassen (außer beim Beenden bzw. mit Offline-Log)
+        if (qos_ > 0 && !connected && !draining && !offline_) break;
+
+        std::atomic<Message*>* slot = nullptr;
+        if (qos_ > 0 && connected) {
+            slot = &inflight_[next_sequence_ & inflight_mask_];
+            if (slot->load(std::memory_order_acquire) != nullptr ||
+                inflight_count_.load(std::memory_order_acquire) >= receive_maximum_) {
+                window_full = true;   // ältestes PUBACK fehlt noch bzw. Receive Maximum erreicht
+                break;
+            }
+        }
+        if (!queue_.try_pop(entry)) break;
+
+        Message* message = entry.message;
+        const std::string& topic = topic_of(message);
+        consumed += mqtt_wire::publish_size(topic.size(), message->length, qos_, protocol_level_);
+
+        if (!connected) {
+            log_offline(message);
+            continue;
+        }
+        if (topic.empty()) {
+            errors_.fetch_add(1, std::memory_order_relaxed);   // Variable-ID ohne register_topic()
+            pool_.release(message);
+            continue;
+        }
+
+        uint16_t packet_id = 0;
+        if (slot) {
+            packet_id = static_cast<uint16_t>((next_sequence_ & inflight_mask_) + 1);
+            slot->store(message, std::memory_order_release);
+            inflight_count_.fetch_add(1, std::memory_order_relaxed);
+            next_sequence_++;
+        }
+
+        connected = append(message, topic, packet_id, false, entry.enqueue_ns);
+        if (!connected && qos_ == 0) {
+            log_offline(message);
+        }
+        // QoS 1: bleibt im In-Flight Fenster und wird nach dem Reconnect erneut gesendet
+    }
+
+    if (batch_->messages > 0) {
+        send_batch();
+    }
+
+    queue_.publish_consumed();
+    if (consumed > 0) {
+        pending_bytes_.fetch_sub(consumed, std::memory_order_acq_rel);
+    }
+    return window_full;
+}
+
+void MqttClient::discard_queue() {
+    size_t consumed = 0;
+    Entry entry;
+    while (queue_.try_pop(entry)) {
+        consumed += mqtt_wire::publish_size(topic_of(entry.message).size(), entry.message->length,
+                                            qos_, protocol_level_);
+        log_offline(entry.message);
+    }
+    queue_.publish_consumed();
+    if (consumed > 0) {
+        pending_bytes_.fetch_sub(consumed, std::memory_order_acq_rel);
+    }
+}
+
+bool MqttClient::fits(const Message* message, const std::string& topic) const {
+    const Batch& batch = *batch_;
+    size_t header_size = mqtt_wire::publish_header_size(topic.size());
+    size_t bytes = mqtt_wire::publish_size(topic.size(), message->length, qos_, protocol_level_);
+    return batch.messages == 0 ||
+           (batch.bytes + bytes <= config_.mqtt_flush_bytes && batch.messages < MAX_BATCH_MESSAGES &&
+            batch.header_used + header_size <= batch.headers.size());
+}
+
+bool MqttClient::append(Message* message, const std::string& topic, uint16_t packet_id, bool dup,
+                        uint64_t enqueue_ns) {
+    Batch& batch = *batch_;
+    if (!fits(message, topic) && !send_batch()) {
+        return false;
+    }
+
+    // MQTT 5: erster PUBLISH der Variable vergibt den Alias (mit Topic), danach nur Alias
+    uint16_t alias = 0;
+    size_t topic_length = topic.size();
+    if (topic_alias_maximum_ > 0) {
+        uint16_t& assigned = topic_aliases_[message->variable_id];
+        if (assigned != 0) {
+            alias = assigned;
+            topic_length = 0;
+            topic_alias_hits_.fetch_add(1, std::memory_order_relaxed);
+        } else if (next_topic_alias_ <= topic_alias_maximum_) {
+            assigned = alias = static_cast<uint16_t>(next_topic_alias_++);
+        }
+    }
+
+    // Header in die Arena, Payload direkt aus dem Pool-Puffer (MQTT 5: mit Sequenznummer)
+    assign_sequence(message);
+    uint8_t* header = batch.headers.data() + batch.header_used;
+    size_t header_length = mqtt_wire::encode_publish_header(header, topic.data(), topic_length, message->length,
+                                                            qos_, packet_id, dup, protocol_level_, alias, false,
+                                                            message->sequence);
+    batch.header_used += header_length;
+    set_io_vector(batch.vectors[batch.vector_count++], header, header_length);
+    if (message->length > 0) {
+        set_io_vector(batch.vectors[batch.vector_count++], message->data, message->length);
+    }
+
+    batch.bytes += header_length + message->length;
+    if (qos_ == 0) {
+        batch.completed_end[batch.completed_count] = batch.bytes;
+        batch.completed[batch.completed_count++] = message;
+    }
+    if (dup) {
+        batch.retransmits++;
+    }
+    batch.messages++;
+    if (batch.oldest_enqueue_ns == 0) {
+        batch.oldest_enqueue_ns = enqueue_ns;
+    }
+    return true;
+}
+
+bool MqttClient::send_batch() {
+    Batch& batch = *batch_;
+    size_t written = 0;
+    bool ok = send_vectors(static_cast<socket_type>(socket_), batch.vectors.data(), batch.vector_count, written);
+
+    // QoS 0: Payload ist geschrieben - Puffer zurück an den Pool
+    // (Fehler: erst die Nachrichten ab der Abbruchstelle ins Offline-Log bzw. verloren;
+    // nachgesendete stehen noch im Log, replay_offline() setzt dort zurück)
+    for (size_t i = 0; i < batch.completed_count; i++) {
+        if (ok || batch.completed_end[i] <= written || batch.completed[i]->replayed) {
+            pool_.release(batch.completed[i]);
+        } else {
+            log_offline(batch.completed[i]);
+        }
+    }
+
+    if (!ok) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[MQTT] ERROR: Send fehlgeschlagen (" << last_socket_error()
+                  << ") - Verbindung wird neu aufgebaut\n";
+        batch.reset();
+        close_connection();
+        return false;
+    }
+
+    uint64_t now = now_ns();
+    last_tx_ns_ = now;
+    published_.fetch_add(batch.messages - batch.retransmits, std::memory_order_relaxed);
+    retransmitted_.fetch_add(batch.retransmits, std::memory_order_relaxed);
+    bytes_sent_.fetch_add(batch.bytes, std::memory_order_relaxed);
+    flushes_.fetch_add(1, std::memory_order_relaxed);
+    if (batch.oldest_enqueue_ns != 0) {
+        flush_latency_->record(now - batch.oldest_enqueue_ns);
+    }
+    batch.reset();
+    return true;
+}
+
+void MqttClient::publish_retained(const std::string& topic, const void* payload, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(payload);
+    std::string name = topic.substr(0, MAX_TOPIC_LENGTH);
+    {
+        std::lock_guard<std::mutex> lock(retained_mutex_);
+        auto it = std::find_if(retained_.begin(), retained_.end(),
+                               [&name](const auto& retained) { return retained.first == name; });
+        if (it == retained_.end()) {
+            retained_.emplace_back(name, std::vector<uint8_t>());
+            it = retained_.end() - 1;
+        }
+        it->second.assign(bytes, bytes + length);
+    }
+    retained_pending_.store(true, std::memory_order_release);
+}
+
+void MqttClient::send_retained() {
+    retained_pending_.store(false, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(retained_mutex_);
+    std::vector<uint8_t> packet;
+    for (const auto& [topic, payload] : retained_) {
+        packet.resize(mqtt_wire::publish_header_size(topic.size()) + payload.size());
+        size_t header = mqtt_wire::encode_publish_header(packet.data(), topic, payload.size(), 0, 0, false,
+                                                         protocol_level_, true);
+        if (!payload.empty()) {
+            std::memcpy(packet.data() + header, payload.data(), payload.size());
+        }
+        if (!send_all(packet.data(), header + payload.size())) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[MQTT] ERROR: Retained PUBLISH fehlgeschlagen (" << last_socket_error()
+                      << ") - Verbindung wird neu aufgebaut\n";
+            close_connection();   // Reconnect sendet alle Retained Nachrichten erneut
+            return;
+        }
+        published_.fetch_add(1, std::memory_order_relaxed);
+        bytes_sent_.fetch_add(header + payload.size(), std::memory_order_relaxed);
+    }
+    last_tx_ns_ = now_ns();
+}
+
+bool MqttClient::resend_inflight() {
+    if (qos_ == 0 || inflight_count_.load(std::memory_order_acquire) == 0) {
+        return true;
+    }
+
+    // Ältester Slot zuerst: der nächste zu belegende Slot ist der am längsten belegte
+    size_t resent = 0;
+    for (size_t i = 0; i <= inflight_mask_; i++) {
+        size_t index = static_cast<size_t>((next_sequence_ + i) & inflight_mask_);
+        Message* message = inflight_[index].load(std::memory_order_acquire);
+        if (!message) continue;
+        if (!append(message, topic_of(message), static_cast<uint16_t>(index + 1), true, 0)) {
+            return false;
+        }
+        resent++;
+    }
+    if (!send_batch()) {
+        return false;
+    }
+    std::cout << "[MQTT] " << resent << " unbestätigte Nachrichten erneut gesendet (DUP)\n";
+    return true;
+}
+
+void MqttClient::assign_sequence(Message* message) {
+    if (!message->sequenced) {
+        message->sequence = offline_ ? offline_->take_sequence() : next_publish_sequence_++;
+        message->sequenced = true;
+    }
+}
+
+void MqttClient::log_offline(Message* message) {
+    uint32_t id = message->variable_id;
+    assign_sequence(message);
+    if (offline_ && id < topic_hashes_.size() &&
+        offline_->append(message->sequence, id, topic_hashes_[id], message->timestamp, message->data,
+                         message->length)) {
+        offline_logged_.fetch_add(1, std::memory_order_relaxed);
+        offline_buffered_.store(offline_->records(), std::memory_order_relaxed);
+        offline_evicted_.store(offline_->evicted(), std::memory_order_relaxed);
+        offline_dirty_ = true;
+    } else {
+        dropped_disconnected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    pool_.release(message);
+}
+
+void MqttClient::replay_offline() {
+    if (offline_->empty()) {
+        return;
+    }
+
+    // QoS 0 Records bleiben im Log, bis ihr Batch gesendet ist (commit);
+    // schlägt das Senden fehl, geht es beim nächsten Mal ab demselben Record weiter
+    offline_->rewind();
+    size_t budget = replay_limiter_.available(now_ns(), MAX_BATCH_MESSAGES);
+    size_t taken = 0;
+    size_t replayed = 0;
+    bool connected = true;
+    while (taken < budget && offline_->has_unread()) {
+        // Live-Verkehr geht vor: nur mit freiem Pool und höchstens ein Batch pro Durchlauf
+        if (pool_.in_use() >= pool_.capacity() / 2 || batch_->messages >= MAX_BATCH_MESSAGES) {
+            break;
+        }
+        std::atomic<Message*>* slot = nullptr;
+        if (qos_ > 0) {
+            slot = &inflight_[next_sequence_ & inflight_mask_];
+            if (slot->load(std::memory_order_acquire) != nullptr ||
+                inflight_count_.load(std::memory_order_acquire) >= receive_maximum_) {
+                break;
+            }
+        }
+        Message* message = pool_.acquire();
+        if (!message) {
+            break;
+        }
+
+        OfflineLog::Record record;
+        bool valid = offline_->peek(record, message->data, sizeof(message->data)) &&
+                     record.variable_id < topic_hashes_.size() &&
+                     topic_hashes_[record.variable_id] == record.topic_hash;
+        message->variable_id = record.variable_id;
+        message->length = record.length;
+        message->timestamp = record.timestamp;
+        message->sequence = record.sequence;
+        message->sequenced = true;
+        message->replayed = true;
+        if (valid && qos_ == 0 && !fits(message, topic_of(message))) {
+            pool_.release(message);   // Batch voll: Rest im nächsten Durchlauf
+            break;
+        }
+
+        offline_->skip();
+        taken++;
+        if (!valid) {
+            // Variable nach einem Neustart nicht mehr (oder unter anderem Topic) registriert
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            pool_.release(message);
+            continue;
+        }
+
+        uint16_t packet_id = 0;
+        if (slot) {
+            // QoS 1: ab jetzt im In-Flight Fenster (Reconnect sendet erneut, Shutdown loggt neu)
+            packet_id = static_cast<uint16_t>((next_sequence_ & inflight_mask_) + 1);
+            slot->store(message, std::memory_order_release);
+            inflight_count_.fetch_add(1, std::memory_order_relaxed);
+            next_sequence_++;
+            offline_->commit();
+            offline_dirty_ = true;
+        }
+        replayed++;
+
+        connected = append(message, topic_of(message), packet_id, false, 0);
+        if (!connected) {
+            if (qos_ == 0) {
+                pool_.release(message);   // Record bleibt im Log (rewind)
+            }
+            break;
+        }
+    }
+
+    if (connected && batch_->messages > 0) {
+        connected = send_batch();
+    }
+    if (connected) {
+        offline_->commit();
+        offline_dirty_ = true;
+    } else {
+        offline_->rewind();
+        if (qos_ == 0) {
+            replayed = 0;
+        }
+    }
+    replay_limiter_.consume(taken);
+    offline_replayed_.fetch_add(replayed, std::memory_order_relaxed);
+    offline_buffered_.store(offline_->records(), std::memory_order_relaxed);
+    if (replayed > 0 && offline_->empty()) {
+        std::cout << "[MQTT] Offline-Log nachgesendet (insgesamt " << offline_replayed_.load(std::memory_order_relaxed)
+                  << " Samples, " << offline_->evicted() << " wegen vollem Log verworfen)\n";
+    }
+}
+
+void MqttClient::keepalive() {
+    if (keepalive_s_ == 0 || !connected_.load(std::memory_order_acquire)) {
+        return;
+    }
+    uint64_t now = now_ns();
+    uint64_t period_ns = static_cast<uint64_t>(keepalive_s_) * 1000000000ULL;
+
+    if (ping_outstanding_.load(std::memory_order_acquire)) {
+        if (now - ping_sent_ns_ >= period_ns) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[MQTT] ERROR: Kein PINGRESP - Verbindung wird neu aufgebaut\n";
+            close_connection();
+        }
+        return;
+    }
+
+    // Auch bei laufendem QoS 0 Strom pingen, sonst fällt eine tote Verbindung nie auf
+    if (now - last_tx_ns_ >= period_ns ||
+        now - last_rx_ns_.load(std::memory_order_relaxed) >= period_ns) {
+        if (!send_all(mqtt_wire::PINGREQ_PACKET, sizeof(mqtt_wire::PINGREQ_PACKET))) {
+            errors_.fetch_add(1, std::memory_order_relaxed);
+            close_connection();
+            return;
+        }
+        ping_sent_ns_ = now;
+        last_tx_ns_ = now;
+        ping_outstanding_.store(true, std::memory_order_release);
+    }
+}
+
+void MqttClient::reader_loop() {
+    socket_type s = static_cast<socket_type>(socket_);
+    std::vector<uint8_t> buffer(RX_BUFFER_SIZE);
+    size_t used = 0;
+    bool protocol_error = false;
+
+    while (connected_.load(std::memory_order_acquire) && !protocol_error) {
+        int n = ::recv(s, reinterpret_cast<char*>(buffer.data() + used),
+                       static_cast<int>(buffer.size() - used), 0);
+        if (n < 0 && is_retryable(last_socket_error())) continue;
+        if (n <= 0) break;
+        used += static_cast<size_t>(n);
+        last_rx_ns_.store(now_ns(), std::memory_order_relaxed);
+
+        size_t offset = 0;
+        while (used - offset >= 2) {
+            uint32_t remaining = 0;
+            size_t length_bytes = 0;
+            if (!mqtt_wire::decode_remaining_length(buffer.data() + offset + 1, used - offset - 1,
+                                                    remaining, length_bytes)) {
+                protocol_error = used - offset - 1 >= 4;
+                break;
+            }
+            size_t total = 1 + length_bytes + remaining;
+            if (total > buffer.size()) {
+                protocol_error = true;   // Publish-only: größere Pakete sind nicht vorgesehen
+                break;
+            }
+            if (used - offset < total) break;
+            handle_packet(buffer[offset], buffer.data() + offset + 1 + length_bytes, remaining);
+            offset += total;
+        }
+        std::memmove(buffer.data(), buffer.data() + offset, used - offset);
+        used -= offset;
+    }
+
+    // Verbindung vom Broker beendet - der Flush Thread baut sie neu auf
+    if (connected_.exchange(false)) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        std::cerr << "[MQTT] ERROR: Verbindung vom Broker getrennt"
+                  << (protocol_error ? " (ungültiges Paket)" : "") << "\n";
+    }
+    if (flusher_waiting_.load(std::memory_order_acquire)) {
+        wake_cv_.notify_one();
+    }
+}
+
+void MqttClient::handle_packet(uint8_t header, const uint8_t* body, size_t size) {
+    switch (static_cast<mqtt_wire::PacketType>(header >> 4)) {
+    case mqtt_wire::PacketType::Puback: {
+        if (size < 2 || !inflight_) break;
+        uint16_t packet_id = mqtt_wire::decode_u16(body);
+        if (size >= 3 && body[2] >= 0x80) {
+            errors_.fetch_add(1, std::memory_order_relaxed);   // MQTT 5 Reason Code: abgelehnt
+        }
+        if (packet_id == 0 || packet_id - 1u > inflight_mask_) break;
+        Message* message = inflight_[packet_id - 1].exchange(nullptr, std::memory_order_acq_rel);
+        if (message) {
+            pool_.release(message);
+            inflight_count_.fetch_sub(1, std::memory_order_relaxed);
+            acked_.fetch_add(1, std::memory_order_relaxed);
+            if (flusher_waiting_.load(std::memory_order_acquire)) {
+                wake_cv_.notify_one();
+            }
+        }
+        break;
+    }
+    case mqtt_wire::PacketType::Pingresp:
+        ping_outstanding_.store(false, std::memory_order_release);
+        break;
+    case mqtt_wire::PacketType::Disconnect:
+        std::cerr << "[MQTT] Broker DISCONNECT (Reason Code "
+                  << static_cast<int>(size > 0 ? body[0] : 0) << ")\n";
+        break;
+    default:
+        break;
+    }
+}
+
+void MqttClient::release_inflight() {
+    if (!inflight_) {
+        return;
+    }
+    for (size_t i = 0; i <= inflight_mask_; i++) {
+        Message* message = inflight_[i].exchange(nullptr, std::memory_order_acq_rel);
+        if (message) {
+            log_offline(message);   // Ohne PUBACK: beim nächsten Start nachsenden
+        }
+    }
+    inflight_count_.store(0, std::memory_order_relaxed);
+}
+
+void MqttClient::add_stats(PublisherStats& stats, LatencySnapshot& flush_latency) const {
+    stats.published += published_.load(std::memory_order_relaxed);
+    stats.queue_depth += queue_.size();
+    stats.dropped_queue += dropped_queue_.load(std::memory_order_relaxed);
+    stats.dropped_disconnected += dropped_disconnected_.load(std::memory_order_relaxed);
+    stats.errors += errors_.load(std::memory_order_relaxed);
+    stats.flushes += flushes_.load(std::memory_order_relaxed);
+    stats.bytes_sent += bytes_sent_.load(std::memory_order_relaxed);
+    stats.inflight += inflight_count_.load(std::memory_order_relaxed);
+    stats.acked += acked_.load(std::memory_order_relaxed);
+    stats.retransmitted += retransmitted_.load(std::memory_order_relaxed);
+    stats.topic_alias_hits += topic_alias_hits_.load(std::memory_order_relaxed);
+    stats.offline_buffered += offline_buffered_.load(std::memory_order_relaxed);
+    stats.offline_logged += offline_logged_.load(std::memory_order_relaxed);
+    stats.offline_replayed += offline_replayed_.load(std::memory_order_relaxed);
+    stats.offline_evicted += offline_evicted_.load(std::memory_order_relaxed);
+    flush_latency.merge(flush_latency_->snapshot());
+}
+
+uint64_t MqttClient::now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace ads_realtime
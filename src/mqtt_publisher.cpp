@@ -4,7 +4,10 @@
 #endif
 
 #include "mqtt_publisher.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 namespace ads_realtime {
 
@@ -14,12 +17,57 @@ MqttPublisher::MqttPublisher(const RealtimeConfig& config)
     std::string server_address = "tcp://" + config_.mqtt_broker 
                                 + ":" + std::to_string(config_.mqtt_port);
     
-    client_ = std::make_unique<mqtt::async_client>(
-        server_address,
-        "ADS-Realtime-Bridge"
-    );
+    pool_ = std::make_unique<Pool>(config_.message_pool_size);
 
-    std::cout << "[MQTT] Publisher initialisiert: " << server_address << "\n";
+    if (config_.mqtt_publish_mode == MqttPublishMode::Embedded) {
+#ifdef _WIN32
+        std::cerr << "[MQTT] WARNING: Eingebetteter Broker nur unter Linux - verwende native\n";
+        config_.mqtt_publish_mode = MqttPublishMode::Native;
+#else
+        int cpu = config_.pin_to_cores
+            ? static_cast<int>(config_.mqtt_first_cpu % std::max(std::thread::hardware_concurrency(), 1u)) : -1;
+        broker_ = std::make_unique<MqttBroker>(config_, *pool_, cpu);
+        std::cout << "[MQTT] Publisher initialisiert: eingebetteter Broker auf Port " << config_.mqtt_port << "\n";
+        return;
+#endif
+    }
+
+    uint32_t connections = config_.mqtt_connections > 0 ? config_.mqtt_connections : config_.worker_threads;
+    shard_count_ = std::max<uint32_t>(connections, 1);
+    unsigned cpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (size_t i = 0; i < shard_count_; i++) {
+        // Eindeutige Client-ID pro Verbindung, sonst trennt der Broker die ältere
+        RealtimeConfig shard_config = config_;
+        if (shard_count_ > 1) {
+            shard_config.mqtt_client_id += "-" + std::to_string(i);
+        }
+
+        if (config_.mqtt_publish_mode == MqttPublishMode::Native) {
+            int cpu = config_.pin_to_cores ? static_cast<int>((config_.mqtt_first_cpu + i) % cpus) : -1;
+            native_.push_back(std::make_unique<MqttClient>(shard_config, *pool_, cpu));
+        } else {
+            clients_.push_back(std::make_unique<mqtt::async_client>(
+                server_address,
+                shard_config.mqtt_client_id
+            ));
+            if (!config_.mqtt_offline_dir.empty()) {
+                std::string path = config_.mqtt_offline_dir + "/" + shard_config.mqtt_client_id + ".olog";
+                PahoOffline offline;
+                offline.log = std::make_unique<OfflineLog>();
+                offline.limiter = ReplayLimiter(config_.mqtt_offline_replay_rate);
+                if (!offline.log->open(path, static_cast<size_t>(config_.mqtt_offline_max_mb) * 1024 * 1024)) {
+                    std::cerr << "[MQTT] WARNING: Offline-Log " << path << " nicht nutzbar - Ausfälle verwerfen Daten\n";
+                    offline.log.reset();
+                }
+                paho_offline_.push_back(std::move(offline));
+            }
+        }
+    }
+    update_offline_stats();
+
+    std::cout << "[MQTT] Publisher initialisiert: " << server_address
+              << (native_.empty() ? "" : " (native)") << ", " << shard_count_ << " Verbindung(en)\n";
 }
 
 MqttPublisher::~MqttPublisher() {
@@ -27,19 +75,43 @@ MqttPublisher::~MqttPublisher() {
 }
 
 bool MqttPublisher::connect() {
+#ifndef _WIN32
+    if (broker_) {
+        bool ok = broker_->start();
+        connected_.store(ok, std::memory_order_release);
+        return ok;
+    }
+#endif
+    if (!native_.empty()) {
+        for (auto& shard : native_) {
+            if (!shard->connect()) {
+                for (auto& connected : native_) connected->disconnect();
+                return false;
+            }
+        }
+        connected_.store(true, std::memory_order_release);
+        return true;
+    }
+
     try {
         mqtt::connect_options opts;
         opts.set_clean_session(true);
-        opts.set_keep_alive_interval(20);
+        opts.set_keep_alive_interval(config_.mqtt_keepalive_s);
         opts.set_automatic_reconnect(true);
 
-        auto tok = client_->connect(opts);
-        tok->wait();
+        // Alle Verbindungen parallel aufbauen, dann auf alle warten
+        std::vector<mqtt::token_ptr> tokens;
+        for (auto& client : clients_) {
+            tokens.push_back(client->connect(opts));
+        }
+        for (auto& tok : tokens) {
+            tok->wait();
+        }
 
         connected_.store(true, std::memory_order_release);
         
         std::cout << "[MQTT] Verbunden mit " << config_.mqtt_broker 
-                  << ":" << config_.mqtt_port << "\n";
+                  << ":" << config_.mqtt_port << " (" << clients_.size() << " Verbindung(en))\n";
         return true;
 
     } catch (const mqtt::exception& e) {
@@ -53,11 +125,31 @@ void MqttPublisher::disconnect() {
         return;
     }
 
-    try {
-        auto tok = client_->disconnect();
-        tok->wait_for(std::chrono::seconds(1));
-    } catch (...) {
-        // Ignore errors during disconnect
+#ifndef _WIN32
+    if (broker_) {
+        broker_->stop();
+        return;
+    }
+#endif
+
+    if (!native_.empty()) {
+        for (auto& shard : native_) {
+            shard->disconnect();
+        }
+        std::cout << "[MQTT] Getrennt\n";
+        return;
+    }
+
+    for (auto& client : clients_) {
+        try {
+            auto tok = client->disconnect();
+            tok->wait_for(std::chrono::seconds(1));
+        } catch (...) {
+            // Ignore errors during disconnect
+        }
+    }
+    for (auto& offline : paho_offline_) {
+        if (offline.log) offline.log->sync();
     }
 
     std::cout << "[MQTT] Getrennt\n";
@@ -67,4 +159,184 @@ void MqttPublisher::publish_string(const std::string& topic, const std::string&
     publish(topic, value.data(), value.size());
 }
 
+void MqttPublisher::publish_retained(const std::string& topic, const void* payload, size_t length) {
+#ifndef _WIN32
+    if (broker_) {
+        broker_->publish_retained(topic, payload, length);
+        return;
+    }
+#endif
+    if (!native_.empty()) {
+        native_[shard_of(topic, native_.size())]->publish_retained(topic, payload, length);
+        return;
+    }
+    if (clients_.empty() || !connected_.load(std::memory_order_acquire)) {
+        dropped_disconnected_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    try {
+        clients_[shard_of(topic, clients_.size())]->publish(
+            mqtt::make_message(topic, payload, length, config_.mqtt_qos, true));
+        published_.fetch_add(1, std::memory_order_relaxed);
+    } catch (const mqtt::exception&) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MqttPublisher::register_topic(uint32_t variable_id, const std::string& topic) {
+    if (variable_id >= topics_.size()) {
+        topics_.resize(variable_id + 1);
+        shards_.resize(variable_id + 1, 0);
+    }
+    topics_[variable_id] = mqtt::string_ref(topic);
+    topic_hashes_.resize(topics_.size(), 0);
+    topic_hashes_[variable_id] = OfflineLog::topic_hash(topic);
+    shards_[variable_id] = static_cast<uint32_t>(shard_of(topic, shard_count_));
+#ifndef _WIN32
+    if (broker_) {
+        broker_->register_topic(variable_id, topic);
+    }
+#endif
+    if (!native_.empty()) {
+        native_[shards_[variable_id]]->register_topic(variable_id, topic);
+    }
+}
+
+void MqttPublisher::publish(Message* message) {
+#ifndef _WIN32
+    if (broker_) {
+        broker_->inject(message);
+        return;
+    }
+#endif
+    if (!native_.empty()) {
+        // Unbekannte Variable-ID: Shard 0 zählt sie als Fehler
+        uint32_t id = message->variable_id;
+        native_[id < shards_.size() ? shards_[id] : 0]->enqueue(message);
+        return;
+    }
+    if (!paho_offline_.empty()) {
+        publish_paho_offline(message);
+    } else {
+        publish(message->variable_id, message->data, message->length);
+    }
+    pool_->release(message);
+}
+
+void MqttPublisher::publish_paho_offline(const Message* message) {
+    uint32_t id = message->variable_id;
+    if (id >= topics_.size()) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    size_t shard = shards_[id];
+    PahoOffline& offline = paho_offline_[shard];
+    if (!offline.log) {
+        publish(id, message->data, message->length);
+        return;
+    }
+
+    if (!connected_.load(std::memory_order_acquire) || !clients_[shard]->is_connected()) {
+        // Broker nicht erreichbar: ins Log statt verwerfen (Paho würde eine Exception werfen)
+        // Paho (MQTT 3.1.1): Sequenznummer nur im Log, Payload unverändert
+        if (offline.log->append(offline.log->take_sequence(), id, topic_hashes_[id], message->timestamp,
+                                message->data, message->length)) {
+            offline_logged_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped_disconnected_.fetch_add(1, std::memory_order_relaxed);
+        }
+        auto now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        if (now - offline.synced_ns >= 1000000000ULL) {
+            offline.log->sync();   // höchstens 1x/s, asynchron
+            offline.synced_ns = now;
+        }
+        update_offline_stats();
+        return;
+    }
+
+    // Live-Sample zuerst, dann einen Teil des Logs
+    publish(id, message->data, message->length);
+    if (!offline.log->empty()) {
+        replay_paho_offline(shard);
+    }
+}
+
+void MqttPublisher::replay_paho_offline(size_t shard) {
+    static constexpr size_t MAX_REPLAY_PER_SAMPLE = 64;
+    OfflineLog& log = *paho_offline_[shard].log;
+    auto now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    size_t budget = paho_offline_[shard].limiter.available(now, MAX_REPLAY_PER_SAMPLE);
+
+    uint8_t payload[Pool::buffer_size];
+    size_t taken = 0;
+    size_t replayed = 0;
+    while (taken < budget && !log.empty()) {
+        OfflineLog::Record record;
+        bool valid = log.front(record, payload, sizeof(payload)) && record.variable_id < topic_hashes_.size() &&
+                     topic_hashes_[record.variable_id] == record.topic_hash && shards_[record.variable_id] == shard;
+        log.pop();
+        taken++;
+        if (!valid) {
+            errors_.fetch_add(1, std::memory_order_relaxed);   // Variable nach Neustart nicht mehr registriert
+            continue;
+        }
+        publish(record.variable_id, payload, record.length);   // Paho kopiert die Payload
+        replayed++;
+    }
+    paho_offline_[shard].limiter.consume(taken);
+    offline_replayed_.fetch_add(replayed, std::memory_order_relaxed);
+    update_offline_stats();
+    if (log.empty()) {
+        std::cout << "[MQTT] Offline-Log Shard " << shard << " nachgesendet (" << log.evicted()
+                  << " wegen vollem Log verworfen)\n";
+    }
+}
+
+void MqttPublisher::update_offline_stats() {
+    uint64_t buffered = 0;
+    uint64_t evicted = 0;
+    for (const auto& offline : paho_offline_) {
+        if (!offline.log) continue;
+        buffered += offline.log->records();
+        evicted += offline.log->evicted();
+    }
+    offline_buffered_.store(buffered, std::memory_order_relaxed);
+    offline_evicted_.store(evicted, std::memory_order_relaxed);
+}
+
+PublisherStats MqttPublisher::get_statistics() const {
+    PublisherStats stats;
+#ifndef _WIN32
+    bool embedded = broker_ != nullptr;
+#else
+    bool embedded = false;
+#endif
+    if (!native_.empty() || embedded) {
+        LatencySnapshot flush_latency;
+        for (const auto& shard : native_) {
+            shard->add_stats(stats, flush_latency);
+        }
+#ifndef _WIN32
+        if (broker_) {
+            broker_->add_stats(stats, flush_latency);
+        }
+#endif
+        stats.flush_latency_p50_us = flush_latency.percentile_ns(50.0) / 1000.0;
+        stats.flush_latency_p99_us = flush_latency.percentile_ns(99.0) / 1000.0;
+        stats.flush_latency_max_us = flush_latency.max_ns / 1000.0;
+    } else {
+        stats.published = published_.load(std::memory_order_relaxed);
+        stats.dropped_disconnected = dropped_disconnected_.load(std::memory_order_relaxed);
+        stats.errors = errors_.load(std::memory_order_relaxed);
+        stats.offline_buffered = offline_buffered_.load(std::memory_order_relaxed);
+        stats.offline_logged = offline_logged_.load(std::memory_order_relaxed);
+        stats.offline_replayed = offline_replayed_.load(std::memory_order_relaxed);
+        stats.offline_evicted = offline_evicted_.load(std::memory_order_relaxed);
+    }
+    stats.dropped_pool = pool_->exhausted();
+    return stats;
+}
+
 } // namespace ads_realtime